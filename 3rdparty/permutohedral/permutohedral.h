@@ -40,13 +40,13 @@ public:
     CPermutohedral(void) = default;
     CPermutohedral(const CPermutohedral& rhs);
     CPermutohedral& operator= (const CPermutohedral& rhs);
-	~CPermutohedral(void) = default;
+	virtual ~CPermutohedral(void) = default;
 
-    void init(const Mat& features);
-    void compute(const Mat& src, Mat& dst, int in_offset = 0, int out_offset = 0, size_t in_size = 0, size_t out_size = 0) const;
+    virtual void init(const Mat& features);
+    virtual void compute(const Mat& src, Mat& dst, int in_offset = 0, int out_offset = 0, size_t in_size = 0, size_t out_size = 0) const;
 
     
-private:
+protected:
     int	m_nFeatures         = 0;        // Number of elements
     int	m_M                 = 0;        // Size of sparse discretized space
     int m_featureSize       = 0;        // Dimension of features
@@ -0,0 +1,143 @@
+#include "permutohedralBlocked.h"
+#include "opencv2/core/hal/intrin.hpp"
+
+namespace {
+#if CV_SIMD128
+	const int blockWidth = v_float32x4::nlanes;		// Width of the values block
+#else
+	const int blockWidth = 1;
+#endif
+
+	// y += w * x
+	inline void axpy(float w, const float *x, float *y, int n)
+	{
+		int k = 0;
+#if CV_SIMD128
+		const v_float32x4 vw = v_setall_f32(w);
+		for (; k <= n - blockWidth; k += blockWidth)
+			v_store(y + k, v_fma(vw, v_load(x + k), v_load(y + k)));
+#endif
+		for (; k < n; k++)
+			y[k] += w * x[k];
+	}
+
+	// dst = a + 0.5 * (b + c), where n is a multiple of blockWidth
+	inline void blur(const float *a, const float *b, const float *c, float *dst, int n)
+	{
+#if CV_SIMD128
+		const v_float32x4 half = v_setall_f32(0.5f);
+		for (int k = 0; k < n; k += blockWidth)
+			v_store(dst + k, v_fma(half, v_load(b + k) + v_load(c + k), v_load(a + k)));
+#else
+		for (int k = 0; k < n; k++)
+			dst[k] = a[k] + 0.5f * (b[k] + c[k]);
+#endif
+	}
+}
+
+void CPermutohedralBlocked::init(const Mat &features)
+{
+	CPermutohedral::init(features);
+
+	// Transposing the splatting: the contributions are grouped by lattice vertex, and within a vertex sorted by feature
+	m_vSplatStart.assign(m_M + 1, 0);
+	for (int k = 0; k < m_nFeatures; k++) {
+		const int *pOffset = m_offset.ptr<int>(k);
+		for (int j = 0; j <= m_featureSize; j++)
+			m_vSplatStart[pOffset[j] + 1]++;
+	}
+	for (int i = 0; i < m_M; i++)
+		m_vSplatStart[i + 1] += m_vSplatStart[i];
+
+	std::vector<int> vPos(m_vSplatStart.begin(), m_vSplatStart.end() - 1);
+	m_vSplatFeature.resize(m_vSplatStart.back());
+	m_vSplatWeight.resize(m_vSplatStart.back());
+	for (int k = 0; k < m_nFeatures; k++) {
+		const int	*pOffset		= m_offset.ptr<int>(k);
+		const float *pBarycentric	= m_barycentric.ptr<float>(k);
+		for (int j = 0; j <= m_featureSize; j++) {
+			const int pos = vPos[pOffset[j]]++;
+			m_vSplatFeature[pos] = k;
+			m_vSplatWeight[pos]	 = pBarycentric[j];
+		}
+	}
+}
+
+void CPermutohedralBlocked::compute(const Mat &src, Mat &dst, int in_offset, int out_offset, size_t in_size, size_t out_size) const
+{
+	// The splatting tables cover all the features: partial ranges are processed by the base class
+	const size_t nFeatures = static_cast<size_t>(m_nFeatures);
+	if (in_offset != 0 || out_offset != 0 || (in_size != 0 && in_size != nFeatures) || (out_size != 0 && out_size != nFeatures)) {
+		CPermutohedral::compute(src, dst, in_offset, out_offset, in_size, out_size);
+		return;
+	}
+	if (dst.empty()) dst = Mat(m_nFeatures, src.cols, CV_32FC1);
+
+	const int nChannels	= src.cols;
+	const int stride	= (nChannels + blockWidth - 1) / blockWidth * blockWidth;
+
+	// Shift all values by 1 such that -1 -> 0 (used for blurring)
+	vec_float_t &values		= m_vValues;
+	vec_float_t &newValues	= m_vNewValues;
+	values.assign(static_cast<size_t>(m_M + 2) * stride, 0.0f);
+	newValues.assign(static_cast<size_t>(m_M + 2) * stride, 0.0f);
+
+	// Splatting
+	{
+#ifdef ENABLE_PDP
+	parallel_for_(Range(0, m_M), [&](const Range &range) {
+#else
+	const Range range(0, m_M);
+#endif
+	for (int v = range.start; v < range.end; v++) {
+		float *pValues = values.data() + static_cast<size_t>(v + 1) * stride;
+		for (int c = m_vSplatStart[v]; c < m_vSplatStart[v + 1]; c++)
+			axpy(m_vSplatWeight[c], src.ptr<float>(m_vSplatFeature[c]), pValues, nChannels);
+	}
+#ifdef ENABLE_PDP
+	});
+#endif
+	}
+
+	// Blurring
+	for (int j = 0; j <= m_featureSize; j++) {
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, m_M), [&](const Range &range) {
+#else
+		const Range range(0, m_M);
+#endif
+		for (int v = range.start; v < range.end; v++) {
+			const int n1 = m_blurNeighbor1.at<int>(v, j) + 1;
+			const int n2 = m_blurNeighbor2.at<int>(v, j) + 1;
+			blur(values.data() + static_cast<size_t>(v + 1) * stride, values.data() + static_cast<size_t>(n1) * stride,
+				 values.data() + static_cast<size_t>(n2) * stride, newValues.data() + static_cast<size_t>(v + 1) * stride, stride);
+		}
+#ifdef ENABLE_PDP
+		});
+#endif
+		values.swap(newValues);
+	}
+
+	// Alpha is a magic scaling constant (write Andrew if you really wanna understand this)
+	const float alpha = 1.0f / (1.0f + powf(2.0f, -static_cast<float>(m_featureSize)));
+
+	// Slicing
+	{
+#ifdef ENABLE_PDP
+	parallel_for_(Range(0, m_nFeatures), [&](const Range &range) {
+#else
+	const Range range(0, m_nFeatures);
+#endif
+	for (int i = range.start; i < range.end; i++) {
+		float		*pOut			= dst.ptr<float>(i);
+		const int	*pOffset		= m_offset.ptr<int>(i);
+		const float *pBarycentric	= m_barycentric.ptr<float>(i);
+		std::fill(pOut, pOut + nChannels, 0.0f);
+		for (int j = 0; j <= m_featureSize; j++)
+			axpy(pBarycentric[j] * alpha, values.data() + static_cast<size_t>(pOffset[j] + 1) * stride, pOut, nChannels);
+	}
+#ifdef ENABLE_PDP
+	});
+#endif
+	}
+}
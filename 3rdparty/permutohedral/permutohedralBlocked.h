@@ -0,0 +1,31 @@
+// Blocked permutohedral lattice
+// Written in 2021 for Project X
+#pragma once
+
+#include "permutohedral.h"
+
+/************************************************/
+/***      Blocked Permutohedral Lattice       ***/
+/************************************************/
+// Multithreaded and vectorized version of CPermutohedral. All the channels are filtered in one splat / blur / slice pass, where the values of
+// every lattice vertex are stored in a block, padded to a multiple of the SIMD vector width. The splatting is performed in the gather form:
+// for every lattice vertex the contributing features are precomputed in init(), thus the vertices are processed in parallel without
+// synchronization, and the contributions are accumulated in the same order as in CPermutohedral. The buffers for the lattice values are
+// reused between the calls, thus compute() must not be called concurrently for the same lattice.
+class CPermutohedralBlocked : public CPermutohedral
+{
+public:
+    CPermutohedralBlocked(void) = default;
+	virtual ~CPermutohedralBlocked(void) = default;
+
+    virtual void init(const Mat& features) override;
+    virtual void compute(const Mat& src, Mat& dst, int in_offset = 0, int out_offset = 0, size_t in_size = 0, size_t out_size = 0) const override;
+
+
+private:
+    std::vector<int>    m_vSplatStart;      // Index of the first contribution of every lattice vertex: m_M + 1
+    std::vector<int>    m_vSplatFeature;    // Contributing feature
+    vec_float_t         m_vSplatWeight;     // Barycentric weight of the contribution
+    mutable vec_float_t m_vValues;          // Buffer for the lattice values, reused between the calls
+    mutable vec_float_t m_vNewValues;       // Buffer for the blurred lattice values
+};
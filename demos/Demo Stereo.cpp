@@ -32,35 +32,47 @@ int main(int argc, char *argv[])
 	graphKit.getGraphExt().addDefaultEdgesModel(1.175f);
 
 	// ==================== Building and filling the graph ====================
-	Mat nodePot(nStates, 1, CV_32FC1);										// node Potential (column-vector)
+	Mat nodePots(width * height, nStates, CV_32FC1);						// node Potentials (one row per node)
 	size_t idx = 0;
 	for (int y = 0; y < height; y++) {
 		byte * pImgL	= imgL.ptr<byte>(y);
 		byte * pImgR	= imgR.ptr<byte>(y);
 		for (int x = 0; x < width; x++) {
 			float imgL_value = static_cast<float>(pImgL[x]);
+			float * pNodePot = nodePots.ptr<float>(static_cast<int>(idx++));
 			for (unsigned int s = 0; s < nStates; s++) {					// state
 				int disparity = minDisparity + s;
 				float imgR_value = (x + disparity < width) ? static_cast<float>(pImgR[x + disparity]) : imgL_value;
 				float p = 1.0f - fabs(imgL_value - imgR_value) / 255.0f;
-				nodePot.at<float>(s, 0) = p * p;
+				pNodePot[s] = p * p;
 			}
-
-			graphKit.getGraph().setNode(idx++, nodePot);
 		} // x
 	} // y
 
 	// =============================== Decoding ===============================
-	Timer::start("Decoding... ");
-	vec_byte_t optimalDecoding = graphKit.getInfer().decode(10);
-	Timer::stop();
+	// The inference replaces the node potentials, thus they are restored before every decoding
+	CInferGraphCut graphCut(dynamic_cast<IGraphPairwise &>(graphKit.getGraph()));
+	auto benchmark = [&](const std::string &name, CInfer &inferer) {
+		graphKit.getGraph().setNodes(0, nodePots);
+		Timer::start(name + " decoding...");
+		vec_byte_t decoding = inferer.decode(10);
+		Timer::stop();
+		graphKit.getGraph().setNodes(0, nodePots);
+		printf("%s energy: %.1f\n", name.c_str(), graphCut.getEnergy(decoding));
+		return decoding;
+	};
+	vec_byte_t optimalDecoding	= benchmark("TRW", graphKit.getInfer());
+	vec_byte_t graphCutDecoding = benchmark("Graph-Cut", graphCut);
 	
 	// ============================ Visualization =============================
-	Mat disparity(imgL.size(), CV_8UC1, optimalDecoding.data());
-	disparity = (disparity + minDisparity) * (256 / maxDisparity);
-	medianBlur(disparity, disparity, 3);
-
-	imshow("Disparity", disparity);
+	auto visualize = [&](const std::string &name, vec_byte_t &decoding) {
+		Mat disparity(imgL.size(), CV_8UC1, decoding.data());
+		disparity = (disparity + minDisparity) * (256 / maxDisparity);
+		medianBlur(disparity, disparity, 3);
+		imshow(name, disparity);
+	};
+	visualize("Disparity", optimalDecoding);
+	visualize("Disparity Graph-Cut", graphCutDecoding);
 
 	waitKey();
 
@@ -5,6 +5,7 @@
 #include "DGM/FeaturesConcatenator.h"
 #include "DGM/KDGauss.h"
 #include "DGM/KDTree.h"
+#include "DGM/KDForest.h"
 #include "DGM/random.h"
 #include "DGM/parallel.h"
 
@@ -19,6 +20,7 @@
 #include "DGM/PriorTriplet.h"
 
 #include "DGM/ITrain.h"
+#include "DGM/SampleStore.h"
 #include "DGM/TrainNode.h"
 #include "DGM/TrainNodeNaiveBayes.h"
 #include "DGM/TrainNodeGM.h"
@@ -52,6 +54,7 @@
 #include "DGM/GraphDense.h"
 #include "DGM/IGraphPairwise.h"
 #include "DGM/GraphPairwise.h"
+#include "DGM/GraphPairwiseCSR.h"
 #include "DGM/GraphWeiss.h"
 #include "DGM/Graph3.h"
 
@@ -62,10 +65,17 @@
 #include "DGM/InferExact.h"
 #include "DGM/InferDense.h"
 #include "DGM/InferChain.h"
+#include "DGM/InferGraphCut.h"
 #include "DGM/InferTree.h"
 #include "DGM/InferLBP.h"
+#include "DGM/InferLBPGrid.h"
+#include "DGM/InferPyramid.h"
+#include "DGM/InferMinSum.h"
+#include "DGM/InferMinSumTRW.h"
+#include "DGM/InferRBP.h"
 #include "DGM/InferTRW.h"
 #include "DGM/InferViterbi.h"
+#include "DGM/TiledInfer.h"
 
 #include "DGM/Decode.h"
 #include "DGM/DecodeExact.h"
@@ -126,10 +136,16 @@ The corresponding classes are @b CTrainEdge* (where @b * is the name of the meth
 DGM implements the following inference and decoding methods: 
 
 @subsubsection sec_main_decode_inference Inference
-- <b>Exact:</b> Exact inferece for small graphs with an exhaustive search @ref DirectGraphicalModels::CInferExact
+- <b>Exact:</b> Exact inferece for graphs with a small treewidth with the junction tree algorithm @ref DirectGraphicalModels::CInferExact
 - <b>Chain:</b> Exact inferece for Markov chains (chain-structured graphs) @ref DirectGraphicalModels::CInferChain
 - <b>Tree:</b> Exact inferece for undirected graphs without loops (tree-structured graphs) @ref DirectGraphicalModels::CInferTree
+- <b>Graph Cut:</b> Approximate MAP estimation with the \f$\alpha\f$-expansion or \f$\alpha\beta\f$-swap moves and a max-flow / min-cut solver @ref DirectGraphicalModels::CInferGraphCut
 - <b>LBP:</b> Approximate inference based on the Loopy Belief Propagation (\a sum-product message-passing) algorithm @ref DirectGraphicalModels::CInferLBP 
+- <b>LBP Grid:</b> Loopy Belief Propagation, specialized for the grid graphs built with @ref DirectGraphicalModels::CGraphLayeredExt @ref DirectGraphicalModels::CInferLBPGrid
+- <b>Pyramid:</b> Coarse-to-fine initialization of the messages of LBP or TRW on the grid graphs @ref DirectGraphicalModels::CInferPyramid
+- <b>Min-Sum:</b> Viterbi (\a max-sum message-passing) algorithm in the energy domain with optional half-precision messages @ref DirectGraphicalModels::CInferMinSum
+- <b>Min-Sum TRW:</b> Sequential Tree-Reweighted message-passing in the energy domain @ref DirectGraphicalModels::CInferMinSumTRW
+- <b>RBP:</b> Loopy Belief Propagation with residual (asynchronous) scheduling of the message updates @ref DirectGraphicalModels::CInferRBP
 - <b>TRW:</b> Approximate inference based on the (<a href="http://pub.ist.ac.at/~vnk/papers/TRW-S-PAMI.pdf" target="_blank">Convergent Tree-Reweighted</a>) (\a max-sum message-passing) algorithm @ref DirectGraphicalModels::CInferTRW 
 - <b>Viterbi:</b> Approximate inference based on Viterbi (\a max-sum message-passing) algorithm @ref DirectGraphicalModels::CInferViterbi 
 - <b>Dense:</b> Efficient inference for \a dense CRFs with Gaussian edge potentials (<a href="http://vladlen.info/publications/efficient-inference-in-fully-connected-crfs-with-gaussian-edge-potentials/" target="_blank">paper</a>) @ref DirectGraphicalModels::CInferDense
@@ -139,7 +155,7 @@ The corresponding classes are @b CInfer* (where @b * is the name of the method a
 All of the inference classes may be also used for approximate decoding via function @ref DirectGraphicalModels::CInfer::decode()
 
 @subsubsection sec_main_decode_decoding Decoding
-- <b>Exact:</b> Exact decoding for small graphs with an exhaustive search @ref DirectGraphicalModels::CDecodeExact
+- <b>Exact:</b> Exact decoding for graphs with a small treewidth with the junction tree algorithm @ref DirectGraphicalModels::CDecodeExact
 
 The corresponding classes are @b CDecode* (where @b * is the name of the method above). 
 
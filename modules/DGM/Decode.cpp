@@ -6,22 +6,39 @@ namespace DirectGraphicalModels
 {
 	vec_byte_t CDecode::decode(const CGraph &graph, Mat &lossMatrix)
 	{
-		size_t		nNodes		= graph.getNumNodes();			// number of nodes
-		vec_byte_t	res(nNodes);
-		Mat			pot;
-		bool		ifLossMat	= !lossMatrix.empty();
+		const size_t	nNodes		= graph.getNumNodes();			// number of nodes
+		const byte		nStates		= graph.getNumStates();
+		const int		nBlockNodes	= 4096;							// number of nodes, which potentials are read at once
+		const int		nBlocks		= static_cast<int>((nNodes + nBlockNodes - 1) / nBlockNodes);
+		vec_byte_t		res(nNodes);
+		bool			ifLossMat	= !lossMatrix.empty();
 
 		// Getting optimal state
-		for (size_t n = 0; n < nNodes; n++) {						// all nodes
-			graph.getNode(n, pot);
-			if (ifLossMat) gemm(lossMatrix, pot, 1.0, Mat(), 0.0, pot);
-		
-			Point extremumLoc;
-			if (ifLossMat) minMaxLoc(pot, NULL, NULL, &extremumLoc, NULL);
-			else minMaxLoc(pot, NULL, NULL, NULL, &extremumLoc);
-			res[n] = static_cast<byte>(extremumLoc.y);
-		} // n
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, nBlocks), [&, nNodes, nStates, nBlockNodes, ifLossMat](const Range &range) {
+#else
+		const Range range(0, nBlocks);
+#endif
+		Mat pots(nBlockNodes, nStates, CV_32FC1);
+		Mat risk;
+		for (int b = range.start; b < range.end; b++) {				// blocks of nodes
+			const size_t start	= static_cast<size_t>(b) * nBlockNodes;
+			const int	 size	= static_cast<int>(MIN(nBlockNodes, nNodes - start));
+			graph.getNodes(start, size, pots.ptr<float>());
+			if (ifLossMat) gemm(pots.rowRange(0, size), lossMatrix, 1.0, Mat(), 0.0, risk, GEMM_2_T);	// the rows are (L * pot)^T
 
+			for (int n = 0; n < size; n++) {
+				// The maximal probability, or the minimal risk; the first extremum is chosen
+				const float *pPot = ifLossMat ? risk.ptr<float>(n) : pots.ptr<float>(n);
+				byte state = 0;
+				for (byte s = 1; s < nStates; s++)
+					if (ifLossMat ? pPot[s] < pPot[state] : pPot[s] > pPot[state]) state = s;
+				res[start + n] = state;
+			} // n
+		} // b
+#ifdef ENABLE_PDP
+		});
+#endif
 		return res;
 	}
 
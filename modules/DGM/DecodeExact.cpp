@@ -1,6 +1,6 @@
 #include "DecodeExact.h"
+#include "JunctionTree.h"
 #include "macroses.h"
-#include <numeric>
 
 namespace DirectGraphicalModels
 {
@@ -8,31 +8,11 @@ namespace DirectGraphicalModels
 	{
 		DGM_IF_WARNING(!lossMatrix.empty(), "The Loss Matrix is not supported by the algorithm.");
 
-		size_t			nNodes = getGraph().getNumNodes();
-		vec_byte_t		state(nNodes);
-
-		// Calculating the potentials for every possible configuration
-		vec_float_t     P = calculatePotentials();
-
+		CJunctionTree junctionTree(getGraphPairwise());
 #ifdef DEBUG_PRINT_INFO
-		// Printing out
-		printf("nConfigurations = %zd\n", P.size());
-
-        // Calculating the partition function
-        float Z = std::accumulate(P.cbegin(), P.cend(), 0.0f);
-        
-        setState(state, 0);
-        for (float &p: P) {
-			for (size_t n = 0; n < nNodes; n++) printf("%d ", state[n]);
-			printf(":-> %2.1f\t| %2.1f %% \n", p, p * 100 / Z);
-			incState(state);
-		}
+		printf("Treewidth = %zu\n", junctionTree.getTreeWidth());
 #endif
-
-		// Finding the most probable configuration
-		qword c = std::max_element(P.cbegin(), P.cend()) - P.begin();
-		setState(state, c);
-		return state;
+		return junctionTree.decode();
 	}
 
 	// Sets the <state> according to the configuration number <c>
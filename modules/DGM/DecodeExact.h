@@ -11,7 +11,9 @@ namespace DirectGraphicalModels
 	/**
 	* @ingroup moduleDecode
 	* @brief Exact decoding class
-	* @note Use this class only if \f$ nStates^{nNodes} < 2^{32}\f$
+	* @details The most probable configuration is found with the max-product message passing over the junction tree of the graph
+	* (see CJunctionTree), which is exponential only in the treewidth of the graph
+	* @note Use this class only if \f$ nStates^{w+1} < 2^{32}\f$, where \f$w\f$ is the treewidth of the graph
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
 	class CDecodeExact : public CDecode
@@ -53,7 +55,7 @@ namespace DirectGraphicalModels
 		void			incState(vec_byte_t &state) const;
 		/**
 		* @brief Calculates potentials for all possible configurations
-		* @details This function is used in exact inference / decoding
+		* @details This function performs the exhaustive search and may be used for validation of the exact inference / decoding
 		* @return \f$nStates^{nNodes}\f$ potentials, corresponding to the all possible configurations (states destributed along the nodes)
 		*/
 		vec_float_t		calculatePotentials(void) const;
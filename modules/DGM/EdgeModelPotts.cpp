@@ -1,14 +1,16 @@
 #include "EdgeModelPotts.h"
-#include "permutohedral/permutohedral.h"
+#include "permutohedral/permutohedralBlocked.h"
 
 namespace DirectGraphicalModels {
 	// Constructor
-	CEdgeModelPotts::CEdgeModelPotts(const Mat& features, float weight, const std::function<void(const Mat& src, Mat& dst)>& semiMetricFunction, bool perPixelNormalization)
+	CEdgeModelPotts::CEdgeModelPotts(const Mat& features, float weight, const std::function<void(const Mat& src, Mat& dst)>& semiMetricFunction, bool perPixelNormalization, bool blockedLattice)
 		: IEdgeModel()
-		, m_pLattice(new CPermutohedral())
+		, m_pLattice(blockedLattice ? new CPermutohedralBlocked() : new CPermutohedral())
 		, m_weight(weight)
 		, m_norm(features.rows, 1, CV_32FC1, Scalar(1))
 		, m_function(semiMetricFunction)
+		, m_features(features)
+		, m_perPixelNormalization(perPixelNormalization)
 	{
 		m_pLattice->init(features);
 
@@ -56,4 +58,37 @@ namespace DirectGraphicalModels {
 		exp(dst, dst);
 	}
 
+	// dst += w * norm * f(Lattice.compute(src))
+	void CEdgeModelPotts::accumulate(const Mat &src, Mat &dst) const
+	{
+		m_filtered.create(src.size(), CV_32FC1);
+		m_pLattice->compute(src, m_filtered);		// filtered = Lattice.compute(src)
+
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+#else
+		const Range range(0, dst.rows); 
+#endif
+		for (int n = range.start; n < range.end; n++) {	// nodes
+			if (m_function) m_function(m_filtered.row(n), lvalue_cast(m_filtered.row(n)));		// With the SemiMetric function
+
+			const float *pFiltered = m_filtered.ptr<float>(n);
+			float		*pDst	   = dst.ptr<float>(n);
+			float		 k		   = m_weight * m_norm.at<float>(n, 0);
+			for (int s = 0; s < dst.cols; s++) pDst[s] += k * pFiltered[s];
+		}
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	bool CEdgeModelPotts::merge(const Mat& features, float weight, bool perPixelNormalization)
+	{
+		if (m_function || perPixelNormalization != m_perPixelNormalization) return false;
+		if (features.size() != m_features.size() || features.type() != m_features.type()) return false;
+		if (features.data != m_features.data && norm(features, m_features, NORM_INF) != 0) return false;
+		m_weight += weight;
+		return true;
+	}
+
 }
@@ -28,11 +28,30 @@ namespace DirectGraphicalModels {
 		* @param semiMetricFunction Reference to a semi-metric function, which arguments \b src and \b dst are: Mat(size: 1 x nFeatures; type: CV_32FC1). This function when provided 
 		* will be called for every node potential in the apply() method. 
 		* @param perPixelNormalization Flag indicating whether er-pixel normalization should be used during applying the edge model.
+		* @param blockedLattice Flag indicating whether the multithreaded and vectorized implementation of the permutohedral lattice should be used.
+		* It filters all the states in one pass and matches the reference implementation up to the rounding errors.
 		*/
-		DllExport CEdgeModelPotts(const Mat& features, float weight = 1.0f, const std::function<void(const Mat& src, Mat& dst)>& semiMetricFunction = {}, bool perPixelNormalization = true);
+		DllExport CEdgeModelPotts(const Mat& features, float weight = 1.0f, const std::function<void(const Mat& src, Mat& dst)>& semiMetricFunction = {}, bool perPixelNormalization = true, bool blockedLattice = true);
 		DllExport virtual ~CEdgeModelPotts(void);
 	
 		DllExport void apply(const Mat &src, Mat &dst) const override;
+		/**
+		* @copydoc IEdgeModel::accumulate
+		* > This function reuses an internal buffer, thus it must not be called concurrently for the same model
+		*/
+		DllExport void accumulate(const Mat &src, Mat &dst) const override;
+		/**
+		* @brief Merges an edge model with the same features into this model
+		* @details Two Potts edge models without semi-metric functions, which are built on the same features with the same normalization, differ
+		* only in the weighting parameter. They are merged into one model with the sum of the weights, which filters the potentials with one
+		* permutohedral lattice instead of two.
+		* @param features The features of the model to merge: Mat(size: nNodes x nFeatures; type: CV_32FC1)
+		* @param weight The weighting parameter of the model to merge
+		* @param perPixelNormalization The normalization flag of the model to merge
+		* @retval true if the model was merged: its weight was added to the weight of this model
+		* @retval false if the models are not compatible
+		*/
+		DllExport bool merge(const Mat& features, float weight, bool perPixelNormalization = true);
 	
 
 	private:
@@ -40,5 +59,8 @@ namespace DirectGraphicalModels {
 		float											m_weight;		///< The weighting parameter
 		Mat												m_norm;			///< Array with normalization factors
 		std::function<void(const Mat &src, Mat &dst)>	m_function;		///< The semi-metric function
+		Mat												m_features;		///< The features of the nodes
+		bool											m_perPixelNormalization;	///< Flag indicating whether per-pixel normalization is used
+		mutable Mat										m_filtered;		///< Buffer for the filtered potentials
 	};
 }
\ No newline at end of file
@@ -4,21 +4,39 @@
 namespace DirectGraphicalModels 
 {
 	void CGraph::addNodes(const Mat &pots) {
-		for (int n = 0; n < pots.rows; n++)
-			addNode(pots.row(n).t());
+		const size_t start_node = getNumNodes();
+		addNodes(static_cast<size_t>(pots.rows));
+		setNodes(start_node, pots);
+	}
+
+	void CGraph::addNodes(size_t nNodes) {
+		for (size_t n = 0; n < nNodes; n++)
+			addNode();
 	}
 
 	void CGraph::setNodes(size_t start_node, const Mat &pots) {
+		if (pots.empty()) return;
+		
 		// Assertions
-		DGM_ASSERT_MSG(start_node + pots.rows <= getNumNodes(), "The given ranges exceed the number of nodes(%zu)", getNumNodes());
+		DGM_ASSERT_MSG(pots.type() == CV_32FC1, "Potentials type is not CV_32FC1");
+		DGM_ASSERT_MSG(pots.cols == m_nStates, "Potential size (%d) does not match (%d)", pots.cols, m_nStates);
+
+		setNodes(start_node, pots.rows, pots.ptr<float>(), pots.step1());
+	}
+
+	void CGraph::setNodes(size_t start_node, size_t num_nodes, const float *pots, size_t step) {
+		if (!step) step = m_nStates;
+		
+		// Assertions
+		DGM_ASSERT_MSG(start_node + num_nodes <= getNumNodes(), "The given ranges exceed the number of nodes(%zu)", getNumNodes());
 
 #ifdef ENABLE_PDP
-		parallel_for_(Range(0, pots.rows), [start_node, &pots, this](const Range& range) {
+		parallel_for_(Range(0, static_cast<int>(num_nodes)), [start_node, pots, step, this](const Range& range) {
 #else
-		const Range range(0, pots.rows);
+		const Range range(0, static_cast<int>(num_nodes));
 #endif
 		for (int n = range.start; n < range.end; n++)
-			setNode(start_node + n, pots.row(n).t());
+			setNode(start_node + n, Mat(m_nStates, 1, CV_32FC1, const_cast<float *>(pots) + n * step));
 #ifdef ENABLE_PDP
 		});
 #endif
@@ -30,21 +48,29 @@ namespace DirectGraphicalModels
 		// Assertions
 		DGM_ASSERT_MSG(start_node + num_nodes <= getNumNodes(), "The given ranges exceed the number of nodes(%zu)", getNumNodes());
 
-		if (pots.empty() || pots.cols != m_nStates || pots.rows != num_nodes)
+		if (pots.empty() || pots.cols != m_nStates || pots.rows != num_nodes || pots.type() != CV_32FC1)
 			pots = Mat(static_cast<int>(num_nodes), m_nStates, CV_32FC1);
 		
-		transpose(pots, pots);
+		getNodes(start_node, num_nodes, pots.ptr<float>(), pots.step1());
+	}
+
+	void CGraph::getNodes(size_t start_node, size_t num_nodes, float *pots, size_t step) const {
+		if (!step) step = m_nStates;
+
+		// Assertions
+		DGM_ASSERT_MSG(start_node + num_nodes <= getNumNodes(), "The given ranges exceed the number of nodes(%zu)", getNumNodes());
 
 #ifdef ENABLE_PDP
-		parallel_for_(Range(0, pots.cols), [start_node, &pots, this](const Range& range) {
+		parallel_for_(Range(0, static_cast<int>(num_nodes)), [start_node, pots, step, this](const Range& range) {
 #else
-		const Range range(0, pots.cols);
+		const Range range(0, static_cast<int>(num_nodes));
 #endif
-		for (int n = range.start; n < range.end; n++)
-			getNode(start_node + n, lvalue_cast(pots.col(n)));
+		for (int n = range.start; n < range.end; n++) {
+			Mat pot(m_nStates, 1, CV_32FC1, pots + n * step);		// header over the buffer: getNode() writes in place
+			getNode(start_node + n, pot);
+		}
 #ifdef ENABLE_PDP
 		});
 #endif
-		transpose(pots, pots);
 	}
 }
@@ -42,6 +42,13 @@ namespace DirectGraphicalModels {
 		*/
 		DllExport virtual void		addNodes(const Mat &pots);
 		/**
+		* @brief Adds a block of nodes without potentials
+		* @details The nodes get consecutive indices, starting from getNumNodes(). The derived graphs allocate all the nodes at once.
+		* > This function supports PPL
+		* @param nNodes The number of nodes
+		*/
+		DllExport virtual void		addNodes(size_t nNodes);
+		/**
 		* @brief Sets or changes the potential of node
 		* @param node node index
 		* @param pot node potential vector: Mat(size: nStates x 1; type: CV_32FC1)
@@ -56,6 +63,17 @@ namespace DirectGraphicalModels {
 		*/
 		DllExport virtual void		setNodes(size_t start_node, const Mat &pots);
 		/**
+		* @brief Fills the graph nodes with new potentials from a raw buffer
+		* @details The potentials are read directly from the caller-owned buffer, \a e.g. from a row of the potentials returned by
+		* CTrainNode::getNodePotentials(), without creating a temporary Mat for every node.
+		* > This function supports PPL
+		* @param start_node The index of the node, starting from which the potentials should be set
+		* @param num_nodes The number of nodes
+		* @param pots Pointer to the potentials of node \b start_node, followed by the potentials of the next nodes
+		* @param step The distance (in number of floats) between the potentials of two consecutive nodes. \b 0 means - \b nStates (dense buffer)
+		*/
+		DllExport virtual void		setNodes(size_t start_node, size_t num_nodes, const float *pots, size_t step = 0);
+		/**
 		* @brief Returns the node potential
 		* @param[in] node node index
 		* @param[out] pot node potential vector: Mat(size: nStates x 1; type: CV_32FC1)
@@ -71,6 +89,16 @@ namespace DirectGraphicalModels {
 		*/
 		DllExport virtual void		getNodes(size_t start_node, size_t num_nodes, Mat &pots) const;
 		/**
+		* @brief Copies the node potentials into a raw buffer
+		* @details The potentials are written directly to the caller-owned buffer without creating a temporary Mat for every node.
+		* > This function supports PPL
+		* @param[in] start_node The index of the node, starting from which the potentials should be got
+		* @param[in] num_nodes The number of nodes
+		* @param[out] pots Pointer to the buffer for the potentials of node \b start_node, followed by the potentials of the next nodes
+		* @param[in] step The distance (in number of floats) between the potentials of two consecutive nodes. \b 0 means - \b nStates (dense buffer)
+		*/
+		DllExport virtual void		getNodes(size_t start_node, size_t num_nodes, float *pots, size_t step = 0) const;
+		/**
 		* @brief Returns the set of IDs of the child nodes of the argument node
 		* @param[in] node node index
 		* @param[out] vNodes vector with the child node's ID
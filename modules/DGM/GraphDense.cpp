@@ -32,6 +32,12 @@ namespace DirectGraphicalModels
 		pots.copyTo(m_nodePotentials(Rect(0, static_cast<int>(start_node), getNumStates(), pots.rows)));
 	}
 
+	void CGraphDense::setNodes(size_t start_node, size_t num_nodes, const float *pots, size_t step)
+	{
+		if (!step) step = getNumStates();
+		setNodes(start_node, Mat(static_cast<int>(num_nodes), getNumStates(), CV_32FC1, const_cast<float *>(pots), step * sizeof(float)));
+	}
+
 	// Return node potential vector 
 	void CGraphDense::getNode(size_t node, Mat &pot) const
 	{
@@ -53,6 +59,14 @@ namespace DirectGraphicalModels
 		m_nodePotentials(Rect(0, static_cast<int>(start_node), getNumStates(), static_cast<int>(num_nodes))).copyTo(pots);
 	}
 
+	void CGraphDense::getNodes(size_t start_node, size_t num_nodes, float *pots, size_t step) const
+	{
+		if (!step) step = getNumStates();
+		DGM_ASSERT_MSG(start_node + num_nodes <= getNumNodes(), "The given ranges exceed the number of nodes(%zu)", getNumNodes());
+		Mat dst(static_cast<int>(num_nodes), getNumStates(), CV_32FC1, pots, step * sizeof(float));	// header over the buffer: copyTo() writes in place
+		m_nodePotentials(Rect(0, static_cast<int>(start_node), getNumStates(), static_cast<int>(num_nodes))).copyTo(dst);
+	}
+
 	void CGraphDense::getChildNodes(size_t node, vec_size_t &vNodes) const
 	{
 		DGM_ASSERT_MSG(node < getNumNodes(), "Node %zu is out of range %zu", node, getNumNodes());
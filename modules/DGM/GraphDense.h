@@ -30,9 +30,11 @@ namespace DirectGraphicalModels
 
 		DllExport void		setNode(size_t node, const Mat &pot) override;
 		DllExport void		setNodes(size_t start_node, const Mat &pots) override;
+		DllExport void		setNodes(size_t start_node, size_t num_nodes, const float *pots, size_t step = 0) override;
 		
 		DllExport void		getNode(size_t node, Mat &pot) const override;
 		DllExport void		getNodes(size_t start_node, size_t num_nodes, Mat &pots) const override;
+		DllExport void		getNodes(size_t start_node, size_t num_nodes, float *pots, size_t step = 0) const override;
 		
 		DllExport void		getChildNodes (size_t node, vec_size_t &vNodes) const override;
 		DllExport void		getParentNodes(size_t node, vec_size_t &vNodes) const override { getChildNodes(node, vNodes); }
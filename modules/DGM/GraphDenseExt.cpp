@@ -14,18 +14,20 @@ namespace DirectGraphicalModels
 		// 2D default potentials
 		Mat pots(graphSize, CV_32FC(m_graph.getNumStates()));
 		pots.setTo(1.0f / m_graph.getNumStates());
-        m_graph.addNodes(pots.clone().reshape(1, pots.cols * pots.rows));
+        m_graph.addNodes(pots.reshape(1, pots.cols * pots.rows));
     }
     
     void CGraphDenseExt::setGraph(const Mat &pots)
 	{
         m_size = pots.size();
 
+		// The graph copies the potentials itself, thus only a non-continuous matrix needs to be cloned before reshaping
+		const Mat nodePots = (pots.isContinuous() ? pots : pots.clone()).reshape(1, pots.cols * pots.rows);
         if (m_graph.getNumNodes() == pots.cols * pots.rows) 
-			m_graph.setNodes(0, pots.clone().reshape(1, pots.cols * pots.rows));
+			m_graph.setNodes(0, nodePots);
         else {
             if (m_graph.getNumNodes()) m_graph.reset();
-            m_graph.addNodes(pots.clone().reshape(1, pots.cols * pots.rows));
+            m_graph.addNodes(nodePots);
         }
 	}
 
@@ -41,7 +43,7 @@ namespace DirectGraphicalModels
 				features.push_back(feature);
 			} // x
 
-		m_graph.addEdgeModel(std::make_shared<CEdgeModelPotts>(features, weight, semiMetricFunction));
+		addPottsEdgeModel(features, weight, semiMetricFunction);
 	}
 
 	void CGraphDenseExt::addBilateralEdgeModel(const Mat &featureVectors, Vec2f sigma, float sigma_opt, float weight, const std::function<void(const Mat& src, Mat& dst)> &semiMetricFunction)
@@ -62,7 +64,7 @@ namespace DirectGraphicalModels
                 features.push_back(feature);
 			} // x
 		} // y
-		m_graph.addEdgeModel(std::make_shared<CEdgeModelPotts>(features, weight, semiMetricFunction));
+		addPottsEdgeModel(features, weight, semiMetricFunction);
 	}
 
     void CGraphDenseExt::addBilateralEdgeModel(const vec_mat_t &featureVectors, Vec2f sigma, float sigma_opt, float weight, const std::function<void(const Mat& src, Mat& dst)> &semiMetricFunction)
@@ -85,6 +87,17 @@ namespace DirectGraphicalModels
                 features.push_back(feature);
             } // x
         } // y
-        m_graph.addEdgeModel(std::make_shared<CEdgeModelPotts>(features, weight, semiMetricFunction));
+        addPottsEdgeModel(features, weight, semiMetricFunction);
     }
+
+    // ------------------------- Private -------------------------
+	void CGraphDenseExt::addPottsEdgeModel(const Mat &features, float weight, const std::function<void(const Mat& src, Mat& dst)> &semiMetricFunction)
+	{
+		if (!semiMetricFunction)
+			for (auto &edgeModel : m_graph.getEdgeModels()) {
+				auto pPottsModel = std::dynamic_pointer_cast<CEdgeModelPotts>(edgeModel);
+				if (pPottsModel && pPottsModel->merge(features, weight)) return;
+			}
+		m_graph.addEdgeModel(std::make_shared<CEdgeModelPotts>(features, weight, semiMetricFunction));
+	}
 }
@@ -92,6 +92,15 @@ namespace DirectGraphicalModels
         DllExport void addBilateralEdgeModel(const vec_mat_t& featureVectors, Vec2f sigma, float sigma_opt = 1.0f, float weight = 1.0f, const std::function<void(const Mat& src, Mat& dst)>& semiMetricFunction = {});
 
 
+	private:
+		/**
+		* @brief Adds a Potts edge model with the given features
+		* @details If no semi-metric function is given, and the graph already has a Potts edge model with the same features, the weight is added
+		* to that model (ref. @ref CEdgeModelPotts::merge), so that both models share one permutohedral lattice during the inference
+		*/
+		void addPottsEdgeModel(const Mat& features, float weight, const std::function<void(const Mat& src, Mat& dst)>& semiMetricFunction);
+
+
 	private:
         CGraphDense& m_graph;	///< The graph
         Size         m_size;    ///< Size of the 2D graph
@@ -12,50 +12,108 @@ namespace DirectGraphicalModels
 {
 	void CGraphLayeredExt::buildGraph(Size graphSize)
 	{
+		const size_t nNodes = static_cast<size_t>(graphSize.width) * graphSize.height * m_nLayers;
+		
+		// The graph of the same size is re-used with the reset potentials
+		if (m_isGraphReuse && graphSize == m_size && !m_isGroupsChanged && m_graph.getNumNodes() == nNodes && 
+			m_vRowDiagEdges.size() == static_cast<size_t>(m_size.height) + 1 && m_vRowEdges.front() == 0 && m_vRowDiagEdges.back() == m_graph.getNumEdges()) {
+			const byte		nStates		= m_graph.getNumStates();
+			const size_t	nRowNodes	= static_cast<size_t>(m_size.width) * m_nLayers;
+			const vec_float_t vPots(nRowNodes * nStates, 0.0f);
+			for (int y = 0; y < m_size.height; y++)
+				m_graph.setNodes(y * nRowNodes, nRowNodes, vPots.data());
+			if (m_graph.getNumEdges()) m_graph.setEdges(std::nullopt, CTrainEdge::getDefaultEdgePotentials(1.0f, nStates));
+			return;
+		}
+
 		if (m_graph.getNumNodes() != 0) m_graph.reset();
 		m_size = graphSize;
-
-		word l;
+		m_isGroupsChanged = false;
+
+		// The numbers of edges, added for every pixel
+		const size_t nLinkEdges	= ((m_gType & GRAPH_EDGES_LINK) && m_nLayers >= 2) ? m_nLayers : 0;
+		const size_t nArcEdges	= 2 * static_cast<size_t>(m_nLayers);
+		const size_t width		= static_cast<size_t>(m_size.width);
+
+		m_vRowEdges.resize(m_size.height + 1);
+		m_vRowDiagEdges.resize(m_size.height + 1);
+		m_vRowEdges[0] = m_graph.getNumEdges();
+		for (int y = 0; y < m_size.height; y++) {
+			m_vRowEdges[y + 1] = m_vRowEdges[y] + width * nLinkEdges;
+			if (m_gType & GRAPH_EDGES_GRID) m_vRowEdges[y + 1] += (MAX(width, 1) - 1 + (y > 0 ? width : 0)) * nArcEdges;
+		}
+		m_vRowDiagEdges[0] = m_vRowEdges.back();
 		for (int y = 0; y < m_size.height; y++)
+			m_vRowDiagEdges[y + 1] = m_vRowDiagEdges[y] + ((m_gType & GRAPH_EDGES_DIAG) && y > 0 ? 2 * (MAX(width, 1) - 1) * nArcEdges : 0);
+
+		// Nodes
+		m_graph.addNodes(nNodes);
+
+		// Edges: every row is written at its own offsets
+		const size_t nEdges = m_vRowDiagEdges.back() - m_vRowEdges[0];
+		vec_size_t vSrcNodes(nEdges);
+		vec_size_t vDstNodes(nEdges);
+		vec_byte_t vGroups(nEdges);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, m_size.height), [&](const Range& range) {
+#else
+		const Range range(0, m_size.height);
+#endif
+		for (int y = range.start; y < range.end; y++) {
+			size_t e = 0;
+			auto addEdge = [&](size_t srcNode, size_t dstNode, byte group) {
+				vSrcNodes[e] = srcNode;
+				vDstNodes[e] = dstNode;
+				vGroups[e++] = group;
+			};
+			auto addArc = [&](size_t node1, size_t node2, byte group) {
+				addEdge(node1, node2, group);
+				addEdge(node2, node1, group);
+			};
+
+			e = m_vRowEdges[y] - m_vRowEdges[0];
 			for (int x = 0; x < m_size.width; x++) {
-				// Nodes
-				size_t idx = m_graph.addNode();
-				for (l = 1; l < m_nLayers; l++) m_graph.addNode();
+				size_t idx = (y * width + x) * m_nLayers;
 
 				// All links have group_id = 1
 				if (m_gType & GRAPH_EDGES_LINK) {
 					if (m_nLayers >= 2)
-						m_graph.addArc(idx, idx + 1, 1, Mat());
-					for (l = 2; l < m_nLayers; l++)
-						m_graph.addEdge(idx + l - 1, idx + l, 1, Mat());
+						addArc(idx, idx + 1, 1);
+					for (word l = 2; l < m_nLayers; l++)
+						addEdge(idx + l - 1, idx + l, 1);
 				} // if LINK
 
 				if (m_gType & GRAPH_EDGES_GRID) {
 					if (x > 0)
-						for (l = 0; l < m_nLayers; l++)
-							m_graph.addArc(idx + l, idx + l - m_nLayers);
+						for (word l = 0; l < m_nLayers; l++)
+							addArc(idx + l, idx + l - m_nLayers, 0);
 					if (y > 0)
-						for (l = 0; l < m_nLayers; l++)
-							m_graph.addArc(idx + l, idx + l - m_nLayers * m_size.width);
+						for (word l = 0; l < m_nLayers; l++)
+							addArc(idx + l, idx + l - m_nLayers * width, 0);
 				} // if GRID
 			} // x
+			DGM_ASSERT(e == m_vRowEdges[y + 1] - m_vRowEdges[0]);
 
-
-		if (m_gType & GRAPH_EDGES_DIAG) {
-			for (int y = 0; y < m_size.height; y++) {
+			if (m_gType & GRAPH_EDGES_DIAG) {
+				e = m_vRowDiagEdges[y] - m_vRowEdges[0];
 				for (int x = 0; x < m_size.width; x++) {
-					size_t idx = (y * m_size.width + x) * m_nLayers;
+					size_t idx = (y * width + x) * m_nLayers;
 
 					if ((x > 0) && (y > 0))
-						for (l = 0; l < m_nLayers; l++)
-							m_graph.addArc(idx + l, idx + l - m_nLayers * (m_size.width + 1));
+						for (word l = 0; l < m_nLayers; l++)
+							addArc(idx + l, idx + l - m_nLayers * (width + 1), 0);
 
-					if ((x < graphSize.width - 1) && (y > 0))
-						for (l = 0; l < m_nLayers; l++)
-							m_graph.addArc(idx + l, idx + l - m_nLayers * (m_size.width - 1));
+					if ((x < m_size.width - 1) && (y > 0))
+						for (word l = 0; l < m_nLayers; l++)
+							addArc(idx + l, idx + l - m_nLayers * (width - 1), 0);
 				} // x
-			} // y
-		} // if DIAG
+				DGM_ASSERT(e == m_vRowDiagEdges[y + 1] - m_vRowEdges[0]);
+			} // if DIAG
+		} // y
+#ifdef ENABLE_PDP
+		});
+#endif
+		m_graph.addEdges(vSrcNodes, vDstNodes, vGroups);
 	}
 
 	void CGraphLayeredExt::setGraph(const Mat& pots) 
@@ -109,35 +167,41 @@ namespace DirectGraphicalModels
 		if (m_nLayers >= 2) DGM_ASSERT(nStatesOccl);
 		DGM_ASSERT(nStatesBase + nStatesOccl == m_graph.getNumStates());
 
+		const byte	 nStates	 = m_graph.getNumStates();
+		const size_t nRowNodes	 = static_cast<size_t>(m_size.width) * m_nLayers;
+
+		// The rows of the base potentials are the node potentials of the rows of the graph: they are passed to the graph as they are
+		if (m_nLayers == 1 && nStatesBase == nStates) {
+			if (potBase.isContinuous()) m_graph.setNodes(0, m_graph.getNumNodes(), potBase.ptr<float>());
+			else
+				for (int y = 0; y < m_size.height; y++)
+					m_graph.setNodes(y * nRowNodes, nRowNodes, potBase.ptr<float>(y));
+			return;
+		}
+
 #ifdef ENABLE_PDP
 		parallel_for_(Range(0, m_size.height), [&, nStatesBase, nStatesOccl](const Range& range) {
 #else
 		const Range range(0, m_size.height);
 #endif
-		Mat nPotBase(m_graph.getNumStates(), 1, CV_32FC1, Scalar(0.0f));
-		Mat nPotOccl(m_graph.getNumStates(), 1, CV_32FC1, Scalar(0.0f));
-		Mat nPotIntr(m_graph.getNumStates(), 1, CV_32FC1, Scalar(0.0f));
-		for (byte s = 0; s < nStatesOccl; s++)
-			nPotIntr.at<float>(m_graph.getNumStates() - nStatesOccl + s, 0) = 100.0f / nStatesOccl;
+		// The potentials of one row of the graph: nRowNodes x nStates
+		vec_float_t vPots(nRowNodes * nStates, 0.0f);
+		for (int x = 0; x < m_size.width; x++)
+			for (word l = 2; l < m_nLayers; l++)
+				for (byte s = 0; s < nStatesOccl; s++)
+					vPots[(x * m_nLayers + l) * nStates + nStates - nStatesOccl + s] = 100.0f / nStatesOccl;
 		for (int y = range.start; y < range.end; y++) {
 			const float* pPotBase = potBase.ptr<float>(y);
 			const float* pPotOccl = potOccl.empty() ? NULL : potOccl.ptr<float>(y);
 			for (int x = 0; x < m_size.width; x++) {
-				size_t idx = (y * m_size.width + x) * m_nLayers;
-
+				float *pPot = vPots.data() + x * m_nLayers * nStates;
 				for (byte s = 0; s < nStatesBase; s++)
-					nPotBase.at<float>(s, 0) = pPotBase[nStatesBase * x + s];
-				m_graph.setNode(idx, nPotBase);
-
-				if (m_nLayers >= 2) {
+					pPot[s] = pPotBase[nStatesBase * x + s];
+				if (m_nLayers >= 2)
 					for (byte s = 0; s < nStatesOccl; s++)
-						nPotOccl.at<float>(m_graph.getNumStates() - nStatesOccl + s, 0) = pPotOccl[nStatesOccl * x + s];
-					m_graph.setNode(idx + 1, nPotOccl);
-				}
-
-				for (word l = 2; l < m_nLayers; l++)
-					m_graph.setNode(idx + l, nPotIntr);
+						pPot[2 * nStates - nStatesOccl + s] = pPotOccl[nStatesOccl * x + s];
 			} // x
+			m_graph.setNodes(y * nRowNodes, nRowNodes, vPots.data());
 		} // y
 #ifdef ENABLE_PDP	
 		});
@@ -256,63 +320,16 @@ namespace DirectGraphicalModels
 		DGM_ASSERT(nFeatures == edgeTrainer.getNumFeatures());
 		if (linkTrainer) DGM_ASSERT(nFeatures == linkTrainer->getNumFeatures());
 		DGM_ASSERT(m_size.width * m_size.height * m_nLayers == m_graph.getNumNodes());
+		DGM_ASSERT_MSG(m_vRowDiagEdges.size() == static_cast<size_t>(m_size.height) + 1 && m_vRowDiagEdges.back() == m_graph.getNumEdges(), "The graph must be built with buildGraph()");
 
 #ifdef ENABLE_PDP
-		parallel_for_(Range(0, m_size.height), [&, nFeatures](const Range& range) {
-
+		parallel_for_(Range(0, m_size.height), [&](const Range& range) {
 #else 
 		const Range range(0, m_size.height);
 #endif
-		Mat featureVector1(nFeatures, 1, CV_8UC1);
-		Mat featureVector2(nFeatures, 1, CV_8UC1);
-		Mat ePot;
-		word l;
-		for (int y = range.start; y < range.end; y++) {
-			const byte* pFv1 = featureVectors.ptr<byte>(y);
-			const byte* pFv2 = (y > 0) ? featureVectors.ptr<byte>(y - 1) : NULL;
-			for (int x = 0; x < m_size.width; x++) {
-				size_t idx = (y * m_size.width + x) * m_nLayers;
-				for (word f = 0; f < nFeatures; f++) featureVector1.at<byte>(f, 0) = pFv1[nFeatures * x + f];				// featureVectors[x][y]
-
-				if (m_gType & GRAPH_EDGES_LINK) {
-					ePot = linkTrainer->getLinkPotentials(featureVector1, linkWeight);
-					add(ePot, ePot.t(), ePot);
-					if (m_nLayers >= 2)
-						m_graph.setArc(idx, idx + 1, ePot);
-					ePot = CTrainEdge::getDefaultEdgePotentials(100, m_graph.getNumStates());
-					for (l = 2; l < m_nLayers; l++)
-						m_graph.setEdge(idx + l - 1, idx + l, ePot);
-				} // edges_link
-
-				if (m_gType & GRAPH_EDGES_GRID) {
-					if (x > 0) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv1[nFeatures * (x - 1) + f];	// featureVectors[x-1][y]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers, ePot);
-					} // if x
-
-					if (y > 0) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv2[nFeatures * x + f];		// featureVectors[x][y-1]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers * m_size.width, ePot);
-					} // if y
-				} // edges_grid
-
-				if (m_gType & GRAPH_EDGES_DIAG) {
-					if ((x > 0) && (y > 0)) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv2[nFeatures * (x - 1) + f];	// featureVectors[x-1][y-1]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers * m_size.width - m_nLayers, ePot);
-					} // if x, y
-
-					if ((x < m_size.width - 1) && (y > 0)) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv2[nFeatures * (x + 1) + f];	// featureVectors[x+1][y-1]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers * m_size.width + m_nLayers, ePot);
-					} // x, y
-				} // edges_diag
-			} // x
-		} // y
+		vec_float_t vPots;
+		for (int y = range.start; y < range.end; y++)
+			fillEdgesRow(edgeTrainer, linkTrainer, y, featureVectors.ptr<byte>(y), (y > 0) ? featureVectors.ptr<byte>(y - 1) : NULL, vParams, edgeWeight, linkWeight, vPots);
 #ifdef ENABLE_PDP
 		});
 #endif
@@ -328,68 +345,26 @@ namespace DirectGraphicalModels
 		DGM_ASSERT(nFeatures == edgeTrainer.getNumFeatures());
 		if (linkTrainer) DGM_ASSERT(nFeatures == linkTrainer->getNumFeatures());
 		DGM_ASSERT(m_size.width * m_size.height * m_nLayers == m_graph.getNumNodes());
+		DGM_ASSERT_MSG(m_vRowDiagEdges.size() == static_cast<size_t>(m_size.height) + 1 && m_vRowDiagEdges.back() == m_graph.getNumEdges(), "The graph must be built with buildGraph()");
 
 #ifdef ENABLE_PDP
-		parallel_for_(Range(0, m_size.height), [&, nFeatures](const Range& range) {
+		parallel_for_(Range(0, m_size.height), [&](const Range& range) {
 #else 
 		const Range range(0, m_size.height);
 #endif
-		Mat featureVector1(nFeatures, 1, CV_8UC1);
-		Mat featureVector2(nFeatures, 1, CV_8UC1);
-		Mat ePot;
-		word l;
+		vec_float_t vPots;
+		vec_mat_t	vRow(nFeatures);
+		Mat			fv1, fv2;		// The feature vectors of the rows y and y - 1: Mat(size: 1 x width; type: CV_8UC<nFeatures>)
+		auto getRow = [&](int y, Mat &fv) {
+			for (word f = 0; f < nFeatures; f++) vRow[f] = featureVectors[f].row(y);
+			merge(vRow, fv);
+		};
+		
+		if (range.start > 0) getRow(range.start - 1, fv2);
 		for (int y = range.start; y < range.end; y++) {
-			byte const** pFv1 = new const byte * [nFeatures];
-			for (word f = 0; f < nFeatures; f++) pFv1[f] = featureVectors[f].ptr<byte>(y);
-			byte const** pFv2 = NULL;
-			if (y > 0) {
-				pFv2 = new const byte * [nFeatures];
-				for (word f = 0; f < nFeatures; f++) pFv2[f] = featureVectors[f].ptr<byte>(y - 1);
-			}
-
-			for (int x = 0; x < m_size.width; x++) {
-				size_t idx = (y * m_size.width + x) * m_nLayers;
-
-				for (word f = 0; f < nFeatures; f++) featureVector1.at<byte>(f, 0) = pFv1[f][x];				// featureVectors[x][y]
-
-				if (m_gType & GRAPH_EDGES_LINK) {
-					ePot = linkTrainer->getLinkPotentials(featureVector1, linkWeight);
-					add(ePot, ePot.t(), ePot);
-					if (m_nLayers >= 2)
-						m_graph.setArc(idx, idx + 1, ePot);
-					ePot = CTrainEdge::getDefaultEdgePotentials(100, m_graph.getNumStates());
-					for (l = 2; l < m_nLayers; l++)
-						m_graph.setEdge(idx + l - 1, idx + l, ePot);
-				} // edges_link
-
-				if (m_gType & GRAPH_EDGES_GRID) {
-					if (x > 0) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv1[f][x - 1];				// featureVectors[x-1][y]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers, ePot);
-					} // if x
-
-					if (y > 0) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv2[f][x];					// featureVectors[x][y-1]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers * m_size.width, ePot);
-					} // if y
-				} // edges_grid
-
-				if (m_gType & GRAPH_EDGES_DIAG) {
-					if ((x > 0) && (y > 0)) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv2[f][x - 1];				// featureVectors[x-1][y-1]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers * m_size.width - m_nLayers, ePot);
-					} // if x, y
-
-					if ((x < m_size.width - 1) && (y > 0)) {
-						for (word f = 0; f < nFeatures; f++) featureVector2.at<byte>(f, 0) = pFv2[f][x + 1];				// featureVectors[x+1][y-1]
-						ePot = edgeTrainer.getEdgePotentials(featureVector1, featureVector2, vParams, edgeWeight);
-						for (word l = 0; l < m_nLayers; l++) m_graph.setArc(idx + l, idx + l - m_nLayers * m_size.width + m_nLayers, ePot);
-					} // x, y
-				} // edges_diag
-			} // x
+			getRow(y, fv1);
+			fillEdgesRow(edgeTrainer, linkTrainer, y, fv1.ptr<byte>(), (y > 0) ? fv2.ptr<byte>() : NULL, vParams, edgeWeight, linkWeight, vPots);
+			std::swap(fv1, fv2);
 		} // y
 #ifdef ENABLE_PDP
 		}); 
@@ -400,6 +375,7 @@ namespace DirectGraphicalModels
 	{
 		// Assertion
 		DGM_ASSERT_MSG(A != 0 || B != 0, "Wrong arguments");
+		m_isGroupsChanged = true;
 
 #ifdef ENABLE_PDP
 		parallel_for_(Range(0, m_size.height), [&](const Range& range) {
@@ -482,4 +458,105 @@ namespace DirectGraphicalModels
 			m_graph.setEdges(group, Pot);
 		}
 	}
+
+	// ------------------------- Private -------------------------
+	void CGraphLayeredExt::fillEdgesRow(const CTrainEdge &edgeTrainer, const CTrainLink *linkTrainer, int y, const byte *pFv1, const byte *pFv2, const vec_float_t &vParams, float edgeWeight, float linkWeight, vec_float_t &vPots)
+	{
+		const word		nFeatures	= edgeTrainer.getNumFeatures();
+		const byte		nStates		= m_graph.getNumStates();
+		const size_t	size		= static_cast<size_t>(nStates) * nStates;
+		const int		width		= m_size.width;
+		byte		  * pCur		= const_cast<byte *>(pFv1);
+		byte		  * pPrev		= const_cast<byte *>(pFv2);
+
+		// The potentials of all the edges of the row with the same direction: Mat(size: nEdges x nStates^2; type: CV_32FC1)
+		Mat potLeft, potUp, potUpLeft, potUpRight;
+		if ((m_gType & GRAPH_EDGES_GRID) && (width > 1))		// featureVectors[x][y] - featureVectors[x-1][y]
+			edgeTrainer.getEdgePotentials(Mat(width - 1, nFeatures, CV_8UC1, pCur + nFeatures), Mat(width - 1, nFeatures, CV_8UC1, pCur), vParams, edgeWeight, potLeft);
+		if ((m_gType & GRAPH_EDGES_GRID) && (y > 0))			// featureVectors[x][y] - featureVectors[x][y-1]
+			edgeTrainer.getEdgePotentials(Mat(width, nFeatures, CV_8UC1, pCur), Mat(width, nFeatures, CV_8UC1, pPrev), vParams, edgeWeight, potUp);
+		if ((m_gType & GRAPH_EDGES_DIAG) && (width > 1) && (y > 0)) {
+			// featureVectors[x][y] - featureVectors[x-1][y-1]
+			edgeTrainer.getEdgePotentials(Mat(width - 1, nFeatures, CV_8UC1, pCur + nFeatures), Mat(width - 1, nFeatures, CV_8UC1, pPrev), vParams, edgeWeight, potUpLeft);
+			// featureVectors[x][y] - featureVectors[x+1][y-1]
+			edgeTrainer.getEdgePotentials(Mat(width - 1, nFeatures, CV_8UC1, pCur), Mat(width - 1, nFeatures, CV_8UC1, pPrev + nFeatures), vParams, edgeWeight, potUpRight);
+		}
+		// The potential of an arc is shared between its both edges (Ref. IGraphPairwise::setArc())
+		for (Mat *pPot : { &potLeft, &potUp, &potUpLeft, &potUpRight })
+			if (!pPot->empty()) sqrt(*pPot, *pPot);
+
+		// The potentials are written into the row buffer in the order of buildGraph(), or directly to the edges, 
+		// if the graph does not address the edges by their indices in this order
+		const bool isIndexed = m_graph.isEdgeOrderPreserved();
+		float *pDst = NULL;
+		auto addEdge = [&](const float *pPot, size_t srcNode, size_t dstNode) {
+			if (isIndexed) {
+				memcpy(pDst, pPot, size * sizeof(float));
+				pDst += size;
+			}
+			else m_graph.setEdge(srcNode, dstNode, Mat(nStates, nStates, CV_32FC1, const_cast<float *>(pPot)));
+		};
+		// Writes the potentials of the both edges of an arc: the second one is transposed
+		auto addArc = [&](const float *pPot, size_t node1, size_t node2) {
+			if (isIndexed) {
+				for (byte s1 = 0; s1 < nStates; s1++)
+					for (byte s2 = 0; s2 < nStates; s2++) {
+						pDst[s1 * nStates + s2]			= pPot[s1 * nStates + s2];
+						pDst[size + s2 * nStates + s1]	= pPot[s1 * nStates + s2];
+					}
+				pDst += 2 * size;
+			}
+			else {
+				const Mat pot(nStates, nStates, CV_32FC1, const_cast<float *>(pPot));
+				m_graph.setEdge(node1, node2, pot);
+				m_graph.setEdge(node2, node1, pot.t());
+			}
+		};
+
+		// Links and grid edges in the order of buildGraph()
+		vPots.resize(isIndexed ? (m_vRowEdges[y + 1] - m_vRowEdges[y]) * size : 0);
+		pDst = vPots.data();
+		Mat linkPot;
+		const Mat defaultLinkPot = CTrainEdge::getDefaultEdgePotentials(100, nStates);
+		for (int x = 0; x < width; x++) {
+			const size_t idx = (static_cast<size_t>(y) * width + x) * m_nLayers;
+			if (m_gType & GRAPH_EDGES_LINK) {
+				if (m_nLayers >= 2) {
+					linkPot = linkTrainer->getLinkPotentials(Mat(nFeatures, 1, CV_8UC1, pCur + x * nFeatures), linkWeight);
+					add(linkPot, linkPot.t(), linkPot);
+					sqrt(linkPot, linkPot);
+					addArc(linkPot.ptr<float>(), idx, idx + 1);
+				}
+				for (word l = 2; l < m_nLayers; l++)
+					addEdge(defaultLinkPot.ptr<float>(), idx + l - 1, idx + l);
+			} // edges_link
+
+			if (m_gType & GRAPH_EDGES_GRID) {
+				if (x > 0)
+					for (word l = 0; l < m_nLayers; l++) addArc(potLeft.ptr<float>(x - 1), idx + l, idx + l - m_nLayers);
+				if (y > 0)
+					for (word l = 0; l < m_nLayers; l++) addArc(potUp.ptr<float>(x), idx + l, idx + l - m_nLayers * width);
+			} // edges_grid
+		} // x
+		if (isIndexed) {
+			DGM_ASSERT(pDst == vPots.data() + vPots.size());
+			m_graph.setEdges(m_vRowEdges[y], m_vRowEdges[y + 1] - m_vRowEdges[y], vPots.data());
+		}
+
+		// Diagonal edges in the order of buildGraph()
+		if (m_vRowDiagEdges[y + 1] == m_vRowDiagEdges[y]) return;
+		vPots.resize(isIndexed ? (m_vRowDiagEdges[y + 1] - m_vRowDiagEdges[y]) * size : 0);
+		pDst = vPots.data();
+		for (int x = 0; x < width; x++) {
+			const size_t idx = (static_cast<size_t>(y) * width + x) * m_nLayers;
+			if (x > 0)
+				for (word l = 0; l < m_nLayers; l++) addArc(potUpLeft.ptr<float>(x - 1), idx + l, idx + l - m_nLayers * (width + 1));
+			if (x < width - 1)
+				for (word l = 0; l < m_nLayers; l++) addArc(potUpRight.ptr<float>(x), idx + l, idx + l - m_nLayers * (width - 1));
+		} // x
+		if (isIndexed) {
+			DGM_ASSERT(pDst == vPots.data() + vPots.size());
+			m_graph.setEdges(m_vRowDiagEdges[y], m_vRowDiagEdges[y + 1] - m_vRowDiagEdges[y], vPots.data());
+		}
+	}
 }
@@ -46,10 +46,30 @@ namespace DirectGraphicalModels
         /**
         * @brief Builds a 2D graph of size corresponding to the image resolution
 		* @details All edges in graph will have group id 0 except the edges connecting different layers (links), which will have group id 1.
-		* When called multiple times, previouse graph structure is always replaced.
+		* The numbers of nodes and edges are derived from the graph size in advance: the nodes are added with CGraph::addNodes() and the edges 
+		* are generated in parallel row blocks and added with one call of IGraphPairwise::addEdges().
+		*
+		* When called multiple times, previouse graph structure is replaced. If the reuse is enabled with enableGraphReuse() and the graph has already 
+		* been built by this function with the same \b graphSize (\a e.g. for the consecutive frames of a video), the structure is reused and only 
+		* the potentials are reset: the node potentials to zeros and the edge potentials to the neutral (all ones) ones.
+		* > This function supports PPL
         * @param graphSize The size of the graph (image resolution)
         */
 		DllExport void buildGraph(Size graphSize) override;
+		/**
+		* @brief Enables reusing the graph of the same size in buildGraph()
+		* @details The reuse skips the rebuilding of the graph structure. Only the changes made with defineEdgeGroup() are tracked, thus the structure
+		* and the groups of the edges must not be changed directly in the graph, \a e.g. with IGraphPairwise::setEdgeGroup() or IGraphPairwise::removeEdge(),
+		* while the reuse is enabled.
+		* @param enable Flag indicating whether the graph should be reused
+		*/
+		DllExport void enableGraphReuse(bool enable = true) { m_isGraphReuse = enable; }
+		/**
+		* @brief Checks whether reusing the graph of the same size is enabled
+		* @retval true if the reuse is enabled
+		* @retval false otherwise
+		*/
+		DllExport bool isGraphReuseEnabled(void) const { return m_isGraphReuse; }
 		DllExport void setGraph(const Mat& pots) override;
         /**
 		* @brief Adds default data-independet edge model
@@ -108,7 +128,8 @@ namespace DirectGraphicalModels
 		/**
 		* @brief Fills the graph edges with potentials
 		* @details This function uses \b edgeTrainer class in oerder to achieve edge potentials from feature vectors, stored in \b featureVectors
-		* and fills with them the graph edges
+		* and fills with them the graph edges. The potentials of every image row are calculated at once and written directly to the edges,
+		* which are addressed by their indices, thus the graph must be built with buildGraph() beforehand.
 		* > This function supports PPL
 		* @param edgeTrainer A pointer to the edge trainer
 		* @param linkTrainer A pointer to tht link (inter-layer edge) trainer
@@ -121,7 +142,8 @@ namespace DirectGraphicalModels
 		/**
 		* @brief Fills the graph edges with potentials
 		* @details This function uses \b edgeTrainer class in oerder to achieve edge potentials from feature vectors, stored in \b featureVectors
-		* and fills with them the graph edges
+		* and fills with them the graph edges. The potentials of every image row are calculated at once and written directly to the edges,
+		* which are addressed by their indices, thus the graph must be built with buildGraph() beforehand.
 		* > This function supports PPL
 		* @param edgeTrainer A pointer to the edge trainer
 		* @param linkTrainer A pointer to tht link (inter-layer edge) trainer
@@ -134,6 +156,7 @@ namespace DirectGraphicalModels
 		/**
 		* @brief Assign the edges, which cross the given line to the grop \b group.
 		* @details The line is given by the equation: <b>A</b>x + <b>B</b>y + <b>C</b> = 0. \b A and \b B are not both equal to zero.
+		* The next call of buildGraph() rebuilds the graph with the default groups.
 		* @param A Constant line parameter
 		* @param B Constant line parameter
 		* @param C Constant line parameter
@@ -159,9 +182,32 @@ namespace DirectGraphicalModels
 
 
 	private:
-		IGraphPairwise&	m_graph;		///< The graph
-		const word		m_nLayers;		///< Number of layers
-		const byte		m_gType;		///< Graph type (Ref. @ref graphEdgesType)
-		Size			m_size;			///< Size of the graph
+		/**
+		* @brief Fills the edges of one row of the graph with potentials
+		* @details The potentials of all the edges of the row, having the same direction, are calculated at once with CTrainEdge::getEdgePotentials(), 
+		* arranged in the order in which buildGraph() added the edges, and written to the graph with IGraphPairwise::setEdges(). If the graph does not
+		* preserve the order of the edges (Ref. IGraphPairwise::isEdgeOrderPreserved()), every edge is set with IGraphPairwise::setEdge() instead.
+		* @param edgeTrainer The edge trainer
+		* @param linkTrainer A pointer to the link (inter-layer edge) trainer
+		* @param y The index of the row
+		* @param pFv1 The feature vectors of the row \b y: \a width x nFeatures values
+		* @param pFv2 The feature vectors of the row \b y - 1: \a width x nFeatures values; NULL if \b y = 0
+		* @param vParams Array of control parameters
+		* @param edgeWeight The weighting parameter for (within-layer) edges
+		* @param linkWeight The weighting parameter for (inter-layer) edges, \a i.e. links
+		* @param vPots Auxiliary buffer for the potentials of the row
+		*/
+		void fillEdgesRow(const CTrainEdge &edgeTrainer, const CTrainLink *linkTrainer, int y, const byte *pFv1, const byte *pFv2, const vec_float_t &vParams, float edgeWeight, float linkWeight, vec_float_t &vPots);
+
+
+	private:
+		IGraphPairwise&	m_graph;			///< The graph
+		const word		m_nLayers;			///< Number of layers
+		const byte		m_gType;			///< Graph type (Ref. @ref graphEdgesType)
+		Size			m_size;				///< Size of the graph
+		vec_size_t		m_vRowEdges;		///< Indices of the first links and grid edges of every row (and the total number of them), added by buildGraph()
+		vec_size_t		m_vRowDiagEdges;	///< Indices of the first diagonal edges of every row (and the total number of edges), added by buildGraph()
+		bool			m_isGroupsChanged = false;	///< Flag indicating whether the edge groups were changed with defineEdgeGroup() after buildGraph()
+		bool			m_isGraphReuse = false;		///< Flag indicating whether the graph of the same size is reused by buildGraph()
 	};
 }
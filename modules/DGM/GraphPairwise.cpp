@@ -3,11 +3,30 @@
 
 namespace DirectGraphicalModels
 {
+	namespace {
+		const size_t EMPTY_SLOT		= std::numeric_limits<size_t>::max();		// The slot of the edge lookup index is free
+		const size_t REMOVED_SLOT	= EMPTY_SLOT - 1;							// The slot of the edge lookup index was occupied by a removed edge
+
+		// Hash of the pair of nodes: the finalizer of the 64-bit MurmurHash3
+		inline size_t hashEdge(size_t srcNode, size_t dstNode)
+		{
+			uint64_t h = static_cast<uint64_t>(srcNode) * 0x9E3779B97F4A7C15ULL ^ static_cast<uint64_t>(dstNode);
+			h ^= h >> 33;
+			h *= 0xFF51AFD7ED558CCDULL;
+			h ^= h >> 33;
+			h *= 0xC4CEB9FE1A85EC53ULL;
+			h ^= h >> 33;
+			return static_cast<size_t>(h);
+		}
+	}
+
 	void CGraphPairwise::reset(void)
 	{
 		m_vNodes.clear();
 		m_vEdges.clear();
+		m_vEdgePotentials.clear();
 		m_IDx = 0;
+		if (m_isEdgeIndex) buildEdgeIndex(0);
 	}
 
 	// Add a new node to the graph with specified potentional
@@ -17,14 +36,52 @@ namespace DirectGraphicalModels
 		return m_IDx++;
 	}
 
+	// All the nodes are allocated at once
+	void CGraphPairwise::addNodes(size_t nNodes)
+	{
+		const size_t start_node = m_vNodes.size();
+		m_vNodes.resize(start_node + nNodes);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(nNodes)), [&](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(nNodes));
+#endif
+		for (int n = range.start; n < range.end; n++)
+			m_vNodes[start_node + n] = ptr_node_t(new Node(m_IDx + n));
+#ifdef ENABLE_PDP
+		});
+#endif
+		m_IDx += nNodes;
+	}
+
 	// Set or change the potential of node idx
 	void CGraphPairwise::setNode(size_t node, const Mat &pot)
 	{
 		DGM_ASSERT_MSG(node < m_vNodes.size(), "Node %zu is out of range %zu", node, m_vNodes.size());
 		DGM_ASSERT_MSG((pot.cols == 1) && (pot.rows == getNumStates()), "Potential size (%d x %d) does not match (%d x %d)", pot.cols, pot.rows, 1, getNumStates());
 
-		if (!m_vNodes[node]->Pot.empty()) m_vNodes[node]->Pot.release();
-		pot.copyTo(m_vNodes[node]->Pot);
+		pot.copyTo(m_vNodes[node]->Pot);						// re-uses the buffer of the node, if it has the same size and type
+	}
+
+	void CGraphPairwise::setNodes(size_t start_node, size_t num_nodes, const float *pots, size_t step)
+	{
+		const byte nStates = getNumStates();
+		if (!step) step = nStates;
+		DGM_ASSERT_MSG(start_node + num_nodes <= m_vNodes.size(), "The given ranges exceed the number of nodes(%zu)", m_vNodes.size());
+
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(num_nodes)), [&, nStates, step](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(num_nodes));
+#endif
+		for (int n = range.start; n < range.end; n++) {
+			Mat &pot = m_vNodes[start_node + n]->Pot;
+			pot.create(nStates, 1, CV_32FC1);						// allocates only the nodes, which were not set yet
+			memcpy(pot.ptr<float>(), pots + n * step, nStates * sizeof(float));
+		}
+#ifdef ENABLE_PDP
+		});
+#endif
 	}
 
 	// Return node potential vector 
@@ -35,6 +92,19 @@ namespace DirectGraphicalModels
 		m_vNodes[node]->Pot.copyTo(pot);
 	}
 
+	void CGraphPairwise::getNodes(size_t start_node, size_t num_nodes, float *pots, size_t step) const
+	{
+		const byte nStates = getNumStates();
+		if (!step) step = nStates;
+		DGM_ASSERT_MSG(start_node + num_nodes <= m_vNodes.size(), "The given ranges exceed the number of nodes(%zu)", m_vNodes.size());
+
+		for (size_t n = 0; n < num_nodes; n++) {
+			const Mat &pot = m_vNodes[start_node + n]->Pot;
+			DGM_ASSERT_MSG(!pot.empty(), "Specified node %zu is not set", start_node + n);
+			memcpy(pots + n * step, pot.ptr<float>(), nStates * sizeof(float));
+		}
+	}
+
 	// Return child nodes ID's
 	void CGraphPairwise::getChildNodes(size_t node, vec_size_t &vNodes) const
 	{
@@ -59,16 +129,72 @@ namespace DirectGraphicalModels
 		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
 
 		// Check if the edge exists
-		if (m_vNodes[srcNode]->to.size() < m_vNodes[dstNode]->from.size())
-			for (size_t &e : m_vNodes[srcNode]->to) { DGM_ASSERT(m_vEdges[e]->node2 != dstNode); }
-		else
-			for (size_t &e : m_vNodes[dstNode]->from) { DGM_ASSERT(m_vEdges[e]->node1 != srcNode); }
+		DGM_ASSERT_MSG(!findEdge(srcNode, dstNode), "The edge (%zu)->(%zu) already exists", srcNode, dstNode);
 
 		// Else: create a new one
+		// The index grows before the edge is linked, since growing re-indexes all the linked edges
+		if (m_isEdgeIndex && 2 * (m_nEdgeIndexSlots + 1) > m_vEdgeIndex.size()) buildEdgeIndex(m_nEdgeIndexSlots + 1);
 		size_t e = m_vEdges.size();
 		m_vEdges.push_back(ptr_edge_t(new Edge(srcNode, dstNode, group, pot)));
 		m_vNodes[srcNode]->to.push_back(e);
 		m_vNodes[dstNode]->from.push_back(e);
+		if (m_isEdgeIndex) indexEdge(e);
+	}
+
+	// Add new (directed) edges to the graph without checking whether they exist
+	void CGraphPairwise::addEdges(const vec_size_t &srcNodes, const vec_size_t &dstNodes, const vec_byte_t &groups)
+	{
+		DGM_ASSERT_MSG(srcNodes.size() == dstNodes.size(), "The number of source nodes (%zu) does not correspond to the number of destination nodes (%zu)", srcNodes.size(), dstNodes.size());
+		DGM_ASSERT_MSG(srcNodes.size() == groups.size(), "The number of edges (%zu) does not correspond to the number of groups (%zu)", srcNodes.size(), groups.size());
+
+		const size_t nNodes		= m_vNodes.size();
+		const size_t nEdges		= srcNodes.size();
+		const size_t start_edge = m_vEdges.size();
+
+		// The number of the new outgoing and incoming edges of every node
+		vec_size_t vTo(nNodes, 0);
+		vec_size_t vFrom(nNodes, 0);
+		for (size_t i = 0; i < nEdges; i++) {
+			DGM_ASSERT_MSG(srcNodes[i] < nNodes, "The source node index %zu is out of range %zu", srcNodes[i], nNodes);
+			DGM_ASSERT_MSG(dstNodes[i] < nNodes, "The destination node index %zu is out of range %zu", dstNodes[i], nNodes);
+			vTo[srcNodes[i]]++;
+			vFrom[dstNodes[i]]++;
+		}
+
+		// The edges and the adjacency lists are allocated at once
+		m_vEdges.resize(start_edge + nEdges);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(nEdges)), [&](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(nEdges));
+#endif
+		for (int i = range.start; i < range.end; i++)
+			m_vEdges[start_edge + i] = ptr_edge_t(new Edge(srcNodes[i], dstNodes[i], groups[i]));
+#ifdef ENABLE_PDP
+		});
+		parallel_for_(Range(0, static_cast<int>(nNodes)), [&](const Range &nodeRange) {
+#else
+		const Range nodeRange(0, static_cast<int>(nNodes));
+#endif
+		for (int n = nodeRange.start; n < nodeRange.end; n++) {
+			if (vTo[n])		m_vNodes[n]->to.reserve(m_vNodes[n]->to.size() + vTo[n]);
+			if (vFrom[n])	m_vNodes[n]->from.reserve(m_vNodes[n]->from.size() + vFrom[n]);
+		}
+#ifdef ENABLE_PDP
+		});
+#endif
+		
+		if (m_isEdgeIndex && 2 * (m_nEdgeIndexSlots + nEdges) > m_vEdgeIndex.size()) buildEdgeIndex(m_nEdgeIndexSlots + nEdges);
+		for (size_t e = start_edge; e < start_edge + nEdges; e++) {
+			const size_t srcNode = m_vEdges[e]->node1;
+			const size_t dstNode = m_vEdges[e]->node2;
+#ifdef DEBUG_MODE
+			DGM_ASSERT_MSG(!findEdge(srcNode, dstNode), "The edge (%zu)->(%zu) already exists", srcNode, dstNode);
+#endif
+			m_vNodes[srcNode]->to.push_back(e);
+			m_vNodes[dstNode]->from.push_back(e);
+			if (m_isEdgeIndex) indexEdge(e);
+		} // e
 	}
 
 	// Set or change the potentional of an directed edge
@@ -77,42 +203,72 @@ namespace DirectGraphicalModels
 		DGM_ASSERT_MSG(srcNode < m_vNodes.size(), "The source node index %zu is out of range %zu", srcNode, m_vNodes.size());
 		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
 
-		vec_size_t::const_iterator e_t = std::find_if(m_vNodes[srcNode]->to.cbegin(), m_vNodes[srcNode]->to.cend(), [&](size_t e) { return (m_vEdges[e]->node2 == dstNode); });
-		DGM_ASSERT_MSG(e_t != m_vNodes[srcNode]->to.end(), "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
 
-		pot.copyTo(m_vEdges[*e_t]->Pot);
+		Mat &edgePot = m_vEdges[e.value()]->Pot;
+		if (!edgePot.empty() && edgePot.u->refcount > 1) edgePot.release();		// the edge references a shared table: detach it
+		pot.copyTo(edgePot);
 	}
 
+	// All the edges of the group reference one copy of the potential
 	void CGraphPairwise::setEdges(std::optional<byte> group, const Mat& pot)
 	{
+		DGM_ASSERT_MSG((pot.cols == getNumStates()) && (pot.rows == getNumStates()), "Potential size (%d x %d) does not match (%d x %d)", pot.cols, pot.rows, getNumStates(), getNumStates());
+		const Mat sharedPot = pot.clone();
 #ifdef ENABLE_PDP
-		parallel_for_(Range(0, static_cast<int>(m_vEdges.size())), [group, &pot, this](const Range& range) {
+		parallel_for_(Range(0, static_cast<int>(m_vEdges.size())), [group, &sharedPot, this](const Range& range) {
 			for (int i = range.start; i < range.end; i++) {
 				ptr_edge_t& pEdge = m_vEdges[i];
 				if (!group || pEdge->group_id == group.value())
-					pot.copyTo(pEdge->Pot);
+					pEdge->Pot = sharedPot;
 			}
 		});
 #else 			
 		for (ptr_edge_t& pEdge : m_vEdges) {
 			if(!group || pEdge->group_id == group.value())
-					pot.copyTo(pEdge->Pot);	
+					pEdge->Pot = sharedPot;	
 		}
 #endif
 	}
 
+	void CGraphPairwise::setEdges(size_t start_edge, size_t num_edges, const float *pots)
+	{
+		DGM_ASSERT_MSG(start_edge + num_edges <= m_vEdges.size(), "The given ranges exceed the number of edges(%zu)", m_vEdges.size());
+
+		const int nStates = getNumStates();
+		for (size_t e = 0; e < num_edges; e++) {
+			Mat &edgePot = m_vEdges[start_edge + e]->Pot;
+			if (!edgePot.empty() && edgePot.u->refcount > 1) edgePot.release();		// the edge references a shared table: detach it
+			edgePot.create(nStates, nStates, CV_32FC1);
+			memcpy(edgePot.data, pots + e * nStates * nStates, nStates * nStates * sizeof(float));
+		}
+	}
+
+	void CGraphPairwise::setEdgePotential(size_t srcNode, size_t dstNode, size_t potId)
+	{
+		DGM_ASSERT_MSG(srcNode < m_vNodes.size(), "The source node index %zu is out of range %zu", srcNode, m_vNodes.size());
+		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
+		DGM_ASSERT_MSG(potId < m_vEdgePotentials.size(), "The edge potential table %zu is out of range %zu", potId, m_vEdgePotentials.size());
+
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+
+		m_vEdges[e.value()]->Pot = m_vEdgePotentials[potId];
+	}
+
 	// Return edge potential matrix
 	void CGraphPairwise::getEdge(size_t srcNode, size_t dstNode, Mat &pot) const
 	{
 		DGM_ASSERT_MSG(srcNode < m_vNodes.size(), "The source node index %zu is out of range %zu", srcNode, m_vNodes.size());
 		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
 
-		vec_size_t::const_iterator e_t = std::find_if(m_vNodes[srcNode]->to.cbegin(), m_vNodes[srcNode]->to.cend(), [&](size_t e) { return (m_vEdges[e]->node2 == dstNode); });
-		DGM_ASSERT_MSG(e_t != m_vNodes[srcNode]->to.end(), "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
-		if (m_vEdges[*e_t]->Pot.empty()) {
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		if (m_vEdges[e.value()]->Pot.empty()) {
  			DGM_WARNING("Edge Potential is empty");
 			if (!pot.empty()) pot.release();
-		} else m_vEdges[*e_t]->Pot.copyTo(pot);
+		} else m_vEdges[e.value()]->Pot.copyTo(pot);
 	}
 
 	void CGraphPairwise::setEdgeGroup(size_t srcNode, size_t dstNode, byte group)
@@ -120,9 +276,9 @@ namespace DirectGraphicalModels
 		DGM_ASSERT_MSG(srcNode < m_vNodes.size(), "The source node index %zu is out of range %zu", srcNode, m_vNodes.size());
 		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
 
-		vec_size_t::const_iterator e_t = std::find_if(m_vNodes[srcNode]->to.cbegin(), m_vNodes[srcNode]->to.cend(), [&](size_t e) { return (m_vEdges[e]->node2 == dstNode); });
-		DGM_ASSERT_MSG(e_t != m_vNodes[srcNode]->to.end(), "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
-		m_vEdges[*e_t]->group_id = group;
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		m_vEdges[e.value()]->group_id = group;
 	}
 
 	byte CGraphPairwise::getEdgeGroup(size_t srcNode, size_t dstNode) const
@@ -130,10 +286,10 @@ namespace DirectGraphicalModels
 		DGM_ASSERT_MSG(srcNode < m_vNodes.size(), "The source node index %zu is out of range %zu", srcNode, m_vNodes.size());
 		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
 
-		vec_size_t::const_iterator e_t = std::find_if(m_vNodes[srcNode]->to.cbegin(), m_vNodes[srcNode]->to.cend(), [&](size_t e) { return (m_vEdges[e]->node2 == dstNode); });
-		DGM_ASSERT_MSG(e_t != m_vNodes[srcNode]->to.end(), "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
 
-		return m_vEdges[*e_t]->group_id;
+		return m_vEdges[e.value()]->group_id;
 	}
 
 	void CGraphPairwise::removeEdge(size_t srcNode, size_t dstNode)
@@ -141,11 +297,10 @@ namespace DirectGraphicalModels
 		DGM_ASSERT_MSG(srcNode < m_vNodes.size(), "The source node index %zu is out of range %zu", srcNode, m_vNodes.size());
 		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
 
-		vec_size_t::const_iterator e_t = std::find_if(m_vNodes[srcNode]->to.cbegin(), m_vNodes[srcNode]->to.cend(), [&](size_t e) { return (m_vEdges[e]->node2 == dstNode); });
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
 
-		DGM_ASSERT_MSG(e_t != m_vNodes[srcNode]->to.end(), "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
-
-		removeEdge(*e_t);
+		removeEdge(e.value());
 	}
 
 	bool CGraphPairwise::isEdgeExists(size_t srcNode, size_t dstNode) const
@@ -153,10 +308,17 @@ namespace DirectGraphicalModels
 		DGM_ASSERT_MSG(srcNode < m_vNodes.size(), "The source node index %zu is out of range %zu", srcNode, m_vNodes.size());
 		DGM_ASSERT_MSG(dstNode < m_vNodes.size(), "The destination node index %zu is out of range %zu", dstNode, m_vNodes.size());
 		
-		auto e_t = std::find_if(m_vNodes[srcNode]->to.cbegin(), m_vNodes[srcNode]->to.cend(), [&](size_t e) { return (m_vEdges[e]->node2 == dstNode); });
+		return findEdge(srcNode, dstNode).has_value();
+	}
 
-		if (e_t == m_vNodes[srcNode]->to.cend()) return false;
-		else									 return true;
+	void CGraphPairwise::enableEdgeIndex(bool enable)
+	{
+		m_isEdgeIndex = enable;
+		if (enable) buildEdgeIndex(m_vEdges.size());
+		else {
+			vec_size_t().swap(m_vEdgeIndex);
+			m_nEdgeIndexSlots = 0;
+		}
 	}
 
 
@@ -169,6 +331,7 @@ namespace DirectGraphicalModels
 		size_t srcNode = m_vEdges[edge]->node1;
 		size_t dstNode = m_vEdges[edge]->node2;
 
+		if (m_isEdgeIndex) unindexEdge(edge);
 		m_vEdges[edge]->Pot.release();
 		//m_vEdges.erase(m_vEdges.begin() + edge);
 		
@@ -180,5 +343,59 @@ namespace DirectGraphicalModels
 		DGM_ASSERT(e_f != m_vNodes[dstNode]->from.cend());
 		m_vNodes[dstNode]->from.erase(e_f);
 	}
-}
 
+	std::optional<size_t> CGraphPairwise::findEdge(size_t srcNode, size_t dstNode) const
+	{
+		if (m_isEdgeIndex) {
+			const size_t mask = m_vEdgeIndex.size() - 1;
+			for (size_t i = hashEdge(srcNode, dstNode) & mask; m_vEdgeIndex[i] != EMPTY_SLOT; i = (i + 1) & mask) {
+				const size_t e = m_vEdgeIndex[i];
+				if (e != REMOVED_SLOT && m_vEdges[e]->node1 == srcNode && m_vEdges[e]->node2 == dstNode) return e;
+			}
+			return std::nullopt;
+		}
+
+		// Linear search over the shorter adjacency list
+		const vec_size_t &vTo	= m_vNodes[srcNode]->to;
+		const vec_size_t &vFrom	= m_vNodes[dstNode]->from;
+		if (vTo.size() <= vFrom.size()) {
+			for (size_t e : vTo) if (m_vEdges[e]->node2 == dstNode) return e;
+		} 
+		else
+			for (size_t e : vFrom) if (m_vEdges[e]->node1 == srcNode) return e;
+		return std::nullopt;
+	}
+
+	// The index has at least 4 slots per edge, thus it is filled by not more than a half before it grows again
+	void CGraphPairwise::buildEdgeIndex(size_t nEdges)
+	{
+		size_t size = 16;
+		while (size < 4 * nEdges) size <<= 1;
+		m_vEdgeIndex.assign(size, EMPTY_SLOT);
+		m_nEdgeIndexSlots = 0;
+		for (const ptr_node_t &node : m_vNodes)
+			for (size_t e : node->to) indexEdge(e);
+	}
+
+	void CGraphPairwise::indexEdge(size_t edge)
+	{
+		DGM_ASSERT_MSG(2 * (m_nEdgeIndexSlots + 1) <= m_vEdgeIndex.size(), "The edge index is full");
+
+		const size_t mask = m_vEdgeIndex.size() - 1;
+		size_t i = hashEdge(m_vEdges[edge]->node1, m_vEdges[edge]->node2) & mask;
+		while (m_vEdgeIndex[i] != EMPTY_SLOT && m_vEdgeIndex[i] != REMOVED_SLOT) i = (i + 1) & mask;
+		if (m_vEdgeIndex[i] == EMPTY_SLOT) m_nEdgeIndexSlots++;
+		m_vEdgeIndex[i] = edge;
+	}
+
+	void CGraphPairwise::unindexEdge(size_t edge)
+	{
+		const size_t mask = m_vEdgeIndex.size() - 1;
+		size_t i = hashEdge(m_vEdges[edge]->node1, m_vEdges[edge]->node2) & mask;
+		while (m_vEdgeIndex[i] != edge) {
+			DGM_ASSERT(m_vEdgeIndex[i] != EMPTY_SLOT);
+			i = (i + 1) & mask;
+		}
+		m_vEdgeIndex[i] = REMOVED_SLOT;
+	}
+}
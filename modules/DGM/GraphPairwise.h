@@ -32,7 +32,7 @@ namespace DirectGraphicalModels
 	struct Edge {
 		size_t	  node1;		///< First (source) node in edge
 		size_t	  node2;		///< Second (destination) node in edge
-		Mat		  Pot;			///< The edge potentials: Mat(size: nStates x nStates; type: CV_32FC1)
+		Mat		  Pot;			///< The edge potentials: Mat(size: nStates x nStates; type: CV_32FC1). May share the data with other edges (see IGraphPairwise::setEdges())
 		byte	  group_id;		///< ID of the group, to which the edge belongs
 
 		Edge(void) = delete;
@@ -50,11 +50,6 @@ namespace DirectGraphicalModels
 	class CGraphPairwise : public IGraphPairwise
 	{
 		friend class CMessagePassing;
-		friend class CInferChain;
-		friend class CInferTree;
-		friend class CInferLBP;
-		friend class CInferViterbi;
-		friend class CInferTRW;
 
         
 	public:
@@ -62,14 +57,20 @@ namespace DirectGraphicalModels
 		* @brief Constructor
 		* @param nStates the number of States (classes)
 		*/
-		DllExport CGraphPairwise(byte nStates) : IGraphPairwise(nStates), m_IDx(0) {}
+		DllExport CGraphPairwise(byte nStates) : IGraphPairwise(nStates), m_IDx(0), m_isEdgeIndex(false), m_nEdgeIndexSlots(0) {}
         DllExport virtual ~CGraphPairwise(void) = default;
 
 		// CGraph
 		DllExport void		reset(void) override;
 		DllExport size_t	addNode		  (const Mat &pot = EmptyMat) override;
+		using CGraph::addNodes;
+		DllExport void		addNodes	  (size_t nNodes) override;
 		DllExport void		setNode       (size_t node, const Mat &pot) override;
+		using CGraph::setNodes;
+		DllExport void		setNodes      (size_t start_node, size_t num_nodes, const float *pots, size_t step = 0) override;
 		DllExport void		getNode       (size_t node, Mat &pot) const override;
+		using CGraph::getNodes;
+		DllExport void		getNodes      (size_t start_node, size_t num_nodes, float *pots, size_t step = 0) const override;
 		DllExport void		getChildNodes (size_t node, vec_size_t &vNodes) const override;
 		DllExport void		getParentNodes(size_t node, vec_size_t &vNodes) const override;
 		DllExport size_t	getNumNodes(void) const override { return m_vNodes.size(); }
@@ -78,14 +79,36 @@ namespace DirectGraphicalModels
 //     DllExport virtual void      marginalize(const vec_size_t &nodes);
 		
 		DllExport void		addEdge		(size_t srcNode, size_t dstNode, byte group, const Mat &pot) override;
+		using IGraphPairwise::addEdges;
+		DllExport void		addEdges	(const vec_size_t &srcNodes, const vec_size_t &dstNodes, const vec_byte_t &groups) override;
 		DllExport void		setEdge		(size_t srcNode, size_t dstNode, const Mat &pot) override;
 		DllExport void		setEdges	(std::optional<byte> group, const Mat& pot) override;
+		DllExport void		setEdges	(size_t start_edge, size_t num_edges, const float *pots) override;
+		DllExport bool		isEdgeOrderPreserved(void) const override { return true; }
+		DllExport void		setEdgePotential(size_t srcNode, size_t dstNode, size_t potId) override;
 		DllExport void		getEdge		(size_t srcNode, size_t dstNode, Mat &pot) const override;
 		DllExport void		setEdgeGroup(size_t srcNode, size_t dstNode, byte group) override;
 		DllExport byte		getEdgeGroup(size_t srcNode, size_t dstNode) const override;
 		DllExport void		removeEdge	(size_t srcNode, size_t dstNode) override;
 		DllExport bool		isEdgeExists(size_t srcNode, size_t dstNode) const override;
 
+		/**
+		* @brief Enables or disables the edge lookup index
+		* @details By default, the functions, which address an edge by its nodes, \a e.g. setEdge(), getEdge(), setArc() or the duplicate check in addEdge(),
+		* search the edge among the outgoing edges of the source node (or the incoming edges of the destination node). With the index enabled,
+		* the edges are found in a hash table with open addressing, keyed by the pair of nodes, in constant time. The index is kept consistent 
+		* with addEdge(), addEdges() and removeEdge() and takes approximately 16 - 32 bytes per edge.
+		* > Enable the index for the graphs with nodes of a high degree, or when the edges are accessed by their nodes many times
+		* @param enable Flag indicating whether the index should be used
+		*/
+		DllExport void		enableEdgeIndex(bool enable = true);
+		/**
+		* @brief Checks whether the edge lookup index is enabled
+		* @retval true if the index is used
+		* @retval false otherwise
+		*/
+		DllExport bool		isEdgeIndexEnabled(void) const { return m_isEdgeIndex; }
+
 #ifdef DEBUG_MODE
 		/**
 		* @brief Returns the edge container
@@ -101,12 +124,38 @@ namespace DirectGraphicalModels
 		* @param edge index of the edge
 		*/
 		DllExport void				removeEdge(size_t edge);
+		/**
+		* @brief Returns the index of the directed edge
+		* @param srcNode index of the source node
+		* @param dstNode index of the destination node
+		* @return The edge index if the edge exists, std::nullopt otherwise
+		*/
+		std::optional<size_t>		findEdge(size_t srcNode, size_t dstNode) const;
+		/**
+		* @brief Rebuilds the edge lookup index with all the edges of the graph
+		* @param nEdges The number of edges, which the index should hold without growing
+		*/
+		void						buildEdgeIndex(size_t nEdges);
+		/**
+		* @brief Adds the edge to the edge lookup index
+		* @details The index must have a free slot for the edge: it is grown with buildEdgeIndex() before the edge is linked to its nodes
+		* @param edge index of the edge
+		*/
+		void						indexEdge(size_t edge);
+		/**
+		* @brief Removes the edge from the edge lookup index
+		* @param edge index of the edge
+		*/
+		void						unindexEdge(size_t edge);
 
 
 	private:
-		size_t		m_IDx;			// = 0;	Primary Key
-		vec_node_t	m_vNodes;		// Nodes container
-		vec_edge_t	m_vEdges;		// Edges container
+		size_t		m_IDx;				// = 0;	Primary Key
+		vec_node_t	m_vNodes;			// Nodes container
+		vec_edge_t	m_vEdges;			// Edges container
+		bool		m_isEdgeIndex;		// = false; Flag indicating whether the edge lookup index is used
+		vec_size_t	m_vEdgeIndex;		// Edge lookup index: hash table of the edge indices with linear probing; its size is a power of 2
+		size_t		m_nEdgeIndexSlots;	// = 0; Number of the occupied (by the edges or by the removed edges) slots of the index
 	};
 }
 
@@ -0,0 +1,376 @@
+#include "GraphPairwiseCSR.h"
+#include "macroses.h"
+#include <numeric>
+#include <unordered_map>
+
+namespace DirectGraphicalModels
+{
+	void CGraphPairwiseCSR::reset(void)
+	{
+		m_vNodePot.clear();
+		m_vEdgePot.clear();
+		m_vpEdgeTable.clear();
+		m_vSharedPot.clear();
+		m_vEdgePotentials.clear();
+		m_vSrc.clear();
+		m_vDst.clear();
+		m_vGroup.clear();
+		m_vFlags.clear();
+		m_isCompact = false;
+		m_isEdgeArena = false;
+	}
+
+	// Add a new node to the graph with specified potentional
+	size_t CGraphPairwiseCSR::addNode(const Mat &pot)
+	{
+		const byte	 nStates = getNumStates();
+		const size_t node	 = getNumNodes();
+		m_vNodePot.resize(m_vNodePot.size() + nStates, 0.0f);
+		if (!pot.empty()) setNode(node, pot);
+		m_isCompact = false;
+		return node;
+	}
+
+	void CGraphPairwiseCSR::addNodes(size_t nNodes)
+	{
+		m_vNodePot.resize(m_vNodePot.size() + nNodes * getNumStates(), 0.0f);
+		m_isCompact = false;
+	}
+
+	// Set or change the potential of node idx
+	void CGraphPairwiseCSR::setNode(size_t node, const Mat &pot)
+	{
+		DGM_ASSERT_MSG(node < getNumNodes(), "Node %zu is out of range %zu", node, getNumNodes());
+		DGM_ASSERT_MSG((pot.cols == 1) && (pot.rows == getNumStates()), "Potential size (%d x %d) does not match (%d x %d)", pot.cols, pot.rows, 1, getNumStates());
+
+		Mat dst(getNumStates(), 1, CV_32FC1, m_vNodePot.data() + node * getNumStates());
+		pot.copyTo(dst);
+	}
+
+	// Return node potential vector
+	void CGraphPairwiseCSR::getNode(size_t node, Mat &pot) const
+	{
+		DGM_ASSERT_MSG(node < getNumNodes(), "Node %zu is out of range %zu", node, getNumNodes());
+		Mat(getNumStates(), 1, CV_32FC1, const_cast<float *>(m_vNodePot.data()) + node * getNumStates()).copyTo(pot);
+	}
+
+	void CGraphPairwiseCSR::setNodes(size_t start_node, size_t num_nodes, const float *pots, size_t step)
+	{
+		const byte nStates = getNumStates();
+		if (!step) step = nStates;
+		DGM_ASSERT_MSG(start_node + num_nodes <= getNumNodes(), "The given ranges exceed the number of nodes(%zu)", getNumNodes());
+
+		float *pDst = m_vNodePot.data() + start_node * nStates;
+		if (step == nStates) memcpy(pDst, pots, num_nodes * nStates * sizeof(float));
+		else
+			for (size_t n = 0; n < num_nodes; n++)
+				memcpy(pDst + n * nStates, pots + n * step, nStates * sizeof(float));
+	}
+
+	void CGraphPairwiseCSR::getNodes(size_t start_node, size_t num_nodes, float *pots, size_t step) const
+	{
+		const byte nStates = getNumStates();
+		if (!step) step = nStates;
+		DGM_ASSERT_MSG(start_node + num_nodes <= getNumNodes(), "The given ranges exceed the number of nodes(%zu)", getNumNodes());
+
+		const float *pSrc = m_vNodePot.data() + start_node * nStates;
+		if (step == nStates) memcpy(pots, pSrc, num_nodes * nStates * sizeof(float));
+		else
+			for (size_t n = 0; n < num_nodes; n++)
+				memcpy(pots + n * step, pSrc + n * nStates, nStates * sizeof(float));
+	}
+
+	// Return child nodes ID's
+	void CGraphPairwiseCSR::getChildNodes(size_t node, vec_size_t &vNodes) const
+	{
+		DGM_ASSERT_MSG(node < getNumNodes(), "Node %zu is out of range %zu", node, getNumNodes());
+		compact();
+		if (!vNodes.empty()) vNodes.clear();
+		for (size_t i = m_vOutOffset[node]; i < m_vOutOffset[node + 1]; i++) vNodes.push_back(m_vDst[m_vOutEdge[i]]);
+	}
+
+	// Return parent nodes ID's
+	void CGraphPairwiseCSR::getParentNodes(size_t node, vec_size_t &vNodes) const
+	{
+		DGM_ASSERT_MSG(node < getNumNodes(), "Node %zu is out of range %zu", node, getNumNodes());
+		compact();
+		if (!vNodes.empty()) vNodes.clear();
+		for (size_t i = m_vInOffset[node]; i < m_vInOffset[node + 1]; i++) vNodes.push_back(m_vSrc[m_vInEdge[i]]);
+	}
+
+	// Add a new (directed) edge to the graph with specified potentional
+	void CGraphPairwiseCSR::addEdge(size_t srcNode, size_t dstNode, byte group, const Mat &pot)
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+
+		const size_t e = m_vSrc.size();
+		m_vSrc.push_back(srcNode);
+		m_vDst.push_back(dstNode);
+		m_vGroup.push_back(group);
+		m_vFlags.push_back(0);
+		m_vpEdgeTable.push_back(NULL);
+		if (m_isEdgeArena) m_vEdgePot.resize(m_vEdgePot.size() + getNumStates() * getNumStates(), 0.0f);
+		if (!pot.empty()) {
+			DGM_ASSERT_MSG((pot.cols == getNumStates()) && (pot.rows == getNumStates()), "Potential size (%d x %d) does not match (%d x %d)", pot.cols, pot.rows, getNumStates(), getNumStates());
+			Mat dst(getNumStates(), getNumStates(), CV_32FC1, getOwnEdgePot(e));
+			pot.copyTo(dst);
+			m_vFlags[e] |= EDGE_POT_SET;
+		}
+		m_isCompact = false;
+	}
+
+	// The duplicates are detected by compact()
+	void CGraphPairwiseCSR::addEdges(const vec_size_t &srcNodes, const vec_size_t &dstNodes, const vec_byte_t &groups)
+	{
+		DGM_ASSERT_MSG(srcNodes.size() == dstNodes.size(), "The number of source nodes (%zu) does not correspond to the number of destination nodes (%zu)", srcNodes.size(), dstNodes.size());
+		DGM_ASSERT_MSG(srcNodes.size() == groups.size(), "The number of edges (%zu) does not correspond to the number of groups (%zu)", srcNodes.size(), groups.size());
+		for (size_t i = 0; i < srcNodes.size(); i++) {
+			DGM_ASSERT_MSG(srcNodes[i] < getNumNodes(), "The source node index %zu is out of range %zu", srcNodes[i], getNumNodes());
+			DGM_ASSERT_MSG(dstNodes[i] < getNumNodes(), "The destination node index %zu is out of range %zu", dstNodes[i], getNumNodes());
+		}
+
+		const size_t nEdges = m_vSrc.size() + srcNodes.size();
+		m_vSrc.insert(m_vSrc.end(), srcNodes.begin(), srcNodes.end());
+		m_vDst.insert(m_vDst.end(), dstNodes.begin(), dstNodes.end());
+		m_vGroup.insert(m_vGroup.end(), groups.begin(), groups.end());
+		m_vFlags.resize(nEdges, 0);
+		m_vpEdgeTable.resize(nEdges, NULL);
+		if (m_isEdgeArena) m_vEdgePot.resize(nEdges * getNumStates() * getNumStates(), 0.0f);
+		m_isCompact = false;
+	}
+
+	// Set or change the potentional of an directed edge
+	void CGraphPairwiseCSR::setEdge(size_t srcNode, size_t dstNode, const Mat &pot)
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+		DGM_ASSERT_MSG((pot.cols == getNumStates()) && (pot.rows == getNumStates()), "Potential size (%d x %d) does not match (%d x %d)", pot.cols, pot.rows, getNumStates(), getNumStates());
+
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+
+		Mat dst(getNumStates(), getNumStates(), CV_32FC1, getOwnEdgePot(e.value()));
+		pot.copyTo(dst);
+		m_vpEdgeTable[e.value()] = NULL;
+		m_vFlags[e.value()] |= EDGE_POT_SET;
+	}
+
+	// All the edges of the group reference one shared table
+	void CGraphPairwiseCSR::setEdges(std::optional<byte> group, const Mat &pot)
+	{
+		DGM_ASSERT_MSG((pot.cols == getNumStates()) && (pot.rows == getNumStates()), "Potential size (%d x %d) does not match (%d x %d)", pot.cols, pot.rows, getNumStates(), getNumStates());
+		DGM_ASSERT(pot.type() == CV_32FC1);
+
+		m_vSharedPot.push_back(pot.clone());
+		const float *pTable = m_vSharedPot.back().ptr<float>();
+
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(m_vSrc.size())), [group, pTable, this](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(m_vSrc.size()));
+#endif
+		for (int e = range.start; e < range.end; e++)
+			if (!group || m_vGroup[e] == group.value()) {
+				m_vpEdgeTable[e] = pTable;
+				m_vFlags[e] |= EDGE_POT_SET;
+			}
+#ifdef ENABLE_PDP
+		});
+#endif
+
+		// Releasing the shared tables, which are not referenced by any edge anymore
+		std::unordered_map<const float *, size_t> mTables;					// table -> index in m_vSharedPot
+		mTables.reserve(m_vSharedPot.size());
+		for (size_t t = 0; t < m_vSharedPot.size(); t++) mTables.emplace(m_vSharedPot[t].ptr<float>(), t);
+		std::vector<bool> vUsed(m_vSharedPot.size(), false);
+		const float *pLastTable = NULL;										// consecutive edges usually reference the same table
+		for (const float *pEdgeTable : m_vpEdgeTable) {
+			if (!pEdgeTable || pEdgeTable == pLastTable) continue;
+			pLastTable = pEdgeTable;
+			auto it = mTables.find(pEdgeTable);
+			if (it != mTables.end()) vUsed[it->second] = true;
+		}
+		size_t nUsed = 0;
+		for (size_t t = 0; t < m_vSharedPot.size(); t++)
+			if (vUsed[t]) m_vSharedPot[nUsed++] = m_vSharedPot[t];
+		m_vSharedPot.resize(nUsed);
+	}
+
+	// The potentials are copied into the edge arena at once
+	void CGraphPairwiseCSR::setEdges(size_t start_edge, size_t num_edges, const float *pots)
+	{
+		DGM_ASSERT_MSG(start_edge + num_edges <= getNumEdges(), "The given ranges exceed the number of edges(%zu)", getNumEdges());
+		if (!num_edges) return;
+
+		memcpy(getOwnEdgePot(start_edge), pots, num_edges * getNumStates() * getNumStates() * sizeof(float));
+		for (size_t e = start_edge; e < start_edge + num_edges; e++) {
+			m_vpEdgeTable[e] = NULL;
+			m_vFlags[e] |= EDGE_POT_SET;
+		}
+	}
+
+	void CGraphPairwiseCSR::setEdgePotential(size_t srcNode, size_t dstNode, size_t potId)
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+		DGM_ASSERT_MSG(potId < m_vEdgePotentials.size(), "The edge potential table %zu is out of range %zu", potId, m_vEdgePotentials.size());
+
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+
+		m_vpEdgeTable[e.value()] = m_vEdgePotentials[potId].ptr<float>();
+		m_vFlags[e.value()] |= EDGE_POT_SET;
+	}
+
+	// Return edge potential matrix
+	void CGraphPairwiseCSR::getEdge(size_t srcNode, size_t dstNode, Mat &pot) const
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		const float *pEdgePot = getEdgePot(e.value());
+		if (!pEdgePot) {
+			DGM_WARNING("Edge Potential is empty");
+			if (!pot.empty()) pot.release();
+		}
+		else Mat(getNumStates(), getNumStates(), CV_32FC1, const_cast<float *>(pEdgePot)).copyTo(pot);
+	}
+
+	void CGraphPairwiseCSR::setEdgeGroup(size_t srcNode, size_t dstNode, byte group)
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		m_vGroup[e.value()] = group;
+	}
+
+	byte CGraphPairwiseCSR::getEdgeGroup(size_t srcNode, size_t dstNode) const
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		return m_vGroup[e.value()];
+	}
+
+	// The removed edges remain in the arena (as in CGraphPairwise), but are excluded from the adjacency
+	void CGraphPairwiseCSR::removeEdge(size_t srcNode, size_t dstNode)
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+
+		auto e = findEdge(srcNode, dstNode);
+		DGM_ASSERT_MSG(e, "The edge (%zu)->(%zu) is not found", srcNode, dstNode);
+		m_vFlags[e.value()] = EDGE_REMOVED;
+		m_isCompact = false;
+	}
+
+	bool CGraphPairwiseCSR::isEdgeExists(size_t srcNode, size_t dstNode) const
+	{
+		DGM_ASSERT_MSG(srcNode < getNumNodes(), "The source node index %zu is out of range %zu", srcNode, getNumNodes());
+		DGM_ASSERT_MSG(dstNode < getNumNodes(), "The destination node index %zu is out of range %zu", dstNode, getNumNodes());
+
+		return findEdge(srcNode, dstNode).has_value();
+	}
+
+	void CGraphPairwiseCSR::reserve(size_t nNodes, size_t nEdges)
+	{
+		const byte nStates = getNumStates();
+		m_vNodePot.reserve(nNodes * nStates);
+		if (m_isEdgeArena) m_vEdgePot.reserve(nEdges * nStates * nStates);
+		m_vpEdgeTable.reserve(nEdges);
+		m_vSrc.reserve(nEdges);
+		m_vDst.reserve(nEdges);
+		m_vGroup.reserve(nEdges);
+		m_vFlags.reserve(nEdges);
+	}
+
+	void CGraphPairwiseCSR::compact(void) const
+	{
+		if (m_isCompact) return;
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (m_isCompact) return;
+
+		const size_t nNodes = getNumNodes();
+		const size_t nEdges = m_vSrc.size();
+
+		// Counting the node degrees
+		m_vOutOffset.assign(nNodes + 1, 0);
+		m_vInOffset.assign(nNodes + 1, 0);
+		for (size_t e = 0; e < nEdges; e++) {
+			if (m_vFlags[e] & EDGE_REMOVED) continue;
+			m_vOutOffset[m_vSrc[e] + 1]++;
+			m_vInOffset[m_vDst[e] + 1]++;
+		}
+		std::partial_sum(m_vOutOffset.begin(), m_vOutOffset.end(), m_vOutOffset.begin());
+		std::partial_sum(m_vInOffset.begin(), m_vInOffset.end(), m_vInOffset.begin());
+
+		// Distributing the edges (counting sort)
+		m_vOutEdge.resize(m_vOutOffset[nNodes]);
+		m_vInEdge.resize(m_vInOffset[nNodes]);
+		vec_size_t vOutPos(m_vOutOffset.begin(), m_vOutOffset.end() - 1);
+		vec_size_t vInPos(m_vInOffset.begin(), m_vInOffset.end() - 1);
+		for (size_t e = 0; e < nEdges; e++) {
+			if (m_vFlags[e] & EDGE_REMOVED) continue;
+			m_vOutEdge[vOutPos[m_vSrc[e]]++] = e;
+			m_vInEdge[vInPos[m_vDst[e]]++] = e;
+		}
+
+		// Sorting the outgoing edges by the destination node and checking for duplicates
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(nNodes)), [&](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(nNodes));
+#endif
+		for (int n = range.start; n < range.end; n++) {
+			auto begin = m_vOutEdge.begin() + m_vOutOffset[n];
+			auto end   = m_vOutEdge.begin() + m_vOutOffset[n + 1];
+			std::sort(begin, end, [&](size_t e1, size_t e2) { return m_vDst[e1] < m_vDst[e2]; });
+			auto dup = std::adjacent_find(begin, end, [&](size_t e1, size_t e2) { return m_vDst[e1] == m_vDst[e2]; });
+			DGM_ASSERT_MSG(dup == end, "The edge (%d)->(%zu) is duplicated", n, m_vDst[*dup]);
+		}
+#ifdef ENABLE_PDP
+		});
+#endif
+
+		m_isCompact = true;
+	}
+
+
+	// ------------------------------ PRIVATE ------------------------------
+	std::optional<size_t> CGraphPairwiseCSR::findEdge(size_t srcNode, size_t dstNode) const
+	{
+		compact();
+		auto begin = m_vOutEdge.cbegin() + m_vOutOffset[srcNode];
+		auto end   = m_vOutEdge.cbegin() + m_vOutOffset[srcNode + 1];
+		auto e_t   = std::lower_bound(begin, end, dstNode, [&](size_t e, size_t node) { return m_vDst[e] < node; });
+		if (e_t == end || m_vDst[*e_t] != dstNode) return std::nullopt;
+		return *e_t;
+	}
+
+	float * CGraphPairwiseCSR::getOwnEdgePot(size_t edge)
+	{
+		const size_t size = getNumStates() * getNumStates();
+		if (!m_isEdgeArena) {
+			std::lock_guard<std::mutex> lock(m_mtx);
+			if (!m_isEdgeArena) {
+				m_vEdgePot.resize(m_vSrc.size() * size, 0.0f);
+				m_isEdgeArena = true;
+			}
+		}
+		return m_vEdgePot.data() + edge * size;
+	}
+
+	const float * CGraphPairwiseCSR::getEdgePot(size_t edge) const
+	{
+		if (!(m_vFlags[edge] & EDGE_POT_SET)) return NULL;
+		if (m_vpEdgeTable[edge]) return m_vpEdgeTable[edge];
+		return m_vEdgePot.data() + edge * getNumStates() * getNumStates();
+	}
+}
@@ -0,0 +1,142 @@
+// Compressed-sparse-row (pairwise) Graph class interface;
+// Written in 2021 for Project X
+#pragma once
+
+#include "IGraphPairwise.h"
+#include <atomic>
+#include <mutex>
+
+namespace DirectGraphicalModels
+{
+	// ================================ CSR Graph Class ================================
+	/**
+	* @brief Compressed-sparse-row pairwise graph class
+	* @details In contrast to CGraphPairwise, this class does not allocate an object per node and per edge. All the node potentials are
+	* stored in one contiguous arena of size \a nNodes x \a nStates, and the edge potentials - in one contiguous arena of size
+	* \a nEdges x \a nStates x \a nStates. The adjacency is stored in compressed-sparse-row (CSR) format for both outgoing and incoming edges.
+	* The edges, whose potentials are set with setEdges() or setEdgePotential(), reference a shared table instead of the edge arena, which is
+	* allocated only when the first edge gets its own potential with addEdge() or setEdge().
+	*
+	* The new edges are appended to the edge list, and the CSR adjacency is (re)built lazily on the first query, which requires it
+	* (or explicitly with compact()). Thus, this class is optimized for the graphs, which are built once and then used many times,
+	* \a e.g. the image grids built by CGraphLayeredExt::buildGraph(). Alternating additions of edges with the edge queries leads to
+	* repeated rebuilding of the adjacency, which is \f$O(nEdges)\f$ each.
+	* @note The duplicated edges are detected, when the CSR adjacency is built
+	* @ingroup moduleGraph
+	*/
+	class CGraphPairwiseCSR : public IGraphPairwise
+	{
+		friend class CMessagePassing;
+
+
+	public:
+		/**
+		* @brief Constructor
+		* @param nStates the number of States (classes)
+		*/
+		DllExport CGraphPairwiseCSR(byte nStates) : IGraphPairwise(nStates), m_isCompact(true), m_isEdgeArena(false) {}
+		DllExport virtual ~CGraphPairwiseCSR(void) = default;
+
+		// CGraph
+		DllExport void		reset(void) override;
+		DllExport size_t	addNode		  (const Mat &pot = EmptyMat) override;
+		using CGraph::addNodes;
+		DllExport void		addNodes	  (size_t nNodes) override;
+		DllExport void		setNode       (size_t node, const Mat &pot) override;
+		using CGraph::setNodes;
+		DllExport void		setNodes      (size_t start_node, size_t num_nodes, const float *pots, size_t step = 0) override;
+		DllExport void		getNode       (size_t node, Mat &pot) const override;
+		using CGraph::getNodes;
+		DllExport void		getNodes      (size_t start_node, size_t num_nodes, float *pots, size_t step = 0) const override;
+		DllExport void		getChildNodes (size_t node, vec_size_t &vNodes) const override;
+		DllExport void		getParentNodes(size_t node, vec_size_t &vNodes) const override;
+		DllExport size_t	getNumNodes(void) const override { return m_vNodePot.size() / getNumStates(); }
+		DllExport size_t	getNumEdges(void) const override { return m_vSrc.size(); }
+
+		// IGraphPairwise
+		DllExport void		addEdge		(size_t srcNode, size_t dstNode, byte group, const Mat &pot) override;
+		using IGraphPairwise::addEdges;
+		DllExport void		addEdges	(const vec_size_t &srcNodes, const vec_size_t &dstNodes, const vec_byte_t &groups) override;
+		DllExport void		setEdge		(size_t srcNode, size_t dstNode, const Mat &pot) override;
+		DllExport void		setEdges	(std::optional<byte> group, const Mat& pot) override;
+		DllExport void		setEdges	(size_t start_edge, size_t num_edges, const float *pots) override;
+		DllExport bool		isEdgeOrderPreserved(void) const override { return true; }
+		DllExport void		setEdgePotential(size_t srcNode, size_t dstNode, size_t potId) override;
+		DllExport void		getEdge		(size_t srcNode, size_t dstNode, Mat &pot) const override;
+		DllExport void		setEdgeGroup(size_t srcNode, size_t dstNode, byte group) override;
+		DllExport byte		getEdgeGroup(size_t srcNode, size_t dstNode) const override;
+		DllExport void		removeEdge	(size_t srcNode, size_t dstNode) override;
+		DllExport bool		isEdgeExists(size_t srcNode, size_t dstNode) const override;
+
+		/**
+		* @brief Reserves memory for the nodes and edges
+		* @details Calling this function before building the graph avoids the reallocations of the potential arenas
+		* @param nNodes The expected number of nodes
+		* @param nEdges The expected number of (directed) edges
+		*/
+		DllExport void		reserve(size_t nNodes, size_t nEdges);
+		/**
+		* @brief Builds the CSR adjacency of the graph
+		* @details This function is called automatically by all the functions, which need the adjacency.
+		* It may be called explicitly after the graph is built in order to avoid the delay at the first query.
+		* > This function is thread-safe
+		*/
+		DllExport void		compact(void) const;
+		/**
+		* @brief Returns the node potentials arena
+		* @details The returned matrix is a header over the arena of the graph: no data is copied, and the changes of the matrix change
+		* the node potentials. The header becomes invalid when new nodes are added or the graph is reset.
+		* @return The node potentials: Mat(size: nNodes x nStates; type: CV_32FC1)
+		*/
+		DllExport Mat		getNodePotentials(void) { return Mat(static_cast<int>(getNumNodes()), getNumStates(), CV_32FC1, m_vNodePot.data()); }
+
+
+	private:
+		/**
+		* @brief Returns the index of the directed edge
+		* @param srcNode index of the source node
+		* @param dstNode index of the destination node
+		* @return The edge index if the edge exists, std::nullopt otherwise
+		*/
+		std::optional<size_t>	findEdge(size_t srcNode, size_t dstNode) const;
+		/**
+		* @brief Returns the own potential of the edge in the edge arena
+		* @details Allocates the edge arena if it was not allocated yet
+		* > This function is thread-safe
+		* @param edge The edge index
+		* @return The pointer to \a nStates x \a nStates values
+		*/
+		float				  *	getOwnEdgePot(size_t edge);
+		/**
+		* @brief Returns the potential of the edge
+		* @param edge The edge index
+		* @return The pointer to \a nStates x \a nStates values either in the edge arena or in a shared table; NULL if the potential is not set
+		*/
+		const float			  *	getEdgePot(size_t edge) const;
+
+
+	private:
+		/// Edge state flags
+		enum : byte {
+			EDGE_POT_SET = 1,		///< The edge potential was set
+			EDGE_REMOVED = 2		///< The edge was removed from the graph
+		};
+
+		vec_float_t				m_vNodePot;		///< Node potentials arena: nNodes x nStates
+		vec_float_t				m_vEdgePot;		///< Edge potentials arena: nEdges x nStates x nStates (empty until the first own edge potential is set)
+		std::vector<const float *> m_vpEdgeTable;	///< Shared table referenced by every edge; NULL if the edge uses its own potential
+		vec_mat_t				m_vSharedPot;	///< Shared tables created by setEdges()
+		vec_size_t				m_vSrc;			///< Source node of every edge
+		vec_size_t				m_vDst;			///< Destination node of every edge
+		vec_byte_t				m_vGroup;		///< Group ID of every edge
+		vec_byte_t				m_vFlags;		///< State flags of every edge
+
+		mutable vec_size_t		m_vOutOffset;	///< CSR offsets of the outgoing edges: nNodes + 1
+		mutable vec_size_t		m_vOutEdge;		///< Outgoing edges, grouped by the source node and sorted by the destination node
+		mutable vec_size_t		m_vInOffset;	///< CSR offsets of the incoming edges: nNodes + 1
+		mutable vec_size_t		m_vInEdge;		///< Incoming edges, grouped by the destination node
+		mutable std::atomic_bool m_isCompact;	///< Flag indicating whether the CSR adjacency is up to date
+		std::atomic_bool		m_isEdgeArena;	///< Flag indicating whether the edge arena is allocated
+		mutable std::mutex		m_mtx;			///< Mutex guarding the adjacency rebuilding and the edge arena allocation
+	};
+}
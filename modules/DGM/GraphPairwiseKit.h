@@ -7,7 +7,11 @@
 #include "GraphPairwise.h"
 
 #include "MessagePassing.h"
+#include "InferGraphCut.h"
 #include "InferLBP.h"
+#include "InferLBPGrid.h"
+#include "InferMinSum.h"
+#include "InferMinSumTRW.h"
 #include "InferTRW.h"
 #include "InferViterbi.h"
 
@@ -19,7 +23,11 @@ namespace DirectGraphicalModels
 {
 	/// Types of the inference / decoding objects
 	enum class INFER { 
+		GraphCut,	///< Graph-cut inference with the alpha-expansion moves
 		LBP,		///< Loopy Belief Propagation inference
+		LBPGrid,	///< Loopy Belief Propagation inference, specialized for grid graphs
+		MinSum,		///< Viterbi inference in the energy domain
+		MinSumTRW,	///< Convergent Tree-Reweighted inference in the energy domain
 		TRW,		///< Convergent Tree-Reweighted inference
 		Viterbi		///< Viterbi inference
 	};
@@ -44,7 +52,11 @@ namespace DirectGraphicalModels
 		{
 			switch (infer)
 			{
+			case INFER::GraphCut: m_pInfer = std::make_unique<CInferGraphCut>(m_graph); break;
 			case INFER::LBP:	 m_pInfer = std::make_unique<CInferLBP>(m_graph); break;
+			case INFER::LBPGrid: m_pInfer = std::make_unique<CInferLBPGrid>(m_graph, m_graphExtension); break;
+			case INFER::MinSum:	 m_pInfer = std::make_unique<CInferMinSum>(m_graph); break;
+			case INFER::MinSumTRW: m_pInfer = std::make_unique<CInferMinSumTRW>(m_graph); break;
 			case INFER::TRW:	 m_pInfer = std::make_unique<CInferTRW>(m_graph); break;
 			case INFER::Viterbi: m_pInfer = std::make_unique<CInferViterbi>(m_graph); break;
 			default: DGM_ASSERT_MSG(false, "Unknown inference method");
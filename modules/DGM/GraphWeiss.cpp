@@ -24,6 +24,7 @@ namespace DirectGraphicalModels
 		for (size_t n = 0; n < nNodes; n++) 
 			delete m_vpNodes.at(n);	
 		m_vpNodes.clear();	
+		m_vEdgePotentials.clear();
 		m_IDx = 0;
 	}
 
@@ -29,5 +29,19 @@ namespace DirectGraphicalModels {
 		* will be the same size and type as the input one: Mat(size: nNodes x nStates; type: CV_32FC1)
 		*/
 		virtual void apply(const Mat &src, Mat &dst) const = 0;
+		/**
+		* @brief Applies an edge model to the node potentials of a dense graph in the log domain.
+		* @details This function adds the logarithm of the result of apply() to the \b dst. Thus the results of multiple edge models may be 
+		* accumulated and exponentiated only once. The derived classes may override this function in order to avoid the exponentiation.
+		* @param[in] src The dense graph node potentials in form Mat(size: nNodes x nStates; type: CV_32FC1)
+		* @param[in,out] dst The accumulator: Mat(size: nNodes x nStates; type: CV_32FC1)
+		*/
+		virtual void accumulate(const Mat &src, Mat &dst) const 
+		{
+			Mat tmp;
+			apply(src, tmp);
+			log(tmp, tmp);
+			add(dst, tmp, dst);
+		}
 	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "IGraphPairwise.h"
+#include "macroses.h"
 
 namespace DirectGraphicalModels
 {
@@ -7,6 +8,54 @@ namespace DirectGraphicalModels
         addEdge(srcNode, dstNode, 0, pot);
     }
     
+	void IGraphPairwise::addEdges(const vec_size_t &srcNodes, const vec_size_t &dstNodes, byte group)
+	{
+		addEdges(srcNodes, dstNodes, vec_byte_t(srcNodes.size(), group));
+	}
+
+	void IGraphPairwise::addEdges(const vec_size_t &srcNodes, const vec_size_t &dstNodes, const vec_byte_t &groups)
+	{
+		DGM_ASSERT_MSG(srcNodes.size() == dstNodes.size(), "The number of source nodes (%zu) does not correspond to the number of destination nodes (%zu)", srcNodes.size(), dstNodes.size());
+		DGM_ASSERT_MSG(srcNodes.size() == groups.size(), "The number of edges (%zu) does not correspond to the number of groups (%zu)", srcNodes.size(), groups.size());
+		for (size_t i = 0; i < srcNodes.size(); i++)
+			addEdge(srcNodes[i], dstNodes[i], groups[i], Mat());
+	}
+
+	size_t IGraphPairwise::addEdgePotential(const Mat &pot)
+	{
+		DGM_ASSERT_MSG((pot.cols == getNumStates()) && (pot.rows == getNumStates()), "Potential size (%d x %d) does not match (%d x %d)", pot.cols, pot.rows, getNumStates(), getNumStates());
+		DGM_ASSERT(pot.type() == CV_32FC1);
+		m_vEdgePotentials.push_back(pot.clone());
+		return m_vEdgePotentials.size() - 1;
+	}
+
+	// Default implementation: the edges are enumerated by their source nodes
+	void IGraphPairwise::setEdges(size_t start_edge, size_t num_edges, const float *pots)
+	{
+		DGM_ASSERT_MSG(start_edge + num_edges <= getNumEdges(), "The given ranges exceed the number of edges(%zu)", getNumEdges());
+		const byte		nStates	= getNumStates();
+		const size_t	size	= static_cast<size_t>(nStates) * nStates;
+		const size_t	end_edge = start_edge + num_edges;
+
+		vec_size_t vChilds;
+		size_t e = 0;
+		for (size_t n = 0; n < getNumNodes() && e < end_edge; n++) {
+			getChildNodes(n, vChilds);
+			for (size_t child : vChilds) {
+				if (e >= start_edge && e < end_edge)
+					setEdge(n, child, Mat(nStates, nStates, CV_32FC1, const_cast<float *>(pots + (e - start_edge) * size)));
+				e++;
+			} // child
+		} // n
+	}
+
+	// Default implementation: the table is copied into the edge
+	void IGraphPairwise::setEdgePotential(size_t srcNode, size_t dstNode, size_t potId)
+	{
+		DGM_ASSERT_MSG(potId < m_vEdgePotentials.size(), "The edge potential table %zu is out of range %zu", potId, m_vEdgePotentials.size());
+		setEdge(srcNode, dstNode, m_vEdgePotentials[potId]);
+	}
+
     bool IGraphPairwise::isEdgeArc(size_t srcNode, size_t dstNode) const
     {
         return isEdgeExists(dstNode, srcNode);
@@ -47,6 +47,25 @@ namespace DirectGraphicalModels {
 		*/
 		DllExport virtual void		addEdge(size_t srcNode, size_t dstNode, byte group, const Mat &pot) = 0;
 		/**
+		* @brief Adds a block of directed edges
+		* @details The edges are added in the given order, thus they get consecutive indices. Unlike addEdge(), the derived graphs do not check, whether 
+		* every new edge already exists: the caller guarantees that the edges are unique (with DEBUG_MODE defined, this is asserted).
+		* This function is meant for the graph builders, which know the structure of the graph in advance, \a e.g. CGraphLayeredExt.
+		* @param srcNodes indices of the source nodes
+		* @param dstNodes indices of the destination nodes
+		* @param group The edge group ID
+		*/
+		DllExport void				addEdges(const vec_size_t &srcNodes, const vec_size_t &dstNodes, byte group = 0);
+		/**
+		* @brief Adds a block of directed edges
+		* @details The same as above, but every edge has its own group ID
+		* > This function supports PPL
+		* @param srcNodes indices of the source nodes
+		* @param dstNodes indices of the destination nodes
+		* @param groups The group IDs of the edges
+		*/
+		DllExport virtual void		addEdges(const vec_size_t &srcNodes, const vec_size_t &dstNodes, const vec_byte_t &groups);
+		/**
 		* @brief Sets or changes the potentional of directed edge
 		* @param srcNode index of the source node
 		* @param dstNode index of the destination node
@@ -57,11 +76,53 @@ namespace DirectGraphicalModels {
 		* @brief Sets the potential \b pot to all edges belonging to group \b group
 		* @details This function assigns the same potential matrix to all the edges in graph with group property equal to \b group.
 		* By default all edges have group 0. This mightbe changes with functon @ref setEdgeGroup()
+		* > The graph may store a single copy of \b pot, shared by all these edges (see addEdgePotential())
 		* @param group The edge group ID. This argument is optional, and if it is not set, this function will set potential to all existing edges
 		* @param pot %Edge potential matrix: Mat(size: nStates x nStates; type: CV_32FC1)
 		*/
 		DllExport virtual void		setEdges(std::optional<byte> group, const Mat& pot) = 0;
 		/**
+		* @brief Fills the edges with new potentials from a raw buffer
+		* @details The edges are addressed by their indices, which follow the order of their addition to the graph. This allows the graph builders,
+		* which know the structure of the graph, \a e.g. CGraphLayeredExt, to write the potentials directly, without searching for every edge by its nodes.
+		* The default implementation, used by the graphs which do not preserve the order of the edges (Ref. isEdgeOrderPreserved()), enumerates the edges
+		* by their source nodes and, for every source node, in the order of getChildNodes(), and sets every edge with setEdge().
+		* > Disjoint ranges of edges may be filled concurrently if the graph preserves the order of the edges
+		* @param start_edge The index of the edge, starting from which the potentials should be set
+		* @param num_edges The number of edges
+		* @param pots Pointer to the potentials of edge \b start_edge, followed by the potentials of the next edges: \a num_edges x nStates x nStates values
+		*/
+		DllExport virtual void		setEdges(size_t start_edge, size_t num_edges, const float *pots);
+		/**
+		* @brief Checks whether the indices of the edges follow the order of their addition to the graph
+		* @details If so, setEdges(size_t, size_t, const float *) addresses the edges by their indices directly
+		* @retval true if the graph preserves the order of the edges
+		* @retval false otherwise
+		*/
+		DllExport virtual bool		isEdgeOrderPreserved(void) const { return false; }
+		/**
+		* @brief Adds a shared edge potential table to the graph
+		* @details The table is stored in the graph once and may be assigned to many edges with setEdgePotential() without copying it into every edge.
+		* This is useful when many edges have the same potential, \a e.g. the edges of one group, or the edges whose contrast falls into the same bucket.
+		* The tables are valid until reset() is called.
+		* @param pot %Edge potential matrix: Mat(size: nStates x nStates; type: CV_32FC1)
+		* @return The ID of the table
+		*/
+		DllExport virtual size_t	addEdgePotential(const Mat &pot);
+		/**
+		* @brief Assigns the shared edge potential table to the directed edge
+		* @details The edge references the table until its potential is changed with setEdge(), which gives the edge its own copy of the potential.
+		* @param srcNode index of the source node
+		* @param dstNode index of the destination node
+		* @param potId The ID of the table, returned by addEdgePotential()
+		*/
+		DllExport virtual void		setEdgePotential(size_t srcNode, size_t dstNode, size_t potId);
+		/**
+		* @brief Returns the number of the shared edge potential tables
+		* @return The number of the tables, added with addEdgePotential()
+		*/
+		DllExport size_t			getNumEdgePotentials(void) const { return m_vEdgePotentials.size(); }
+		/**
 		* @brief Returns the edge potential
 		* @param[in] srcNode index of the source node
 		* @param[in] dstNode index of the destination node
@@ -163,5 +224,9 @@ namespace DirectGraphicalModels {
 		* @retval false otherwise
 		*/
 		DllExport virtual bool		isArcExists(size_t Node1, size_t Node2) const;
+
+
+	protected:
+		vec_mat_t	m_vEdgePotentials;		///< Shared edge potential tables
 	};
 }  
@@ -0,0 +1,153 @@
+#include "IKNNIndex.h"
+#include "macroses.h"
+
+namespace DirectGraphicalModels
+{
+	void IKNNIndex::reset(void)
+	{
+		m_k = 0;
+		m_vKeys.clear();
+		m_vValues.clear();
+	}
+
+	// File format: type (byte), k (word), nPoints (size_t), keys (nPoints x k bytes), values (nPoints bytes), followed by the search structure
+	void IKNNIndex::save(const std::string &fileName) const
+	{
+		if (empty()) {
+			DGM_WARNING("The index is not built");
+			return;
+		}
+		FILE *pFile = fopen(fileName.c_str(), "wb");
+		if (!pFile) {
+			DGM_WARNING("Can't create file %s. Data was NOT saved.", fileName.c_str());
+			return;
+		}
+
+		const byte   type	 = static_cast<byte>(getIndexType());
+		const size_t nPoints = getNumPoints();
+		fwrite(&type, sizeof(byte), 1, pFile);
+		fwrite(&m_k, sizeof(word), 1, pFile);
+		fwrite(&nPoints, sizeof(size_t), 1, pFile);
+		fwrite(m_vKeys.data(), sizeof(byte), m_vKeys.size(), pFile);
+		fwrite(m_vValues.data(), sizeof(byte), nPoints, pFile);
+		saveFile(pFile);
+		fclose(pFile);
+	}
+
+	void IKNNIndex::load(const std::string &fileName)
+	{
+		FILE *pFile = fopen(fileName.c_str(), "rb");
+		DGM_ASSERT_MSG(pFile, "Can't load data from %s", fileName.c_str());
+
+		byte type = 0;
+		fread(&type, sizeof(byte), 1, pFile);
+		DGM_ASSERT_MSG(type == static_cast<byte>(getIndexType()), "The file %s contains an index of type %d, but type %d is expected", fileName.c_str(), type, static_cast<byte>(getIndexType()));
+
+		size_t nPoints;
+		fread(&m_k, sizeof(word), 1, pFile);
+		fread(&nPoints, sizeof(size_t), 1, pFile);
+		m_vKeys.resize(nPoints * m_k);
+		m_vValues.resize(nPoints);
+		fread(m_vKeys.data(), sizeof(byte), m_vKeys.size(), pFile);
+		fread(m_vValues.data(), sizeof(byte), nPoints, pFile);
+		loadFile(pFile);
+		fclose(pFile);
+	}
+
+	size_t IKNNIndex::findNearestNeighbor(const Mat &key) const
+	{
+		DGM_ASSERT_MSG(!empty(), "The index is not built");
+		return findNearestNeighbors(key, 1).front();
+	}
+
+	vec_size_t IKNNIndex::findNearestNeighbors(const Mat &key, size_t maxNeighbors) const
+	{
+		vec_size_t res;
+		if (empty()) {
+			DGM_WARNING("The index is not built");
+			return res;
+		}
+		DGM_ASSERT_MSG(key.type() == CV_8UC1, "Incorrect type of the key");
+		DGM_ASSERT_MSG(key.isContinuous() && key.total() == m_k, "The key must be a continuous vector of %d elements", m_k);
+
+		heap_t heap;
+		query(key.ptr<byte>(), maxNeighbors, heap);
+		res.reserve(heap.size());
+		for (const auto &neighbor : heap) res.push_back(neighbor.second);
+		return res;
+	}
+
+	void IKNNIndex::findNearestNeighbors(const Mat &keys, size_t maxNeighbors, Mat &indices) const
+	{
+		DGM_ASSERT_MSG(!empty(), "The index is not built");
+		DGM_ASSERT_MSG(keys.type() == CV_8UC1, "Incorrect type of the keys");
+		DGM_ASSERT_MSG(keys.cols == m_k, "The dimensionality of the keys (%d) does not correspond to the dimensionality of the index (%d)", keys.cols, m_k);
+
+		indices.create(keys.rows, static_cast<int>(maxNeighbors), CV_32SC1);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, keys.rows), [&](const Range &range) {
+#else
+		const Range range(0, keys.rows);
+#endif
+		heap_t heap;
+		heap.reserve(maxNeighbors);
+		for (int y = range.start; y < range.end; y++) {
+			query(keys.ptr<byte>(y), maxNeighbors, heap);
+			int *pIndices = indices.ptr<int>(y);
+			for (size_t i = 0; i < maxNeighbors; i++)
+				pIndices[i] = i < heap.size() ? static_cast<int>(heap[i].second) : -1;
+		} // y
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	Mat IKNNIndex::getKey(size_t idx) const
+	{
+		DGM_ASSERT_MSG(idx < getNumPoints(), "The index %zu is out of range %zu", idx, getNumPoints());
+		return Mat(1, m_k, CV_8UC1, const_cast<byte *>(&m_vKeys[idx * m_k]));
+	}
+
+	// ------------------------- Protected -------------------------
+	void IKNNIndex::setPoints(const Mat &keys, const Mat &values)
+	{
+		reset();
+		if (keys.empty()) {
+			DGM_WARNING("The data is empty");
+			return;
+		}
+		DGM_ASSERT_MSG(keys.type() == CV_8UC1, "Incorrect type of the keys");
+		DGM_ASSERT_MSG(values.type() == CV_8UC1, "Incorrect type of the values");
+		DGM_ASSERT_MSG(keys.rows == values.rows, "The amount of keys (%d) does not crrespond to the amount of values (%d)", keys.rows, values.rows);
+		DGM_ASSERT_MSG(keys.cols <= 0xFFFF, "The dimensionality of the keys (%d) is too high", keys.cols);
+
+		m_k = static_cast<word>(keys.cols);
+		const size_t k		= m_k;
+		const size_t nKeys	= static_cast<size_t>(keys.rows);
+
+		// data_i = [key, val]: k + 1 entries
+		vec_byte_t data(nKeys * (k + 1));
+		for (int y = 0; y < keys.rows; y++) {
+			memcpy(&data[y * (k + 1)], keys.ptr<byte>(y), k);
+			data[y * (k + 1) + k] = values.at<byte>(y, 0);
+		}
+
+		// Delete dublicated entries
+		vec_size_t vIdx(nKeys);
+		for (size_t i = 0; i < nKeys; i++) vIdx[i] = i;
+		std::sort(vIdx.begin(), vIdx.end(), [&](size_t a, size_t b) {
+			return memcmp(&data[a * (k + 1)], &data[b * (k + 1)], k + 1) < 0;
+		});
+		vIdx.erase(std::unique(vIdx.begin(), vIdx.end(), [&](size_t a, size_t b) {
+			return memcmp(&data[a * (k + 1)], &data[b * (k + 1)], k + 1) == 0;
+		}), vIdx.end());
+
+		const size_t nPoints = vIdx.size();
+		m_vKeys.resize(nPoints * k);
+		m_vValues.resize(nPoints);
+		for (size_t i = 0; i < nPoints; i++) {
+			memcpy(&m_vKeys[i * k], &data[vIdx[i] * (k + 1)], k);
+			m_vValues[i] = data[vIdx[i] * (k + 1) + k];
+		}
+	}
+}
@@ -0,0 +1,187 @@
+// Nearest neighbors index interface class
+// Written in 2021 for Project X
+#pragma once
+
+#include "types.h"
+
+namespace DirectGraphicalModels
+{
+	// ============================= Nearest Neighbors Index Class =============================
+	/**
+	* @brief Interface class for the nearest neighbors search structures
+	* @details This class stores the points (keys with the corresponding values) contiguously and defines the interface for the \a k-nearest neighbors
+	* search, used by CTrainNodeKNN. The points are addressed by their indices ( [0; getNumPoints()) ), which are valid until the index is rebuilt or reloaded.
+	* The distances between the keys are the Euclidian distances.
+	*/
+	class IKNNIndex
+	{
+	public:
+		DllExport IKNNIndex(void) = default;
+		DllExport IKNNIndex(const IKNNIndex&) = delete;
+		DllExport virtual ~IKNNIndex(void) = default;
+
+		DllExport bool				operator=(const IKNNIndex&) = delete;
+
+		/**
+		* @brief Resets the index
+		*/
+		DllExport virtual void		reset(void);
+		/**
+		* @brief Saves the index into a file
+		* @param fileName The output file name
+		*/
+		DllExport void				save(const std::string &fileName) const;
+		/**
+		* @brief Loads an index from the file
+		* @details The file must be saved by an index of the same type, \a e.g. the file of CKDTree can not be loaded by CKDForest
+		* @param fileName The output file name
+		*/
+		DllExport void				load(const std::string &fileName);
+		/**
+		* @brief Builds the index on \b keys with corresponding \b values
+		* @details The duplicated pairs (key, value) are stored only once.
+		* @param keys The keys: k-d points: Mat(size: nKeys x k; type: CV_8UC1)
+		* @param values The values for every key: Mat(size: nKeys x 1; type: CV_8UC1)
+		*/
+		DllExport virtual void		build(const Mat &keys, const Mat &values) = 0;
+		/**
+		* @brief Finds the nearest neighbor to the \b key
+		* @param key The search key: k-d point: Mat(size: 1 x k or k x 1; type: CV_8UC1)
+		* @returns The index of the point, which is the most close to the argument \b key
+		*/
+		DllExport size_t			findNearestNeighbor(const Mat &key) const;
+		/**
+		* @brief Finds up to \b maxNeighbors nearest neighbors to the \b key
+		* @param key The search key: k-d point: Mat(size: 1 x k or k x 1; type: CV_8UC1)
+		* @param maxNeighbors maximum number of neighbor nodes to find
+		* @returns The indices of the points, sorted by the distance to the argument \b key
+		*/
+		DllExport vec_size_t		findNearestNeighbors(const Mat &key, size_t maxNeighbors) const;
+		/**
+		* @brief Finds up to \b maxNeighbors nearest neighbors to every key of \b keys
+		* @details This is the batched version of the findNearestNeighbors() function, which processes all the keys at once, \a e.g. all the pixels
+		* of an image.
+		* > This function supports PPL.
+		* @param[in] keys The search keys: k-d points: Mat(size: nKeys x k; type: CV_8UC1)
+		* @param[in] maxNeighbors maximum number of neighbor nodes to find
+		* @param[out] indices The indices of the points, sorted by the distance to the corresponding keys: Mat(size: nKeys x maxNeighbors; type: CV_32SC1).
+		* If less than \b maxNeighbors points are found, the missing indices are set to -1.
+		*/
+		DllExport void				findNearestNeighbors(const Mat &keys, size_t maxNeighbors, Mat &indices) const;
+		/**
+		* @brief Returns the key of a point
+		* @param idx The index of the point
+		* @returns The key of the point: Mat(size: 1 x k; type: CV_8UC1). The matrix header points to the data of the index.
+		*/
+		DllExport Mat				getKey(size_t idx) const;
+		/**
+		* @brief Returns the value of a point
+		* @param idx The index of the point
+		* @returns The value of the point
+		*/
+		DllExport byte				getValue(size_t idx) const { return m_vValues[idx]; }
+		/**
+		* @brief Returns the number of points in the index
+		* @returns The number of stored points
+		*/
+		DllExport size_t			getNumPoints(void) const { return m_vValues.size(); }
+		/**
+		* @brief Returns the dimensionality of the keys
+		* @returns The dimensionality \a k
+		*/
+		DllExport word				getNumDimensions(void) const { return m_k; }
+		/**
+		* @brief Checks whether the index is built
+		* @retval true if the index contains no points
+		* @retval false otherwise
+		*/
+		DllExport bool				empty(void) const { return m_vValues.empty(); }
+
+
+	protected:
+		/// Max-heap of the nearest neighbors found so far: pairs (squared distance, index)
+		using heap_t = std::vector<std::pair<dword, size_t>>;
+		/// Type of the search structure, stored in the file
+		enum class IndexType : byte { KDTree = 1, KDForest = 2 };
+
+		/**
+		* @brief Returns the type of the search structure
+		* @details The type is written to the file by save() and checked by load()
+		* @returns The type of the search structure
+		*/
+		DllExport virtual IndexType	getIndexType(void) const = 0;
+
+		/**
+		* @brief Saves the search structure (everything besides the points) to the file
+		* @param pFile The pointer to the file, opened for writing
+		*/
+		DllExport virtual void		saveFile(FILE *pFile) const = 0;
+		/**
+		* @brief Loads the search structure (everything besides the points) from the file
+		* @param pFile The pointer to the file, opened for reading
+		*/
+		DllExport virtual void		loadFile(FILE *pFile) = 0;
+		/**
+		* @brief Finds up to \b maxNeighbors nearest neighbors to the \b key
+		* @details The function is called concurrently from the batched findNearestNeighbors() and, thus, must be thread-safe.
+		* @param[in] pKey The pointer to the search key of getNumDimensions() elements
+		* @param[in] maxNeighbors maximum number of neighbor nodes to find
+		* @param[out] heap The found nearest neighbors (squared distance, index), sorted by the distance
+		*/
+		DllExport virtual void		query(const byte *pKey, size_t maxNeighbors, heap_t &heap) const = 0;
+		/**
+		* @brief Stores the points
+		* @details Copies the \b keys and the \b values into the contiguous storage, removing the duplicated pairs (key, value)
+		* @param keys The keys: k-d points: Mat(size: nKeys x k; type: CV_8UC1)
+		* @param values The values for every key: Mat(size: nKeys x 1; type: CV_8UC1)
+		*/
+		DllExport void				setPoints(const Mat &keys, const Mat &values);
+		/**
+		* @brief Adds a point to the \b heap of the nearest neighbors, if it is nearer than the farthest one
+		* @param[in] dist The squared distance to the point
+		* @param[in] idx The index of the point
+		* @param[in] maxNeighbors maximum number of neighbor nodes to find
+		* @param[in,out] heap The max-heap of the nearest neighbors found so far
+		*/
+		static void					addNeighbor(dword dist, size_t idx, size_t maxNeighbors, heap_t &heap)
+		{
+			if (heap.size() < maxNeighbors) {
+				heap.emplace_back(dist, idx);
+				std::push_heap(heap.begin(), heap.end());
+			}
+			else if (dist < heap.front().first) {
+				std::pop_heap(heap.begin(), heap.end());
+				heap.back() = std::make_pair(dist, idx);
+				std::push_heap(heap.begin(), heap.end());
+			}
+		}
+		/**
+		* @brief Returns the squared Euclidian distance between the \b key and the point
+		* @param pKey The pointer to the key of getNumDimensions() elements
+		* @param idx The index of the point
+		* @returns The squared distance
+		*/
+		dword						getSqDistance(const byte *pKey, size_t idx) const { return getSqDistance(pKey, &m_vKeys[idx * m_k]); }
+		/**
+		* @brief Returns the squared Euclidian distance between two keys
+		* @param pKey The pointer to the first key of getNumDimensions() elements
+		* @param pPoint The pointer to the second key of getNumDimensions() elements
+		* @returns The squared distance
+		*/
+		dword						getSqDistance(const byte *pKey, const byte *pPoint) const
+		{
+			dword res = 0;
+			for (word x = 0; x < m_k; x++) {
+				const int diff = static_cast<int>(pKey[x]) - static_cast<int>(pPoint[x]);
+				res += static_cast<dword>(diff * diff);
+			}
+			return res;
+		}
+
+
+	protected:
+		word			m_k = 0;		///< The dimensionality of the keys
+		vec_byte_t		m_vKeys;		///< The keys: nPoints x k
+		vec_byte_t		m_vValues;		///< The values: nPoints
+	};
+}
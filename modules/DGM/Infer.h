@@ -5,6 +5,7 @@
 #pragma once
 
 #include "types.h"
+#include <optional>
 
 namespace DirectGraphicalModels 
 {
@@ -23,7 +24,7 @@ namespace DirectGraphicalModels
 		* @brief Constructor
 		* @param graph The graph
 		*/
-		DllExport CInfer(CGraph &graph) : m_graph(graph) {}
+		DllExport CInfer(CGraph &graph) : m_graph(graph), m_nIterations(0) {}
         CInfer(const CInfer&) = delete;
         DllExport virtual ~CInfer() = default;
         const CInfer& operator= (const CInfer&) = delete;
@@ -72,6 +73,19 @@ namespace DirectGraphicalModels
 		* @return The potential values for each node of the graph.
 		*/
 		DllExport vec_float_t	getPotentials(byte state) const;
+		/**
+		* @brief Sets the convergence criterion for the iterative inference algorithms
+		* @details If the tolerance is set, CInferLBP, CInferLBPGrid, CInferTRW and CInferDense stop before \a nIt iterations are done, as soon as
+		* the maximal change of a message (or of a marginal potential for CInferDense) in one iteration does not exceed \b tolerance.
+		* The number of actually performed iterations may be then queried with getNumIterations().
+		* @param tolerance The tolerance. If not set, all the \a nIt iterations are performed.
+		*/
+		DllExport void			setConvergenceTolerance(std::optional<float> tolerance) { m_tolerance = tolerance; }
+		/**
+		* @brief Returns the number of iterations, performed by the last call of infer()
+		* @return The number of iterations
+		*/
+		DllExport unsigned int	getNumIterations(void) const { return m_nIterations; }
 
 
 	protected:
@@ -80,9 +94,28 @@ namespace DirectGraphicalModels
 		* @return The reference to the graph
 		*/
 		CGraph& getGraph(void) const { return m_graph; }
+		/**
+		* @brief Returns the convergence tolerance
+		* @return The tolerance if it was set with setConvergenceTolerance(), std::nullopt otherwise
+		*/
+		std::optional<float>	getConvergenceTolerance(void) const { return m_tolerance; }
+		/**
+		* @brief Checks whether the convergence criterion is met
+		* @param delta The maximal change of a message or of a marginal potential in the last iteration
+		* @retval true if the tolerance is set and \b delta does not exceed it
+		* @retval false otherwise
+		*/
+		bool					isConverged(float delta) const { return m_tolerance && delta <= m_tolerance.value(); }
+		/**
+		* @brief Sets the number of the performed iterations
+		* @param nIt The number of iterations
+		*/
+		void					setNumIterations(unsigned int nIt) { m_nIterations = nIt; }
 
         
 	private:
-		CGraph & m_graph;
+		CGraph				  & m_graph;
+		std::optional<float>	m_tolerance;		///< The convergence tolerance
+		unsigned int			m_nIterations;		///< The number of iterations, performed by the last inference
 	};
 }
@@ -17,21 +17,32 @@ namespace DirectGraphicalModels
 			} // y
 		}
 		
+		// dst = normalize(pot0 * exp(energy)). The maximal exponent of every row is subtracted, so that the exp does not overflow
 		template<typename T>
-		void myexp(const Mat &src, Mat &dst)
+		void update(const Mat &pot0, const Mat &energy, Mat &dst)
 		{
-			for (int y = 0; y < src.rows; y++) {             
-				const T *pSrc  = src.ptr<float>(y);
-				T *pDst = dst.ptr<float>(y);
-
-				// Find the max and subtract it so that the exp doesn't explode
-				T max = pSrc[0];
-				for (int x = 1; x < src.cols; x++)
-					if (pSrc[x] > max) max = pSrc[x];
+#ifdef ENABLE_PDP
+			parallel_for_(Range(0, dst.rows), [&](const Range &range) {
+#else
+			const Range range(0, dst.rows);
+#endif
+			for (int y = range.start; y < range.end; y++) {
+				const T *pPot0	 = pot0.ptr<T>(y);
+				const T *pEnergy = energy.ptr<T>(y);
+				T		*pDst	 = dst.ptr<T>(y);
 
-				for (int x = 0; x < src.cols; x++)
-					pDst[x] = expf(pSrc[x] - max);
+				const T max = *std::max_element(pEnergy, pEnergy + energy.cols);
+				T sum = 0;
+				for (int x = 0; x < dst.cols; x++) {
+					pDst[x] = pPot0[x] * std::exp(pEnergy[x] - max);
+					sum += pDst[x];
+				}
+				if (sum > DBL_EPSILON)
+					for (int x = 0; x < dst.cols; x++) pDst[x] /= sum;
 			} // y
+#ifdef ENABLE_PDP
+			});
+#endif
 		}
 	}
 	
@@ -40,25 +51,31 @@ namespace DirectGraphicalModels
 		// ====================================== Initialization ======================================
 		Mat nodePotentials	= getGraphDense().getNodePotentials();
 		Mat	nodePotentials0	= nodePotentials.clone();
-		Mat	temp			= Mat(nodePotentials.size(), nodePotentials.type());
-		Mat	tmp;
+		Mat	energy			= Mat(nodePotentials.size(), nodePotentials.type());	// sum of the edge models in the log domain
+		Mat	prev;															// normalized potentials of the previous iteration
+		const bool checkConvergence = getConvergenceTolerance().has_value();
+
+		normalize<float>(nodePotentials, nodePotentials);
 
 		// =================================== Calculating potentials ==================================	
-		for (unsigned int i = 0; i < nIt; i++) {
+		unsigned int i;
+		for (i = 0; i < nIt; i++) {
 #ifdef DEBUG_PRINT_INFO
 			if (i == 0) printf("\n");
 			if (i % 5 == 0) printf("--- It: %d ---\n", i);
 #endif
-			normalize<float>(nodePotentials, nodePotentials);
-			
-			// Add up all pairwise potentials
-			temp.setTo(1);
-			for (auto &edgePotModel : getGraphDense().getEdgeModels()) {
-				edgePotModel->apply(nodePotentials, tmp);					// tmp = f(pot_i)
-				multiply(temp, tmp, temp);									// temp *= exp(tmp)
+			if (checkConvergence) {
+				if (i > 0 && isConverged(static_cast<float>(norm(nodePotentials, prev, NORM_INF)))) break;
+				nodePotentials.copyTo(prev);
 			}
+			
+			// Add up all pairwise potentials in the log domain
+			energy.setTo(0);
+			for (auto &edgePotModel : getGraphDense().getEdgeModels())
+				edgePotModel->accumulate(nodePotentials, energy);			// energy += log(f(pot_i))
 
-			multiply(nodePotentials0, temp, nodePotentials);				// pot_(i+1) = pot_0 * next
+			update<float>(nodePotentials0, energy, nodePotentials);			// pot_(i+1) = normalize(pot_0 * exp(energy))
 		} // iter
+		setNumIterations(i);
 	}
 }
@@ -11,7 +11,9 @@ namespace DirectGraphicalModels
 	/**
 	* @ingroup moduleDecode
 	* @brief Exact inference class
-	* @note Use this class only if \f$ nStates^{nNodes} < 2^{32}\f$
+	* @details The marginals are found with the sum-product message passing over the junction tree of the graph (see CJunctionTree),
+	* which is exponential only in the treewidth of the graph
+	* @note Use this class only if \f$ nStates^{w+1} < 2^{32}\f$, where \f$w\f$ is the treewidth of the graph
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
 	class CInferExact : public CInfer, private CDecodeExact
@@ -0,0 +1,199 @@
+#include "InferGraphCut.h"
+#include "macroses.h"
+#include <unordered_map>
+
+namespace DirectGraphicalModels
+{
+	void CInferGraphCut::infer(unsigned int nIt)
+	{
+		const byte nStates = getGraph().getNumStates();
+
+		// ====================================== Initialization ======================================
+		createView(false);
+		createEnergies();
+
+		const GraphPairwiseView &view = getView();
+		const size_t nNodes = view.getNumNodes();
+		m_vState.resize(nNodes);
+		for (size_t n = 0; n < nNodes; n++) {
+			const float *energy = m_vNodeEnergy.data() + n * nStates;
+			m_vState[n] = static_cast<byte>(std::min_element(energy, energy + nStates) - energy);
+		}
+
+		// ====================================== Minimization =======================================
+		calculateMessages(nIt);
+
+		// ============================== Writing the configuration ==================================
+		for (size_t n = 0; n < nNodes; n++)
+			for (byte s = 0; s < nStates; s++)
+				view.vpNodePot[n][s] = s == m_vState[n] ? 1.0f : 0.0f;
+
+		deleteEnergies();
+		deleteView();
+	}
+
+	double CInferGraphCut::getEnergy(const vec_byte_t &state)
+	{
+		DGM_ASSERT_MSG(state.size() == getGraph().getNumNodes(), "The size of the configuration %zu does not match the number of nodes %zu", state.size(), getGraph().getNumNodes());
+
+		createView(false);
+		createEnergies();
+		double res = calculateEnergy(state);
+		deleteEnergies();
+		deleteView();
+		return res;
+	}
+
+	void CInferGraphCut::calculateMessages(unsigned int nIt)
+	{
+		const byte nStates = getGraph().getNumStates();
+		double	   energy  = calculateEnergy(m_vState);
+
+		unsigned int i;
+		for (i = 0; i < nIt; i++) {												// cycles
+#ifdef DEBUG_PRINT_INFO
+			printf("--- It: %d --- Energy: %f\n", i, energy);
+#endif
+			bool decreased = false;
+			for (byte alpha = 0; alpha < nStates; alpha++)
+				if (m_swap)
+					for (byte beta = alpha + 1; beta < nStates; beta++) decreased |= move(alpha, beta, energy);
+				else
+					decreased |= move(alpha, std::nullopt, energy);
+
+			if (!decreased) {													// converged
+				i++;
+				break;
+			}
+		} // i
+		setNumIterations(i);
+	}
+
+	// ------------------------------ PRIVATE ------------------------------
+	void CInferGraphCut::createEnergies(void)
+	{
+		const GraphPairwiseView &view = getView();
+		const size_t nNodes	 = view.getNumNodes();
+		const size_t nEdges	 = view.getNumEdges();
+		const byte	 nStates = getGraph().getNumStates();
+		const size_t size	 = nStates * nStates;
+
+		// Edge energies: one table per distinct edge potential
+		std::unordered_map<const float *, size_t> mTable;
+		std::vector<const float *> vpTablePot;
+		vec_size_t vTable(nEdges);
+		for (size_t e = 0; e < nEdges; e++) {
+			const float *pPot = view.vpEdgePot[e];
+			if (!pPot) continue;
+			auto it = mTable.emplace(pPot, vpTablePot.size());
+			if (it.second) vpTablePot.push_back(pPot);
+			vTable[e] = it.first->second;
+		}
+		m_vEdgeEnergy.resize(vpTablePot.size() * size);
+		for (size_t t = 0; t < vpTablePot.size(); t++)
+			for (size_t i = 0; i < size; i++)
+				m_vEdgeEnergy[t * size + i] = -logf(MAX(vpTablePot[t][i], FLT_MIN));
+		m_vpEdgeEnergy.resize(nEdges);
+		for (size_t e = 0; e < nEdges; e++)
+			m_vpEdgeEnergy[e] = view.vpEdgePot[e] ? m_vEdgeEnergy.data() + vTable[e] * size : NULL;
+
+		// Node energies
+		m_vNodeEnergy.resize(nNodes * nStates);
+		for (size_t n = 0; n < nNodes; n++)
+			for (byte s = 0; s < nStates; s++)
+				m_vNodeEnergy[n * nStates + s] = -logf(MAX(view.vpNodePot[n][s], FLT_MIN));
+	}
+
+	void CInferGraphCut::deleteEnergies(void)
+	{
+		m_vNodeEnergy	= vec_float_t();
+		m_vEdgeEnergy	= vec_float_t();
+		m_vpEdgeEnergy	= std::vector<const float *>();
+	}
+
+	double CInferGraphCut::calculateEnergy(const vec_byte_t &state) const
+	{
+		const GraphPairwiseView &view	 = getView();
+		const byte				 nStates = getGraph().getNumStates();
+
+		double res = 0;
+		for (size_t n = 0; n < view.getNumNodes(); n++)
+			res += m_vNodeEnergy[n * nStates + state[n]];
+		for (size_t e = 0; e < view.getNumEdges(); e++)
+			if (m_vpEdgeEnergy[e]) res += m_vpEdgeEnergy[e][state[view.pSrc[e]] * nStates + state[view.pDst[e]]];
+		return res;
+	}
+
+	bool CInferGraphCut::move(byte alpha, std::optional<byte> beta, double &energy)
+	{
+		const GraphPairwiseView &view	 = getView();
+		const byte				 nStates = getGraph().getNumStates();
+		const size_t			 nNodes	 = view.getNumNodes();
+
+		// The states of a node for the choices 0 (source segment) and 1 (sink segment)
+		auto state0 = [&](size_t n) { return beta ? alpha : m_vState[n]; };
+		auto state1 = [&](size_t n) { return beta ? beta.value() : alpha; };
+
+		// Binary variables
+		int nVars = 0;
+		m_vVar.resize(nNodes);
+		for (size_t n = 0; n < nNodes; n++) {
+			const bool isVar = beta ? (m_vState[n] == alpha || m_vState[n] == beta.value()) : m_vState[n] != alpha;
+			m_vVar[n] = isVar ? nVars++ : -1;
+		}
+		if (nVars == 0) return false;
+
+		m_vUnary.resize(nVars);
+		for (size_t n = 0; n < nNodes; n++)
+			if (m_vVar[n] >= 0) {
+				const float *energy = m_vNodeEnergy.data() + n * nStates;
+				m_vUnary[m_vVar[n]] = std::make_pair(energy[state0(n)], energy[state1(n)]);
+			}
+
+		// Edges: E(x_u, x_v) = A + (C - A) x_u + (D - C) x_v + (B + C - A - D) (1 - x_u) x_v
+		m_maxFlow.reset(nVars);
+		for (size_t e = 0; e < view.getNumEdges(); e++) {
+			const float *E = m_vpEdgeEnergy[e];
+			if (!E) continue;
+			const size_t u	= view.pSrc[e];
+			const size_t v	= view.pDst[e];
+			const int	 xu = m_vVar[u];
+			const int	 xv = m_vVar[v];
+			if (xu < 0 && xv < 0) continue;
+			if (xv < 0) {				// v is fixed
+				m_vUnary[xu].first  += E[state0(u) * nStates + m_vState[v]];
+				m_vUnary[xu].second += E[state1(u) * nStates + m_vState[v]];
+			}
+			else if (xu < 0) {			// u is fixed
+				m_vUnary[xv].first  += E[m_vState[u] * nStates + state0(v)];
+				m_vUnary[xv].second += E[m_vState[u] * nStates + state1(v)];
+			}
+			else {
+				const float A = E[state0(u) * nStates + state0(v)];
+				const float B = E[state0(u) * nStates + state1(v)];
+				const float C = E[state1(u) * nStates + state0(v)];
+				const float D = E[state1(u) * nStates + state1(v)];
+				m_vUnary[xu].second += C - A;
+				m_vUnary[xv].second += D - C;
+				const float w = B + C - A - D;
+				if (w > 0) m_maxFlow.addEdge(xu, xv, w, 0);		// non-submodular terms (w < 0) are truncated
+			}
+		} // e
+		for (int x = 0; x < nVars; x++)
+			m_maxFlow.addTerminalWeights(x, m_vUnary[x].second, m_vUnary[x].first);
+
+		m_maxFlow.maxFlow();
+
+		// Applying the move if it decreases the energy
+		m_vNewState = m_vState;
+		for (size_t n = 0; n < nNodes; n++)
+			if (m_vVar[n] >= 0) m_vNewState[n] = m_maxFlow.isSink(m_vVar[n]) ? state1(n) : state0(n);
+
+		const double newEnergy = calculateEnergy(m_vNewState);
+		if (newEnergy >= energy) return false;
+
+		m_vState.swap(m_vNewState);
+		energy = newEnergy;
+		return true;
+	}
+}
@@ -0,0 +1,91 @@
+// Graph-cut inference class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "MessagePassing.h"
+#include "MaxFlow.h"
+
+namespace DirectGraphicalModels
+{
+	// ==================== Graph-Cut Infer Class ==================
+	/**
+	* @ingroup moduleDecode
+	* @brief Graph-cut (move making) inference class
+	* @details This class finds an approximation of the most probable configuration (MAP) by minimizing the energy \f$-\log\psi\f$ of the graph with
+	* the \f$\alpha\f$-expansion or the \f$\alpha\beta\f$-swap moves, as described in the paper
+	* <a href="https://www.cs.cornell.edu/rdz/Papers/BVZ-pami01-final.pdf" target="_blank">Fast Approximate Energy Minimization via Graph Cuts</a>.
+	* Every move is an optimal binary labeling, found as the minimal cut with CMaxFlow. The moves are exact for the semi-metric (swap) and the
+	* metric (expansion) edge energies, \a e.g. for the Potts potentials built by CGraphPairwiseExt or CTrainEdgePottsCS. The non-submodular
+	* edge terms are truncated, and a move is accepted only if it decreases the energy, thus the energy never increases.
+	*
+	* One iteration is a cycle of moves over all the states (expansion) or all the pairs of states (swap). The inference stops before \a nIt
+	* iterations are done, if the last cycle did not decrease the energy (see CInfer::getNumIterations()).
+	*
+	* After the inference the node potentials contain the indicator vectors of the found configuration: 1 for the found state and 0 otherwise.
+	* > The class is derived from CMessagePassing only for the flat view of the graph; no messages are used.
+	*/
+	class CInferGraphCut : public CMessagePassing
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @param graph The graph
+		* @param swap Flag indicating whether the \f$\alpha\beta\f$-swap moves should be used instead of the \f$\alpha\f$-expansion moves
+		*/
+		DllExport CInferGraphCut(IGraphPairwise &graph, bool swap = false) : CMessagePassing(graph), m_swap(swap) {}
+		DllExport virtual ~CInferGraphCut(void) = default;
+
+		DllExport void	infer(unsigned int nIt = 1) override;
+		/**
+		* @brief Returns the energy of a configuration
+		* @details \f$E(x) = -\sum_i\log\psi_i(x_i) - \sum_{(i,j)}\log\psi_{ij}(x_i,x_j)\f$, where the second sum goes over the directed edges
+		* @param state The configuration: the states of all the nodes
+		* @return The energy, based on the current potentials of the graph
+		*/
+		DllExport double getEnergy(const vec_byte_t &state);
+
+
+	protected:
+		/**
+		* @brief Performs the cycles of the moves
+		* @param nIt The maximal number of cycles
+		*/
+		DllExport void	calculateMessages(unsigned int nIt) override;
+
+
+	private:
+		/**
+		* @brief Converts the node and edge potentials to energies
+		* @details The flat view of the graph must be created before calling this function
+		*/
+		void			createEnergies(void);
+		/**
+		* @brief Releases the energies
+		*/
+		void			deleteEnergies(void);
+		double			calculateEnergy(const vec_byte_t &state) const;
+		/**
+		* @brief Performs one move
+		* @details The nodes with the state \b alpha or \b beta (swap), or with a state other than \b alpha (expansion) choose between two states
+		* with a minimal cut. The configuration m_vState is changed if the energy decreases.
+		* @param alpha The state \f$\alpha\f$
+		* @param beta The state \f$\beta\f$ for the swap move; std::nullopt for the expansion move
+		* @param[in,out] energy The energy of the current configuration
+		* @retval true if the energy was decreased
+		* @retval false otherwise
+		*/
+		bool			move(byte alpha, std::optional<byte> beta, double &energy);
+
+
+	private:
+		bool						m_swap;				///< Flag indicating whether the swap moves are used
+		vec_float_t					m_vNodeEnergy;		///< Node energies: nNodes x nStates
+		vec_float_t					m_vEdgeEnergy;		///< Edge energies: one table per distinct edge potential
+		std::vector<const float *>	m_vpEdgeEnergy;		///< Edge energy table of every edge; NULL if the edge potential is not set
+		vec_byte_t					m_vState;			///< The current configuration
+		vec_byte_t					m_vNewState;		///< The configuration after the move
+		std::vector<int>			m_vVar;				///< Index of the binary variable of every node in the move; -1 for the fixed nodes
+		std::vector<std::pair<float, float>> m_vUnary;	///< Energies of the binary variables for the both choices
+		CMaxFlow					m_maxFlow;			///< Max-flow solver, reused for all the moves
+	};
+}
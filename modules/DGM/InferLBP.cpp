@@ -1,37 +1,52 @@
 #include "InferLBP.h"
-#include "GraphPairwise.h"
+#include "macroses.h"
+#include <mutex>
 
 namespace DirectGraphicalModels
 {
 	void CInferLBP::calculateMessages(unsigned int nIt)
 	{
 		const byte		nStates = getGraph().getNumStates();				// number of states
+		const bool		checkConvergence = getConvergenceTolerance().has_value();
+		std::mutex		mtx;
 		
 		// ======================== Main loop (iterative messages calculation) ========================
-		for (unsigned int i = 0; i < nIt; i++) {								// iterations
+		unsigned int i;
+		for (i = 0; i < nIt; i++) {												// iterations
 #ifdef DEBUG_PRINT_INFO
 			if (i == 0) printf("\n");
 			if (i % 5 == 0) printf("--- It: %d ---\n", i);
 #endif
+			float maxDelta = 0;													// maximal change of a message in the iteration
 #ifdef ENABLE_PDP
-			parallel_for_(Range(0, static_cast<int>(getGraphPairwise().m_vNodes.size())), [&, nStates](const Range& range) {		// all nodes
+			parallel_for_(Range(0, static_cast<int>(getView().getNumNodes())), [&, nStates](const Range& range) {		// all nodes
 #else
-			const Range range(0, getGraphPairwise().m_vNodes.size());
+			const Range range(0, static_cast<int>(getView().getNumNodes()));
 #endif
 			float* temp = new float[nStates];
+			float  delta = 0;
 			for (int i = range.start; i < range.end; i++) {
-				ptr_node_t& node = getGraphPairwise().m_vNodes[i];
 				// Calculate a message to each neighbor
-				for (size_t e_t : node->to) {									// outgoing edges
-					Edge* edge_to = getGraphPairwise().m_vEdges[e_t].get();		// current outgoing edge
-					calculateMessage(*edge_to, temp, getMessageTemp(e_t), m_maxSum);
-				} // e_t;
+				for (size_t e_t : getView().to(i)) {							// outgoing edges
+					float *msg_temp = getMessageTemp(e_t);
+					calculateMessage(e_t, temp, msg_temp, m_maxSum);
+					if (checkConvergence) {
+						const float *msg = getMessage(e_t);
+						for (byte s = 0; s < nStates; s++) delta = MAX(delta, fabs(msg_temp[s] - msg[s]));
+					}
+				} // e_t
 			} // i
 			delete[] temp;
+			if (checkConvergence) {
+				std::lock_guard<std::mutex> lock(mtx);
+				maxDelta = MAX(maxDelta, delta);
+			}
 #ifdef ENABLE_PDP			
 			});
 #endif
 			swapMessages();														// Coping data from msg_temp to msg
+			if (checkConvergence && isConverged(maxDelta)) { i++; break; }
 		} // iterations
+		setNumIterations(i);
 	}
 }
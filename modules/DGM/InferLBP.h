@@ -20,7 +20,7 @@ namespace DirectGraphicalModels
 		* @brief Constructor
 		* @param graph The graph
 		*/			
-		DllExport CInferLBP(CGraphPairwise &graph) : CMessagePassing(graph), m_maxSum(false) {}
+		DllExport CInferLBP(IGraphPairwise &graph) : CMessagePassing(graph), m_maxSum(false) {}
 		DllExport virtual ~CInferLBP(void) = default;
 
 
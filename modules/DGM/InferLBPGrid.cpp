@@ -0,0 +1,208 @@
+#include "InferLBPGrid.h"
+#include "GraphExt.h"
+#include "msgkernel.h"
+#include "macroses.h"
+#include <array>
+#include <mutex>
+
+namespace DirectGraphicalModels
+{
+	namespace {
+		// Code of the direction (dx, dy, dl) with each component in [-1; 1]: in range [0; 26], where 13 is the node itself
+		inline int dirCode(int dx, int dy, int dl) { return (dy + 1) * 9 + (dx + 1) * 3 + (dl + 1); }
+	}
+
+	void CInferLBPGrid::infer(unsigned int nIt)
+	{
+		const byte nStates = getGraph().getNumStates();
+
+		// ====================================== Initialization ======================================
+		createView();
+		createGrid();
+
+		// =================================== Calculating messages ==================================
+		calculateMessages(nIt);
+
+		// =================================== Calculating beliefs ===================================
+		const size_t nDirs = m_vOffset.size();
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(m_nNodes)), [&, nStates, nDirs](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(m_nNodes));
+#endif
+		for (int n = range.start; n < range.end; n++) {
+			float *pot = getView().vpNodePot[n];
+			for (size_t d = 0; d < nDirs; d++) {
+				if (!(m_vInMask[n] & (1u << d))) continue;
+				const float *msg = getMsg(m_vMsg, d, n);
+				for (byte s = 0; s < nStates; s++)
+					pot[s] = (FLT_EPSILON + pot[s]) * (FLT_EPSILON + msg[s]);		// Soft multiplication
+			} // d
+
+			// Normalization
+			float SUM_pot = 0;
+			for (byte s = 0; s < nStates; s++) SUM_pot += pot[s];
+			for (byte s = 0; s < nStates; s++) {
+				pot[s] /= SUM_pot;
+				DGM_ASSERT_MSG(!std::isnan(pot[s]), "The lower precision boundary for the potential of the node %d is reached.\n \
+						SUM_pot = %f\n", n, SUM_pot);
+			}
+		} // n
+#ifdef ENABLE_PDP
+		});
+#endif
+
+		deleteGrid();
+		deleteView();
+	}
+
+	void CInferLBPGrid::calculateMessages(unsigned int nIt)
+	{
+		const byte	 nStates	= getGraph().getNumStates();
+		const size_t nDirs		= m_vOffset.size();
+		const size_t rowLength	= static_cast<size_t>(m_size.width) * m_nLayers;		// number of nodes in one row of the grid
+		const bool	 checkConvergence = getConvergenceTolerance().has_value();
+		std::mutex	 mtx;
+
+		unsigned int i;
+		for (i = 0; i < nIt; i++) {														// iterations
+#ifdef DEBUG_PRINT_INFO
+			if (i == 0) printf("\n");
+			if (i % 5 == 0) printf("--- It: %d ---\n", i);
+#endif
+			float maxDelta = 0;															// maximal change of a message in the iteration
+#ifdef ENABLE_PDP
+			parallel_for_(Range(0, m_size.height), [&, nStates, nDirs, rowLength](const Range &range) {		// rows
+#else
+			const Range range(0, m_size.height);
+#endif
+			vec_float_t temp(nStates);
+			float delta = 0;
+			for (int y = range.start; y < range.end; y++) {
+				for (size_t n = y * rowLength; n < (y + 1) * rowLength; n++) {
+					const dword	  outMask = m_vOutMask[n];
+					const dword	  inMask  = m_vInMask[n];
+					const float * pot	  = getView().vpNodePot[n];
+
+					for (size_t d = 0; d < nDirs; d++) {
+						if (!(outMask & (1u << d))) continue;
+
+						// temp = node.Pot * all incoming messages, except the one from the destination node
+						std::copy(pot, pot + nStates, temp.begin());
+						for (size_t p = 0; p < nDirs; p++) {
+							if (p == d || !(inMask & (1u << p))) continue;
+							const float *msg = getMsg(m_vMsg, p, n);
+							for (byte s = 0; s < nStates; s++) temp[s] *= msg[s];
+						} // p
+
+						// The destination node receives the message from the opposite direction
+						float		*dst  = getMsg(m_vMsgTemp, m_vOpposite[d], n + m_vOffset[d]);
+						const float *pPot = m_vpOutPot[d * m_nNodes + n];
+						float Z = pPot ? msgkernel::matVec(pPot, nStates, temp.data(), dst, m_maxSum) : 0.0f;
+
+						// Normalization
+						if (Z > FLT_EPSILON)
+							for (byte s = 0; s < nStates; s++) dst[s] /= Z;
+						else
+							for (byte s = 0; s < nStates; s++) dst[s] = 1.0f / nStates;
+
+						if (checkConvergence) {
+							const float *msg = getMsg(m_vMsg, m_vOpposite[d], n + m_vOffset[d]);
+							for (byte s = 0; s < nStates; s++) delta = MAX(delta, fabs(dst[s] - msg[s]));
+						}
+					} // d
+				} // n
+			} // y
+			if (checkConvergence) {
+				std::lock_guard<std::mutex> lock(mtx);
+				maxDelta = MAX(maxDelta, delta);
+			}
+#ifdef ENABLE_PDP
+			});
+#endif
+			m_vMsg.swap(m_vMsgTemp);
+			if (checkConvergence && isConverged(maxDelta)) { i++; break; }
+		} // iterations
+		setNumIterations(i);
+	}
+
+	// ------------------------------ PRIVATE ------------------------------
+	void CInferLBPGrid::createGrid(void)
+	{
+		const GraphPairwiseView &view = getView();
+		const byte	nStates	= getGraph().getNumStates();
+		const int	nLayers = m_nLayers;
+
+		m_size	 = m_graphExt.getSize();
+		m_nNodes = view.getNumNodes();
+		DGM_ASSERT_MSG(m_nNodes == static_cast<size_t>(m_size.width) * m_size.height * m_nLayers,
+			"The number of nodes %zu does not match the grid size %d x %d x %d", m_nNodes, m_size.width, m_size.height, nLayers);
+
+		// Returns the code of the direction from node n1 to node n2
+		auto getDirCode = [&](size_t n1, size_t n2) {
+			const int l1 = static_cast<int>(n1 % m_nLayers);
+			const int l2 = static_cast<int>(n2 % m_nLayers);
+			const int x1 = static_cast<int>((n1 / m_nLayers) % m_size.width);
+			const int x2 = static_cast<int>((n2 / m_nLayers) % m_size.width);
+			const int y1 = static_cast<int>(n1 / m_nLayers / m_size.width);
+			const int y2 = static_cast<int>(n2 / m_nLayers / m_size.width);
+			DGM_ASSERT_MSG(n1 != n2 && abs(x2 - x1) <= 1 && abs(y2 - y1) <= 1 && abs(l2 - l1) <= 1, "The edge (%zu)->(%zu) does not connect neighbouring grid nodes", n1, n2);
+			return dirCode(x2 - x1, y2 - y1, l2 - l1);
+		};
+
+		// Detecting the directions, present in the graph (each together with its opposite one)
+		std::array<int, 27> vDirIdx;
+		vDirIdx.fill(-1);
+		m_vOffset.clear();
+		m_vOpposite.clear();
+		for (size_t e = 0; e < view.getNumEdges(); e++) {
+			const int code = getDirCode(view.pSrc[e], view.pDst[e]);
+			if (vDirIdx[code] >= 0) continue;
+			for (int c : { code, 26 - code }) {
+				const int dl = c % 3 - 1;
+				const int dx = (c / 3) % 3 - 1;
+				const int dy = c / 9 - 1;
+				vDirIdx[c] = static_cast<int>(m_vOffset.size());
+				m_vOffset.push_back((static_cast<ptrdiff_t>(dy) * m_size.width + dx) * m_nLayers + dl);
+			}
+			m_vOpposite.push_back(m_vOffset.size() - 1);
+			m_vOpposite.push_back(m_vOffset.size() - 2);
+		}
+		const size_t nDirs = m_vOffset.size();
+		DGM_ASSERT_MSG(nDirs <= 8 * sizeof(dword), "Too many neighbourhood directions: %zu", nDirs);
+
+		// Filling in the direction masks and the edge potential planes
+		m_vOutMask.assign(m_nNodes, 0);
+		m_vInMask.assign(m_nNodes, 0);
+		m_vpOutPot.assign(nDirs * m_nNodes, NULL);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(m_nNodes)), [&](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(m_nNodes));
+#endif
+		for (int n = range.start; n < range.end; n++) {
+			for (size_t e_t : view.to(n)) {
+				const int d = vDirIdx[getDirCode(n, view.pDst[e_t])];
+				m_vOutMask[n] |= 1u << d;
+				m_vpOutPot[d * m_nNodes + n] = view.vpEdgePotSqT[e_t];
+			}
+			for (size_t e_f : view.from(n))
+				m_vInMask[n] |= 1u << vDirIdx[getDirCode(n, view.pSrc[e_f])];
+		}
+#ifdef ENABLE_PDP
+		});
+#endif
+
+		m_vMsg.assign(nDirs * m_nNodes * nStates, 1.0f / nStates);
+		m_vMsgTemp.assign(nDirs * m_nNodes * nStates, 1.0f / nStates);
+	}
+
+	void CInferLBPGrid::deleteGrid(void)
+	{
+		m_vOutMask		= std::vector<dword>();
+		m_vInMask		= std::vector<dword>();
+		m_vpOutPot		= std::vector<const float *>();
+		m_vMsg			= vec_float_t();
+		m_vMsgTemp		= vec_float_t();
+	}
+}
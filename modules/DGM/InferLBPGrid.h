@@ -0,0 +1,84 @@
+// Grid Loopy Belief Propagation inference class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "MessagePassing.h"
+
+namespace DirectGraphicalModels
+{
+	class CGraphExt;
+
+	// ==================== Grid Loopy Belief Propagation Infer Class ==================
+	/**
+	* @ingroup moduleDecode
+	* @brief Sum product Loopy Belief Propagation inference class for grid graphs
+	* @details This class is specialized for the graphs, built with CGraphLayeredExt::buildGraph() or CGraphPairwiseExt::buildGraph(), where the node
+	* with the coordinates (\a x, \a y) in the layer \a l has index \f$(y \cdot width + x) \cdot nLayers + l\f$. The neighbours of a node are derived
+	* arithmetically from its index, and instead of the per-edge messages, this class keeps one dense message plane per neighbourhood direction.
+	* The planes are processed row by row, which makes the iterations considerably faster than the ones of generic CInferLBP on image-sized graphs.
+	*
+	* The directions are detected from the edges of the graph at the beginning of inference, thus any combination of the grid, diagonal and
+	* inter-layer edges is supported. The result is equal to the result of CInferLBP up to the rounding errors.
+	*/
+	class CInferLBPGrid : public CMessagePassing
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @param graph The graph
+		* @param graphExt The graph extension, which built the \b graph. It provides the size of the grid at the beginning of inference.
+		* @param nLayers The number of layers of the graph
+		*/
+		DllExport CInferLBPGrid(IGraphPairwise &graph, const CGraphExt &graphExt, word nLayers = 1)
+			: CMessagePassing(graph)
+			, m_graphExt(graphExt)
+			, m_nLayers(nLayers)
+			, m_maxSum(false)
+		{}
+		DllExport virtual ~CInferLBPGrid(void) = default;
+
+		DllExport void			infer(unsigned int nIt = 1) override;
+
+
+	protected:
+		DllExport void			calculateMessages(unsigned int nIt) override;
+		void					setMaxSum(bool maxSum) { m_maxSum = maxSum; }
+		bool					isMaxSum(void) const { return m_maxSum; }
+
+
+	private:
+		/**
+		* @brief Detects the neighbourhood directions and fills in the direction masks and the edge potential planes
+		* @details The flat view of the graph must be created before calling this function
+		*/
+		void					createGrid(void);
+		/**
+		* @brief Releases the message planes and the direction tables
+		*/
+		void					deleteGrid(void);
+		/**
+		* @brief Returns the pointer to the message, which the node \b node receives from the direction \b dir
+		* @param msg The message planes
+		* @param dir The direction index
+		* @param node The node index
+		* @return The pointer to \a nStates values
+		*/
+		float				  *	getMsg(vec_float_t &msg, size_t dir, size_t node) { return msg.data() + (dir * m_nNodes + node) * getGraph().getNumStates(); }
+
+
+	private:
+		const CGraphExt			  & m_graphExt;		///< The graph extension providing the grid size
+		const word					m_nLayers;		///< The number of layers
+		bool						m_maxSum;		///< Flag indicating weather the max-sum LBP should be applied
+
+		size_t						m_nNodes	= 0;	///< The number of nodes
+		Size						m_size;			///< The size of the grid
+		std::vector<ptrdiff_t>		m_vOffset;		///< Node index offset for every direction
+		vec_size_t					m_vOpposite;	///< Index of the opposite direction for every direction
+		std::vector<dword>			m_vOutMask;		///< Per node: bit \a d is set if the node has an outgoing edge in direction \a d
+		std::vector<dword>			m_vInMask;		///< Per node: bit \a d is set if the node has an incoming edge from direction \a d
+		std::vector<const float *>	m_vpOutPot;		///< Squared and transposed potentials of the outgoing edges: nDirections x nNodes
+		vec_float_t					m_vMsg;			///< Message planes: nDirections x nNodes x nStates. Plane \a d keeps the messages coming from the direction \a d
+		vec_float_t					m_vMsgTemp;		///< Temp message planes
+	};
+}
@@ -0,0 +1,293 @@
+#include "InferMinSum.h"
+#include "msgkernel.h"
+#include "macroses.h"
+#include <unordered_map>
+#include <mutex>
+
+namespace DirectGraphicalModels
+{
+	void CInferMinSum::infer(unsigned int nIt)
+	{
+		const byte nStates = getGraph().getNumStates();
+
+		// ====================================== Initialization ======================================
+		createView(false);
+		createEnergies();
+
+		const size_t size = getView().getNumEdges() * nStates;
+		if (m_halfPrecision)	for (auto &vMsg : m_vMsgHalf) vMsg.assign(size, float16_t(0.0f));
+		else					for (auto &vMsg : m_vMsg)	  vMsg.assign(size, 0.0f);
+
+		// =================================== Calculating messages ==================================
+		calculateMessages(nIt);
+
+		// =================================== Calculating beliefs ===================================
+		if (m_halfPrecision)	calculateBeliefs(m_vMsgHalf[0].data());
+		else					calculateBeliefs(m_vMsg[0].data());
+
+		deleteEnergies();
+		deleteView();
+	}
+
+	void CInferMinSum::calculateMessages(unsigned int nIt)
+	{
+		if (m_TRW) {
+			if (m_halfPrecision)	calculateMessagesTRW(m_vMsgHalf[0].data(), nIt);
+			else					calculateMessagesTRW(m_vMsg[0].data(), nIt);
+		}
+		else {
+			if (m_halfPrecision)	calculateMessagesFlooding(m_vMsgHalf, nIt);
+			else					calculateMessagesFlooding(m_vMsg, nIt);
+		}
+	}
+
+	// ------------------------------ PRIVATE ------------------------------
+	void CInferMinSum::createEnergies(void)
+	{
+		const GraphPairwiseView &view = getView();
+		const size_t nNodes	 = view.getNumNodes();
+		const size_t nEdges	 = view.getNumEdges();
+		const byte	 nStates = getGraph().getNumStates();
+		const size_t size	 = nStates * nStates;
+
+		// Edge energies: one table per distinct edge potential
+		std::unordered_map<const float *, size_t> mTable;
+		std::vector<const float *> vpTablePot;
+		vec_size_t vTable(nEdges);
+		for (size_t e = 0; e < nEdges; e++) {
+			const float *pPot = view.vpEdgePot[e];
+			if (!pPot) continue;
+			auto it = mTable.emplace(pPot, vpTablePot.size());
+			if (it.second) vpTablePot.push_back(pPot);
+			vTable[e] = it.first->second;
+		}
+		m_vEdgeEnergy.resize(vpTablePot.size() * size);
+		for (size_t t = 0; t < vpTablePot.size(); t++)
+			msgkernel::prepareEnergy(vpTablePot[t], nStates, m_vEdgeEnergy.data() + t * size);
+		m_vpEdgeEnergy.resize(nEdges);
+		for (size_t e = 0; e < nEdges; e++)
+			m_vpEdgeEnergy[e] = view.vpEdgePot[e] ? m_vEdgeEnergy.data() + vTable[e] * size : NULL;
+
+		// Node energies and reverse edges
+		m_vNodeEnergy.resize(nNodes * nStates);
+		m_vReverse.assign(nEdges, nEdges);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(nNodes)), [&, nStates](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(nNodes));
+#endif
+		std::vector<std::pair<size_t, size_t>> vIn;											// (source node, edge) of the incoming edges
+		for (int n = range.start; n < range.end; n++) {
+			const float *pot	= view.vpNodePot[n];
+			float		*energy = m_vNodeEnergy.data() + n * nStates;
+			for (byte s = 0; s < nStates; s++) energy[s] = -logf(MAX(pot[s], FLT_MIN));
+
+			vIn.clear();
+			for (size_t e_f : view.from(n)) vIn.emplace_back(view.pSrc[e_f], e_f);
+			std::sort(vIn.begin(), vIn.end());
+			for (size_t e_t : view.to(n)) {
+				auto it = std::lower_bound(vIn.begin(), vIn.end(), std::make_pair(view.pDst[e_t], static_cast<size_t>(0)));
+				if (it != vIn.end() && it->first == view.pDst[e_t]) m_vReverse[e_t] = it->second;
+			}
+		} // n
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	void CInferMinSum::deleteEnergies(void)
+	{
+		m_vNodeEnergy	= vec_float_t();
+		m_vEdgeEnergy	= vec_float_t();
+		m_vpEdgeEnergy	= std::vector<const float *>();
+		m_vReverse		= vec_size_t();
+		for (auto &vMsg : m_vMsg)	  vMsg = vec_float_t();
+		for (auto &vMsg : m_vMsgHalf) vMsg = std::vector<float16_t>();
+	}
+
+	// Parallel (flooding) schedule: all the messages are updated from the messages of the previous iteration
+	template <typename T>
+	void CInferMinSum::calculateMessagesFlooding(std::vector<T> (&vMsg)[2], unsigned int nIt)
+	{
+		const byte				 nStates = getGraph().getNumStates();
+		const GraphPairwiseView &view	 = getView();
+		const bool				 checkConvergence = getConvergenceTolerance().has_value();
+		std::mutex				 mtx;
+
+		unsigned int i;
+		for (i = 0; i < nIt; i++) {														// iterations
+#ifdef DEBUG_PRINT_INFO
+			if (i == 0) printf("\n");
+			if (i % 5 == 0) printf("--- It: %d ---\n", i);
+#endif
+			float	 maxDelta = 0;														// maximal change of a message in the iteration
+			const T *msg	  = vMsg[0].data();
+			T		*msgTemp  = vMsg[1].data();
+#ifdef ENABLE_PDP
+			parallel_for_(Range(0, static_cast<int>(view.getNumNodes())), [&, nStates, msg, msgTemp](const Range &range) {
+#else
+			const Range range(0, static_cast<int>(view.getNumNodes()));
+#endif
+			vec_float_t h(nStates), temp(nStates), dst(nStates);
+			float		delta = 0;
+			for (int n = range.start; n < range.end; n++) {
+				calculateBelief(msg, n, h.data());
+				for (size_t e_t : view.to(n)) {
+					calculateMessageMinSum(msg, e_t, h.data(), temp.data(), dst.data());
+					if (checkConvergence)
+						for (byte s = 0; s < nStates; s++) delta = MAX(delta, fabs(dst[s] - static_cast<float>(msg[e_t * nStates + s])));
+					for (byte s = 0; s < nStates; s++) msgTemp[e_t * nStates + s] = T(dst[s]);
+				} // e_t
+			} // n
+			if (checkConvergence) {
+				std::lock_guard<std::mutex> lock(mtx);
+				maxDelta = MAX(maxDelta, delta);
+			}
+#ifdef ENABLE_PDP
+			});
+#endif
+			vMsg[0].swap(vMsg[1]);
+			if (checkConvergence && isConverged(maxDelta)) { i++; break; }
+		} // iterations
+		setNumIterations(i);
+	}
+
+	// Sequential TRW-S schedule: the messages are updated in place in the forward and backward passes along the node indexes
+	template <typename T>
+	void CInferMinSum::calculateMessagesTRW(T *msg, unsigned int nIt)
+	{
+		const byte				 nStates = getGraph().getNumStates();
+		const GraphPairwiseView &view	 = getView();
+		const bool				 checkConvergence = getConvergenceTolerance().has_value();
+		std::mutex				 mtx;
+
+		vec_size_t vNodes, vLevelStart;
+		createSchedule(vNodes, vLevelStart);
+		const size_t nLevels = vLevelStart.size() - 1;
+
+		unsigned int i;
+		for (i = 0; i < nIt; i++) {														// iterations
+#ifdef DEBUG_PRINT_INFO
+			if (i == 0) printf("\n");
+			if (i % 5 == 0) printf("--- It: %d ---\n", i);
+#endif
+			float maxDelta = 0;															// maximal change of a message in the iteration
+			for (int pass = 0; pass < 2; pass++) {										// forward and backward passes
+				const bool forward = pass == 0;
+				for (size_t k = 0; k < nLevels; k++) {									// levels
+					const size_t  l			  = forward ? k : nLevels - 1 - k;
+					const size_t *pNodes	  = vNodes.data() + vLevelStart[l];
+					const int	  nLevelNodes = static_cast<int>(vLevelStart[l + 1] - vLevelStart[l]);
+#ifdef ENABLE_PDP
+					parallel_for_(Range(0, nLevelNodes), [&, nStates, forward, pNodes, nLevelNodes](const Range &range) {
+#else
+					const Range range(0, nLevelNodes);
+#endif
+					vec_float_t h(nStates), temp(nStates), dst(nStates);
+					float		delta = 0;
+					for (int j = range.start; j < range.end; j++) {
+						const size_t n = pNodes[forward ? j : nLevelNodes - 1 - j];
+
+						// TRW weight: the node belongs to max(nForward, nBackward) monotonic chains
+						int nForward = 0;
+						int nBackward = 0;
+						for (size_t e_t : view.to(n)) {
+							if (view.pDst[e_t] > n) nForward++;
+							if (view.pDst[e_t] < n) nBackward++;
+						}
+						const float gamma = 1.0f / MAX(1, MAX(nForward, nBackward));
+
+						calculateBelief(msg, n, h.data());
+						for (byte s = 0; s < nStates; s++) h[s] *= gamma;
+
+						for (size_t e_t : view.to(n)) {
+							if (forward ? view.pDst[e_t] < n : view.pDst[e_t] > n) continue;
+							calculateMessageMinSum(msg, e_t, h.data(), temp.data(), dst.data());
+							T *pMsg = msg + e_t * nStates;
+							if (checkConvergence)
+								for (byte s = 0; s < nStates; s++) delta = MAX(delta, fabs(dst[s] - static_cast<float>(pMsg[s])));
+							for (byte s = 0; s < nStates; s++) pMsg[s] = T(dst[s]);
+						} // e_t
+					} // j
+					if (checkConvergence) {
+						std::lock_guard<std::mutex> lock(mtx);
+						maxDelta = MAX(maxDelta, delta);
+					}
+#ifdef ENABLE_PDP
+					});
+#endif
+				} // k
+			} // pass
+
+			if (checkConvergence && isConverged(maxDelta)) { i++; break; }
+		} // iterations
+		setNumIterations(i);
+	}
+
+	template <typename T>
+	void CInferMinSum::calculateBeliefs(const T *msg)
+	{
+		const byte				 nStates = getGraph().getNumStates();
+		const GraphPairwiseView &view	 = getView();
+
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(view.getNumNodes())), [&, nStates](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(view.getNumNodes()));
+#endif
+		vec_float_t h(nStates);
+		for (int n = range.start; n < range.end; n++) {
+			calculateBelief(msg, n, h.data());
+			const float min = *std::min_element(h.begin(), h.end());
+
+			// Converting to the normalized min-marginals: the sum is at least 1, thus it never underflows
+			float *pot = view.vpNodePot[n];
+			float  sum = 0;
+			for (byte s = 0; s < nStates; s++) {
+				pot[s] = expf(min - h[s]);
+				sum += pot[s];
+			}
+			for (byte s = 0; s < nStates; s++) pot[s] /= sum;
+		} // n
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	template <typename T>
+	void CInferMinSum::calculateBelief(const T *msg, size_t node, float *h)
+	{
+		const byte nStates = getGraph().getNumStates();
+		const float *energy = m_vNodeEnergy.data() + node * nStates;
+
+		std::copy(energy, energy + nStates, h);													// h = node.Energy
+		for (size_t e_f : getView().from(node)) {
+			const T *pMsg = msg + e_f * nStates;
+			for (byte s = 0; s < nStates; s++) h[s] += static_cast<float>(pMsg[s]);				// h += edge_from.msg
+		}
+	}
+
+	template <typename T>
+	void CInferMinSum::calculateMessageMinSum(const T *msg, size_t edge, const float *h, float *temp, float *dst)
+	{
+		const byte	 nStates = getGraph().getNumStates();
+		const float *pEnergy = m_vpEdgeEnergy[edge];
+
+		if (!pEnergy) {
+			std::fill(dst, dst + nStates, 0.0f);
+			return;
+		}
+
+		// temp = h - the message from the destination node
+		const size_t rev = m_vReverse[edge];
+		if (rev < m_vReverse.size()) {
+			const T *pMsg = msg + rev * nStates;
+			for (byte s = 0; s < nStates; s++) temp[s] = h[s] - static_cast<float>(pMsg[s]);
+		}
+		else std::copy(h, h + nStates, temp);
+
+		// dst[y] = min_x(temp[x] + edge.Energy(x, y)) - min
+		const float min = msgkernel::minSum(pEnergy, nStates, temp, dst);
+		for (byte s = 0; s < nStates; s++) dst[s] -= min;
+	}
+}
@@ -0,0 +1,96 @@
+// Min-sum message passing inference class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "MessagePassing.h"
+
+namespace DirectGraphicalModels
+{
+	// ==================== Min-Sum Infer Class ==================
+	/**
+	* @ingroup moduleDecode
+	* @brief Min-sum (energy domain) message passing inference class
+	* @details This class is the energy domain counterpart of CInferViterbi: the potentials \f$\psi\f$ are converted to the energies \f$-\log\psi\f$,
+	* and the messages are computed with additions and minimums instead of the multiplications and maximums. In contrast to the probability domain,
+	* the messages are normalized by subtracting their minimum, and the message from the destination node is excluded from the node belief by
+	* subtraction, which makes the update of all the messages sent by a node linear in its degree. The beliefs never underflow, thus the inference
+	* is numerically stable on the graphs with high node degrees.
+	*
+	* The messages may be stored in half precision (16-bit floating point), which halves the memory traffic of the message passing.
+	* The messages are normalized to the minimum 0, thus the loss of precision is limited to the relative error of about \f$10^{-3}\f$.
+	*
+	* After the inference the node potentials contain the normalized min-marginals \f$\exp(-(b_i - \min b_i))\f$.
+	* @see CInferMinSumTRW for the sequential tree-reweighted message passing in the energy domain
+	*/
+	class CInferMinSum : public CMessagePassing
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @param graph The graph
+		* @param halfPrecision Flag indicating whether the messages should be stored in half precision
+		*/
+		DllExport CInferMinSum(IGraphPairwise &graph, bool halfPrecision = false) : CMessagePassing(graph), m_halfPrecision(halfPrecision), m_TRW(false) {}
+		DllExport virtual ~CInferMinSum(void) = default;
+
+		DllExport void	infer(unsigned int nIt = 1) override;
+
+
+	protected:
+		DllExport void	calculateMessages(unsigned int nIt) override;
+		/**
+		* @brief Switches to the sequential tree-reweighted message passing (TRW-S)
+		* @param TRW Flag indicating whether TRW-S should be applied instead of the parallel (flooding) message passing
+		*/
+		void			setTRW(bool TRW) { m_TRW = TRW; }
+
+
+	private:
+		/**
+		* @brief Converts the node and edge potentials to energies and finds the reverse edges
+		* @details The flat view of the graph must be created before calling this function
+		*/
+		void			createEnergies(void);
+		/**
+		* @brief Releases the energies and the messages
+		*/
+		void			deleteEnergies(void);
+		template <typename T>
+		void			calculateMessagesFlooding(std::vector<T> (&vMsg)[2], unsigned int nIt);
+		template <typename T>
+		void			calculateMessagesTRW(T *msg, unsigned int nIt);
+		template <typename T>
+		void			calculateBeliefs(const T *msg);
+		/**
+		* @brief Calculates the energy belief of the node \b node
+		* @details \f$h = \theta_{node} + \sum_{e\in from(node)} m_e\f$
+		* @param msg The messages
+		* @param node The node index
+		* @param h The resulting belief of \a nStates values
+		*/
+		template <typename T>
+		void			calculateBelief(const T *msg, size_t node, float *h);
+		/**
+		* @brief Calculates one message
+		* @details \f$m_e(y) = \min_x (E_e(x, y) + h(x) - m_{rev(e)}(x))\f$, normalized to the minimum 0
+		* @param msg The messages
+		* @param edge The edge index
+		* @param h The belief of the source node, scaled with the TRW weight if needed
+		* @param temp Auxilary array of \b nStates values
+		* @param dst Destination array of \b nStates values
+		*/
+		template <typename T>
+		void			calculateMessageMinSum(const T *msg, size_t edge, const float *h, float *temp, float *dst);
+
+
+	private:
+		bool						m_halfPrecision;	///< Flag indicating whether the messages are stored in half precision
+		bool						m_TRW;				///< Flag indicating whether TRW-S should be applied
+		vec_float_t					m_vNodeEnergy;		///< Node energies: nNodes x nStates
+		vec_float_t					m_vEdgeEnergy;		///< Edge energies: one transposed table per distinct edge potential
+		std::vector<const float *>	m_vpEdgeEnergy;		///< Edge energy table of every edge; NULL if the edge potential is not set
+		vec_size_t					m_vReverse;			///< Index of the reverse edge of every edge; the number of edges if there is no reverse edge
+		vec_float_t					m_vMsg[2];			///< Messages and temp messages in single precision
+		std::vector<float16_t>		m_vMsgHalf[2];		///< Messages and temp messages in half precision
+	};
+}
@@ -0,0 +1,29 @@
+// Min-sum tree-reweighted inference class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "InferMinSum.h"
+
+namespace DirectGraphicalModels
+{
+	// ==================== Min-Sum TRW-S Infer Class ==================
+	/**
+	* @ingroup moduleDecode
+	* @brief Sequential tree-reweighted (TRW-S) inference class in the energy domain
+	* @details The nodes are processed in the forward and backward passes along their indexes, as described in the paper
+	* <a href="http://pub.ist.ac.at/~vnk/papers/TRW-S-PAMI.pdf" target="_blank">Convergent Tree-reweighted Message Passing for Energy Minimization</a>.
+	* If \b ENABLE_PDP is defined, the independent nodes are processed concurrently (see CMessagePassing::createSchedule()), which does not
+	* change the result.
+	*/
+	class CInferMinSumTRW : public CInferMinSum
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @param graph The graph
+		* @param halfPrecision Flag indicating whether the messages should be stored in half precision
+		*/
+		DllExport CInferMinSumTRW(IGraphPairwise &graph, bool halfPrecision = false) : CInferMinSum(graph, halfPrecision) { setTRW(true); }
+		DllExport virtual ~CInferMinSumTRW(void) = default;
+	};
+}
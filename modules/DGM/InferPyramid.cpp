@@ -0,0 +1,219 @@
+#include "InferPyramid.h"
+#include "GraphPairwiseCSR.h"
+#include "GraphExt.h"
+#include "macroses.h"
+#include <unordered_map>
+
+namespace DirectGraphicalModels
+{
+	namespace {
+		const size_t npos = static_cast<size_t>(-1);
+	}
+
+	CInferPyramid::CInferPyramid(IGraphPairwise &graph, const CGraphExt &graphExt, word nLayers, const infer_factory_t &inferFactory, word nLevels, unsigned int nItCoarse)
+		: CInfer(graph)
+		, m_graph(graph)
+		, m_graphExt(graphExt)
+		, m_nLayers(nLayers)
+		, m_inferFactory(inferFactory)
+		, m_nLevels(nLevels)
+		, m_nItCoarse(nItCoarse)
+	{
+		DGM_ASSERT_MSG(m_inferFactory, "The inference factory is not set");
+		DGM_ASSERT_MSG(m_nLayers > 0, "Wrong number of layers %d", m_nLayers);
+		DGM_ASSERT_MSG(m_nLevels > 0, "Wrong number of levels %d", m_nLevels);
+	}
+
+	void CInferPyramid::infer(unsigned int nIt)
+	{
+		const byte nStates = getGraph().getNumStates();
+		std::unique_ptr<CMessagePassing> pInfer = m_inferFactory(m_graph);
+		DGM_ASSERT_MSG(pInfer, "The inference factory returned no algorithm");
+		pInfer->setConvergenceTolerance(getConvergenceTolerance());
+
+		// ====================================== Building the pyramid ======================================
+		std::vector<Level> vLevels(1);
+		vLevels.reserve(m_nLevels);
+		vLevels[0].size = m_graphExt.getSize();
+		DGM_ASSERT_MSG(static_cast<size_t>(vLevels[0].size.area()) * m_nLayers == getGraph().getNumNodes(), "The size of the grid (%d x %d x %d) does not correspond to the number of nodes (%zu)",
+			vLevels[0].size.width, vLevels[0].size.height, m_nLayers, getGraph().getNumNodes());
+
+		// The view has the same order of the edges as the messages of the algorithm
+		GraphPairwiseView view;
+		CMessagePassing::buildView(m_graph, view, false);
+		const size_t *pSrc = view.pSrc;
+		const size_t *pDst = view.pDst;
+		std::vector<const float *> vpNodePot(view.vpNodePot.begin(), view.vpNodePot.end());
+		std::vector<const float *> vpEdgePot(view.vpEdgePot);
+		while (vLevels.size() < m_nLevels && vLevels.back().size.area() > 1) {
+			Level coarse;
+			buildLevel(vLevels.back().size, pSrc, pDst, vpNodePot, vpEdgePot, vLevels.back().vParentEdge, coarse);
+			vLevels.push_back(std::move(coarse));
+
+			// The next coarser level is built from this one
+			const Level &level = vLevels.back();
+			pSrc = level.vSrc.data();
+			pDst = level.vDst.data();
+			vpNodePot.resize(level.vNodePot.size() / nStates);
+			for (size_t n = 0; n < vpNodePot.size(); n++) vpNodePot[n] = level.vNodePot.data() + n * nStates;
+			vpEdgePot.resize(level.vSrc.size());
+			for (size_t e = 0; e < vpEdgePot.size(); e++) vpEdgePot[e] = level.vEdgePot.data() + e * nStates * nStates;
+		}
+
+		// ===================================== Coarse-to-fine inference =====================================
+		vec_float_t vMsg;
+		for (size_t l = vLevels.size() - 1; l > 0; l--) {
+			Level &level = vLevels[l];
+			const size_t nNodes = level.vNodePot.size() / nStates;
+			const size_t nEdges = level.vSrc.size();
+
+			CGraphPairwiseCSR graph(nStates);
+			graph.reserve(nNodes, nEdges);
+			graph.addNodes(nNodes);
+			graph.setNodes(0, nNodes, level.vNodePot.data());
+			graph.addEdges(level.vSrc, level.vDst);
+			graph.setEdges(0, nEdges, level.vEdgePot.data());
+			level = Level();
+
+			std::unique_ptr<CMessagePassing> pCoarseInfer = m_inferFactory(graph);
+			DGM_ASSERT_MSG(pCoarseInfer, "The inference factory returned no algorithm");
+			pCoarseInfer->setConvergenceTolerance(getConvergenceTolerance());
+			if (!vMsg.empty()) pCoarseInfer->setInitialMessages(vMsg);
+			pCoarseInfer->keepMessages();
+			pCoarseInfer->infer(m_nItCoarse);
+
+			upsampleMessages(vLevels[l - 1].vParentEdge, pCoarseInfer->getMessages(), vMsg);
+		} // l
+
+		if (!vMsg.empty()) pInfer->setInitialMessages(vMsg);
+		pInfer->infer(nIt);
+		setNumIterations(pInfer->getNumIterations());
+	}
+
+	// ------------------------- Private -------------------------
+	void CInferPyramid::buildLevel(Size size, const size_t *pSrc, const size_t *pDst, const std::vector<const float *> &vpNodePot, const std::vector<const float *> &vpEdgePot, vec_size_t &vParentEdge, Level &coarse) const
+	{
+		const byte		nStates	= getGraph().getNumStates();
+		const size_t	nEdges	= vpEdgePot.size();
+		coarse.size = Size((size.width + 1) / 2, (size.height + 1) / 2);
+		const size_t	nCoarseNodes = static_cast<size_t>(coarse.size.area()) * m_nLayers;
+
+		// ------------------------- Node potentials -------------------------
+		// Geometric mean of the potentials of the 2 x 2 children
+		coarse.vNodePot.resize(nCoarseNodes * nStates);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, coarse.size.height), [&](const Range &range) {
+#else
+		const Range range(0, coarse.size.height);
+#endif
+		for (int y = range.start; y < range.end; y++)
+			for (int x = 0; x < coarse.size.width; x++)
+				for (word l = 0; l < m_nLayers; l++) {
+					float *pPot = coarse.vNodePot.data() + ((static_cast<size_t>(y) * coarse.size.width + x) * m_nLayers + l) * nStates;
+					std::fill(pPot, pPot + nStates, 0.0f);
+					int nChildren = 0;
+					for (int dy = 0; dy < 2; dy++)
+						for (int dx = 0; dx < 2; dx++) {
+							const int cx = 2 * x + dx;
+							const int cy = 2 * y + dy;
+							if (cx >= size.width || cy >= size.height) continue;
+							const float *pChildPot = vpNodePot[(static_cast<size_t>(cy) * size.width + cx) * m_nLayers + l];
+							if (!pChildPot) continue;
+							for (byte s = 0; s < nStates; s++) pPot[s] += logf(FLT_EPSILON + pChildPot[s]);
+							nChildren++;
+						} // dx
+					if (!nChildren) {
+						std::fill(pPot, pPot + nStates, 1.0f / nStates);
+						continue;
+					}
+					const float maxLog = *std::max_element(pPot, pPot + nStates);
+					float sum = 0;
+					for (byte s = 0; s < nStates; s++) {
+						pPot[s] = expf((pPot[s] - maxLog) / nChildren);
+						sum += pPot[s];
+					}
+					for (byte s = 0; s < nStates; s++) pPot[s] /= sum;
+				} // l
+#ifdef ENABLE_PDP
+		});
+#endif
+
+		// ------------------------- Edges -------------------------
+		// Parent of the node and its coordinates in the coarser grid
+		auto getParent = [&](size_t node, int &x, int &y) {
+			const size_t l = node % m_nLayers;
+			const size_t p = node / m_nLayers;
+			x = static_cast<int>(p % size.width);
+			y = static_cast<int>(p / size.width);
+			return ((static_cast<size_t>(y / 2)) * coarse.size.width + x / 2) * m_nLayers + l;
+		};
+
+		std::unordered_map<size_t, size_t> mEdges;						// (src, dst) -> coarse edge
+		mEdges.reserve(nEdges / 2);
+		std::vector<const float *> vpCoarseEdgePot;
+		vec_bool_t vIsSameDisplacement;
+		vParentEdge.assign(nEdges, npos);
+		for (size_t e = 0; e < nEdges; e++) {
+			int x1, y1, x2, y2;
+			const size_t p1 = getParent(pSrc[e], x1, y1);
+			const size_t p2 = getParent(pDst[e], x2, y2);
+			if (p1 == p2) continue;												// both nodes are in the same block
+
+			auto res = mEdges.emplace(p1 * nCoarseNodes + p2, coarse.vSrc.size());
+			const size_t ce = res.first->second;
+			if (res.second) {
+				coarse.vSrc.push_back(p1);
+				coarse.vDst.push_back(p2);
+				vpCoarseEdgePot.push_back(NULL);
+				vIsSameDisplacement.push_back(false);
+			}
+			vParentEdge[e] = ce;
+
+			// The potential is preferably taken from an edge with the same displacement as the coarse edge
+			const bool isSameDisplacement = (x2 - x1 == x2 / 2 - x1 / 2) && (y2 - y1 == y2 / 2 - y1 / 2);
+			if (vpEdgePot[e] && (!vpCoarseEdgePot[ce] || (isSameDisplacement && !vIsSameDisplacement[ce]))) {
+				vpCoarseEdgePot[ce] = vpEdgePot[e];
+				vIsSameDisplacement[ce] = isSameDisplacement;
+			}
+		} // e
+
+		const size_t nCoarseEdges = coarse.vSrc.size();
+		const size_t size2 = static_cast<size_t>(nStates) * nStates;
+		coarse.vEdgePot.resize(nCoarseEdges * size2);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(nCoarseEdges)), [&](const Range &edgeRange) {
+#else
+		const Range edgeRange(0, static_cast<int>(nCoarseEdges));
+#endif
+		for (int e = edgeRange.start; e < edgeRange.end; e++) {
+			float *pPot = coarse.vEdgePot.data() + e * size2;
+			if (vpCoarseEdgePot[e]) std::copy(vpCoarseEdgePot[e], vpCoarseEdgePot[e] + size2, pPot);
+			else std::fill(pPot, pPot + size2, 1.0f);
+		} // e
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	void CInferPyramid::upsampleMessages(const vec_size_t &vParentEdge, const vec_float_t &vCoarseMsg, vec_float_t &vMsg) const
+	{
+		const byte		nStates	= getGraph().getNumStates();
+		const size_t	nEdges	= vParentEdge.size();
+
+		vMsg.resize(nEdges * nStates);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(nEdges)), [&](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(nEdges));
+#endif
+		for (int e = range.start; e < range.end; e++) {
+			float *pMsg = vMsg.data() + e * nStates;
+			const size_t ce = vParentEdge[e];
+			if (ce == npos) std::fill(pMsg, pMsg + nStates, 1.0f / nStates);
+			else std::copy(vCoarseMsg.begin() + ce * nStates, vCoarseMsg.begin() + (ce + 1) * nStates, pMsg);
+		} // e
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+}
@@ -0,0 +1,99 @@
+// Coarse-to-fine inference class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "MessagePassing.h"
+
+namespace DirectGraphicalModels
+{
+	class CGraphExt;
+
+	// ============================= Pyramid Infer Class =============================
+	/**
+	* @ingroup moduleDecode
+	* @brief Coarse-to-fine (multi-resolution) inference class for grid graphs
+	* @details This class accelerates the convergence of the message passing algorithms on the graphs, built with CGraphLayeredExt::buildGraph()
+	* or CGraphPairwiseExt::buildGraph(), where the node with the coordinates (\a x, \a y) in the layer \a l has index \f$(y \cdot width + x) \cdot nLayers + l\f$.
+	* Instead of starting with the uniform messages, which need many iterations to propagate the information across large homogeneous regions,
+	* it builds a pyramid of coarser grids, runs the inference from the coarsest level to the finest one and initializes the messages of every level
+	* with the converged messages of the next coarser level:
+	* - Every node of a coarser level represents 2 x 2 nodes of the finer level in the same layer. Its potential is the geometric mean of their potentials.
+	* - Every edge of the finer level, connecting the nodes with different parents, corresponds to the coarser edge between the parents. The potential
+	* of the coarser edge is taken from a corresponding finer edge with the same displacement, \a e.g. from a horizontal edge for a horizontal coarser edge.
+	* - Every edge of the finer level gets the message of the corresponding coarser edge. The edges inside the 2 x 2 blocks start with the uniform messages.
+	*
+	* The message passing algorithm is created for every level with the factory. The algorithm must start with the uniform messages, which are
+	* replaced with CMessagePassing::setInitialMessages(), \a e.g. CInferLBP or CInferTRW:
+	* @code
+	* CInferPyramid inferer(graph, graphExt, 1, [](IGraphPairwise &graph) { return std::make_unique<CInferTRW>(graph); });
+	* vec_byte_t decoding = inferer.decode(10);
+	* @endcode
+	*/
+	class CInferPyramid : public CInfer
+	{
+	public:
+		/// Message passing algorithm factory
+		using infer_factory_t = std::function<std::unique_ptr<CMessagePassing>(IGraphPairwise &graph)>;
+
+
+	public:
+		/**
+		* @brief Constructor
+		* @param graph The graph
+		* @param graphExt The graph extension, which built the \b graph. It provides the size of the grid at the beginning of inference.
+		* @param nLayers The number of layers of the graph
+		* @param inferFactory The function, creating the message passing algorithm for a level of the pyramid
+		* @param nLevels The number of levels of the pyramid, including the original graph
+		* @param nItCoarse Number of iterations of the inference on every coarser level
+		*/
+		DllExport CInferPyramid(IGraphPairwise &graph, const CGraphExt &graphExt, word nLayers, const infer_factory_t &inferFactory, word nLevels = 3, unsigned int nItCoarse = 10);
+		DllExport virtual ~CInferPyramid(void) = default;
+
+		/**
+		* @brief Inference
+		* @details The iterations of the coarser levels are not counted in getNumIterations()
+		* @param nIt Number of iterations on the original graph
+		*/
+		DllExport void			infer(unsigned int nIt = 1) override;
+
+
+	private:
+		/// Level of the pyramid
+		struct Level {
+			Size		size;			///< The size of the grid
+			vec_size_t	vSrc;			///< Source node of every edge
+			vec_size_t	vDst;			///< Destination node of every edge
+			vec_float_t	vNodePot;		///< Node potentials: nNodes x nStates
+			vec_float_t	vEdgePot;		///< Edge potentials: nEdges x nStates x nStates
+			vec_size_t	vParentEdge;	///< For every edge: the corresponding edge of the next coarser level or \a npos
+		};
+
+		/**
+		* @brief Builds the next coarser level
+		* @param[in] size The size of the grid of the finer level
+		* @param[in] pSrc The source node of every edge of the finer level
+		* @param[in] pDst The destination node of every edge of the finer level
+		* @param[in] vpNodePot The node potentials of the finer level: NULL if not set
+		* @param[in] vpEdgePot The edge potentials of the finer level: NULL if not set
+		* @param[out] vParentEdge The corresponding edges of the coarser level for the edges of the finer level
+		* @param[out] coarse The coarser level
+		*/
+		void	buildLevel(Size size, const size_t *pSrc, const size_t *pDst, const std::vector<const float *> &vpNodePot, const std::vector<const float *> &vpEdgePot, vec_size_t &vParentEdge, Level &coarse) const;
+		/**
+		* @brief Upsamples the messages of the coarser level
+		* @param[in] vParentEdge The corresponding edges of the coarser level for the edges of the finer level
+		* @param[in] vCoarseMsg The messages of the coarser level
+		* @param[out] vMsg The initial messages of the finer level
+		*/
+		void	upsampleMessages(const vec_size_t &vParentEdge, const vec_float_t &vCoarseMsg, vec_float_t &vMsg) const;
+
+
+	private:
+		IGraphPairwise	& m_graph;				///< The graph
+		const CGraphExt	& m_graphExt;			///< The graph extension
+		word			  m_nLayers;			///< The number of layers
+		infer_factory_t	  m_inferFactory;		///< The message passing algorithm factory
+		word			  m_nLevels;			///< The number of levels of the pyramid
+		unsigned int	  m_nItCoarse;			///< Number of iterations on the coarser levels
+	};
+}
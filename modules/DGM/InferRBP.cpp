@@ -0,0 +1,145 @@
+#include "InferRBP.h"
+#include "macroses.h"
+#include <queue>
+
+namespace DirectGraphicalModels
+{
+	namespace {
+		// Priority queue of edges, ordered by their residuals. The outdated entries are skipped, when popped
+		using residual_queue_t = std::priority_queue<std::pair<float, size_t>>;
+	}
+
+	void CInferRBP::calculateMessages(unsigned int nIt)
+	{
+		const size_t maxUpdates = static_cast<size_t>(nIt) * getView().getNumEdges();
+
+		m_nUpdates = 0;
+		m_vResidual.assign(getView().getNumEdges(), 0.0f);
+#ifdef ENABLE_PDP
+		calculateMessagesParallel(maxUpdates);
+#else
+		calculateMessagesSequential(maxUpdates);
+#endif
+		m_vResidual = vec_float_t();
+		setNumIterations(static_cast<unsigned int>((m_nUpdates + getView().getNumEdges() - 1) / MAX(static_cast<size_t>(1), getView().getNumEdges())));
+
+#ifdef DEBUG_PRINT_INFO
+		printf("\n%zu message updates (%.2f iterations)\n", m_nUpdates, static_cast<float>(m_nUpdates) / MAX(static_cast<size_t>(1), getView().getNumEdges()));
+#endif
+	}
+
+	// ------------------------------ PRIVATE ------------------------------
+	float CInferRBP::calculateResidual(size_t edge, float *temp)
+	{
+		const byte nStates = getGraph().getNumStates();
+		float *msg	= getMessage(edge);
+		float *cand = getMessageTemp(edge);
+		calculateMessage(edge, temp, cand, isMaxSum());
+
+		float res = 0;
+		for (byte s = 0; s < nStates; s++) res = MAX(res, fabs(cand[s] - msg[s]));
+		m_vResidual[edge] = res;
+		return res;
+	}
+
+	void CInferRBP::commitMessage(size_t edge)
+	{
+		memcpy(getMessage(edge), getMessageTemp(edge), getGraph().getNumStates() * sizeof(float));
+		m_vResidual[edge] = 0;
+	}
+
+	// Strict residual scheduling: the message with the largest residual is always committed first
+	void CInferRBP::calculateMessagesSequential(size_t maxUpdates)
+	{
+		const GraphPairwiseView &view = getView();
+		vec_float_t temp(getGraph().getNumStates());
+		residual_queue_t queue;
+
+		for (size_t e = 0; e < view.getNumEdges(); e++) {
+			float res = calculateResidual(e, temp.data());
+			if (res > m_tolerance) queue.emplace(res, e);
+		}
+
+		while (!queue.empty() && m_nUpdates < maxUpdates) {
+			const auto [res, e] = queue.top();
+			queue.pop();
+			if (res != m_vResidual[e]) continue;										// outdated entry
+
+			commitMessage(e);
+			m_nUpdates++;
+
+			// Updating the messages, sent by the destination node
+			const size_t node = view.pDst[e];
+			for (size_t e_t : view.to(node)) {
+				if (view.pDst[e_t] == view.pSrc[e]) continue;							// does not depend on the committed message
+				float res_t = calculateResidual(e_t, temp.data());
+				if (res_t > m_tolerance) queue.emplace(res_t, e_t);
+			} // e_t
+		}
+	}
+
+	// Relaxed residual scheduling: the nodes are split into blocks with own priority queues, which are processed in parallel rounds.
+	// The edges are owned by the block of their source node, thus every residual and candidate message is written by one block only
+	void CInferRBP::calculateMessagesParallel(size_t maxUpdates)
+	{
+		const GraphPairwiseView &view = getView();
+		const byte	 nStates	= getGraph().getNumStates();
+		const size_t nNodes		= view.getNumNodes();
+		const size_t nBlocks	= MIN(nNodes, static_cast<size_t>(MAX(1, getNumThreads())) * 4);
+		if (nBlocks == 0) return;
+		const size_t blockSize	= (nNodes + nBlocks - 1) / nBlocks;
+		const size_t batchSize	= MAX(static_cast<size_t>(1), view.getNumEdges() / (nBlocks * 8));			// number of messages committed by a block in one round
+
+		std::vector<residual_queue_t>	vQueue(nBlocks);
+		std::vector<vec_size_t>			vCommitted(nBlocks);							// edges, committed by the block in the current round
+		vec_byte_t						vIsCommitted(view.getNumEdges(), 0);
+
+		// Computes the candidate messages, sent by the nodes of the block
+		auto updateBlock = [&](size_t b, float *temp, bool all) {
+			for (size_t n = b * blockSize; n < MIN((b + 1) * blockSize, nNodes); n++) {
+				bool isChanged = all;
+				for (size_t e_f : view.from(n))
+					if (vIsCommitted[e_f]) { isChanged = true; break; }
+				if (!isChanged) continue;
+				for (size_t e_t : view.to(n)) {
+					float res = calculateResidual(e_t, temp);
+					if (res > m_tolerance) vQueue[b].emplace(res, e_t);
+				} // e_t
+			} // n
+		};
+
+		parallel_for_(Range(0, static_cast<int>(nBlocks)), [&](const Range &range) {
+			vec_float_t temp(nStates);
+			for (int b = range.start; b < range.end; b++) updateBlock(b, temp.data(), true);
+		});
+
+		while (m_nUpdates < maxUpdates) {
+			// Committing the largest residuals of every block
+			parallel_for_(Range(0, static_cast<int>(nBlocks)), [&](const Range &range) {
+				for (int b = range.start; b < range.end; b++) {
+					for (size_t e : vCommitted[b]) vIsCommitted[e] = 0;
+					vCommitted[b].clear();
+					while (!vQueue[b].empty() && vCommitted[b].size() < batchSize) {
+						const auto [res, e] = vQueue[b].top();
+						vQueue[b].pop();
+						if (res != m_vResidual[e]) continue;								// outdated entry
+						commitMessage(e);
+						vIsCommitted[e] = 1;
+						vCommitted[b].push_back(e);
+					}
+				} // b
+			});
+
+			size_t nCommitted = 0;
+			for (const vec_size_t &committed : vCommitted) nCommitted += committed.size();
+			if (nCommitted == 0) break;
+			m_nUpdates += nCommitted;
+
+			// Updating the messages, which depend on the committed ones
+			parallel_for_(Range(0, static_cast<int>(nBlocks)), [&](const Range &range) {
+				vec_float_t temp(nStates);
+				for (int b = range.start; b < range.end; b++) updateBlock(b, temp.data(), false);
+			});
+		}
+	}
+}
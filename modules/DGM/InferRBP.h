@@ -0,0 +1,72 @@
+// Residual Belief Propagation inference class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "InferLBP.h"
+
+namespace DirectGraphicalModels
+{
+	// ==================== Residual Belief Propagation Infer Class ==================
+	/**
+	* @ingroup moduleDecode
+	* @brief Sum product Residual Belief Propagation inference class
+	* @details In contrast to CInferLBP, which recomputes all the messages in every iteration, this class schedules the message updates
+	* asynchronously: the message with the largest residual (the largest change between its committed value and the value computed from the
+	* current incoming messages) is committed first, and only the messages depending on it are recomputed. The inference stops when all the
+	* residuals are below the tolerance, or when the number of message updates reaches \a nIt times the number of edges, \a i.e. the work of
+	* \a nIt iterations of CInferLBP.
+	*
+	* If \b ENABLE_PDP is defined, the relaxed parallel scheduler is used: the nodes are split into blocks, each block keeps its own priority
+	* queue of the messages sent by its nodes, and in every round each block commits a batch of its largest residuals in parallel.
+	*/
+	class CInferRBP : public CInferLBP
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @param graph The graph
+		* @param tolerance The residual, below which a message is considered converged
+		*/
+		DllExport CInferRBP(IGraphPairwise &graph, float tolerance = 1e-5f) : CInferLBP(graph), m_tolerance(tolerance), m_nUpdates(0) {}
+		DllExport virtual ~CInferRBP(void) = default;
+
+		/**
+		* @brief Sets the tolerance
+		* @param tolerance The residual, below which a message is considered converged
+		*/
+		DllExport void		setTolerance(float tolerance) { m_tolerance = tolerance; }
+		/**
+		* @brief Returns the number of message updates performed by the last inference
+		* @return The number of committed messages
+		*/
+		DllExport size_t	getNumUpdates(void) const { return m_nUpdates; }
+
+
+	protected:
+		DllExport void		calculateMessages(unsigned int nIt) override;
+
+
+	private:
+		/**
+		* @brief Computes the candidate message for the edge \b edge and returns its residual
+		* @details The candidate message is stored in msg_temp container
+		* @param edge The edge index
+		* @param temp Auxilary array of \b nStates values
+		* @return The maximal absolute difference between the candidate and the committed messages
+		*/
+		float	calculateResidual(size_t edge, float *temp);
+		/**
+		* @brief Commits the candidate message of the edge \b edge
+		* @param edge The edge index
+		*/
+		void	commitMessage(size_t edge);
+		void	calculateMessagesSequential(size_t maxUpdates);
+		void	calculateMessagesParallel(size_t maxUpdates);
+
+
+	private:
+		float		m_tolerance;		///< The residual, below which a message is considered converged
+		size_t		m_nUpdates;			///< The number of message updates performed by the last inference
+		vec_float_t	m_vResidual;		///< The residual of every edge
+	};
+}
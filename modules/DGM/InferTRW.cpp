@@ -1,145 +1,208 @@
 #include "InferTRW.h"
-#include "GraphPairwise.h"
+#include "msgkernel.h"
 #include "macroses.h"
+#include <mutex>
 
 namespace DirectGraphicalModels
 {
+	namespace {
+		// The levels with fewer nodes are processed in the calling thread, since dispatching them to the threads costs more than processing them
+		const int PARALLEL_LEVEL_SIZE = 64;
+	}
+
 	void CInferTRW::infer(unsigned int nIt)
 	{
 		const byte nStates = getGraph().getNumStates();					// number of states (classes)
 
-		// ====================================== Initialization ======================================			
+		// ====================================== Initialization ======================================
+		createView(false);
 		createMessages(1.0f);
 
-		// =================================== Calculating messages ==================================	
+		// =================================== Calculating messages ==================================
 
 		calculateMessages(nIt);
 
-		// =================================== Calculating beliefs ===================================	
+		// =================================== Calculating beliefs ===================================
 
-		for (ptr_node_t &node : getGraphPairwise().m_vNodes) {
+		const GraphPairwiseView &view = getView();
+		vec_byte_t vSol(view.getNumNodes(), 0);
+		for (size_t n = 0; n < view.getNumNodes(); n++) {
+			float *pot = view.vpNodePot[n];
 			// backward edges
-			for (size_t e_f : node->from) {
-				Edge * edge_from = getGraphPairwise().m_vEdges[e_f].get();
-				if (edge_from->node1 > edge_from->node2) continue;
-				Node *src = getGraphPairwise().m_vNodes[edge_from->node1].get();
-				for (byte s = 0; s < nStates; s++) node->Pot.at<float>(s, 0) *= edge_from->Pot.at<float>(src->sol, s);
+			for (size_t e_f : view.from(n)) {
+				if (view.pSrc[e_f] > view.pDst[e_f]) continue;
+				const float *pPot = view.vpEdgePot[e_f];
+				const byte	 sol  = vSol[view.pSrc[e_f]];
+				for (byte s = 0; s < nStates; s++) pot[s] *= pPot[sol * nStates + s];
 			}
 			// forward edges
-			for (size_t e_t : node->to) {
-				Edge *edge_to = getGraphPairwise().m_vEdges[e_t].get();
-				if (edge_to->node1 > edge_to->node2) continue;
+			for (size_t e_t : view.to(n)) {
+				if (view.pSrc[e_t] > view.pDst[e_t]) continue;
 				float *msg = getMessage(e_t);
-				for (byte s = 0; s < nStates; s++) node->Pot.at<float>(s, 0) *= msg[s];
+				for (byte s = 0; s < nStates; s++) pot[s] *= msg[s];
 			}
 
-			Point extremumLoc;
-			minMaxLoc(node->Pot, NULL, NULL, NULL, &extremumLoc);
-			node->sol = static_cast<byte> (extremumLoc.y);
+			vSol[n] = static_cast<byte>(std::max_element(pot, pot + nStates) - pot);
 		}
 
 		deleteMessages();
+		deleteView();
 	}
 
 	void CInferTRW::calculateMessages(unsigned int nIt)
 	{
 		const    byte	  nStates	= getGraph().getNumStates();										// number of states
-		float			* data		= new float[nStates];
-		float			* temp		= new float[nStates];
+		const bool		  checkConvergence = getConvergenceTolerance().has_value();
+		std::mutex		  mtx;
+
+		// Schedule: the nodes are grouped into levels, which are processed in order; the nodes of one level are processed concurrently
+		vec_size_t vNodes, vLevelStart;
+		createSchedule(vNodes, vLevelStart);
+		const size_t nLevels = vLevelStart.size() - 1;
+
+		// Processes the nodes [start; end) of a level and returns the maximal change of a message
+		auto processNodes = [&, nStates, checkConvergence](const size_t *pNodes, int nLevelNodes, int start, int end, bool forward) {
+			float buffer[3 * (std::numeric_limits<byte>::max() + 1)];									// data, temp and prev: nStates values each
+			float *data = buffer;
+			float *temp = buffer + nStates;
+			float *prev = checkConvergence ? buffer + 2 * nStates : NULL;
+			float delta = 0;
+			for (int j = start; j < end; j++) {
+				const size_t n = pNodes[forward ? j : nLevelNodes - 1 - j];
+				delta = MAX(delta, forward ? calculateForward(n, data, temp, prev) : calculateBackward(n, data, temp, prev));
+			} // j
+			return delta;
+		};
 
 		// main loop
-		for (unsigned int i = 0; i < nIt; i++) {										// iterations
+		unsigned int i;
+		for (i = 0; i < nIt; i++) {																	// iterations
 	#ifdef DEBUG_PRINT_INFO
 			if (i == 0) printf("\n");
 			if (i % 5 == 0) printf("--- It: %d ---\n", i);
 	#endif
-			// Forward pass
-			std::for_each(getGraphPairwise().m_vNodes.begin(), getGraphPairwise().m_vNodes.end(), [&](ptr_node_t &node) {
-				memcpy(data, node->Pot.data, nStates * sizeof(float));					// data = node.pot
-
-				int	nForward = 0;
-				for (size_t e_t : node->to) {
-					Edge *edge_to = getGraphPairwise().m_vEdges[e_t].get();
-					if (edge_to->node1 > edge_to->node2) continue;
-					float *msg = getMessage(e_t);
-					for (byte s = 0; s < nStates; s++) data[s] *= msg[s];				// data = node.pot * edge_to.msg
-					nForward++;
-				} // e_t
-			
-				int	nBackward = 0;
-				for (size_t e_f : node->from) {
-					Edge *edge_from = getGraphPairwise().m_vEdges[e_f].get();
-					if (edge_from->node1 > edge_from->node2) continue;
-					float *msg = getMessage(e_f);
-					for (byte s = 0; s < nStates; s++) data[s] *= msg[s];				// data = node.pot * edge_to.msg * edge_from.msg
-					nBackward++;
-				} // e_f
-
-				for (byte s = 0; s < nStates; s++) data[s] = static_cast<float>(fastPow(data[s], 1.0f / MAX(nForward, nBackward)));
-
-				// pass messages from i to nodes with higher m_ordering
-				for (size_t e_t : node->to) {
-					Edge *edge_to = getGraphPairwise().m_vEdges[e_t].get();
-					if (edge_to->node1 < edge_to->node2) calculateMessage(getMessage(e_t), *edge_to, temp, data);
-				} // e_t
-			});
-
-			// Backward pass
-			std::for_each(getGraphPairwise().m_vNodes.rbegin(), getGraphPairwise().m_vNodes.rend(), [&](ptr_node_t &node) {
-				memcpy(data, node->Pot.data, nStates * sizeof(float));							// data = node.pot
-
-				int	nForward = 0;
-				for (size_t e_t : node->to) {
-					Edge *edge_to = getGraphPairwise().m_vEdges[e_t].get();
-					if (edge_to->node1 > edge_to->node2) continue;
-					float *msg = getMessage(e_t);
-					for (byte s = 0; s < nStates; s++) data[s] *= msg[s];
-					nForward++;
-				} // e_t
-			
-				int	nBackward = 0;
-				for (size_t e_f : node->from) {
-					Edge *edge_from = getGraphPairwise().m_vEdges[e_f].get();
-					if (edge_from->node1 > edge_from->node2) continue;
-					float *msg = getMessage(e_f);
-					for (byte s = 0; s < nStates; s++) data[s] *= msg[s];
-					nBackward++;
-				} // e_f
-
-				// normalize data
-				float max = data[0];
-				for (byte s = 1; s < nStates; s++) if (max < data[s]) max = data[s];
-				for (byte s = 0; s < nStates; s++) data[s] /= max;
-				for (byte s = 0; s < nStates; s++) data[s] = static_cast<float>(fastPow(data[s], 1.0f / MAX(nForward, nBackward)));
-
-				// pass messages from i to nodes with smaller m_ordering
-				for (size_t e_f : node->from) {
-					Edge *edge_from = getGraphPairwise().m_vEdges[e_f].get();
-					if (edge_from->node1 < edge_from->node2) calculateMessage(getMessage(e_f), *edge_from, temp, data);
-				} // e_f
-			}); // All Nodes
+			float maxDelta = 0;																		// maximal change of a message in the iteration
+			for (int pass = 0; pass < 2; pass++) {													// forward and backward passes
+				const bool forward = pass == 0;
+				for (size_t k = 0; k < nLevels; k++) {												// levels
+					const size_t  l			= forward ? k : nLevels - 1 - k;
+					const size_t *pNodes	= vNodes.data() + vLevelStart[l];
+					const int	  nLevelNodes = static_cast<int>(vLevelStart[l + 1] - vLevelStart[l]);
+#ifdef ENABLE_PDP
+					if (nLevelNodes >= PARALLEL_LEVEL_SIZE) {
+						parallel_for_(Range(0, nLevelNodes), [&, forward, pNodes, nLevelNodes](const Range &range) {
+							const float delta = processNodes(pNodes, nLevelNodes, range.start, range.end, forward);
+							if (checkConvergence) {
+								std::lock_guard<std::mutex> lock(mtx);
+								maxDelta = MAX(maxDelta, delta);
+							}
+						});
+						continue;
+					}
+#endif
+					maxDelta = MAX(maxDelta, processNodes(pNodes, nLevelNodes, 0, nLevelNodes, forward));
+				} // k
+			} // pass
+
+			if (checkConvergence && isConverged(maxDelta)) { i++; break; }
 		} // iterations
+		setNumIterations(i);
+	}
 
-		delete[] data;
-		delete[] temp;
+	// Forward pass: passes the messages from node n to the nodes with higher ordering
+	float CInferTRW::calculateForward(size_t n, float *data, float *temp, float *prev)
+	{
+		const byte				 nStates = getGraph().getNumStates();
+		const GraphPairwiseView &view	 = getView();
+
+		memcpy(data, view.vpNodePot[n], nStates * sizeof(float));						// data = node.pot
+
+		int	nForward = 0;
+		for (size_t e_t : view.to(n)) {
+			if (view.pSrc[e_t] > view.pDst[e_t]) continue;
+			float *msg = getMessage(e_t);
+			for (byte s = 0; s < nStates; s++) data[s] *= msg[s];						// data = node.pot * edge_to.msg
+			nForward++;
+		} // e_t
+
+		int	nBackward = 0;
+		for (size_t e_f : view.from(n)) {
+			if (view.pSrc[e_f] > view.pDst[e_f]) continue;
+			float *msg = getMessage(e_f);
+			for (byte s = 0; s < nStates; s++) data[s] *= msg[s];						// data = node.pot * edge_to.msg * edge_from.msg
+			nBackward++;
+		} // e_f
+
+		for (byte s = 0; s < nStates; s++) data[s] = static_cast<float>(fastPow(data[s], 1.0f / MAX(nForward, nBackward)));
+
+		// pass messages from i to nodes with higher m_ordering
+		float delta = 0;
+		for (size_t e_t : view.to(n))
+			if (view.pSrc[e_t] < view.pDst[e_t]) delta = MAX(delta, updateMessage(e_t, temp, data, prev));
+		return delta;
 	}
 
-	// Updates edge->msg = F(data, edge.Pot)
-	void CInferTRW::calculateMessage(float *msg, Edge &edge, float *temp, float *data)
+	// Backward pass: passes the messages from node n to the nodes with smaller ordering
+	float CInferTRW::calculateBackward(size_t n, float *data, float *temp, float *prev)
+	{
+		const byte				 nStates = getGraph().getNumStates();
+		const GraphPairwiseView &view	 = getView();
+
+		memcpy(data, view.vpNodePot[n], nStates * sizeof(float));						// data = node.pot
+
+		int	nForward = 0;
+		for (size_t e_t : view.to(n)) {
+			if (view.pSrc[e_t] > view.pDst[e_t]) continue;
+			float *msg = getMessage(e_t);
+			for (byte s = 0; s < nStates; s++) data[s] *= msg[s];
+			nForward++;
+		} // e_t
+
+		int	nBackward = 0;
+		for (size_t e_f : view.from(n)) {
+			if (view.pSrc[e_f] > view.pDst[e_f]) continue;
+			float *msg = getMessage(e_f);
+			for (byte s = 0; s < nStates; s++) data[s] *= msg[s];
+			nBackward++;
+		} // e_f
+
+		// normalize data
+		float max = data[0];
+		for (byte s = 1; s < nStates; s++) if (max < data[s]) max = data[s];
+		for (byte s = 0; s < nStates; s++) data[s] /= max;
+		for (byte s = 0; s < nStates; s++) data[s] = static_cast<float>(fastPow(data[s], 1.0f / MAX(nForward, nBackward)));
+
+		// pass messages from i to nodes with smaller m_ordering
+		float delta = 0;
+		for (size_t e_f : view.from(n))
+			if (view.pSrc[e_f] < view.pDst[e_f]) delta = MAX(delta, updateMessage(e_f, temp, data, prev));
+		return delta;
+	}
+
+	// Updates the message and returns its maximal change, if prev is given
+	float CInferTRW::updateMessage(size_t edge, float *temp, float *data, float *prev)
 	{
 		const byte nStates = getGraph().getNumStates();
+		float	  *msg	   = getMessage(edge);
+
+		if (prev) std::copy(msg, msg + nStates, prev);
+		calculateMessage(msg, edge, temp, data);
+		
+		float delta = 0;
+		if (prev)
+			for (byte s = 0; s < nStates; s++) delta = MAX(delta, fabs(msg[s] - prev[s]));
+		return delta;
+	}
+
+	// Updates edge->msg = F(data, edge.Pot)
+	void CInferTRW::calculateMessage(float *msg, size_t edge, float *temp, float *data)
+	{
+		const byte	  nStates = getGraph().getNumStates();
+		const float * pEdgePot = getView().vpEdgePot[edge];
 
 		for (byte s = 0; s < nStates; s++) temp[s] = data[s] / MAX(FLT_EPSILON, msg[s]); 				// tmp = gamma * data / edge.msg
 
-		for (byte y = 0; y < nStates; y++) {
-			float *pPot = edge.Pot.ptr<float>(y);
-			float max = temp[0] * pPot[0];																// vMin = tmp + edge.Pot(0, kdest)
-			for (byte x = 1; x < nStates; x++) {
-				float val = temp[x] * pPot[x];
-				if (max < val) max = val;
-			}
-			msg[y] = max;
-		}
+		msgkernel::matVec(pEdgePot, nStates, temp, msg, true);											// msg[y] = max_x(tmp[x] * edge.Pot(y, x))
 
 		// Normalization
 		float max = msg[0];
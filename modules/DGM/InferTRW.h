@@ -6,14 +6,16 @@
 
 namespace DirectGraphicalModels
 {
-	struct Edge;
-	
 	// ==================== Microsoft TRW Decode Class ==================
 	/**
 	* @ingroup moduleDecode
 	* @brief Tree-reweighted inference class
 	* @details This class is based on the Tree-reweighted message passing algorithm (a modification of a max-poduct LBP algorithm), 
 	* described in the paper <a href="http://pub.ist.ac.at/~vnk/papers/TRW-S-PAMI.pdf" target="_blank">Convergent Tree-reweighted Message Passing for Energy Minimization</a>
+	* 
+	* If \b ENABLE_PDP is defined, the nodes are processed by levels: a level contains the nodes, whose neighbours with smaller indexes all 
+	* belong to the previous levels. The nodes of one level are not connected with each other and are processed concurrently, which keeps the 
+	* monotonic ordering of TRW-S, thus the result is identical to the sequential one. On grid graphs the levels are the anti-diagonal wavefronts.
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
 	class CInferTRW : public CMessagePassing
@@ -23,7 +25,7 @@ namespace DirectGraphicalModels
 		* @brief Constructor
 		* @param graph The graph
 		*/
-		DllExport CInferTRW(CGraphPairwise &graph) : CMessagePassing(graph) {}
+		DllExport CInferTRW(IGraphPairwise &graph) : CMessagePassing(graph) {}
 		DllExport virtual ~CInferTRW(void) = default;
 
 		DllExport virtual void infer(unsigned int nIt = 1);
@@ -31,6 +33,30 @@ namespace DirectGraphicalModels
 
 	protected:
 		DllExport virtual void	calculateMessages(unsigned int nIt);
-		void					calculateMessage(float* msg, Edge& edge, float* temp, float* data);
+		void					calculateMessage(float* msg, size_t edge, float* temp, float* data);
+
+
+	private:
+		/**
+		* @brief Processes the node \b n in the forward pass
+		* @details Updates the messages from the node \b n to its neighbours with larger indexes
+		* @param n The node index
+		* @param data Auxilary array of \b nStates values
+		* @param temp Auxilary array of \b nStates values
+		* @param prev Auxilary array of \b nStates values for tracking the change of the messages (may be NULL)
+		* @return The maximal change of the updated messages (0 if \b prev is NULL)
+		*/
+		float					calculateForward(size_t n, float *data, float *temp, float *prev);
+		/**
+		* @brief Processes the node \b n in the backward pass
+		* @details Updates the messages from the node \b n to its neighbours with smaller indexes
+		* @param n The node index
+		* @param data Auxilary array of \b nStates values
+		* @param temp Auxilary array of \b nStates values
+		* @param prev Auxilary array of \b nStates values for tracking the change of the messages (may be NULL)
+		* @return The maximal change of the updated messages (0 if \b prev is NULL)
+		*/
+		float					calculateBackward(size_t n, float *data, float *temp, float *prev);
+		float					updateMessage(size_t edge, float *temp, float *data, float *prev);
 	};
 }
@@ -1,10 +1,11 @@
 #include "InferTree.h"
-#include "GraphPairwise.h"
+#include <deque>
 
 namespace DirectGraphicalModels
 {
 	void CInferTree::calculateMessages(unsigned int)
 	{
+		const GraphPairwiseView &view = getView();
 		const byte		nStates	= getGraph().getNumStates();
 		const size_t	nNodes	= getGraph().getNumNodes();
 		const size_t	nEdges	= getGraph().getNumEdges();
@@ -16,9 +17,9 @@ namespace DirectGraphicalModels
 		// =================================== Computing messages ===================================
 		size_t  * nFromEdges = new size_t[nNodes];							// Count number of neighbors
 		std::deque<size_t> nodeQueue;
-		for (ptr_node_t &node: getGraphPairwise().m_vNodes) {
-			nFromEdges[node->id] = node->from.size();						// number of incoming edges
-			if (nFromEdges[node->id] <= 1) nodeQueue.push_back(node->id);	// Add all leafs to the queue
+		for (size_t n = 0; n < nNodes; n++) {
+			nFromEdges[n] = view.from(n).size();							// number of incoming edges
+			if (nFromEdges[n] <= 1) nodeQueue.push_back(n);					// Add all leafs to the queue
 		}
 
 
@@ -29,30 +30,27 @@ namespace DirectGraphicalModels
 			size_t n = nodeQueue.front();									// n - node with one neighbour
 			nodeQueue.pop_front();
 
-			Node  *node = getGraphPairwise().m_vNodes[n].get();				// Node with one neighbour
-			
 			bool allSuspend = true;
-			for (size_t e_t : node->to)
+			for (size_t e_t : view.to(n))
 				if (!suspend[e_t]) {
 					allSuspend = false;
 					break;
 				}
 
 			if (allSuspend) {	// Now prepare messages for suspending edges
-				for (size_t e_t : node->to) {
+				for (size_t e_t : view.to(n)) {
 					if (isReady[e_t]) continue;
 					
-					Edge *edge_to = getGraphPairwise().m_vEdges[e_t].get();
-					calculateMessage(*edge_to, temp, getMessage(e_t));
+					calculateMessage(e_t, temp, getMessage(e_t));
 					isReady[e_t] = true;
 					
 					// ------
-					size_t n1 = edge_to->node1;
-					size_t n2 = edge_to->node2;
-					auto it = std::find_if(getGraphPairwise().m_vNodes[n1]->from.begin(), getGraphPairwise().m_vNodes[n1]->from.end(), [&](size_t e) {
-						return (getGraphPairwise().m_vEdges[e]->node1 == n2);
+					size_t n1 = view.pSrc[e_t];
+					size_t n2 = view.pDst[e_t];
+					auto it = std::find_if(view.from(n1).begin(), view.from(n1).end(), [&](size_t e) {
+						return (view.pSrc[e] == n2);
 					});
-					if (it != getGraphPairwise().m_vNodes[n1]->from.end())
+					if (it != view.from(n1).end())
 						suspend[*it] = true;
 					// ------
 					
@@ -60,20 +58,19 @@ namespace DirectGraphicalModels
 					if (nFromEdges[n2] <= 1) nodeQueue.push_back(n2);
 				}
 			} else {			// Prepare messages for all non-suspending edges
-				for (size_t e_t : node->to) {
+				for (size_t e_t : view.to(n)) {
 					if (suspend[e_t]) continue;
 					if (isReady[e_t]) continue;
 					
-					Edge * edge_to = getGraphPairwise().m_vEdges[e_t].get();
-					calculateMessage(*edge_to, temp, getMessage(e_t));
+					calculateMessage(e_t, temp, getMessage(e_t));
 					isReady[e_t] = true;
 					// ------
-					size_t n1 = edge_to->node1;
-					size_t n2 = edge_to->node2;
-					auto it = std::find_if(getGraphPairwise().m_vNodes[n1]->from.begin(), getGraphPairwise().m_vNodes[n1]->from.end(), [&](size_t e) {
-						return (getGraphPairwise().m_vEdges[e]->node1 == n2);
+					size_t n1 = view.pSrc[e_t];
+					size_t n2 = view.pDst[e_t];
+					auto it = std::find_if(view.from(n1).begin(), view.from(n1).end(), [&](size_t e) {
+						return (view.pSrc[e] == n2);
 					});
-					if (it != getGraphPairwise().m_vNodes[n1]->from.end())
+					if (it != view.from(n1).end())
 						suspend[*it] = true;
 					// ------
 					
@@ -20,7 +20,7 @@ namespace DirectGraphicalModels
 		* @brief Constructor
 		* @param graph The graph
 		*/
-		DllExport CInferTree(CGraphPairwise & graph) : CMessagePassing(graph) {}
+		DllExport CInferTree(IGraphPairwise &graph) : CMessagePassing(graph) {}
 		DllExport virtual ~CInferTree(void) = default;
 
 
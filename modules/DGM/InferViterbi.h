@@ -19,7 +19,7 @@ namespace DirectGraphicalModels
 		* @brief Constructor
 		* @param graph The graph
 		*/			
-		DllExport CInferViterbi(CGraphPairwise &graph) : CInferLBP(graph) { setMaxSum(true); }
+		DllExport CInferViterbi(IGraphPairwise &graph) : CInferLBP(graph) { setMaxSum(true); }
 		DllExport virtual ~CInferViterbi(void) = default;
 	};
 
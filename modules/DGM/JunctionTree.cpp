@@ -0,0 +1,268 @@
+#include "JunctionTree.h"
+#include "IGraphPairwise.h"
+#include "macroses.h"
+#include <map>
+#include <set>
+
+namespace DirectGraphicalModels
+{
+	namespace {
+		// Switches the states of the nodes, starting from position <start>, to the consequent configuration. Returns false after the last one
+		inline bool incState(vec_byte_t &state, byte nStates, size_t start = 0)
+		{
+			for (size_t i = start; i < state.size(); i++)
+				if (++state[i] < nStates) return true;
+				else state[i] = 0;
+			return false;
+		}
+
+		inline void normalize(std::vector<double> &v)
+		{
+			double sum = 0;
+			for (double x : v) sum += x;
+			if (sum > 0)
+				for (double &x : v) x /= sum;
+		}
+	}
+
+	// Constructor
+	CJunctionTree::CJunctionTree(const IGraphPairwise &graph)
+		: m_nNodes(graph.getNumNodes())
+		, m_nStates(graph.getNumStates())
+	{
+		const byte nStates = m_nStates;
+
+		// ================================== Gathering the potentials ==================================
+		m_vNodePot.assign(m_nNodes * nStates, 1.0);
+		std::map<std::pair<size_t, size_t>, size_t> mTables;					// (node1 < node2) -> index of the pairwise table
+		std::vector<std::pair<size_t, size_t>> vTableNodes;
+		std::vector<std::set<size_t>> vAdj(m_nNodes);
+		Mat pot;
+		vec_size_t vChilds;
+		for (size_t n = 0; n < m_nNodes; n++) {
+			graph.getNode(n, pot);
+			if (!pot.empty())
+				for (byte s = 0; s < nStates; s++) m_vNodePot[n * nStates + s] = pot.at<float>(s, 0);
+
+			graph.getChildNodes(n, vChilds);
+			for (size_t c : vChilds) {
+				if (c == n) continue;
+				graph.getEdge(n, c, pot);
+				if (pot.empty()) continue;
+				const auto key = std::make_pair(MIN(n, c), MAX(n, c));
+				auto it = mTables.emplace(key, m_vPairPot.size());
+				if (it.second) {
+					m_vPairPot.emplace_back(nStates * nStates, 1.0);
+					vTableNodes.push_back(key);
+					vAdj[n].insert(c);
+					vAdj[c].insert(n);
+				}
+				std::vector<double> &table = m_vPairPot[it.first->second];
+				for (byte x = 0; x < nStates; x++)
+					for (byte y = 0; y < nStates; y++)
+						table[n < c ? x * nStates + y : y * nStates + x] *= pot.at<float>(x, y);
+			} // c
+		} // n
+
+		// =================================== Min-fill elimination ===================================
+		vec_size_t			vPosInOrder(m_nNodes);
+		std::vector<bool>	vEliminated(m_nNodes, false);
+		m_vCliques.resize(m_nNodes);
+		m_vOrder.clear();
+		for (size_t step = 0; step < m_nNodes; step++) {
+			size_t best		= m_nNodes;
+			size_t bestFill = 0;
+			for (size_t v = 0; v < m_nNodes; v++) {
+				if (vEliminated[v]) continue;
+				size_t fill = 0;
+				for (auto a = vAdj[v].begin(); a != vAdj[v].end(); a++)
+					for (auto b = std::next(a); b != vAdj[v].end(); b++)
+						if (!vAdj[*a].count(*b)) fill++;
+				if (best == m_nNodes || fill < bestFill || (fill == bestFill && vAdj[v].size() < vAdj[best].size())) {
+					best	 = v;
+					bestFill = fill;
+				}
+			} // v
+
+			Clique &clique = m_vCliques[best];
+			clique.vNodes.assign(1, best);
+			clique.vNodes.insert(clique.vNodes.end(), vAdj[best].begin(), vAdj[best].end());
+			for (size_t a : vAdj[best]) {
+				vAdj[a].erase(best);
+				for (size_t b : vAdj[best]) if (a != b) vAdj[a].insert(b);	// fill-in edges
+			}
+			vAdj[best].clear();
+			vEliminated[best]	= true;
+			vPosInOrder[best]	= step;
+			m_vOrder.push_back(best);
+		} // step
+
+		// =================================== Building the tree ===================================
+		for (size_t v : m_vOrder) {
+			Clique &clique = m_vCliques[v];
+			const size_t size = clique.vNodes.size();
+			DGM_ASSERT_MSG(powl(nStates, static_cast<long double>(size)) < 4294967296.0L,
+				"The clique of %zu nodes is too large: the treewidth of the graph is too high for the exact inference", size);
+
+			clique.parent = m_nNodes;
+			for (size_t i = 1; i < size; i++)
+				if (clique.parent == m_nNodes || vPosInOrder[clique.vNodes[i]] < vPosInOrder[clique.parent]) clique.parent = clique.vNodes[i];
+			if (clique.parent == m_nNodes) continue;
+
+			// The separator of the clique is a subset of the parent clique
+			Clique &parent = m_vCliques[clique.parent];
+			vec_size_t vPos;
+			for (size_t i = 1; i < size; i++) {
+				const auto it = std::find(parent.vNodes.begin(), parent.vNodes.end(), clique.vNodes[i]);
+				DGM_ASSERT(it != parent.vNodes.end());
+				vPos.push_back(it - parent.vNodes.begin());
+			}
+			parent.vChildren.push_back(v);
+			parent.vChildPos.push_back(vPos);
+		} // v
+
+		// Every pairwise table is assigned to the clique of its first eliminated node, which contains both nodes
+		for (size_t t = 0; t < m_vPairPot.size(); t++) {
+			const size_t node1 = vTableNodes[t].first;
+			const size_t node2 = vTableNodes[t].second;
+			Clique &clique = m_vCliques[vPosInOrder[node1] < vPosInOrder[node2] ? node1 : node2];
+			const size_t pos1 = std::find(clique.vNodes.begin(), clique.vNodes.end(), node1) - clique.vNodes.begin();
+			const size_t pos2 = std::find(clique.vNodes.begin(), clique.vNodes.end(), node2) - clique.vNodes.begin();
+			clique.vFactors.push_back({ t, pos1, pos2 });
+		}
+
+		m_vSepPos.resize(m_nNodes);
+		for (size_t v = 0; v < m_nNodes; v++) {
+			m_vSepPos[v].resize(m_vCliques[v].vNodes.size() - 1);
+			for (size_t i = 0; i < m_vSepPos[v].size(); i++) m_vSepPos[v][i] = i + 1;
+		}
+	}
+
+	Mat CJunctionTree::calculateMarginals(void)
+	{
+		const byte nStates = m_nStates;
+		calculateUpMessages(false);
+		calculateDownMessages();
+
+		// The marginal of a node is accumulated from the belief of its clique
+		Mat res(static_cast<int>(m_nNodes), nStates, CV_32FC1);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(m_nNodes)), [&, nStates](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(m_nNodes));
+#endif
+		std::vector<double> marginal(nStates);
+		vec_byte_t			state;
+		for (int v = range.start; v < range.end; v++) {
+			std::fill(marginal.begin(), marginal.end(), 0.0);
+			state.assign(m_vCliques[v].vNodes.size(), 0);
+			do marginal[state[0]] += calculateProduct(v, state, m_nNodes, true);
+			while (incState(state, nStates));
+			normalize(marginal);
+			for (byte s = 0; s < nStates; s++) res.at<float>(v, s) = static_cast<float>(marginal[s]);
+		} // v
+#ifdef ENABLE_PDP
+		});
+#endif
+		return res;
+	}
+
+	vec_byte_t CJunctionTree::decode(void)
+	{
+		calculateUpMessages(true);
+
+		// Back-tracking from the roots: the separator of every clique is eliminated later, thus its nodes are already decoded
+		vec_byte_t res(m_nNodes, 0);
+		vec_byte_t state;
+		for (auto it = m_vOrder.rbegin(); it != m_vOrder.rend(); it++) {
+			const Clique &clique = m_vCliques[*it];
+			state.resize(clique.vNodes.size());
+			for (size_t i = 1; i < state.size(); i++) state[i] = res[clique.vNodes[i]];
+			double max = -1;
+			for (byte s = 0; s < m_nStates; s++) {
+				state[0] = s;
+				const double val = calculateProduct(*it, state, m_nNodes, false);
+				if (val > max) {
+					max		 = val;
+					res[*it] = s;
+				}
+			}
+		}
+		return res;
+	}
+
+	size_t CJunctionTree::getTreeWidth(void) const
+	{
+		size_t res = 0;
+		for (const Clique &clique : m_vCliques) res = MAX(res, clique.vNodes.size() - 1);
+		return res;
+	}
+
+	// ------------------------- Private -------------------------
+	double CJunctionTree::calculateProduct(size_t node, const vec_byte_t &state, size_t exclude, bool down) const
+	{
+		const Clique &clique = m_vCliques[node];
+		double res = m_vNodePot[node * m_nStates + state[0]];
+		for (const Factor &factor : clique.vFactors) {
+			if (res == 0) return 0;
+			res *= m_vPairPot[factor.table][state[factor.pos1] * m_nStates + state[factor.pos2]];
+		}
+		for (size_t i = 0; i < clique.vChildren.size(); i++) {
+			if (res == 0) return 0;
+			if (clique.vChildren[i] != exclude) res *= m_vUp[clique.vChildren[i]][getIndex(state, clique.vChildPos[i])];
+		}
+		if (down && clique.parent != m_nNodes) res *= m_vDown[node][getIndex(state, m_vSepPos[node])];
+		return res;
+	}
+
+	size_t CJunctionTree::getIndex(const vec_byte_t &state, const vec_size_t &vPos) const
+	{
+		size_t res	  = 0;
+		size_t stride = 1;
+		for (size_t pos : vPos) {
+			res	   += state[pos] * stride;
+			stride *= m_nStates;
+		}
+		return res;
+	}
+
+	// Collecting: the children are eliminated before their parents
+	void CJunctionTree::calculateUpMessages(bool maxProduct)
+	{
+		m_vUp.resize(m_nNodes);
+		vec_byte_t state;
+		for (size_t v : m_vOrder) {
+			const Clique &clique = m_vCliques[v];
+			if (clique.parent == m_nNodes) continue;
+
+			std::vector<double> &msg = m_vUp[v];
+			msg.assign(static_cast<size_t>(powl(m_nStates, static_cast<long double>(clique.vNodes.size() - 1))), 0.0);
+			state.assign(clique.vNodes.size(), 0);
+			do {
+				const double val = calculateProduct(v, state, m_nNodes, false);
+				double &dst = msg[getIndex(state, m_vSepPos[v])];
+				dst = maxProduct ? MAX(dst, val) : dst + val;
+			} while (incState(state, m_nStates));
+			normalize(msg);
+		} // v
+	}
+
+	// Distributing: the parents are eliminated after their children
+	void CJunctionTree::calculateDownMessages(void)
+	{
+		m_vDown.resize(m_nNodes);
+		vec_byte_t state;
+		for (auto it = m_vOrder.rbegin(); it != m_vOrder.rend(); it++) {
+			const Clique &clique = m_vCliques[*it];
+			for (size_t i = 0; i < clique.vChildren.size(); i++) {
+				const size_t child = clique.vChildren[i];
+				std::vector<double> &msg = m_vDown[child];
+				msg.assign(m_vUp[child].size(), 0.0);
+				state.assign(clique.vNodes.size(), 0);
+				do msg[getIndex(state, clique.vChildPos[i])] += calculateProduct(*it, state, child, true);
+				while (incState(state, m_nStates));
+				normalize(msg);
+			} // i
+		} // it
+	}
+}
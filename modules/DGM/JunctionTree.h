@@ -0,0 +1,93 @@
+// Junction tree class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "types.h"
+
+namespace DirectGraphicalModels
+{
+	class IGraphPairwise;
+
+	// ============================= Junction Tree Class =============================
+	/**
+	* @ingroup moduleDecode
+	* @brief Junction tree for the exact inference and decoding
+	* @details The nodes of the graph are eliminated one by one in the greedy \a min-fill order, \a i.e. the node, whose elimination adds the
+	* least number of the fill-in edges, is eliminated first. The elimination of the node \f$v\f$ creates the clique \f$C_v\f$, containing \f$v\f$
+	* and its not yet eliminated neighbours (the separator \f$S_v\f$). The parent of \f$C_v\f$ is the clique of the first eliminated node of
+	* \f$S_v\f$, which results in a junction tree. The exact marginals are found with two passes of the sum-product message passing over the tree,
+	* and the exact MAP configuration - with one pass of the max-product message passing and back-tracking.
+	*
+	* The clique potentials are never stored: every message and every marginal is accumulated while enumerating the configurations of one clique.
+	* Thus the memory is needed only for the messages of \f$nStates^{|S_v|}\f$ values, and the complexity is \f$O(nNodes\cdot nStates^{w+1})\f$,
+	* where \f$w\f$ is the treewidth of the elimination order, instead of \f$O(nStates^{nNodes})\f$ of the exhaustive search.
+	*/
+	class CJunctionTree
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @details Copies the potentials of the graph and builds the junction tree
+		* @param graph The graph
+		*/
+		DllExport CJunctionTree(const IGraphPairwise &graph);
+		DllExport ~CJunctionTree(void) = default;
+
+		/**
+		* @brief Calculates the exact marginal probabilities of the nodes
+		* @return The marginals: Mat(size: nNodes x nStates; type: CV_32FC1)
+		*/
+		DllExport Mat			calculateMarginals(void);
+		/**
+		* @brief Calculates the exact most probable configuration
+		* @return The most probable configuration
+		*/
+		DllExport vec_byte_t	decode(void);
+		/**
+		* @brief Returns the treewidth of the elimination order
+		* @return The size of the largest clique minus 1
+		*/
+		DllExport size_t		getTreeWidth(void) const;
+
+
+	private:
+		/// Pairwise factor of a clique
+		struct Factor {
+			size_t	table;		///< Index of the pairwise table
+			size_t	pos1;		///< Position of the first node of the table in the clique
+			size_t	pos2;		///< Position of the second node of the table in the clique
+		};
+		/// Clique, created by the elimination of a node
+		struct Clique {
+			vec_size_t			vNodes;			///< The eliminated node, followed by the separator
+			size_t				parent;			///< The clique of the parent; nNodes for the roots
+			vec_size_t			vChildren;		///< The cliques of the children
+			std::vector<vec_size_t> vChildPos;	///< Positions of the separator nodes of every child in this clique
+			std::vector<Factor>	vFactors;		///< Pairwise factors, assigned to the clique
+		};
+
+		/**
+		* @brief Returns the product of the factors and the messages of the clique for one configuration
+		* @param node The clique (eliminated node) index
+		* @param state The states of the clique nodes
+		* @param exclude The child, whose message is excluded from the product; nNodes to include all the children
+		* @param down Flag indicating whether the message from the parent should be included
+		*/
+		double			calculateProduct(size_t node, const vec_byte_t &state, size_t exclude, bool down) const;
+		size_t			getIndex(const vec_byte_t &state, const vec_size_t &vPos) const;
+		void			calculateUpMessages(bool maxProduct);
+		void			calculateDownMessages(void);
+
+
+	private:
+		size_t					m_nNodes;
+		byte					m_nStates;
+		std::vector<double>		m_vNodePot;		///< Node potentials: nNodes x nStates
+		std::vector<std::vector<double>> m_vPairPot;	///< Pairwise tables: product of the potentials of the edges between two nodes
+		std::vector<Clique>		m_vCliques;		///< The cliques, indexed by the eliminated node
+		vec_size_t				m_vOrder;		///< The elimination order
+		std::vector<vec_size_t>	m_vSepPos;		///< Positions of the separator in the own clique: 1 .. size - 1
+		std::vector<std::vector<double>> m_vUp;		///< Messages from the cliques to their parents
+		std::vector<std::vector<double>> m_vDown;	///< Messages from the parents to the cliques
+	};
+}
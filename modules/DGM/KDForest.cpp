@@ -0,0 +1,195 @@
+#include "KDForest.h"
+#include "random.h"
+#include "macroses.h"
+
+namespace DirectGraphicalModels
+{
+	namespace {
+		const size_t RAND_DIMS = 5;		// The split dimension is chosen among RAND_DIMS dimensions with the largest spread
+		const size_t LEAF_SIZE = 16;	// Maximal number of points in a leaf
+	}
+
+	void CKDForest::reset(void)
+	{
+		IKNNIndex::reset();
+		m_vTrees.clear();
+	}
+
+	void CKDForest::build(const Mat &keys, const Mat &values)
+	{
+		DGM_ASSERT_MSG(m_nTrees > 0, "The number of trees must be positive");
+		DGM_ASSERT_MSG(static_cast<size_t>(keys.rows) <= std::numeric_limits<dword>::max(), "The amount of keys (%d) is too large", keys.rows);
+
+		setPoints(keys, values);
+		m_vTrees.assign(m_nTrees, Tree());
+		if (empty()) return;
+
+		const size_t nPoints = getNumPoints();
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, m_nTrees), [&](const Range &range) {
+#else
+		const Range range(0, m_nTrees);
+#endif
+		for (int t = range.start; t < range.end; t++) {
+			Tree &tree = m_vTrees[t];
+			tree.vIdx.resize(nPoints);
+			for (size_t i = 0; i < nPoints; i++) tree.vIdx[i] = static_cast<dword>(i);
+			tree.vSplitDim.assign(nPoints, 0);
+			tree.vSplitVal.assign(nPoints, 0);
+			buildTree(tree, 0, nPoints);
+			fillKeys(tree);
+		} // t
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	// ----------------------------------------- Protected -----------------------------------------
+	// File format: nTrees (word), for every tree: indices (nPoints dwords), split dimensions (nPoints words), split values (nPoints bytes)
+	void CKDForest::saveFile(FILE *pFile) const
+	{
+		fwrite(&m_nTrees, sizeof(word), 1, pFile);
+		for (const Tree &tree : m_vTrees) {
+			fwrite(tree.vIdx.data(), sizeof(dword), tree.vIdx.size(), pFile);
+			fwrite(tree.vSplitDim.data(), sizeof(word), tree.vSplitDim.size(), pFile);
+			fwrite(tree.vSplitVal.data(), sizeof(byte), tree.vSplitVal.size(), pFile);
+		}
+	}
+
+	void CKDForest::loadFile(FILE *pFile)
+	{
+		const size_t nPoints = getNumPoints();
+		fread(&m_nTrees, sizeof(word), 1, pFile);
+		DGM_ASSERT_MSG(m_nTrees > 0, "Wrong number of trees %d in the file", m_nTrees);
+		m_vTrees.assign(m_nTrees, Tree());
+		for (Tree &tree : m_vTrees) {
+			tree.vIdx.resize(nPoints);
+			tree.vSplitDim.resize(nPoints);
+			tree.vSplitVal.resize(nPoints);
+			fread(tree.vIdx.data(), sizeof(dword), nPoints, pFile);
+			fread(tree.vSplitDim.data(), sizeof(word), nPoints, pFile);
+			fread(tree.vSplitVal.data(), sizeof(byte), nPoints, pFile);
+			fillKeys(tree);
+		}
+	}
+
+	void CKDForest::query(const byte *pKey, size_t maxNeighbors, heap_t &heap) const
+	{
+		static thread_local std::vector<Branch> vBranches;
+
+		heap.clear();
+		if (maxNeighbors == 0) return;
+
+		const dword	 nPoints   = static_cast<dword>(getNumPoints());
+		const size_t maxChecks = m_maxChecks ? m_maxChecks : std::numeric_limits<size_t>::max();
+		size_t		 nChecks   = 0;
+
+		// Every tree is descended at least once
+		vBranches.clear();
+		for (word t = 0; t < m_nTrees; t++)
+			descend(pKey, { 0, 0, t, 0, nPoints }, maxNeighbors, heap, vBranches, nChecks);
+
+		// Best-bin-first backtracking
+		while (!vBranches.empty() && nChecks < maxChecks) {
+			std::pop_heap(vBranches.begin(), vBranches.end(), std::greater<Branch>());
+			const Branch branch = vBranches.back();
+			vBranches.pop_back();
+			if (heap.size() == maxNeighbors && branch.bound >= heap.front().first) continue;		// the branch can not contain nearer points
+			descend(pKey, branch, maxNeighbors, heap, vBranches, nChecks);
+		}
+
+		std::sort_heap(heap.begin(), heap.end());
+	}
+
+	// ----------------------------------------- Private -----------------------------------------
+	// The range [begin; end) is split in the middle in a random dimension among the ones with the largest spread
+	// left = [begin; mid): key[splitDim] <= splitVal
+	// right = [mid; end): key[splitDim] >= splitVal
+	void CKDForest::buildTree(Tree &tree, size_t begin, size_t end) const
+	{
+		if (end - begin <= LEAF_SIZE) return;
+		const size_t k		= m_k;
+		const byte	*pData	= m_vKeys.data();
+		dword		*pIdx	= tree.vIdx.data();
+
+		// Bounding box of the range
+		vec_byte_t vMin(pData + pIdx[begin] * k, pData + pIdx[begin] * k + k);
+		vec_byte_t vMax(vMin);
+		for (size_t i = begin + 1; i < end; i++) {
+			const byte *pKey = pData + pIdx[i] * k;
+			for (size_t x = 0; x < k; x++) {
+				if (vMin[x] > pKey[x]) vMin[x] = pKey[x];
+				if (vMax[x] < pKey[x]) vMax[x] = pKey[x];
+			} // x
+		} // i
+
+		// Dimensions sorted by the spread
+		std::vector<word> vDims(k);
+		for (word x = 0; x < m_k; x++) vDims[x] = x;
+		const size_t nDims = MIN(RAND_DIMS, k);
+		std::partial_sort(vDims.begin(), vDims.begin() + nDims, vDims.end(), [&](word a, word b) {
+			return vMax[a] - vMin[a] > vMax[b] - vMin[b];
+		});
+		const word splitDim = vDims[random::u<size_t>(0, nDims - 1)];
+
+		const size_t mid = (begin + end) / 2;
+		std::nth_element(pIdx + begin, pIdx + mid, pIdx + end, [pData, k, splitDim](dword a, dword b) {
+			return pData[a * k + splitDim] < pData[b * k + splitDim];
+		});
+		// The sub-trees reorder their ranges, thus the split value is stored
+		tree.vSplitDim[mid] = splitDim;
+		tree.vSplitVal[mid] = pData[pIdx[mid] * k + splitDim];
+
+		buildTree(tree, begin, mid);
+		buildTree(tree, mid, end);
+	}
+
+	void CKDForest::fillKeys(Tree &tree) const
+	{
+		const size_t k = m_k;
+		tree.vKeys.resize(tree.vIdx.size() * k);
+		for (size_t i = 0; i < tree.vIdx.size(); i++)
+			memcpy(&tree.vKeys[i * k], &m_vKeys[tree.vIdx[i] * k], k);
+	}
+
+	void CKDForest::descend(const byte *pKey, Branch branch, size_t maxNeighbors, heap_t &heap, std::vector<Branch> &vBranches, size_t &nChecks) const
+	{
+		const Tree &tree = m_vTrees[branch.tree];
+
+		// The farther sub-trees are stored with the lower bound of the distance to their points
+		while (branch.end - branch.begin > LEAF_SIZE) {
+			const dword mid		 = (branch.begin + branch.end) / 2;
+			const word	splitDim = tree.vSplitDim[mid];
+			const int	diff	 = static_cast<int>(pKey[splitDim]) - static_cast<int>(tree.vSplitVal[mid]);
+			const dword	diff2	 = static_cast<dword>(diff * diff);
+
+			Branch farBranch = branch;
+			farBranch.dist	= branch.dist + diff2;
+			farBranch.bound = MAX(branch.bound, diff2);
+			if (diff < 0)	{ farBranch.begin = mid;	branch.end	 = mid; }
+			else			{ farBranch.end	  = mid;	branch.begin = mid; }
+			if (heap.size() < maxNeighbors || farBranch.bound < heap.front().first) {
+				vBranches.push_back(farBranch);
+				std::push_heap(vBranches.begin(), vBranches.end(), std::greater<Branch>());
+			}
+		}
+
+		// Leaf
+		const size_t k = m_k;
+		for (dword i = branch.begin; i < branch.end; i++) {
+			const dword dist = getSqDistance(pKey, &tree.vKeys[i * k]);
+			nChecks++;
+			if (heap.size() < maxNeighbors || dist < heap.front().first) {
+				// The point might be already found in another tree
+				const dword idx = tree.vIdx[i];
+				bool isFound = false;
+				for (const auto &neighbor : heap)
+					if (neighbor.second == idx) {
+						isFound = true;
+						break;
+					}
+				if (!isFound) addNeighbor(dist, idx, maxNeighbors, heap);
+			}
+		} // i
+	}
+}
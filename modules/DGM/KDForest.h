@@ -0,0 +1,107 @@
+// Randomized k-D forest class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "IKNNIndex.h"
+
+namespace DirectGraphicalModels
+{
+	// ============================= Randomized k-D Forest Class =============================
+	/**
+	* @brief Randomized k-D forest for the approximate nearest neighbors search
+	* @details This class implements the approximate nearest neighbors search with multiple randomized k-D trees, as described in the paper
+	* <a href="https://www.cs.ubc.ca/research/flann/uploads/FLANN/flann_visapp09.pdf" target="_blank">Fast Approximate Nearest Neighbors with Automatic Algorithm Configuration</a>.
+	* The trees are implicit: every sub-tree occupies a range of the array of the points, which is split in the middle, and the leaves are the ranges
+	* of at most 16 points. The split dimension of every node is chosen randomly among the dimensions with the largest spread. Every tree keeps a copy
+	* of the keys in the order of its leaves, thus the points of a leaf are checked in one contiguous pass. The search descends all the trees and then
+	* continues with the best-bin-first backtracking: the unexplored branches are visited in the order of their distance to the search key,
+	* until \a maxChecks points are checked.
+	*
+	* The parameter \a maxChecks trades the recall for the speed: the larger it is, the more of the found neighbors are the true nearest neighbors.
+	* With \a maxChecks = 0 the backtracking is not bounded and the search is exact.
+	*/
+	class CKDForest : public IKNNIndex
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @param nTrees The number of randomized trees
+		* @param maxChecks The maximal number of points to be checked for one search key. 0 means the exact search
+		*/
+		DllExport CKDForest(word nTrees = 4, size_t maxChecks = 512) : m_nTrees(nTrees), m_maxChecks(maxChecks) {}
+		/**
+		* @brief Constructor
+		* @param keys The keys: k-d points: Mat(size: nKeys x k; type: CV_8UC1)
+		* @param values The values for every key: Mat(size: nKeys x 1; type: CV_8UC1)
+		* @param nTrees The number of randomized trees
+		* @param maxChecks The maximal number of points to be checked for one search key. 0 means the exact search
+		*/
+		DllExport CKDForest(const Mat &keys, const Mat &values, word nTrees = 4, size_t maxChecks = 512) : CKDForest(nTrees, maxChecks) { build(keys, values); }
+		DllExport virtual ~CKDForest(void) = default;
+
+		DllExport void	reset(void) override;
+		DllExport void	build(const Mat &keys, const Mat &values) override;
+
+		/**
+		* @brief Sets the maximal number of points to be checked for one search key
+		* @details The search parameter is not stored with the forest by save()
+		* @param maxChecks The maximal number of points to be checked for one search key. 0 means the exact search
+		*/
+		DllExport void	setMaxChecks(size_t maxChecks) { m_maxChecks = maxChecks; }
+		/**
+		* @brief Returns the maximal number of points to be checked for one search key
+		* @returns The maximal number of points to be checked for one search key
+		*/
+		DllExport size_t getMaxChecks(void) const { return m_maxChecks; }
+		/**
+		* @brief Returns the number of trees
+		* @returns The number of randomized trees
+		*/
+		DllExport word	getNumTrees(void) const { return m_nTrees; }
+
+
+	protected:
+		DllExport IndexType	getIndexType(void) const override { return IndexType::KDForest; }
+		DllExport void	saveFile(FILE *pFile) const override;
+		DllExport void	loadFile(FILE *pFile) override;
+		DllExport void	query(const byte *pKey, size_t maxNeighbors, heap_t &heap) const override;
+
+
+	private:
+		/// Implicit randomized k-d tree
+		struct Tree {
+			std::vector<dword>	vIdx;			///< Indices of the points in the order of the leaves
+			vec_byte_t			vKeys;			///< The keys in the order of the leaves: nPoints x k
+			std::vector<word>	vSplitDim;		///< The split dimension of every node, stored at the middle of its range
+			vec_byte_t			vSplitVal;		///< The split value of every node, stored at the middle of its range
+		};
+		/// Unexplored branch of a tree
+		struct Branch {
+			dword	dist;						///< Sum of the squared distances from the search key to the split planes on the way to the branch: the priority
+			dword	bound;						///< Lower bound of the squared distance from the search key to the points of the branch
+			word	tree;						///< Index of the tree
+			dword	begin;						///< The first point of the branch
+			dword	end;						///< The point after the last point of the branch
+			bool operator>(const Branch &other) const { return dist > other.dist; }
+		};
+
+		void			buildTree(Tree &tree, size_t begin, size_t end) const;
+		void			fillKeys(Tree &tree) const;
+		/**
+		* @brief Descends one branch of a tree down to a leaf, storing the farther sub-trees on the way, and checks the points of the leaf
+		* @param[in] pKey The pointer to the search key
+		* @param[in] branch The branch
+		* @param[in] maxNeighbors maximum number of neighbor nodes to find
+		* @param[in,out] heap The max-heap of the nearest neighbors found so far
+		* @param[in,out] vBranches The min-heap of the unexplored branches
+		* @param[in,out] nChecks The number of checked points
+		*/
+		void			descend(const byte *pKey, Branch branch, size_t maxNeighbors, heap_t &heap, std::vector<Branch> &vBranches, size_t &nChecks) const;
+
+
+	private:
+		word				m_nTrees;			///< The number of trees
+		size_t				m_maxChecks;		///< The maximal number of points to be checked for one search key
+		std::vector<Tree>	m_vTrees;			///< The trees
+	};
+}
@@ -186,6 +186,24 @@ namespace DirectGraphicalModels
 		return exp(value);
 	}
 
+	void CKDGauss::getValues(const Mat &X, Mat &values) const
+	{
+		// Assertions
+		DGM_ASSERT_MSG(X.cols == m_mu.rows, "Wrong X size");
+		DGM_ASSERT_MSG(X.type() == m_mu.type(), "Wrong X type");
+
+		Mat D = X - repeat(m_mu.t(), X.rows, 1);				// D = X - mu
+		Mat P = D * getSigmaInv();							// P = (X - mu) * Sigma^-1
+		values.create(X.rows, 1, CV_64FC1);
+		for (int i = 0; i < X.rows; i++) {
+			const double *pD = D.ptr<double>(i);
+			const double *pP = P.ptr<double>(i);
+			double value = 0;
+			for (int k = 0; k < X.cols; k++) value += pD[k] * pP[k];
+			values.at<double>(i, 0) = exp(-0.5 * value);		// val = -0.5 * (X-mu)^T * Sigma^-1 * (X-mu)
+		} // i
+	}
+
 	double CKDGauss::getEuclidianDistance(const Mat &x) const
 	{
 		// Assertions (mathop::Euclidian also checks that)
@@ -166,6 +166,14 @@ namespace DirectGraphicalModels
 		*/
 		DllExport double		getValue(const Mat& x, Mat &aux1 = EmptyMat, Mat &aux2 = EmptyMat, Mat &aux3 = EmptyMat) const;
 		/**
+		* @brief Returns unscaled values of the Gaussian function for a block of points
+		* @details This function is the batch version of getValue(): the quadratic forms of all the points are calculated with one matrix product.
+		* > This function is PPL-safe function.
+		* @param[in] X Block of n-dimensional points (samples): Mat(size: nPoints x k; type: CV_64FC1)
+		* @param[out] values Unscaled values of the Gaussian function: Mat(size: nPoints x 1; type: CV_64FC1)
+		*/
+		DllExport void			getValues(const Mat &X, Mat &values) const;
+		/**
 		* @brief Returns a random vector (sample) from multivariate normal distribution
 		* @details The implementation is based on the paper <a target=blank href="ftp://ftp.dca.fee.unicamp.br/pub/docs/vonzuben/ia013_2s09/material_de_apoio/gen_rand_multivar.pdf">Generating Random Vectors from the Multivariate Normal Distribution</a>
 		* @return n-dimensional point (sample): Mat(size: k x 1; type: CV_64FC1)
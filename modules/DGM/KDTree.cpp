@@ -1,230 +1,107 @@
 #include "KDTree.h"
-#include "random.h"
-#include "parallel.h"
-#include "mathop.h"
+#include "macroses.h"
 
 namespace DirectGraphicalModels
 {
-	namespace {
-		template<typename T>
-		pair_mat_t getBoundingBox(const Mat& data)
-		{
-			Mat min, max;
-
-			data.row(0).copyTo(min);
-			data.row(0).copyTo(max);
-			T * pMin = min.ptr<T>(0);
-			T * pMax = max.ptr<T>(0);
-			for (int y = 1; y < data.rows; y++) {				// samples
-				const T * pData = data.ptr<T>(y);
-				for (int x = 0; x < data.cols; x++) {			// dimensions
-					if (pMin[x] > pData[x]) pMin[x] = pData[x];
-					if (pMax[x] < pData[x]) pMax[x] = pData[x];
-				} // x: dimenstions
-			} // y: samples
-
-			return std::make_pair(min, max);
-		}
-
-		template<typename T>
-		int getSplitDimension(const pair_mat_t& boundingBox)
-		{
-			int		res = 0;
-			Mat		diff = boundingBox.second - boundingBox.first;		// diff = max - min
-			T		max = diff.at<T>(0, 0);
-			Mat		maxMasc(1, diff.cols, CV_8UC1);						// binary maxv-alue masc 
-			for (int x = 0; x < diff.cols; x++) {						// dimensions
-				if (max == diff.at<T>(0, x)) {
-					maxMasc.at<byte>(0, x) = 1;
-				}
-				else if (max > diff.at<T>(0, x)) {
-					maxMasc.at<byte>(0, x) = 0;
-				}
-				else if (max < diff.at<T>(0, x)) {
-					maxMasc.at<byte>(0, x) = 1;
-					maxMasc(Rect(0, 0, x, 1)).setTo(0);
-					max = diff.at<T>(0, x);
-					res = x;
-				}
-			} // x: dimensions
-
-			int nMaxs = countNonZero(maxMasc);
-			if (nMaxs == 1) return res;
-
-			// Randomly choose one of the maximums
-			int x = 0;
-			int n = random::u<int>(1, nMaxs);
-			for (x = 0; x < diff.cols; x++) {						// dimensions
-				if (maxMasc.at<byte>(0, x) == 1) n--;
-				if (n == 0) break;
-			} // x: dimensions
-			return x;
-		}
+	void CKDTree::reset(void)
+	{
+		IKNNIndex::reset();
+		m_vSplitDim.clear();
 	}
-	 
-	void CKDTree::save(const std::string &fileName) const
+
+	void CKDTree::build(const Mat &keys, const Mat &values)
 	{
-		if (!m_root) {
-			DGM_WARNING("The k-D tree is not built");
-			return;
+		setPoints(keys, values);
+		if (empty()) return;
+
+		// Building the implicit tree and storing the points in its order
+		const size_t k		 = m_k;
+		const size_t nPoints = getNumPoints();
+		vec_size_t vIdx(nPoints);
+		for (size_t i = 0; i < nPoints; i++) vIdx[i] = i;
+		m_vSplitDim.assign(nPoints, 0);
+		buildTree(vIdx.data(), 0, nPoints);
+
+		vec_byte_t vKeys(nPoints * k);
+		vec_byte_t vValues(nPoints);
+		for (size_t i = 0; i < nPoints; i++) {
+			memcpy(&vKeys[i * k], &m_vKeys[vIdx[i] * k], k);
+			vValues[i] = m_vValues[vIdx[i]];
 		}
-		FILE *pFile = fopen(fileName.c_str(), "wb");
-		
-		// header
-		int k = m_root->getBoundingBox().first.cols;
-		fwrite(&k, sizeof(int), 1, pFile);				// dimensionality
-		m_root->save(pFile);
-		fclose(pFile);
+		m_vKeys.swap(vKeys);
+		m_vValues.swap(vValues);
 	}
-	
-	void CKDTree::load(const std::string &fileName)
+
+	// ----------------------------------------- Protected -----------------------------------------
+	void CKDTree::saveFile(FILE *pFile) const
 	{
-		FILE *pFile = fopen(fileName.c_str(), "rb");
-		// header
-		int k;
-		fread(&k, sizeof(int), 1, pFile);				// dimensionality
-		m_root = loadTree(pFile, k);
-		fclose(pFile);
+		fwrite(m_vSplitDim.data(), sizeof(word), m_vSplitDim.size(), pFile);
 	}
 
-	void CKDTree::build(Mat &keys, Mat &values)
+	void CKDTree::loadFile(FILE *pFile)
 	{
-		if (keys.empty()) {
-			DGM_WARNING("The data is empty");
-			return;
-		}
-		DGM_ASSERT_MSG(keys.type() == CV_8UC1, "Incorrect type of the keys");
-		DGM_ASSERT_MSG(values.type() == CV_8UC1, "Incorrect type of the values");
-		DGM_ASSERT_MSG(keys.rows == values.rows, "The amount of keys (%d) does not crrespond to the amount of values (%d)", keys.rows, values.rows);
-		
-		pair_mat_t boundingBox = getBoundingBox<byte>(keys);
-		hconcat(keys, values, keys);							// keys = [keys; data]
-
-		// Delete dublicated entries
-		parallel::sortRows<byte>(keys);
-		Mat data;
-		int y = keys.rows - 1;
-		for(; y > 0; y--) {
-			if (!mathop::isEqual<byte>(keys.row(y), keys.row(y - 1))) data.push_back(keys.row(y));
-			keys.pop_back();
-		}
-		data.push_back(keys.row(0));
-		keys.pop_back();
-
-		m_root = buildTree(data, boundingBox);
+		m_vSplitDim.resize(getNumPoints());
+		fread(m_vSplitDim.data(), sizeof(word), m_vSplitDim.size(), pFile);
 	}
 
-	std::vector<std::shared_ptr<const CKDNode>> CKDTree::findNearestNeighbors(const Mat &key, size_t maxNeighbors) const
+	void CKDTree::query(const byte *pKey, size_t maxNeighbors, heap_t &heap) const
 	{
-		const float searchRadius_extension = 2.0f;
-		
-		std::vector<std::shared_ptr<const CKDNode>> nearestNeighbors;
-		nearestNeighbors.reserve(maxNeighbors);
-
-		if (!m_root) {
-			DGM_WARNING("The k-D tree is not built");
-			return nearestNeighbors;
-		}
-
-		std::shared_ptr<const CKDNode> nearestNode = findNearestNode(key);
-		nearestNeighbors.push_back(nearestNode);
-		float searchRadius = mathop::Euclidian<byte, float>(key, nearestNode->getKey());
-		if (maxNeighbors > 1) searchRadius *= searchRadius_extension;
-		searchRadius += 0.5f;
-//		searchRadius = 255 * sqrtf(static_cast<float>(key.cols)); // infinity
-
-		pair_mat_t searchBox;
-		searchBox.first  = key - searchRadius;
-		searchBox.second = key + searchRadius;
-
-		m_root->findNearestNeighbors(key, maxNeighbors, searchBox, searchRadius, nearestNeighbors);
-	
-		return nearestNeighbors;
+		heap.clear();
+		if (maxNeighbors == 0) return;
+		search(pKey, 0, getNumPoints(), maxNeighbors, heap);
+		std::sort_heap(heap.begin(), heap.end());
 	}
 
 	// ----------------------------------------- Private -----------------------------------------
-	std::shared_ptr<CKDNode> CKDTree::loadTree(FILE * pFile, int k) 
+	// The median of the range [begin; end) becomes the node, splitting the range in the dimension of the largest spread
+	// left = [begin; mid): key[splitDim] <= median[splitDim]
+	// right = (mid; end): key[splitDim] >= median[splitDim]
+	void CKDTree::buildTree(size_t *pIdx, size_t begin, size_t end)
 	{
-		byte _isLeaf;
-		fread(&_isLeaf, sizeof(byte), 1, pFile);
-		if (_isLeaf) {		// --- Leaf node ---
-			Mat		key(1, k, CV_8UC1);
-			byte	value;
-
-			fread(key.data, sizeof(byte), k, pFile);
-			fread(&value, sizeof(byte), 1, pFile);
-
-			std::shared_ptr<CKDNode> res(new CKDNode(key, value));
-			return res;
-		} else {			// --- Branch node ---
-			pair_mat_t	boundingBox = std::make_pair(Mat(1, k, CV_8UC1), Mat(1, k, CV_8UC1));
-			byte		splitVal;
-			int			splitDim;
-
-			fread(boundingBox.first.data,  sizeof(byte), k, pFile);
-			fread(boundingBox.second.data, sizeof(byte), k, pFile);
-			fread(&splitVal, sizeof(byte), 1, pFile);
-			fread(&splitDim, sizeof(int),  1, pFile);
-			std::shared_ptr<CKDNode> left  = loadTree(pFile, k);
-			std::shared_ptr<CKDNode> right = loadTree(pFile, k);
-
-			std::shared_ptr<CKDNode> res(new CKDNode(boundingBox, splitVal, splitDim, left, right));
-			return res;
-		}
+		if (end - begin < 2) return;
+		const size_t k		= m_k;
+		const byte	*pData	= m_vKeys.data();
+
+		// Bounding box of the range
+		vec_byte_t vMin(pData + pIdx[begin] * k, pData + pIdx[begin] * k + k);
+		vec_byte_t vMax(vMin);
+		for (size_t i = begin + 1; i < end; i++) {
+			const byte *pKey = pData + pIdx[i] * k;
+			for (size_t x = 0; x < k; x++) {
+				if (vMin[x] > pKey[x]) vMin[x] = pKey[x];
+				if (vMax[x] < pKey[x]) vMax[x] = pKey[x];
+			} // x
+		} // i
+
+		word splitDim = 0;
+		for (word x = 1; x < m_k; x++)
+			if (vMax[x] - vMin[x] > vMax[splitDim] - vMin[splitDim]) splitDim = x;
+
+		const size_t mid = (begin + end) / 2;
+		std::nth_element(pIdx + begin, pIdx + mid, pIdx + end, [pData, k, splitDim](size_t a, size_t b) {
+			return pData[a * k + splitDim] < pData[b * k + splitDim];
+		});
+		m_vSplitDim[mid] = splitDim;
+
+		buildTree(pIdx, begin, mid);
+		buildTree(pIdx, mid + 1, end);
 	}
-	
-	// data_i = [key,val]: k + 1 entries 
-	// left = [0; splitVal)
-	// right = [splitVal; end]
-	std::shared_ptr<CKDNode> CKDTree::buildTree(Mat& data, const pair_mat_t& boundingBox)
-	{
-		if (data.rows == 1) {
-			return std::make_shared<CKDNode>(lvalue_cast(data(Rect(0, 0, data.cols - 1, 1))), data.at<byte>(0, data.cols - 1));
-		}
-		else if (data.rows == 2) {
-			int	 splitDim = getSplitDimension<byte>(boundingBox);
-			byte splitVal = (data.at<byte>(0, splitDim) + data.at<byte>(1, splitDim)) / 2;
-			
-			std::shared_ptr<CKDNode> left, right;
-			if (data.at<byte>(0, splitDim) < data.at<byte>(1, splitDim)) {
-				left  = std::make_shared<CKDNode>(lvalue_cast(data.row(0)(Rect(0, 0, data.cols - 1, 1))), data.at<byte>(0, data.cols - 1));
-				right = std::make_shared<CKDNode>(lvalue_cast(data.row(1)(Rect(0, 0, data.cols - 1, 1))), data.at<byte>(1, data.cols - 1));
-			}
-			else {
-				left  = std::make_shared<CKDNode>(lvalue_cast(data.row(1)(Rect(0, 0, data.cols - 1, 1))), data.at<byte>(1, data.cols - 1));
-				right = std::make_shared<CKDNode>(lvalue_cast(data.row(0)(Rect(0, 0, data.cols - 1, 1))), data.at<byte>(0, data.cols - 1));
-			}
-			return std::make_shared<CKDNode>(boundingBox, splitVal, splitDim, left, right);
-		}
-		else {
-			int	 splitDim = getSplitDimension<byte>(boundingBox);
-			parallel::sortRows<byte>(data, splitDim);
-			int	 splitIdx = data.rows / 2;
-			byte splitVal = data.at<byte>(splitIdx, splitDim);
 
-			pair_mat_t boundingBoxLeft(boundingBox.first.clone(), boundingBox.second.clone());
-			pair_mat_t boundingBoxRight(boundingBox.first.clone(), boundingBox.second.clone());
-
-			boundingBoxLeft.second.at<byte>(0, splitDim) = splitVal > 0 ? splitVal - 1 : 0;
-			boundingBoxRight.first.at<byte>(0, splitDim) = splitVal;
-
-			auto left  = buildTree(lvalue_cast(data(Rect(0, 0, data.cols, splitIdx))), boundingBoxLeft);
-			auto right = buildTree(lvalue_cast(data(Rect(0, data.rows / 2, data.cols, data.rows - data.rows / 2))), boundingBoxRight);
-			return std::make_shared<CKDNode>(boundingBox, splitVal, splitDim, left, right);
-		}
-	}
-
-	std::shared_ptr<const CKDNode> CKDTree::findNearestNode(const Mat& key) const
+	void CKDTree::search(const byte *pKey, size_t begin, size_t end, size_t maxNeighbors, heap_t &heap) const
 	{
-		std::shared_ptr<CKDNode> node(m_root);
-
-		while (!node->isLeaf()) {
-			std::shared_ptr<CKDNode> n = std::static_pointer_cast<CKDNode>(node);
-			if (key.at<byte>(0, n->getSplitDim()) < n->getSplitVal())	node = n->Left();
-			else														node = n->Right();
+		while (begin < end) {
+			const size_t mid = (begin + end) / 2;
+			addNeighbor(getSqDistance(pKey, mid), mid, maxNeighbors, heap);
+
+			// The nearer sub-tree is searched first; the farther one - only if the split plane is within the search radius
+			const word	splitDim = m_vSplitDim[mid];
+			const int	diff	 = static_cast<int>(pKey[splitDim]) - static_cast<int>(m_vKeys[mid * m_k + splitDim]);
+			if (diff < 0)	search(pKey, begin, mid, maxNeighbors, heap);
+			else			search(pKey, mid + 1, end, maxNeighbors, heap);
+
+			if (heap.size() == maxNeighbors && static_cast<dword>(diff * diff) >= heap.front().first) return;
+			if (diff < 0)	begin = mid + 1;
+			else			end   = mid;
 		}
-
-		return std::static_pointer_cast<CKDNode>(node);
 	}
-
 }
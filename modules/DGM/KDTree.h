@@ -3,8 +3,7 @@
 // Inspired by http://codereview.stackexchange.com/questions/110225/k-d-tree-implementation-in-c11
 #pragma once
 
-#include "types.h"
-#include "KDNode.h"
+#include "IKNNIndex.h"
 
 namespace DirectGraphicalModels
 {
@@ -12,9 +11,14 @@ namespace DirectGraphicalModels
 	/**
 	* @brief Class implementing k-D Tree data structure
 	* @details This class implementats a non-uniform <a href="https://en.wikipedia.org/wiki/K-d_tree" target="blank">k-D Tree</a> data structure.
+	* The tree is implicit: the keys are stored contiguously in one array, ordered so that the root of every sub-tree, occupying the range [begin; end)
+	* of the array, is its median element (begin + end) / 2, and the elements to the left (right) of it form the left (right) sub-tree. Thus, besides
+	* the keys and values, only the split dimension of every node is stored.
+	*
+	* The nearest neighbors are searched exactly. For the approximate search on large data sets see CKDForest.
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
-	class CKDTree
+	class CKDTree : public IKNNIndex
 	{
 	public:
 		/**
@@ -26,60 +30,26 @@ namespace DirectGraphicalModels
 		* @param keys The tree keys: k-d points: Mat(size: nKeys x k; type: CV_8UC1)
 		* @param values The values for every key: Mat(size: nKeys x 1; type: CV_8UC1)
 		*/
-		DllExport CKDTree(Mat &keys, Mat &values) { build(keys, values); }	
-		DllExport CKDTree(const CKDTree&) = delete;
-		DllExport ~CKDTree(void) = default;
+		DllExport CKDTree(const Mat &keys, const Mat &values) { build(keys, values); }
+		DllExport virtual ~CKDTree(void) = default;
 
-		DllExport bool											operator=(const CKDTree&) = delete;
+		DllExport void	reset(void) override;
+		DllExport void	build(const Mat &keys, const Mat &values) override;
 
-		/**
-		* @brief Resets the tree
-		*/
-		DllExport void											reset(void) { m_root.reset(); }
-		/**
-		* @brief Saves the tree into a file
-		* @param fileName The output file name
-		*/
-		DllExport void											save(const std::string &fileName) const;
-		/**
-		* @brief Loads a tree from the file
-		* @param fileName The output file name
-		*/
-		DllExport void											load(const std::string &fileName);
-		/**
-		* @brief Builds a k-d tree on \b keys with corresponding \b values
-		* @param keys The tree keys: k-d points: Mat(size: nKeys x k; type: CV_8UC1)
-		* > The \b keys matrix is modified by this function
-		* @param values The values for every key: Mat(size: nKeys x 1; type: CV_8UC1)
-		*/
-		DllExport void											build(Mat &keys, Mat &values);
-		/**
-		* @brief Finds the nearest neighbor to the \b key
-		* @param key The search key: k-d point: Mat(size: 1 x k; type: CV_8UC1)
-		* @returns The %Node (tree leaf) with the key, which is the most close to the argument \b key
-		*/
-		DllExport std::shared_ptr<const CKDNode>				findNearestNeighbor(const Mat &key) const { return findNearestNeighbors(key, 1).front(); }
-		/**
-		* @brief Finds up to \b maxNeighbors nearest neighbors to the \b key
-		* @param key The search key: k-d point: Mat(size: 1 x k; type: CV_8UC1)
-		* @param maxNeighbors maximum number of neighbor nodes to find
-		* @returns The array of %Nodes (tree leaves) with the keys, which are the most close to the argument \b key
-		*/
-		DllExport std::vector<std::shared_ptr<const CKDNode>>	findNearestNeighbors(const Mat &key, size_t maxNeighbors) const;
-		/**
-		* @brief Returns pointer to the root of the tree
-		* @returns The pointer to the root of the tree
-		*/
-		DllExport std::shared_ptr<const CKDNode>				getRoot(void) const { return m_root; }
+
+	protected:
+		DllExport IndexType	getIndexType(void) const override { return IndexType::KDTree; }
+		DllExport void	saveFile(FILE *pFile) const override;
+		DllExport void	loadFile(FILE *pFile) override;
+		DllExport void	query(const byte *pKey, size_t maxNeighbors, heap_t &heap) const override;
 
 
 	private:
-		std::shared_ptr<CKDNode>								loadTree(FILE *pFile, int k);
-		std::shared_ptr<CKDNode>								buildTree(Mat& data, const pair_mat_t& boundingBox);
-		std::shared_ptr<const CKDNode>							findNearestNode(const Mat &key) const;
+		void			buildTree(size_t *pIdx, size_t begin, size_t end);
+		void			search(const byte *pKey, size_t begin, size_t end, size_t maxNeighbors, heap_t &heap) const;
 
 
 	private:
-		std::shared_ptr<CKDNode>	m_root = nullptr;
+		std::vector<word> m_vSplitDim;	///< The split dimension of every node
 	};
-}
\ No newline at end of file
+}
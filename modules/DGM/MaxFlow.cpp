@@ -0,0 +1,265 @@
+#include "MaxFlow.h"
+#include "macroses.h"
+#include <climits>
+
+namespace DirectGraphicalModels
+{
+	void CMaxFlow::reset(size_t nNodes)
+	{
+		m_vEdgeNodes.clear();
+		m_vEdgeCaps.clear();
+		m_vTrCap.assign(nNodes, 0.0f);
+		m_flow = 0;
+	}
+
+	void CMaxFlow::addTerminalWeights(size_t node, float capSource, float capSink)
+	{
+		DGM_ASSERT_MSG(node < m_vTrCap.size(), "Node %zu is out of range %zu", node, m_vTrCap.size());
+
+		// Only the difference of the terminal capacities is stored; the common part is saturated immediately
+		const float delta = m_vTrCap[node];
+		if (delta > 0)	capSource += delta;
+		else			capSink	  -= delta;
+		m_flow += MIN(capSource, capSink);
+		m_vTrCap[node] = capSource - capSink;
+	}
+
+	void CMaxFlow::addEdge(size_t node1, size_t node2, float cap, float revCap)
+	{
+		DGM_ASSERT_MSG(node1 < m_vTrCap.size() && node2 < m_vTrCap.size(), "The edge (%zu, %zu) is out of range %zu", node1, node2, m_vTrCap.size());
+		DGM_ASSERT_MSG(node1 != node2, "Loops are not allowed");
+		m_vEdgeNodes.emplace_back(static_cast<int>(node1), static_cast<int>(node2));
+		m_vEdgeCaps.emplace_back(cap, revCap);
+	}
+
+	double CMaxFlow::maxFlow(void)
+	{
+		buildArcs();
+
+		// ====================================== Initialization ======================================
+		const size_t nNodes = m_vTrCap.size();
+		m_vParent.assign(nNodes, NONE);
+		m_vIsSink.assign(nNodes, false);
+		m_vNext.assign(nNodes, NONE);
+		m_vTS.assign(nNodes, 0);
+		m_vDist.assign(nNodes, 0);
+		m_queueFirst = m_queueLast = NONE;
+		m_orphans.clear();
+		m_time = 0;
+
+		for (int i = 0; i < static_cast<int>(nNodes); i++)
+			if (m_vTrCap[i] != 0) {
+				m_vIsSink[i] = m_vTrCap[i] < 0;
+				m_vParent[i] = TERMINAL;
+				m_vDist[i]	 = 1;
+				setActive(i);
+			}
+
+		// ========================================= Main loop ========================================
+		int current = NONE;
+		for (;;) {
+			int i = current;
+			if (i != NONE) {
+				m_vNext[i] = NONE;
+				if (m_vParent[i] == NONE) i = NONE;
+			}
+			if (i == NONE) {
+				i = nextActive();
+				if (i == NONE) break;
+			}
+
+			// Growth: looking for an arc, connecting the trees
+			int middleArc = NONE;
+			const bool sinkTree = m_vIsSink[i];
+			for (int a = m_vFirstArc[i]; a < m_vFirstArc[i + 1]; a++) {
+				const Arc &arc = m_vArcs[a];
+				if ((sinkTree ? m_vArcs[arc.sister].rCap : arc.rCap) <= 0) continue;
+				const int j = arc.head;
+				if (m_vParent[j] == NONE) {
+					m_vIsSink[j] = sinkTree;
+					m_vParent[j] = arc.sister;
+					m_vTS[j]	 = m_vTS[i];
+					m_vDist[j]	 = m_vDist[i] + 1;
+					setActive(j);
+				}
+				else if (m_vIsSink[j] != sinkTree) {
+					middleArc = sinkTree ? arc.sister : a;				// the arc from the source tree to the sink tree
+					break;
+				}
+				else if (m_vTS[j] <= m_vTS[i] && m_vDist[j] > m_vDist[i]) {	// heuristic: trying to make the distance from j to the terminal shorter
+					m_vParent[j] = arc.sister;
+					m_vTS[j]	 = m_vTS[i];
+					m_vDist[j]	 = m_vDist[i] + 1;
+				}
+			} // a
+
+			m_time++;
+			if (middleArc != NONE) {
+				m_vNext[i] = i;											// the node stays active as the current node
+				current = i;
+				augment(middleArc);
+				while (!m_orphans.empty()) {							// adoption
+					const int orphan = m_orphans.front();
+					m_orphans.pop_front();
+					processOrphan(orphan);
+				}
+			}
+			else current = NONE;
+		} // forever
+
+		return m_flow;
+	}
+
+	// ------------------------- Private -------------------------
+	void CMaxFlow::buildArcs(void)
+	{
+		const size_t nNodes = m_vTrCap.size();
+
+		// Counting sort of the arcs by the tail node
+		m_vFirstArc.assign(nNodes + 1, 0);
+		for (auto &edge : m_vEdgeNodes) {
+			m_vFirstArc[edge.first + 1]++;
+			m_vFirstArc[edge.second + 1]++;
+		}
+		for (size_t n = 0; n < nNodes; n++) m_vFirstArc[n + 1] += m_vFirstArc[n];
+
+		std::vector<int> vPos(m_vFirstArc.begin(), m_vFirstArc.end() - 1);
+		m_vArcs.resize(2 * m_vEdgeNodes.size());
+		for (size_t e = 0; e < m_vEdgeNodes.size(); e++) {
+			const int node1 = m_vEdgeNodes[e].first;
+			const int node2 = m_vEdgeNodes[e].second;
+			const int arc1	= vPos[node1]++;
+			const int arc2	= vPos[node2]++;
+			m_vArcs[arc1] = { node2, arc2, m_vEdgeCaps[e].first };
+			m_vArcs[arc2] = { node1, arc1, m_vEdgeCaps[e].second };
+		}
+	}
+
+	void CMaxFlow::setActive(int node)
+	{
+		if (m_vNext[node] != NONE) return;									// already active
+		if (m_queueLast != NONE) m_vNext[m_queueLast] = node;
+		else					 m_queueFirst = node;
+		m_queueLast	  = node;
+		m_vNext[node] = node;
+	}
+
+	int CMaxFlow::nextActive(void)
+	{
+		for (;;) {
+			const int node = m_queueFirst;
+			if (node == NONE) return NONE;
+			if (m_vNext[node] == node)	m_queueFirst = m_queueLast = NONE;
+			else						m_queueFirst = m_vNext[node];
+			m_vNext[node] = NONE;
+			if (m_vParent[node] != NONE) return node;						// the free nodes are skipped
+		}
+	}
+
+	void CMaxFlow::augment(int middleArc)
+	{
+		const int tail = m_vArcs[m_vArcs[middleArc].sister].head;
+		const int head = m_vArcs[middleArc].head;
+		int node;
+
+		// Finding the bottleneck capacity
+		float bottleneck = m_vArcs[middleArc].rCap;
+		for (node = tail; m_vParent[node] != TERMINAL; node = m_vArcs[m_vParent[node]].head)		// the source tree
+			bottleneck = MIN(bottleneck, m_vArcs[m_vArcs[m_vParent[node]].sister].rCap);
+		bottleneck = MIN(bottleneck, m_vTrCap[node]);
+		for (node = head; m_vParent[node] != TERMINAL; node = m_vArcs[m_vParent[node]].head)		// the sink tree
+			bottleneck = MIN(bottleneck, m_vArcs[m_vParent[node]].rCap);
+		bottleneck = MIN(bottleneck, -m_vTrCap[node]);
+
+		// Augmenting
+		m_vArcs[m_vArcs[middleArc].sister].rCap += bottleneck;
+		m_vArcs[middleArc].rCap -= bottleneck;
+		for (node = tail; ; ) {																	// the source tree
+			const int a = m_vParent[node];
+			if (a == TERMINAL) break;
+			m_vArcs[a].rCap += bottleneck;
+			m_vArcs[m_vArcs[a].sister].rCap -= bottleneck;
+			if (m_vArcs[m_vArcs[a].sister].rCap <= 0) setOrphanFront(node);
+			node = m_vArcs[a].head;
+		}
+		m_vTrCap[node] -= bottleneck;
+		if (m_vTrCap[node] <= 0) setOrphanFront(node);
+		for (node = head; ; ) {																	// the sink tree
+			const int a = m_vParent[node];
+			if (a == TERMINAL) break;
+			m_vArcs[m_vArcs[a].sister].rCap += bottleneck;
+			m_vArcs[a].rCap -= bottleneck;
+			if (m_vArcs[a].rCap <= 0) setOrphanFront(node);
+			node = m_vArcs[a].head;
+		}
+		m_vTrCap[node] += bottleneck;
+		if (m_vTrCap[node] >= 0) setOrphanFront(node);
+
+		m_flow += bottleneck;
+	}
+
+	void CMaxFlow::processOrphan(int node)
+	{
+		const bool	sinkTree = m_vIsSink[node];
+		int			minArc	 = NONE;
+		int			minDist	 = INT_MAX;
+
+		// Trying to find a new valid parent
+		for (int a0 = m_vFirstArc[node]; a0 < m_vFirstArc[node + 1]; a0++) {
+			const Arc &arc = m_vArcs[a0];
+			if ((sinkTree ? arc.rCap : m_vArcs[arc.sister].rCap) <= 0) continue;
+			const int j = arc.head;
+			if (m_vIsSink[j] != sinkTree || m_vParent[j] == NONE) continue;
+
+			// Checking the origin of j
+			int d = 0;
+			for (int k = j; ; ) {
+				if (m_vTS[k] == m_time) {
+					d += m_vDist[k];
+					break;
+				}
+				const int a = m_vParent[k];
+				d++;
+				if (a == TERMINAL) {
+					m_vTS[k]   = m_time;
+					m_vDist[k] = 1;
+					break;
+				}
+				if (a == ORPHAN) {
+					d = INT_MAX;
+					break;
+				}
+				k = m_vArcs[a].head;
+			}
+			if (d == INT_MAX) continue;											// j originates from an orphan
+
+			if (d < minDist) {
+				minArc	= a0;
+				minDist = d;
+			}
+			// Setting the marks along the path
+			for (int k = j; m_vTS[k] != m_time; k = m_vArcs[m_vParent[k]].head) {
+				m_vTS[k]   = m_time;
+				m_vDist[k] = d--;
+			}
+		} // a0
+
+		if (minArc != NONE) {
+			m_vParent[node] = minArc;
+			m_vTS[node]		= m_time;
+			m_vDist[node]	= minDist + 1;
+			return;
+		}
+
+		// No parent is found: the node becomes free, and its children become orphans
+		for (int a0 = m_vFirstArc[node]; a0 < m_vFirstArc[node + 1]; a0++) {
+			const Arc &arc = m_vArcs[a0];
+			const int  j   = arc.head;
+			const int  a   = m_vParent[j];
+			if (m_vIsSink[j] != sinkTree || a == NONE) continue;
+			if ((sinkTree ? arc.rCap : m_vArcs[arc.sister].rCap) > 0) setActive(j);
+			if (a != TERMINAL && a != ORPHAN && m_vArcs[a].head == node) setOrphanRear(j);
+		} // a0
+		m_vParent[node] = NONE;
+	}
+}
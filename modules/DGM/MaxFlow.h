@@ -0,0 +1,101 @@
+// Max-flow / min-cut class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "types.h"
+#include <deque>
+
+namespace DirectGraphicalModels
+{
+	// ============================= Max-Flow Class =============================
+	/**
+	* @ingroup moduleDecode
+	* @brief Max-flow / min-cut solver
+	* @details This class implements the augmenting paths algorithm from the paper
+	* <a href="https://www.csd.uwo.ca/~yboykov/Papers/pami04.pdf" target="_blank">An Experimental Comparison of Min-Cut/Max-Flow Algorithms for Energy Minimization in Vision</a>
+	* by Y. Boykov and V. Kolmogorov. The search trees, grown from the source and the sink, are reused after every augmentation.
+	* The arcs are stored in flat arrays, grouped by their tail node, so that the arcs of a node lie contiguously in memory.
+	* The storage is kept between reset() calls, thus the solver may be reused for a sequence of problems of the similar size without reallocations.
+	*/
+	class CMaxFlow
+	{
+	public:
+		DllExport CMaxFlow(void) = default;
+		DllExport ~CMaxFlow(void) = default;
+
+		/**
+		* @brief Starts a new problem
+		* @param nNodes The number of nodes (excluding the terminals)
+		*/
+		DllExport void	reset(size_t nNodes);
+		/**
+		* @brief Adds the capacities of the terminal edges to the node
+		* @param node The node index
+		* @param capSource The capacity of the edge from the source to the \b node
+		* @param capSink The capacity of the edge from the \b node to the sink
+		*/
+		DllExport void	addTerminalWeights(size_t node, float capSource, float capSink);
+		/**
+		* @brief Adds a pair of edges between two nodes
+		* @param node1 The index of the first node
+		* @param node2 The index of the second node
+		* @param cap The capacity of the edge \b node1 -> \b node2
+		* @param revCap The capacity of the edge \b node2 -> \b node1
+		*/
+		DllExport void	addEdge(size_t node1, size_t node2, float cap, float revCap);
+		/**
+		* @brief Calculates the maximal flow
+		* @return The value of the maximal flow, \a i.e. the capacity of the minimal cut
+		*/
+		DllExport double maxFlow(void);
+		/**
+		* @brief Returns the segment of the node after maxFlow()
+		* @param node The node index
+		* @retval true if the node belongs to the sink segment
+		* @retval false if the node belongs to the source segment
+		*/
+		DllExport bool	isSink(size_t node) const { return m_vParent[node] != NONE && m_vIsSink[node]; }
+
+
+	private:
+		/// Arc of the residual graph
+		struct Arc {
+			int		head;		///< The head node
+			int		sister;		///< The reverse arc
+			float	rCap;		///< The residual capacity
+		};
+
+		static constexpr int NONE		= -1;	///< The node is free
+		static constexpr int TERMINAL	= -2;	///< The parent of the node is a terminal
+		static constexpr int ORPHAN		= -3;	///< The node is an orphan
+
+		void	buildArcs(void);
+		void	setActive(int node);
+		int		nextActive(void);
+		void	setOrphanFront(int node) { m_vParent[node] = ORPHAN; m_orphans.push_front(node); }
+		void	setOrphanRear(int node)	 { m_vParent[node] = ORPHAN; m_orphans.push_back(node); }
+		void	augment(int middleArc);
+		void	processOrphan(int node);
+
+
+	private:
+		// Input edges
+		std::vector<std::pair<int, int>>	m_vEdgeNodes;		///< Nodes of the added edges
+		std::vector<std::pair<float, float>>m_vEdgeCaps;		///< Capacities of the added edges
+		// Residual graph
+		std::vector<Arc>		m_vArcs;			///< Arcs, grouped by the tail node
+		std::vector<int>		m_vFirstArc;		///< Index of the first arc of every node: nNodes + 1
+		vec_float_t				m_vTrCap;			///< Residual terminal capacity: > 0 for the source, < 0 for the sink
+		// Search trees
+		std::vector<int>		m_vParent;			///< Arc to the parent node, or NONE / TERMINAL / ORPHAN
+		std::vector<bool>		m_vIsSink;			///< Flag indicating whether the node belongs to the sink tree
+		std::vector<int>		m_vNext;			///< Next active node; NONE if the node is not active
+		std::vector<int>		m_vTS;				///< Timestamp of the distance
+		std::vector<int>		m_vDist;			///< Distance to the terminal
+		int						m_queueFirst	= NONE;
+		int						m_queueLast		= NONE;
+		std::deque<int>			m_orphans;
+		int						m_time			= 0;
+		double					m_flow			= 0;
+	};
+}
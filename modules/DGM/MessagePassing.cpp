@@ -1,6 +1,10 @@
 #include "MessagePassing.h"
 #include "GraphPairwise.h"
+#include "GraphPairwiseCSR.h"
+#include "msgkernel.h"
 #include "macroses.h"
+#include <unordered_map>
+#include <numeric>
 
 namespace DirectGraphicalModels
 {
@@ -9,6 +13,7 @@ namespace DirectGraphicalModels
 		const byte   nStates = getGraph().getNumStates();
 
 		// ====================================== Initialization ======================================
+		createView();
 		createMessages(1.0f / nStates);				// msg[] = 1 / nStates; msg_temp[] = 1 / nStates;
 
 		// =================================== Calculating messages ==================================
@@ -16,49 +21,51 @@ namespace DirectGraphicalModels
 
 		// =================================== Calculating beliefs ===================================
 #ifdef ENABLE_PDP
-		parallel_for_(Range(0, static_cast<int>(getGraphPairwise().m_vNodes.size())), [&, nStates](const Range& range) {
+		parallel_for_(Range(0, static_cast<int>(m_view.getNumNodes())), [&, nStates](const Range& range) {
 #else
-		const Range range(0, getGraphPairwise().m_vNodes.size());
+		const Range range(0, static_cast<int>(m_view.getNumNodes()));
 #endif
 		for (int i = range.start; i < range.end; i++) {
-			auto& node = getGraphPairwise().m_vNodes[i];
-			for (size_t e_f : node->from) {
+			float *pot = m_view.vpNodePot[i];
+			for (size_t e_f : m_view.from(i)) {
 				float* msg = getMessage(e_f);				// message of current incoming edge
 				float epsilon = FLT_EPSILON;
 				for (byte s = 0; s < nStates; s++) { 		// states
-					// node->Pot.at<float>(s,0) *= msg[s];
-					node->Pot.at<float>(s, 0) = (epsilon + node->Pot.at<float>(s, 0)) * (epsilon + msg[s]);		// Soft multiplication
+					// pot[s] *= msg[s];
+					pot[s] = (epsilon + pot[s]) * (epsilon + msg[s]);		// Soft multiplication
 				} //s
 			} // e_f
 
 			// Normalization
 			float SUM_pot = 0;
 			for (byte s = 0; s < nStates; s++)				// states
-				SUM_pot += node->Pot.at<float>(s, 0);
+				SUM_pot += pot[s];
 			for (byte s = 0; s < nStates; s++) {			// states
-				node->Pot.at<float>(s, 0) /= SUM_pot;
-				DGM_ASSERT_MSG(!std::isnan(node->Pot.at<float>(s, 0)), "The lower precision boundary for the potential of the node %zu is reached.\n \
-						SUM_pot = %f\n", node->id, SUM_pot);
+				pot[s] /= SUM_pot;
+				DGM_ASSERT_MSG(!std::isnan(pot[s]), "The lower precision boundary for the potential of the node %d is reached.\n \
+						SUM_pot = %f\n", i, SUM_pot);
 			}
 		}
 #ifdef ENABLE_PDP
 		});
 #endif
 		deleteMessages();
+		deleteView();
 	}
 
 	// dst: usually edge msg or edge msg_temp
-	void CMessagePassing::calculateMessage(const Edge& edge_to, float* temp, float* dst, bool maxSum)
+	void CMessagePassing::calculateMessage(size_t edge_to, float* temp, float* dst, bool maxSum)
 	{
-		Node		* node = getGraphPairwise().m_vNodes[edge_to.node1].get();		// source node
+		const size_t  srcNode = m_view.pSrc[edge_to];								// source node
+		const size_t  dstNode = m_view.pDst[edge_to];								// destination node
 		const byte	  nStates = getGraph().getNumStates();							// number of states
 
 		// Compute temp = product of all incoming msgs except e_t
-		for (byte s = 0; s < nStates; s++) temp[s] = node->Pot.at<float>(s, 0);		// temp = node.Pot
+		const float *pot = m_view.vpNodePot[srcNode];
+		for (byte s = 0; s < nStates; s++) temp[s] = pot[s];						// temp = node.Pot
 
-		for (size_t e_f : node->from) {												// incoming edges
-			Edge *edge_from = getGraphPairwise().m_vEdges[e_f].get();				// current incoming edge
-			if (edge_from->node1 != edge_to.node2) {
+		for (size_t e_f : m_view.from(srcNode)) {									// incoming edges
+			if (m_view.pSrc[e_f] != dstNode) {
 				float *msg = getMessage(e_f);										// message of current incoming edge
 				for (byte s = 0; s < nStates; s++)
 					temp[s] *= msg[s];												// temp = temp * msg
@@ -66,7 +73,8 @@ namespace DirectGraphicalModels
 		} // e_f
 
 		// Compute new message: new_msg = (edge_to.Pot^2)^t x temp
-		float Z = MatMul(edge_to.Pot, temp, dst, maxSum);
+		const float *pPot = m_view.vpEdgePotSqT[edge_to];
+		float Z = pPot ? msgkernel::matVec(pPot, nStates, temp, dst, maxSum) : 0.0f;
 
 		// Normalization and setting new values
 		if (Z > FLT_EPSILON)
@@ -77,17 +85,152 @@ namespace DirectGraphicalModels
 				dst[s] = 1.0f / nStates;
 	}
 
+	void CMessagePassing::buildView(IGraphPairwise &graph, GraphPairwiseView &view, bool squarePotentials)
+	{
+		const size_t nNodes = graph.getNumNodes();
+		const size_t nEdges = graph.getNumEdges();
+		const byte	 nStates = graph.getNumStates();
+
+		view.vpNodePot.resize(nNodes);
+		view.vpEdgePot.resize(nEdges);
+
+		CGraphPairwiseCSR *pGraphCSR = dynamic_cast<CGraphPairwiseCSR *>(&graph);
+		if (pGraphCSR) {
+			pGraphCSR->compact();
+			for (size_t n = 0; n < nNodes; n++) view.vpNodePot[n] = pGraphCSR->m_vNodePot.data() + n * nStates;
+			for (size_t e = 0; e < nEdges; e++) view.vpEdgePot[e] = static_cast<const CGraphPairwiseCSR *>(pGraphCSR)->getEdgePot(e);	// may point to a shared table
+			view.pSrc			= pGraphCSR->m_vSrc.data();
+			view.pDst			= pGraphCSR->m_vDst.data();
+			view.pOutOffset		= pGraphCSR->m_vOutOffset.data();
+			view.pOutEdge		= pGraphCSR->m_vOutEdge.data();
+			view.pInOffset		= pGraphCSR->m_vInOffset.data();
+			view.pInEdge		= pGraphCSR->m_vInEdge.data();
+			if (squarePotentials) prepareEdgePotentials(view, nStates);
+			return;
+		}
+
+		CGraphPairwise *pGraph = dynamic_cast<CGraphPairwise *>(&graph);
+		DGM_ASSERT_MSG(pGraph, "The message passing algorithms support only CGraphPairwise and CGraphPairwiseCSR graphs");
+
+		// Gathering the topology of the graph into the CSR format
+		view.vSrc.resize(nEdges);
+		view.vDst.resize(nEdges);
+		view.vOutOffset.resize(nNodes + 1);
+		view.vInOffset.resize(nNodes + 1);
+		view.vOutEdge.clear();
+		view.vInEdge.clear();
+		view.vOutOffset[0] = 0;
+		view.vInOffset[0] = 0;
+		for (size_t n = 0; n < nNodes; n++) {
+			ptr_node_t &node = pGraph->m_vNodes[n];
+			view.vpNodePot[n] = node->Pot.empty() ? NULL : node->Pot.ptr<float>();
+			view.vOutEdge.insert(view.vOutEdge.end(), node->to.begin(), node->to.end());
+			view.vInEdge.insert(view.vInEdge.end(), node->from.begin(), node->from.end());
+			view.vOutOffset[n + 1] = view.vOutEdge.size();
+			view.vInOffset[n + 1] = view.vInEdge.size();
+		}
+		for (size_t e = 0; e < nEdges; e++) {
+			ptr_edge_t &edge = pGraph->m_vEdges[e];
+			view.vSrc[e] = edge->node1;
+			view.vDst[e] = edge->node2;
+			view.vpEdgePot[e] = edge->Pot.empty() ? NULL : edge->Pot.ptr<float>();
+		}
+		view.pSrc			= view.vSrc.data();
+		view.pDst			= view.vDst.data();
+		view.pOutOffset		= view.vOutOffset.data();
+		view.pOutEdge		= view.vOutEdge.data();
+		view.pInOffset		= view.vInOffset.data();
+		view.pInEdge		= view.vInEdge.data();
+		if (squarePotentials) prepareEdgePotentials(view, nStates);
+	}
+
+	void CMessagePassing::createView(bool squarePotentials)
+	{
+		buildView(getGraphPairwise(), m_view, squarePotentials);
+	}
+
+	void CMessagePassing::deleteView(void)
+	{
+		m_view = GraphPairwiseView();
+	}
+
+	// Squares and transposes every distinct edge potential once
+	void CMessagePassing::prepareEdgePotentials(GraphPairwiseView &view, byte nStates)
+	{
+		const size_t nEdges	 = view.getNumEdges();
+		const size_t size	 = nStates * nStates;
+
+		// Assigning a table to every distinct edge potential
+		std::unordered_map<const float *, size_t> mTable;
+		std::vector<const float *> vpTablePot;
+		vec_size_t vTable(nEdges);
+		for (size_t e = 0; e < nEdges; e++) {
+			const float *pPot = view.vpEdgePot[e];
+			if (!pPot) continue;
+			auto it = mTable.emplace(pPot, vpTablePot.size());
+			if (it.second) vpTablePot.push_back(pPot);
+			vTable[e] = it.first->second;
+		}
+
+		view.vEdgePotSqT.resize(vpTablePot.size() * size);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, static_cast<int>(vpTablePot.size())), [&](const Range &range) {
+#else
+		const Range range(0, static_cast<int>(vpTablePot.size()));
+#endif
+		for (int t = range.start; t < range.end; t++)
+			msgkernel::prepare(vpTablePot[t], nStates, view.vEdgePotSqT.data() + t * size);
+#ifdef ENABLE_PDP
+		});
+#endif
+
+		view.vpEdgePotSqT.resize(nEdges);
+		for (size_t e = 0; e < nEdges; e++)
+			view.vpEdgePotSqT[e] = view.vpEdgePot[e] ? view.vEdgePotSqT.data() + vTable[e] * size : NULL;
+	}
+
+	void CMessagePassing::createSchedule(vec_size_t &vNodes, vec_size_t &vLevelStart) const
+	{
+		const size_t nNodes = m_view.getNumNodes();
+		
+		vNodes.resize(nNodes);
+#ifdef ENABLE_PDP
+		// level(n) = 1 + max level of the neighbours of n with smaller index
+		vec_size_t vLevel(nNodes, 0);
+		for (size_t n = 0; n < nNodes; n++) {
+			for (size_t e_t : m_view.to(n))		if (m_view.pDst[e_t] < n) vLevel[n] = MAX(vLevel[n], vLevel[m_view.pDst[e_t]] + 1);
+			for (size_t e_f : m_view.from(n))	if (m_view.pSrc[e_f] < n) vLevel[n] = MAX(vLevel[n], vLevel[m_view.pSrc[e_f]] + 1);
+		}
+		
+		// Counting sort of the nodes by level
+		vLevelStart.assign(nNodes ? *std::max_element(vLevel.begin(), vLevel.end()) + 2 : 1, 0);
+		for (size_t n = 0; n < nNodes; n++) vLevelStart[vLevel[n] + 1]++;
+		for (size_t l = 1; l < vLevelStart.size(); l++) vLevelStart[l] += vLevelStart[l - 1];
+		vec_size_t vPos(vLevelStart.begin(), vLevelStart.end() - 1);
+		for (size_t n = 0; n < nNodes; n++) vNodes[vPos[vLevel[n]]++] = n;
+#else
+		std::iota(vNodes.begin(), vNodes.end(), 0);
+		vLevelStart = { 0, nNodes };
+#endif
+	}
+
 	void CMessagePassing::createMessages(std::optional<float> val)
 	{
 		const size_t nEdges = getGraph().getNumEdges();
 		const byte	nStates	= getGraph().getNumStates();
-		
+
 		m_msg = new float[nEdges * nStates];
 		DGM_ASSERT_MSG(m_msg, "Out of Memory");
 		m_msg_temp = new float[nEdges * nStates];
 		DGM_ASSERT_MSG(m_msg_temp, "Out of Memory");
 
-		if (val) {
+		if (!m_vInitialMessages.empty()) {
+			DGM_ASSERT_MSG(m_vInitialMessages.size() == nEdges * nStates, "The number of the initial messages (%zu) does not correspond to the graph (%zu)", m_vInitialMessages.size(), nEdges * nStates);
+			std::copy(m_vInitialMessages.begin(), m_vInitialMessages.end(), m_msg);
+			std::copy(m_vInitialMessages.begin(), m_vInitialMessages.end(), m_msg_temp);
+			vec_float_t().swap(m_vInitialMessages);
+		}
+		else if (val) {
 			std::fill(m_msg, m_msg + nEdges * nStates, val.value());
 			std::fill(m_msg_temp, m_msg_temp + nEdges * nStates, val.value());
 		}
@@ -96,6 +239,7 @@ namespace DirectGraphicalModels
 	void CMessagePassing::deleteMessages(void)
 	{
 		if (m_msg) {
+			if (m_keepMessages) m_vMessages.assign(m_msg, m_msg + getGraph().getNumEdges() * getGraph().getNumStates());
 			delete[] m_msg;
 			m_msg = NULL;
 		}
@@ -112,32 +256,13 @@ namespace DirectGraphicalModels
 		m_msg_temp = pTemp;
 	}
 
-	float* CMessagePassing::getMessage(size_t edge) 
-	{ 
+	float* CMessagePassing::getMessage(size_t edge)
+	{
 		return m_msg ? m_msg + edge * getGraph().getNumStates() : NULL;
 	}
 
-	float* CMessagePassing::getMessageTemp(size_t edge) 
-	{ 
-		return m_msg_temp ? m_msg_temp + edge * getGraph().getNumStates() : NULL;
-	}
-
-	// dst = (M * M)^T x v
-	float CMessagePassing::MatMul(const Mat& M, const float* v, float* dst, bool maxSum)
+	float* CMessagePassing::getMessageTemp(size_t edge)
 	{
-		float res = 0;
-		DGM_ASSERT(dst);
-		for (int x = 0; x < M.cols; x++) {
-			float sum = 0;
-			for (int y = 0; y < M.rows; y++) {
-				float m = M.at<float>(y, x);
-				float prod = v[y] * m * m;
-				if (maxSum) { if (prod > sum) sum = prod; }
-				else sum += prod;
-			} // y
-			dst[x] = sum;
-			res += sum;
-		} // x
-		return res;
+		return m_msg_temp ? m_msg_temp + edge * getGraph().getNumStates() : NULL;
 	}
 }
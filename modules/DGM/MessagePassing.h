@@ -3,16 +3,53 @@
 #pragma once
 
 #include "Infer.h"
-#include "GraphPairwise.h"
+#include "IGraphPairwise.h"
 
 namespace DirectGraphicalModels
 {
-	struct Edge;
+	// ============================ Graph View Structure ===========================
+	/**
+	* @brief Flat view of a pairwise graph
+	* @details Provides the message passing algorithms with raw access to the node and edge potentials and to the compressed-sparse-row (CSR)
+	* adjacency of the graph. For CGraphPairwiseCSR the topology is referenced without copying; for CGraphPairwise it is gathered once per inference.
+	*/
+	struct GraphPairwiseView {
+		/// Range of edge indexes
+		struct EdgeRange {
+			const size_t * pBegin;
+			const size_t * pEnd;
+
+			const size_t * begin(void) const { return pBegin; }
+			const size_t * end(void) const { return pEnd; }
+			size_t		   size(void) const { return pEnd - pBegin; }
+		};
+
+		std::vector<float *>		vpNodePot;		///< Node potentials: nStates values per node
+		std::vector<const float *>	vpEdgePot;		///< Edge potentials: nStates x nStates values per edge (row-major); NULL if not set
+		std::vector<const float *>	vpEdgePotSqT;	///< Squared and transposed edge potentials for the message kernels (see msgkernel::prepare()); NULL if not set
+		const size_t			  *	pSrc		= NULL;	///< Source node of every edge
+		const size_t			  *	pDst		= NULL;	///< Destination node of every edge
+		const size_t			  *	pOutOffset	= NULL;	///< CSR offsets of the outgoing edges: nNodes + 1
+		const size_t			  *	pOutEdge	= NULL;	///< Outgoing edges, grouped by the source node
+		const size_t			  *	pInOffset	= NULL;	///< CSR offsets of the incoming edges: nNodes + 1
+		const size_t			  *	pInEdge		= NULL;	///< Incoming edges, grouped by the destination node
+
+		size_t		getNumNodes(void) const { return vpNodePot.size(); }
+		size_t		getNumEdges(void) const { return vpEdgePot.size(); }
+		/// Returns the outgoing edges of the node \b node
+		EdgeRange	to(size_t node) const { return { pOutEdge + pOutOffset[node], pOutEdge + pOutOffset[node + 1] }; }
+		/// Returns the incoming edges of the node \b node
+		EdgeRange	from(size_t node) const { return { pInEdge + pInOffset[node], pInEdge + pInOffset[node + 1] }; }
+
+		vec_size_t	vSrc, vDst, vOutOffset, vOutEdge, vInOffset, vInEdge;	///< Storage for the gathered topology (unused for CGraphPairwiseCSR)
+		vec_float_t	vEdgePotSqT;											///< Storage for the squared and transposed edge potentials: one table per distinct edge potential
+	};
 
 	// ==================== Message Passing Base Abstract Class ==================
 	/**
 	* @ingroup moduleDecode
 	* @brief Abstract base class for message passing inference algorithmes
+	* @details The message passing algorithms may be applied to both CGraphPairwise and CGraphPairwiseCSR graphs
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
 	class CMessagePassing : public CInfer
@@ -22,10 +59,41 @@ namespace DirectGraphicalModels
 		* @brief Constructor
 		* @param graph The graph
 		*/
-		DllExport CMessagePassing(CGraphPairwise &graph) : CInfer(graph) {}
+		DllExport CMessagePassing(IGraphPairwise &graph) : CInfer(graph), m_msg(NULL), m_msg_temp(NULL), m_keepMessages(false) {}
 		DllExport virtual ~CMessagePassing(void) = default;
-		
+
 		DllExport virtual void	  infer(unsigned int nIt = 1);
+		/**
+		* @brief Sets the initial messages for the next inference
+		* @details By default, the inference starts with the uniform messages. The messages, set with this function, are used instead by the next call 
+		* of infer() and then discarded, which allows to warm-start the inference, \a e.g. with the messages of a previous frame or of a coarser graph
+		* (Ref. CInferPyramid). The messages are not normalized, but the algorithms are invariant to the scale of every message.
+		* > This function is used by the algorithms, starting with the uniform messages: CInferLBP, CInferTRW and the derived ones
+		* @param vMessages The messages: nEdges x nStates values in the order of the edges of the graph
+		*/
+		DllExport void			  setInitialMessages(const vec_float_t &vMessages) { m_vInitialMessages = vMessages; }
+		/**
+		* @brief Enables keeping the messages after inference
+		* @details If enabled, infer() copies the final messages, which may be then obtained with getMessages()
+		* @param keep Flag indicating whether the messages should be kept
+		*/
+		DllExport void			  keepMessages(bool keep = true) { m_keepMessages = keep; }
+		/**
+		* @brief Returns the messages of the last inference
+		* @details The messages are kept only if enabled with keepMessages()
+		* @return The messages: nEdges x nStates values in the order of the edges of the graph
+		*/
+		DllExport const vec_float_t & getMessages(void) const { return m_vMessages; }
+		/**
+		* @brief Builds the flat view of a graph
+		* @details The edges of the view are in the order, in which the message passing algorithms store the messages, \a e.g. in setInitialMessages()
+		* and getMessages(). The view references the data of the graph, thus the graph must not be changed while the view is used.
+		* @param[in] graph The graph (CGraphPairwise or CGraphPairwiseCSR)
+		* @param[out] view The flat view of the graph
+		* @param[in] squarePotentials Flag indicating whether the squared and transposed edge potentials GraphPairwiseView::vpEdgePotSqT should be prepared.
+		* Every distinct edge potential (\a e.g. a table shared by many edges) is prepared only once.
+		*/
+		DllExport static void	  buildView(IGraphPairwise &graph, GraphPairwiseView &view, bool squarePotentials = true);
 
 
 	protected:
@@ -33,7 +101,13 @@ namespace DirectGraphicalModels
 		* @brief Returns the graph
 		* @return The graph
 		*/
-		CGraphPairwise& getGraphPairwise(void) const { return dynamic_cast<CGraphPairwise&>(getGraph()); }
+		IGraphPairwise& getGraphPairwise(void) const { return dynamic_cast<IGraphPairwise&>(getGraph()); }
+		/**
+		* @brief Returns the flat view of the graph
+		* @details The view is valid between createView() and deleteView() calls
+		* @return The view of the graph
+		*/
+		const GraphPairwiseView& getView(void) const { return m_view; }
 		/**
 		* @brief Calculates messages, associated with the edges of corresponding graphical model
 		* @details > This function may modify Edge::msg and Edge::msg_temp containers of graph edges
@@ -43,15 +117,36 @@ namespace DirectGraphicalModels
 		/**
 		* @brief Calculates one message for the specified edge \b edge
 		* @details > PPL-safe function.
-		* @param[in] edge Graph edge
+		* @param[in] edge Index of the graph edge
 		* @param[in] temp Auxilary array of \b nStates values. Introduced for higher perfomance reasons.
 		* @param[out] dst Destination array for calculated message. Usually \b edge->msg or \b edge->msg_temp.
 		* @param[in] maxSum Flag indicating weather the message must be calculated according to the \a sum-product (false) or \a max-product (true) algorithm.
 		*/
-		void	calculateMessage(const Edge& edge, float* temp, float* dst, bool maxSum = false);
+		void	calculateMessage(size_t edge, float* temp, float* dst, bool maxSum = false);
+		/**
+		* @brief Captures the flat view of the graph
+		* @details The graph structure must not be changed until deleteView() is called
+		* @param squarePotentials Flag indicating whether the squared and transposed edge potentials GraphPairwiseView::vpEdgePotSqT should be prepared (Ref. buildView())
+		*/
+		void	createView(bool squarePotentials = true);
+		/**
+		* @brief Releases the flat view of the graph
+		*/
+		void	deleteView(void);
+		/**
+		* @brief Creates the level schedule for the sequential message passing algorithms
+		* @details Groups the nodes into levels, such that the level of a node is larger than the levels of all its neighbours with smaller indexes.
+		* The nodes of one level are not connected with each other and may be processed concurrently, while processing the levels in the ascending
+		* (descending) order keeps every node after all its neighbours with smaller (larger) indexes, as in the sequential order. 
+		* On grid graphs the levels are the anti-diagonal wavefronts. If \b ENABLE_PDP is not defined, all the nodes form one level in the index order.
+		* > The flat view of the graph must be created before calling this function
+		* @param[out] vNodes The nodes, sorted by level
+		* @param[out] vLevelStart The index of the first node of every level in \b vNodes, followed by the number of nodes
+		*/
+		void	createSchedule(vec_size_t &vNodes, vec_size_t &vLevelStart) const;
 		/**
 		* @brief Allocates memory for Edge::msg and Edge::msg_temp containers for all edges in the graph
-		* @param val Default value to fill in the Edge::msg and Edge::msg_temp containers 
+		* @param val Default value to fill in the Edge::msg and Edge::msg_temp containers
 		*/
 		void	createMessages(std::optional<float> val = std::nullopt);
 		/**
@@ -59,7 +154,7 @@ namespace DirectGraphicalModels
 		*/
 		void	deleteMessages(void);
 		/**
-		* @brief Swaps Edge::msg and Edge::msg_temp for all edges in the graph 
+		* @brief Swaps Edge::msg and Edge::msg_temp for all edges in the graph
 		*/
 		void	swapMessages(void);
 		/**
@@ -74,21 +169,23 @@ namespace DirectGraphicalModels
 		* @return The pointer to the edge temp messages
 		*/
 		float*	getMessageTemp(size_t edge);
+
+
+	private:
 		/**
-		* @brief Specific matrix multiplication
-		* @details This function calculates the result of multiplying square of matrix \b M by vector \b v as following:
-		* \f$\vec{dst} = (M\cdot M)^\top\times\vec{v}\f$
-		* @param[in] M Matrix: Mat(size: \a M.height x \a M.width; type: CV_32FC1)
-		* @param[in] v Vector of length \a M.height
-		* @param[out] dst Resulting vector of length \a M.width.
-		* @param[in] maxSum Flag indicating weather the \a max-sum multiplication should be performed
-		* @return The sum of all elemts in vector \b dst
+		* @brief Fills in GraphPairwiseView::vpEdgePotSqT
+		* @param view The flat view of the graph
+		* @param nStates The number of states
 		*/
-		static float MatMul(const Mat& M, const float* v, float* dst, bool maxSum = false);
+		static void	prepareEdgePotentials(GraphPairwiseView &view, byte nStates);
 
 
 	private:
-		float	* m_msg;			///< Message: Mat(size: nStates x 1; type: CV_32FC1)
-		float	* m_msg_temp;		///< Temp Message: Mat(size: nStates x 1; type: CV_32FC1)
+		GraphPairwiseView	  m_view;			///< Flat view of the graph
+		float				* m_msg;			///< Message: Mat(size: nStates x 1; type: CV_32FC1)
+		float				* m_msg_temp;		///< Temp Message: Mat(size: nStates x 1; type: CV_32FC1)
+		vec_float_t			  m_vInitialMessages;	///< The initial messages for the next inference
+		vec_float_t			  m_vMessages;		///< The messages of the last inference
+		bool				  m_keepMessages;	///< Flag indicating whether the messages of the last inference should be kept
 	};
 }
@@ -0,0 +1,281 @@
+#include "SampleStore.h"
+#include "random.h"
+#include "macroses.h"
+#include <filesystem>
+#include <unordered_set>
+#include <numeric>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace DirectGraphicalModels
+{
+	namespace {
+		const char		MAGIC[8]		= { 'D', 'G', 'M', 'S', 'T', 'O', 'R', 'E' };
+		const dword		VERSION			= 1;
+		const size_t	HEADER_SIZE		= sizeof(MAGIC) + sizeof(dword) + 2 * sizeof(word);	// magic, version, nStates, nFeatures
+		const size_t	SEGMENT_HEADER	= 2 * sizeof(dword);									// state, nSamples
+		const size_t	SEGMENT_BYTES	= 4 << 20;												// Maximal size of the samples data in one segment
+
+		// Read-only memory mapping of a file
+		class CMappedFile
+		{
+		public:
+			CMappedFile(const std::string &fileName, size_t size) : m_size(size)
+			{
+				if (size == 0) return;
+#ifdef _WIN32
+				m_hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+				DGM_ASSERT_MSG(m_hFile != INVALID_HANDLE_VALUE, "Can't open file %s", fileName.c_str());
+				m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+				DGM_ASSERT_MSG(m_hMapping, "Can't map file %s", fileName.c_str());
+				m_pData = static_cast<const byte *>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, size));
+				DGM_ASSERT_MSG(m_pData, "Can't map file %s", fileName.c_str());
+#else
+				int fd = open(fileName.c_str(), O_RDONLY);
+				DGM_ASSERT_MSG(fd >= 0, "Can't open file %s", fileName.c_str());
+				void *pData = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				close(fd);
+				DGM_ASSERT_MSG(pData != MAP_FAILED, "Can't map file %s", fileName.c_str());
+				m_pData = static_cast<const byte *>(pData);
+#endif
+			}
+			CMappedFile(const CMappedFile &) = delete;
+			~CMappedFile(void)
+			{
+#ifdef _WIN32
+				if (m_pData) UnmapViewOfFile(m_pData);
+				if (m_hMapping) CloseHandle(m_hMapping);
+				if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+#else
+				if (m_pData) munmap(const_cast<byte *>(m_pData), m_size);
+#endif
+			}
+			CMappedFile & operator=(const CMappedFile &) = delete;
+
+			const byte * data(void) const { return m_pData; }
+
+
+		private:
+			const byte	* m_pData = NULL;
+			size_t		  m_size;
+#ifdef _WIN32
+			HANDLE		  m_hFile = INVALID_HANDLE_VALUE;
+			HANDLE		  m_hMapping = NULL;
+#endif
+		};
+
+		// Floyd's algorithm: k distinct random indices from [0; n), sorted
+		vec_size_t getRandomSubset(size_t n, size_t k)
+		{
+			std::unordered_set<size_t> selected;
+			selected.reserve(k);
+			for (size_t j = n - k; j < n; j++) {
+				size_t t = random::u<size_t>(0, j);
+				if (!selected.insert(t).second) selected.insert(j);
+			}
+			vec_size_t res(selected.begin(), selected.end());
+			std::sort(res.begin(), res.end());
+			return res;
+		}
+	}
+
+	CSampleStore::CSampleStore(const std::string &fileName, byte nStates, word nFeatures)
+		: m_fileName(fileName)
+		, m_nFeatures(nFeatures)
+		, m_segmentSize(MAX(1, SEGMENT_BYTES / MAX(1, nFeatures)))
+		, m_vvSegments(nStates)
+		, m_vBuffers(nStates)
+	{
+		DGM_ASSERT_MSG(nStates > 0, "The number of states must be positive");
+		DGM_ASSERT_MSG(nFeatures > 0, "The number of features must be positive");
+		open();
+	}
+
+	CSampleStore::~CSampleStore(void)
+	{
+		if (m_pFile) {
+			flush();
+			fclose(m_pFile);
+		}
+	}
+
+	void CSampleStore::addSample(const Mat &featureVector, byte state)
+	{
+		// Assertions:
+		DGM_ASSERT_MSG(state < m_vBuffers.size(), "The groundtruth value %d is out of range %zu", state, m_vBuffers.size());
+		DGM_ASSERT_MSG(featureVector.type() == CV_8UC1, "Incorrect type of the feature vector");
+		DGM_ASSERT_MSG(featureVector.total() == m_nFeatures, "The number of features (%zu) does not correspond to %d", featureVector.total(), m_nFeatures);
+
+		vec_byte_t &buffer = m_vBuffers[state];
+		const Mat fv = featureVector.isContinuous() ? featureVector : featureVector.clone();
+		buffer.insert(buffer.end(), fv.ptr<byte>(), fv.ptr<byte>() + m_nFeatures);
+		if (buffer.size() >= m_segmentSize * m_nFeatures) writeSegment(state);
+	}
+
+	void CSampleStore::addSamples(const Mat &featureVectors, const Mat &states)
+	{
+		// Assertions:
+		DGM_ASSERT_MSG(featureVectors.depth() == CV_8U, "Incorrect type of the feature vectors");
+		DGM_ASSERT_MSG(states.type() == CV_8UC1, "Incorrect type of the states");
+
+		const byte nStates = static_cast<byte>(m_vBuffers.size());
+		const bool isBlock = featureVectors.channels() == 1 && featureVectors.cols == m_nFeatures && states.cols == 1;	// nSamples x nFeatures
+		if (isBlock) DGM_ASSERT_MSG(featureVectors.rows == states.rows, "The amount of feature vectors (%d) does not correspond to the amount of states (%d)", featureVectors.rows, states.rows);
+		else {
+			DGM_ASSERT_MSG(featureVectors.channels() == m_nFeatures, "The number of features (%d) does not correspond to %d", featureVectors.channels(), m_nFeatures);
+			DGM_ASSERT_MSG(featureVectors.size() == states.size(), "The size of the feature vectors does not correspond to the size of the states");
+		}
+
+		for (int y = 0; y < states.rows; y++) {
+			const byte *pFv		= featureVectors.ptr<byte>(y);
+			const byte *pState	= states.ptr<byte>(y);
+			for (int x = 0; x < states.cols; x++) {
+				const byte state = pState[x];
+				DGM_ASSERT_MSG(state < nStates, "The groundtruth value %d is out of range %d", state, nStates);
+				vec_byte_t &buffer = m_vBuffers[state];
+				buffer.insert(buffer.end(), pFv + x * m_nFeatures, pFv + (x + 1) * m_nFeatures);
+				if (buffer.size() >= m_segmentSize * m_nFeatures) writeSegment(state);
+			} // x
+		} // y
+	}
+
+	void CSampleStore::flush(void)
+	{
+		for (byte s = 0; s < m_vBuffers.size(); s++)
+			if (!m_vBuffers[s].empty()) writeSegment(s);
+		fflush(m_pFile);
+	}
+
+	void CSampleStore::getSamples(Mat &samples, Mat &states, size_t maxSamples) const
+	{
+		const byte nStates = static_cast<byte>(m_vBuffers.size());
+
+		// The number of samples of every state
+		vec_size_t vCount(nStates);
+		vec_size_t vSelected(nStates);
+		for (byte s = 0; s < nStates; s++) {
+			vCount[s] = getNumSamples(s);
+			vSelected[s] = maxSamples ? MIN(vCount[s], maxSamples) : vCount[s];
+		}
+		const size_t nSamples = std::accumulate(vSelected.begin(), vSelected.end(), static_cast<size_t>(0));
+		samples = Mat(static_cast<int>(nSamples), m_nFeatures, CV_8UC1);
+		states	= Mat(static_cast<int>(nSamples), 1, CV_8UC1);
+		if (nSamples == 0) return;
+
+		fflush(m_pFile);
+		const CMappedFile file(m_fileName, static_cast<size_t>(m_fileSize));
+
+		int row = 0;
+		for (byte s = 0; s < nStates; s++) {
+			// Random subset of the samples, which are addressed by the global index over the segments, followed by the buffer
+			vec_size_t vIdx;
+			if (vSelected[s] < vCount[s]) vIdx = getRandomSubset(vCount[s], vSelected[s]);
+			else {
+				vIdx.resize(vCount[s]);
+				std::iota(vIdx.begin(), vIdx.end(), static_cast<size_t>(0));
+			}
+
+			auto	itSegment	= m_vvSegments[s].begin();
+			size_t	first		= 0;									// The global index of the first sample in the current segment
+			for (size_t idx : vIdx) {
+				while (itSegment != m_vvSegments[s].end() && idx >= first + itSegment->nSamples) first += (itSegment++)->nSamples;
+				const byte *pSample = itSegment != m_vvSegments[s].end()
+					? file.data() + itSegment->offset + (idx - first) * m_nFeatures
+					: m_vBuffers[s].data() + (idx - first) * m_nFeatures;
+				memcpy(samples.ptr<byte>(row), pSample, m_nFeatures);
+				states.at<byte>(row, 0) = s;
+				row++;
+			} // idx
+		} // s
+	}
+
+	size_t CSampleStore::getNumSamples(byte state) const
+	{
+		DGM_ASSERT_MSG(state < m_vBuffers.size(), "The groundtruth value %d is out of range %zu", state, m_vBuffers.size());
+		size_t res = m_vBuffers[state].size() / m_nFeatures;
+		for (const Segment &segment : m_vvSegments[state])
+			res += segment.nSamples;
+		return res;
+	}
+
+	// ------------------------- Private -------------------------
+	// File format: magic (8 chars), version (dword), nStates (word), nFeatures (word), followed by the segments:
+	// state (dword), nSamples (dword), samples (nSamples x nFeatures bytes)
+	void CSampleStore::open(void)
+	{
+		const word nStates = static_cast<word>(m_vBuffers.size());
+		std::error_code ec;
+		const uint64_t fileSize = std::filesystem::exists(m_fileName, ec) ? std::filesystem::file_size(m_fileName, ec) : 0;
+
+		if (fileSize == 0) {
+			m_pFile = fopen(m_fileName.c_str(), "wb");
+			DGM_ASSERT_MSG(m_pFile, "Can't create file %s", m_fileName.c_str());
+			fwrite(MAGIC, sizeof(char), sizeof(MAGIC), m_pFile);
+			fwrite(&VERSION, sizeof(dword), 1, m_pFile);
+			fwrite(&nStates, sizeof(word), 1, m_pFile);
+			fwrite(&m_nFeatures, sizeof(word), 1, m_pFile);
+			fflush(m_pFile);
+			m_fileSize = HEADER_SIZE;
+			return;
+		}
+
+		// Resuming: reading the header and the list of the segments (no other store may write to the file)
+		uint64_t pos = HEADER_SIZE;
+		{
+			DGM_ASSERT_MSG(fileSize >= HEADER_SIZE, "The file %s is not a samples store", m_fileName.c_str());
+			const CMappedFile file(m_fileName, static_cast<size_t>(fileSize));
+			const byte *pData = file.data();
+			dword	version;
+			word	nStatesFile;
+			word	nFeaturesFile;
+			memcpy(&version, pData + sizeof(MAGIC), sizeof(dword));
+			memcpy(&nStatesFile, pData + sizeof(MAGIC) + sizeof(dword), sizeof(word));
+			memcpy(&nFeaturesFile, pData + sizeof(MAGIC) + sizeof(dword) + sizeof(word), sizeof(word));
+			DGM_ASSERT_MSG(memcmp(pData, MAGIC, sizeof(MAGIC)) == 0 && version == VERSION, "The file %s is not a samples store", m_fileName.c_str());
+			DGM_ASSERT_MSG(nStatesFile == nStates, "The number of states in the file (%d) does not correspond to %d", nStatesFile, nStates);
+			DGM_ASSERT_MSG(nFeaturesFile == m_nFeatures, "The number of features in the file (%d) does not correspond to %d", nFeaturesFile, m_nFeatures);
+
+			while (pos + SEGMENT_HEADER <= fileSize) {
+				dword header[2];
+				memcpy(header, pData + pos, SEGMENT_HEADER);
+				const uint64_t size = static_cast<uint64_t>(header[1]) * m_nFeatures;
+				if (header[0] >= nStates || pos + SEGMENT_HEADER + size > fileSize) break;			// incomplete segment
+				m_vvSegments[header[0]].push_back({ pos + SEGMENT_HEADER, header[1] });
+				pos += SEGMENT_HEADER + size;
+			}
+		} // the file is unmapped before truncation
+
+		if (pos < fileSize) {
+			DGM_WARNING("The incomplete segment at the end of file %s is discarded", m_fileName.c_str());
+			std::filesystem::resize_file(m_fileName, pos, ec);
+			DGM_ASSERT_MSG(!ec, "Can't truncate file %s", m_fileName.c_str());
+		}
+		m_fileSize = pos;
+
+		m_pFile = fopen(m_fileName.c_str(), "ab");
+		DGM_ASSERT_MSG(m_pFile, "Can't open file %s", m_fileName.c_str());
+	}
+
+	void CSampleStore::writeSegment(byte state)
+	{
+		vec_byte_t &buffer = m_vBuffers[state];
+		const dword header[2] = { state, static_cast<dword>(buffer.size() / m_nFeatures) };
+		const bool res = fwrite(header, sizeof(dword), 2, m_pFile) == 2 && fwrite(buffer.data(), sizeof(byte), buffer.size(), m_pFile) == buffer.size();
+		DGM_ASSERT_MSG(res, "Can't write to file %s", m_fileName.c_str());
+		m_vvSegments[state].push_back({ m_fileSize + SEGMENT_HEADER, header[1] });
+		m_fileSize += SEGMENT_HEADER + buffer.size();
+		buffer.clear();
+	}
+}
@@ -0,0 +1,120 @@
+// Memory-mapped training samples store class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "types.h"
+
+namespace DirectGraphicalModels
+{
+	// ============================= Samples Store Class =============================
+	/**
+	* @ingroup moduleTrainNode
+	* @brief On-disk training samples store
+	* @details This class stores the training samples (feature vectors with the corresponding states) in an append-only binary file, which allows for
+	* training on the amounts of samples, which do not fit into the memory. The samples are buffered per state and written to the end of the file
+	* as segments of up to 4 MB, \a i.e. the file consists of a header (nStates, nFeatures) and a sequence of segments, each holding the samples
+	* of one state as contiguous rows of \a nFeatures bytes.
+	*
+	* The ingestion is resumable: when the store is opened with the name of an existing file, the new samples are appended to the ones, added in
+	* the previous sessions. An incomplete trailing segment, left by an interrupted process, is discarded.
+	* @warning The file is not locked, thus only one store may write to it at a time: the sessions must be sequential. The stores, appending to the
+	* same file concurrently (in the same or in different processes), overwrite the segments of each other, and opening a file, which is being written,
+	* discards the segment, which is being written at the moment.
+	*
+	* The node trainers CTrainNodeKNN, CTrainNodeCvRF, CTrainNodeMsRF and CTrainNodeCvSVM are trained directly from the store with their
+	* \a train(const CSampleStore &) functions: the file is memory-mapped and only the (randomly selected) samples are copied into the training data,
+	* bypassing the samples accumulator.
+	* @code
+	* CSampleStore store("samples.dat", nStates, nFeatures);
+	* for (auto &image : images) store.addSamples(image.features, image.gt);
+	* store.flush();
+	* CTrainNodeKNN nodeTrainer(nStates, nFeatures);
+	* nodeTrainer.train(store);
+	* @endcode
+	*/
+	class CSampleStore
+	{
+	public:
+		/**
+		* @brief Constructor
+		* @details Opens the store file and appends the new samples to the existing ones, or creates a new file
+		* @param fileName The name of the store file
+		* @param nStates Number of states (classes)
+		* @param nFeatures Number of features
+		*/
+		DllExport CSampleStore(const std::string &fileName, byte nStates, word nFeatures);
+		DllExport CSampleStore(const CSampleStore&) = delete;
+		/**
+		* @brief Destructor
+		* @details Writes the buffered samples to the file
+		*/
+		DllExport ~CSampleStore(void);
+
+		DllExport CSampleStore & operator=(const CSampleStore&) = delete;
+
+		/**
+		* @brief Adds new sample to the store
+		* @param featureVector Multi-dimensinal point: Mat(size: nFeatures x 1; type: CV_8UC1)
+		* @param state State (class) corresponding to the \b featureVector
+		*/
+		DllExport void		addSample(const Mat &featureVector, byte state);
+		/**
+		* @brief Adds a block of samples to the store
+		* @param featureVectors Multi-channel matrix, each element of which is a multi-dimensinal point: Mat(type: CV_8UC(nFeatures)), \a e.g. an image,
+		* or a block of multi-dimensinal points: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param states Matrix, each element of which is a state (class), corresponding to the \b featureVectors: Mat(type: CV_8UC1)
+		*/
+		DllExport void		addSamples(const Mat &featureVectors, const Mat &states);
+		/**
+		* @brief Writes the buffered samples to the file
+		*/
+		DllExport void		flush(void);
+		/**
+		* @brief Returns the samples
+		* @details The file is memory-mapped and only the selected samples are copied into \b samples, thus the memory footprint is defined by the
+		* number of the returned samples. The buffered, not yet written samples are also taken into account.
+		* @param[out] samples The samples: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param[out] states The states (classes) of the samples: Mat(size: nSamples x 1; type: CV_8UC1)
+		* @param[in] maxSamples Maximum number of samples per state. If the store contains more samples of a state, \b maxSamples samples,
+		* selected uniformly at random, are returned. 0 means returning all the samples.
+		*/
+		DllExport void		getSamples(Mat &samples, Mat &states, size_t maxSamples = 0) const;
+		/**
+		* @brief Returns the number of stored samples for the state (class) \b state
+		* @param state The state (class)
+		* @return The number of samples
+		*/
+		DllExport size_t	getNumSamples(byte state) const;
+		/**
+		* @brief Returns the number of states (classes)
+		* @return The number of states
+		*/
+		DllExport byte		getNumStates(void) const { return static_cast<byte>(m_vvSegments.size()); }
+		/**
+		* @brief Returns the number of features
+		* @return The number of features
+		*/
+		DllExport word		getNumFeatures(void) const { return m_nFeatures; }
+
+
+	private:
+		/// Segment of the file
+		struct Segment {
+			uint64_t	offset;						///< The offset of the first sample in the file
+			size_t		nSamples;					///< The number of samples in the segment
+		};
+
+		void	open(void);
+		void	writeSegment(byte state);
+
+
+	private:
+		std::string							m_fileName;			///< The name of the store file
+		word								m_nFeatures;		///< The number of features
+		size_t								m_segmentSize;		///< The maximal number of samples in one segment
+		FILE							  * m_pFile = NULL;		///< The store file, opened for appending
+		uint64_t							m_fileSize = 0;		///< The size of the store file
+		std::vector<std::vector<Segment>>	m_vvSegments;		///< The segments of every state
+		std::vector<vec_byte_t>				m_vBuffers;			///< The buffered samples of every state: nSamples x nFeatures
+	};
+}
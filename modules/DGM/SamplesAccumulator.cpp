@@ -6,42 +6,185 @@ namespace DirectGraphicalModels
 {
 	void CSamplesAccumulator::reset(void)
 	{
-		for (Mat &acc : m_vSamplesAcc) acc.release();
-		std::fill(m_vNumInputSamples.begin(), m_vNumInputSamples.end(), 0);
+		for (byte s = 0; s < m_vvShards.front().size(); s++)
+			release(s);
 	}
 
 	void CSamplesAccumulator::addSample(const Mat &featureVector, byte state)
 	{
 		// Assertions:
-		DGM_ASSERT_MSG(state < m_vSamplesAcc.size(), "The groundtruth value %d is out of range %zu", state, m_vSamplesAcc.size());
+		DGM_ASSERT_MSG(state < m_vvShards.front().size(), "The groundtruth value %d is out of range %zu", state, m_vvShards.front().size());
+		DGM_ASSERT_MSG(featureVector.type() == CV_8UC1, "Incorrect type of the feature vector");
+		if (m_nFeatures == 0) m_nFeatures = static_cast<word>(featureVector.total());
+		DGM_ASSERT_MSG(featureVector.total() == m_nFeatures, "The number of features (%zu) does not correspond to %d", featureVector.total(), m_nFeatures);
 
-		if (m_vSamplesAcc[state].rows < m_maxSamples) {
-			m_vSamplesAcc[state].push_back(featureVector.t());
-		}
+		if (featureVector.isContinuous()) add(m_vvShards.front()[state], featureVector.ptr<byte>());
 		else {
-			int k = random::u(0, m_vNumInputSamples[state]);
-			if (k < m_maxSamples)
-				m_vSamplesAcc[state].row(k) = featureVector.t();
+			Mat fv = featureVector.clone();
+			add(m_vvShards.front()[state], fv.ptr<byte>());
 		}
-		m_vNumInputSamples[state]++;
+	}
+
+	void CSamplesAccumulator::addSamples(const Mat &featureVectors, const Mat &states)
+	{
+		// Assertions:
+		DGM_ASSERT_MSG(featureVectors.type() == CV_8UC1, "Incorrect type of the feature vectors");
+		DGM_ASSERT_MSG(states.type() == CV_8UC1, "Incorrect type of the states");
+		DGM_ASSERT_MSG(featureVectors.rows == states.rows, "The amount of feature vectors (%d) does not correspond to the amount of states (%d)", featureVectors.rows, states.rows);
+		if (featureVectors.empty()) return;
+		if (m_nFeatures == 0) m_nFeatures = static_cast<word>(featureVectors.cols);
+		DGM_ASSERT_MSG(featureVectors.cols == m_nFeatures, "The number of features (%d) does not correspond to %d", featureVectors.cols, m_nFeatures);
+
+		const byte	nStates		= static_cast<byte>(m_vvShards.front().size());
+		const int	nSamples	= featureVectors.rows;
+#ifdef ENABLE_PDP
+		const int	nShards		= MIN(nSamples, MAX(1, getNumThreads()));
+#else
+		const int	nShards		= 1;
+#endif
+		if (m_vvShards.size() < static_cast<size_t>(nShards)) m_vvShards.resize(nShards, std::vector<Reservoir>(nStates));
+
+		// Every stripe of the block is accumulated in its own shard
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, nShards), [&](const Range &range) {
+#else
+		const Range range(0, nShards);
+#endif
+		for (int shard = range.start; shard < range.end; shard++) {
+			const int begin = static_cast<int>(static_cast<long long>(nSamples) * shard / nShards);
+			const int end	= static_cast<int>(static_cast<long long>(nSamples) * (shard + 1) / nShards);
+			std::vector<Reservoir> &vReservoirs = m_vvShards[shard];
+
+			// Preallocating the storage
+			vec_size_t vCount(nStates, 0);
+			for (int i = begin; i < end; i++) {
+				byte state = states.at<byte>(i, 0);
+				DGM_ASSERT_MSG(state < nStates, "The groundtruth value %d is out of range %d", state, nStates);
+				vCount[state]++;
+			}
+			for (byte s = 0; s < nStates; s++) {
+				vec_byte_t &data = vReservoirs[s].data;
+				const size_t size = MIN(m_maxSamples, vReservoirs[s].nInputSamples + vCount[s]) * m_nFeatures;
+				if (size > data.capacity()) data.reserve(MAX(size, 2 * data.capacity()));
+			}
+
+			for (int i = begin; i < end; i++)
+				add(vReservoirs[states.at<byte>(i, 0)], featureVectors.ptr<byte>(i));
+		} // shard
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	Mat CSamplesAccumulator::getSamplesContainer(byte state) const
+	{
+		DGM_ASSERT_MSG(state < m_vvShards.front().size(), "The groundtruth value %d is out of range %zu", state, m_vvShards.front().size());
+		merge(state);
+		const Reservoir &reservoir = m_vvShards.front()[state];
+		if (reservoir.data.empty()) return Mat();
+		return Mat(static_cast<int>(reservoir.data.size() / m_nFeatures), m_nFeatures, CV_8UC1, const_cast<byte *>(reservoir.data.data()));
 	}
 
 	int	CSamplesAccumulator::getNumSamples(byte state) const
 	{
-		DGM_ASSERT_MSG(state < m_vSamplesAcc.size(), "The groundtruth value %d is out of range %zu", state, m_vSamplesAcc.size());
-		return m_vSamplesAcc[state].rows;
+		DGM_ASSERT_MSG(state < m_vvShards.front().size(), "The groundtruth value %d is out of range %zu", state, m_vvShards.front().size());
+		merge(state);
+		const Reservoir &reservoir = m_vvShards.front()[state];
+		return reservoir.data.empty() ? 0 : static_cast<int>(reservoir.data.size() / m_nFeatures);
 	}
 
 	int CSamplesAccumulator::getNumInputSamples(byte state) const
 	{
-		DGM_ASSERT_MSG(state < m_vNumInputSamples.size(), "The groundtruth value %d is out of range %zu", state, m_vNumInputSamples.size());
-		return m_vNumInputSamples[state];
+		DGM_ASSERT_MSG(state < m_vvShards.front().size(), "The groundtruth value %d is out of range %zu", state, m_vvShards.front().size());
+		size_t res = 0;
+		for (const auto &vReservoirs : m_vvShards)
+			res += vReservoirs[state].nInputSamples;
+		return static_cast<int>(res);
 	}
 
 	void CSamplesAccumulator::release(byte state)
 	{
-		m_vNumInputSamples[state] = 0;
-		m_vSamplesAcc[state].release();
+		for (auto &vReservoirs : m_vvShards) {
+			vec_byte_t().swap(vReservoirs[state].data);
+			vReservoirs[state].nInputSamples = 0;
+		}
+	}
+
+	// ------------------------- Private -------------------------
+	// Algorithm R: the n-th sample replaces a random stored one with probability maxSamples / n
+	void CSamplesAccumulator::add(Reservoir &reservoir, const byte *pSample) const
+	{
+		if (reservoir.nInputSamples < m_maxSamples)
+			reservoir.data.insert(reservoir.data.end(), pSample, pSample + m_nFeatures);
+		else {
+			size_t k = random::u<size_t>(0, reservoir.nInputSamples);
+			if (k < m_maxSamples)
+				memcpy(&reservoir.data[k * m_nFeatures], pSample, m_nFeatures);
+		}
+		reservoir.nInputSamples++;
 	}
 
-}
\ No newline at end of file
+	// The number of the samples, taken from every shard, follows the multivariate hypergeometric distribution,
+	// thus the merged samples remain a uniform random subset of all the input samples
+	void CSamplesAccumulator::merge(byte state) const
+	{
+		const size_t nShards = m_vvShards.size();
+		size_t nInputSamples = 0;
+		size_t nStoredSamples = 0;
+		bool isMerged = true;
+		for (size_t shard = 0; shard < nShards; shard++) {
+			const Reservoir &reservoir = m_vvShards[shard][state];
+			nInputSamples  += reservoir.nInputSamples;
+			nStoredSamples += reservoir.data.size();
+			if (shard > 0 && reservoir.nInputSamples > 0) isMerged = false;
+		}
+		if (isMerged) return;
+		nStoredSamples /= m_nFeatures;
+
+		Reservoir &dst = m_vvShards.front()[state];
+		if (nStoredSamples <= m_maxSamples) {								// all the samples are kept: concatenation
+			dst.data.reserve(nStoredSamples * m_nFeatures);
+			for (size_t shard = 1; shard < nShards; shard++) {
+				const Reservoir &src = m_vvShards[shard][state];
+				dst.data.insert(dst.data.end(), src.data.begin(), src.data.end());
+			}
+		}
+		else {
+			// The number of samples from every shard
+			vec_size_t vRemaining(nShards);
+			vec_size_t vCount(nShards, 0);
+			for (size_t shard = 0; shard < nShards; shard++) vRemaining[shard] = m_vvShards[shard][state].nInputSamples;
+			size_t nRemaining = nInputSamples;
+			for (size_t i = 0; i < m_maxSamples; i++) {
+				size_t k = random::u<size_t>(0, nRemaining - 1);
+				size_t shard = 0;
+				while (k >= vRemaining[shard]) k -= vRemaining[shard++];
+				vRemaining[shard]--;
+				vCount[shard]++;
+				nRemaining--;
+			}
+
+			// Random samples from every shard: partial Fisher-Yates shuffle
+			vec_byte_t data;
+			data.reserve(m_maxSamples * m_nFeatures);
+			for (size_t shard = 0; shard < nShards; shard++) {
+				Reservoir &src = m_vvShards[shard][state];
+				const size_t nSamples = src.data.size() / m_nFeatures;
+				byte *pData = src.data.data();
+				for (size_t i = 0; i < vCount[shard]; i++) {
+					size_t j = random::u<size_t>(i, nSamples - 1);
+					byte *pSample = pData + i * m_nFeatures;
+					if (j != i) std::swap_ranges(pSample, pSample + m_nFeatures, pData + j * m_nFeatures);
+					data.insert(data.end(), pSample, pSample + m_nFeatures);
+				}
+			}
+			dst.data.swap(data);
+		}
+		dst.nInputSamples = nInputSamples;
+
+		for (size_t shard = 1; shard < nShards; shard++) {
+			vec_byte_t().swap(m_vvShards[shard][state].data);
+			m_vvShards[shard][state].nInputSamples = 0;
+		}
+	}
+}
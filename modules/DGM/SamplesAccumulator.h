@@ -10,6 +10,12 @@ namespace DirectGraphicalModels
 	/**
 	* @brief Samples accumulator abstract class
 	* @details This class allows for storing samples (\a e.g. n-dimensinal points in feature space) into the memory
+	*
+	* The samples of every state are stored contiguously as rows of \a nFeatures bytes. If the number of samples is limited, the stored samples are
+	* a uniform random subset of all the added samples (<a href="https://en.wikipedia.org/wiki/Reservoir_sampling" target="_blank">reservoir sampling</a>).
+	* The blocks of samples, added with addSamples(), are split into stripes, which are accumulated concurrently in independent shards without locking.
+	* The shards are merged into one container, when the samples are requested, \a e.g. with getSamplesContainer() in the \a train() function of the
+	* node trainers. The merging preserves the uniformity of the random subset.
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
 	class CSamplesAccumulator
@@ -20,12 +26,11 @@ namespace DirectGraphicalModels
 		* @param nStates Number of states (classes)
 		* @param maxSamples Maximum number of samples to be used in training.
 		* > Default value \b 0 means using all the samples.<br>
-		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addSample() function
+		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addSample() or addSamples() functions
 		*/
 		CSamplesAccumulator(byte nStates, size_t maxSamples)
-			: m_vSamplesAcc(vec_mat_t(nStates))
-			, m_vNumInputSamples(vec_int_t(nStates, 0))
-			, m_maxSamples(maxSamples ? static_cast<int>(maxSamples) : std::numeric_limits<int>::max())
+			: m_vvShards(1, std::vector<Reservoir>(nStates))
+			, m_maxSamples(maxSamples ? maxSamples : std::numeric_limits<size_t>::max())
 		{ }
 		CSamplesAccumulator(const CSamplesAccumulator&) = delete;
 		~CSamplesAccumulator(void) {}
@@ -38,16 +43,26 @@ namespace DirectGraphicalModels
 		void	reset(void);
 		/**
 		* @brief Adds new sample to the accumulator
-		* @param featureVector Multi-dimensinal point: Mat(size: nFeatures x 1)
+		* @param featureVector Multi-dimensinal point: Mat(size: nFeatures x 1; type: CV_8UC1)
 		* @param state State (class) corresponding to the \b featureVector
 		*/
 		void	addSample(const Mat &featureVector, byte state);
 		/**
+		* @brief Adds a block of samples to the accumulator
+		* @details The block is split into stripes, one per thread, and every stripe is accumulated into its own shard.
+		* > This function supports PPL.
+		* @param featureVectors Block of multi-dimensinal points: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param states States (classes) corresponding to the \b featureVectors: Mat(size: nSamples x 1; type: CV_8UC1)
+		*/
+		void	addSamples(const Mat &featureVectors, const Mat &states);
+		/**
 		* @brief Returns samples container for the state (class) \b state
+		* @details This function may be called concurrently for different states.
 		* @param state The state (class)
-		* @return The container: Mat(size: nSamples x nFeatures)
+		* @return The container: Mat(size: nSamples x nFeatures; type: CV_8UC1). The matrix header points to the data of the accumulator, 
+		* which is valid until the next modification of the accumulator.
 		*/
-		Mat		getSamplesContainer(byte state) const { return m_vSamplesAcc[state]; }
+		Mat		getSamplesContainer(byte state) const;
 		/**
 		* @brief Returns the number of stored samples in container for the state (class) \b state
 		* @param state The state (class)
@@ -56,7 +71,7 @@ namespace DirectGraphicalModels
 		int		getNumSamples(byte state) const;
 		/**
 		* @brief Returns the number of input samples in container for the state (class) \b state
-		* @details This function retunts the number of samples added with the addSample() function.
+		* @details This function retunts the number of samples added with the addSample() or addSamples() functions.
 		* Please note, that this number may be larger than the number of samples, actually stored in container,
 		* that may me true, if the constructor's argument \b maxSamples was specified.
 		* than the output of the getNumSamples()
@@ -65,6 +80,11 @@ namespace DirectGraphicalModels
 		*/
 		int		getNumInputSamples(byte state) const;
 		/**
+		* @brief Returns the maximal number of stored samples per state (class)
+		* @return The maximal number of samples, specified in the constructor, or the maximal value of size_t if all the samples are stored
+		*/
+		size_t	getMaxSamples(void) const { return m_maxSamples; }
+		/**
 		* @brief Releases memory of container for the state (class) \b state
 		* @param state The state (class)
 		*/
@@ -72,8 +92,28 @@ namespace DirectGraphicalModels
 
 
 	private:
-		vec_mat_t	m_vSamplesAcc;						// = vec_mat_t(nStates);	// Samples container for all states
-		vec_int_t	m_vNumInputSamples;					// = vec_int_t(nStates, 0);	// Amount of input samples for all states		
-		int			m_maxSamples;						// = INFINITY;				// for optimisation purposes
+		/// Samples of one state in one shard
+		struct Reservoir {
+			vec_byte_t	data;							///< The stored samples: nSamples x nFeatures
+			size_t		nInputSamples = 0;				///< The number of the samples, added to the reservoir
+		};
+
+		/**
+		* @brief Adds a sample to the reservoir
+		* @param reservoir The reservoir
+		* @param pSample The pointer to the sample of m_nFeatures elements
+		*/
+		void	add(Reservoir &reservoir, const byte *pSample) const;
+		/**
+		* @brief Merges all the shards of the state (class) \b state into the first shard
+		* @param state The state (class)
+		*/
+		void	merge(byte state) const;
+
+
+	private:
+		mutable std::vector<std::vector<Reservoir>>	m_vvShards;		// [shard][state]; the first shard holds the merged samples
+		size_t										m_maxSamples;	// = INFINITY;				// for optimisation purposes
+		word										m_nFeatures = 0;// number of features, derived from the first sample
 	};
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "TiledInfer.h"
+#include "GraphExt.h"
+#include "Graph.h"
+#include "Infer.h"
+#include "macroses.h"
+#include <atomic>
+
+namespace DirectGraphicalModels
+{
+	CTiledInfer::CTiledInfer(const kit_factory_t &kitFactory, Size tileSize, int halo, size_t maxWorkers)
+		: m_kitFactory(kitFactory)
+		, m_tileSize(tileSize)
+		, m_halo(halo)
+		, m_maxWorkers(maxWorkers)
+	{
+		DGM_ASSERT_MSG(m_kitFactory, "The graph kit factory is not set");
+		DGM_ASSERT_MSG(m_tileSize.width > 0 && m_tileSize.height > 0, "Wrong tile size %d x %d", m_tileSize.width, m_tileSize.height);
+		DGM_ASSERT_MSG(m_halo >= 0, "Wrong halo width %d", m_halo);
+	}
+
+	void CTiledInfer::infer(Size imageSize, const fill_function_t &fillTile, Mat &solution, Mat &confidence, unsigned int nIt)
+	{
+		std::vector<Rect> vCores, vTiles;
+		getTiles(imageSize, vCores, vTiles);
+
+		solution.create(imageSize, CV_8UC1);
+		confidence.create(imageSize, CV_32FC1);
+
+		const int nTiles = static_cast<int>(vTiles.size());
+#ifdef ENABLE_PDP
+		const int nWorkers = MIN(nTiles, m_maxWorkers ? static_cast<int>(m_maxWorkers) : MAX(1, getNumThreads()));
+#else
+		const int nWorkers = MIN(nTiles, 1);
+#endif
+
+		// Every worker takes the next unprocessed tile
+		std::atomic_int nextTile(0);
+#ifdef ENABLE_PDP
+		parallel_for_(Range(0, nWorkers), [&](const Range &range) {
+#else
+		const Range range(0, nWorkers);
+#endif
+		for (int worker = range.start; worker < range.end; worker++) {
+			std::shared_ptr<CGraphKit> pGraphKit;
+			for (int t = nextTile++; t < nTiles; t = nextTile++) {
+				const Rect &core = vCores[t];
+				const Rect &tile = vTiles[t];
+				if (!pGraphKit) pGraphKit = m_kitFactory();
+
+				pGraphKit->getGraphExt().buildGraph(tile.size());
+				fillTile(*pGraphKit, tile);
+				DGM_ASSERT_MSG(pGraphKit->getGraphExt().getSize() == tile.size(), "The size of the graph (%d x %d) does not correspond to the size of the tile (%d x %d)",
+					pGraphKit->getGraphExt().getSize().width, pGraphKit->getGraphExt().getSize().height, tile.width, tile.height);
+
+				const vec_byte_t	vSolution	= pGraphKit->getInfer().decode(nIt);
+				const vec_float_t	vConfidence = pGraphKit->getInfer().getConfidence();
+				DGM_ASSERT(vSolution.size() == static_cast<size_t>(tile.area()));
+
+				// Only the core is stitched into the result
+				for (int y = core.y; y < core.y + core.height; y++) {
+					byte  *pSolution	= solution.ptr<byte>(y);
+					float *pConfidence	= confidence.ptr<float>(y);
+					const size_t idx	= static_cast<size_t>(y - tile.y) * tile.width - tile.x;
+					for (int x = core.x; x < core.x + core.width; x++) {
+						pSolution[x]	= vSolution[idx + x];
+						pConfidence[x]	= vConfidence[idx + x];
+					} // x
+				} // y
+			} // t
+		} // worker
+#ifdef ENABLE_PDP
+		});
+#endif
+	}
+
+	void CTiledInfer::getTiles(Size imageSize, std::vector<Rect> &vCores, std::vector<Rect> &vTiles) const
+	{
+		const Rect image(Point(0, 0), imageSize);
+		vCores.clear();
+		vTiles.clear();
+		for (int y = 0; y < imageSize.height; y += m_tileSize.height)
+			for (int x = 0; x < imageSize.width; x += m_tileSize.width) {
+				const Rect core = Rect(Point(x, y), m_tileSize) & image;
+				vCores.push_back(core);
+				vTiles.push_back(Rect(core.x - m_halo, core.y - m_halo, core.width + 2 * m_halo, core.height + 2 * m_halo) & image);
+			} // x
+	}
+}
@@ -0,0 +1,106 @@
+// Tiled inference class interface
+// Written in 2021 for Project X
+#pragma once
+
+#include "GraphKit.h"
+
+namespace DirectGraphicalModels
+{
+	// ============================= Tiled Inference Class =============================
+	/**
+	* @ingroup moduleDecode
+	* @brief Tiled inference for the images, which are too large to be represented with one graph
+	* @details This class splits the image into tiles, builds a separate graph for every tile, decodes it and stitches the decoded states
+	* (classes) and their confidences into the result images. Every tile consists of a core and a halo of \a halo pixels around it, which is
+	* clipped at the image borders. Only the results of the core are copied into the result images, while the halo provides the context of the
+	* neighbouring pixels, thus the wider the halo is, the closer the result at the seams between the tiles is to the result of the whole-image graph.
+	*
+	* The tiles are processed in parallel. Every worker thread owns one graph kit, created with the kit factory, and re-uses it for all the tiles it
+	* processes, thus at most \a maxWorkers tiles are kept in memory at once. The graph of every tile is filled by the user-provided function,
+	* which gets the kit and the region of the tile in the image:
+	* @code
+	* CTiledInfer tiledInfer(GraphType::pairwise, nStates, Size(1024, 1024), 64);
+	* tiledInfer.infer(image.size(), [&](CGraphKit &graphKit, const Rect &roi) {
+	*     graphKit.getGraphExt().setGraph(potentials(roi));
+	*     graphKit.getGraphExt().addDefaultEdgesModel(image(roi), 100.0f);
+	* }, solution, confidence, 10);
+	* @endcode
+	* Instead of the whole-image potentials, the fill function may also calculate the potentials of the tile from its features on the fly.
+	*/
+	class CTiledInfer
+	{
+	public:
+		/**
+		* @brief Fill function
+		* @details The function must fill the graph of the kit with the potentials of the region \b roi of the image, \a e.g. using CGraphExt::setGraph()
+		* and CGraphExt::addDefaultEdgesModel(). The graph is already built with CGraphExt::buildGraph() for the size of the region.
+		* > The function is called concurrently from multiple threads (with different kits)
+		*/
+		using fill_function_t = std::function<void(CGraphKit &graphKit, const Rect &roi)>;
+		/// Graph kit factory
+		using kit_factory_t = std::function<std::shared_ptr<CGraphKit>(void)>;
+
+
+	public:
+		/**
+		* @brief Constructor
+		* @param kitFactory The function, creating the graph kit for a worker thread
+		* @param tileSize The size of the core of the tiles
+		* @param halo The width of the halo around the core of the tiles (in pixels)
+		* @param maxWorkers The maximal number of tiles, processed at once. 0 means the number of threads
+		*/
+		DllExport CTiledInfer(const kit_factory_t &kitFactory, Size tileSize = Size(512, 512), int halo = 32, size_t maxWorkers = 0);
+		/**
+		* @brief Constructor
+		* @param graphType Type of the graphical model (Ref. @ref GraphType)
+		* @param nStates The number of States (classes)
+		* @param tileSize The size of the core of the tiles
+		* @param halo The width of the halo around the core of the tiles (in pixels)
+		* @param maxWorkers The maximal number of tiles, processed at once. 0 means the number of threads
+		*/
+		DllExport CTiledInfer(GraphType graphType, byte nStates, Size tileSize = Size(512, 512), int halo = 32, size_t maxWorkers = 0)
+			: CTiledInfer([graphType, nStates]() { return CGraphKit::create(graphType, nStates); }, tileSize, halo, maxWorkers)
+		{}
+		DllExport CTiledInfer(const CTiledInfer&) = delete;
+		DllExport ~CTiledInfer(void) = default;
+
+		DllExport CTiledInfer & operator=(const CTiledInfer&) = delete;
+
+		/**
+		* @brief Approximate decoding of the image
+		* @details For every tile, this function builds the graph, fills it with \b fillTile and calls CInfer::decode() and CInfer::getConfidence()
+		* > This function supports PPL
+		* @param[in] imageSize The size of the image
+		* @param[in] fillTile The fill function
+		* @param[out] solution The decoded states (classes): Mat(size: imageSize; type: CV_8UC1)
+		* @param[out] confidence The confidence of the decoded states: Mat(size: imageSize; type: CV_32FC1)
+		* @param[in] nIt Number of iterations of the inference
+		*/
+		DllExport void	infer(Size imageSize, const fill_function_t &fillTile, Mat &solution, Mat &confidence, unsigned int nIt = 10);
+		/**
+		* @brief Returns the regions of the tiles
+		* @param imageSize The size of the image
+		* @param[out] vCores The regions of the cores of the tiles
+		* @param[out] vTiles The regions of the tiles (the cores with the halo)
+		*/
+		DllExport void	getTiles(Size imageSize, std::vector<Rect> &vCores, std::vector<Rect> &vTiles) const;
+
+		/**
+		* @brief Returns the size of the core of the tiles
+		* @return The size of the core of the tiles
+		*/
+		DllExport Size	getTileSize(void) const { return m_tileSize; }
+		/**
+		* @brief Returns the width of the halo
+		* @return The width of the halo around the core of the tiles (in pixels)
+		*/
+		DllExport int	getHalo(void) const { return m_halo; }
+
+
+	private:
+		kit_factory_t	m_kitFactory;		///< The graph kit factory
+		Size			m_tileSize;			///< The size of the core of the tiles
+		int				m_halo;				///< The width of the halo
+		size_t			m_maxWorkers;		///< The maximal number of tiles, processed at once
+	};
+}
@@ -30,18 +30,25 @@ namespace DirectGraphicalModels
 	{
 		Mat res = calculateEdgePotentials(featureVector1, featureVector2, vParams);
 		if (weight != 1.0f) pow(res, weight, res);
-
-		// Normalization
-		for (byte y = 0; y < m_nStates; y++) {
-			float *pRes = res.ptr<float>(y);
-			float  Sum = 0;
-			for (byte x = 0; x < m_nStates; x++) Sum += pRes[x];
-			if (Sum == 0) continue;
-			for (byte x = 0; x < m_nStates; x++) pRes[x] *= 100 / Sum;
-		} // y
-	
+		normalizePotential(res.ptr<float>());
 		return res;
 	}
+
+	void CTrainEdge::getEdgePotentials(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, float weight, Mat &potentials) const
+	{
+		// Assertions
+		DGM_ASSERT_MSG((featureVectors1.type() == CV_8UC1) && (featureVectors2.type() == CV_8UC1), "Incorrect type of the feature vectors");
+		DGM_ASSERT_MSG(featureVectors1.size() == featureVectors2.size(), "The blocks of feature vectors have different sizes");
+		DGM_ASSERT_MSG(featureVectors1.cols == getNumFeatures(), "The number of features (%d) does not correspond to %d", featureVectors1.cols, getNumFeatures());
+
+		potentials.create(featureVectors1.rows, m_nStates * m_nStates, CV_32FC1);
+		if (featureVectors1.empty()) return;
+
+		calculateEdgePotentialsBatch(featureVectors1, featureVectors2, vParams, potentials);
+		if (weight != 1.0f) pow(potentials, weight, potentials);
+		for (int i = 0; i < potentials.rows; i++)
+			normalizePotential(potentials.ptr<float>(i));
+	}
     
     // returns the matrix filled with ones, except the diagonal values wich are set to <values>
     Mat CTrainEdge::getDefaultEdgePotentials(const vec_float_t &values)
@@ -51,4 +58,27 @@ namespace DirectGraphicalModels
         for (byte s = 0; s < nStates; s++) res.at<float>(s, s) = values[s];
         return res;
     }
+
+	// ------------------------- Protected -------------------------
+	void CTrainEdge::calculateEdgePotentialsBatch(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, Mat &potentials) const
+	{
+		const word nFeatures = getNumFeatures();
+		for (int i = 0; i < featureVectors1.rows; i++) {
+			Mat pot = calculateEdgePotentials(featureVectors1.row(i).reshape(1, nFeatures), featureVectors2.row(i).reshape(1, nFeatures), vParams);
+			if (!pot.isContinuous()) pot = pot.clone();
+			pot.reshape(1, 1).copyTo(potentials.row(i));
+		} // i
+	}
+
+	// ------------------------- Private -------------------------
+	void CTrainEdge::normalizePotential(float *pPot) const
+	{
+		for (byte y = 0; y < m_nStates; y++) {
+			float *pRes = pPot + y * m_nStates;
+			float  Sum = 0;
+			for (byte x = 0; x < m_nStates; x++) Sum += pRes[x];
+			if (Sum == 0) continue;
+			for (byte x = 0; x < m_nStates; x++) pRes[x] *= 100 / Sum;
+		} // y
+	}
 }
@@ -63,6 +63,17 @@ namespace DirectGraphicalModels
 		* @return %Edge potentials on success: Mat(size: nStates x nStates; type: CV_32FC1)
 		*/	
 		DllExport Mat			getEdgePotentials(const Mat &featureVector1, const Mat &featureVector2, const vec_float_t &vParams, float weight = 1.0f) const; 
+		/**
+		* @brief Returns the edge potentials, based on a block of feature vector pairs
+		* @details This function calls calculateEdgePotentialsBatch() function for the whole block, \a e.g. for all the horizontal edges of an image row. 
+		* After that, every resulting edge potential is powered by parameter \b weight and normalized, as in the getEdgePotentials() function above.
+		* @param[in] featureVectors1 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1), corresponding to the first nodes of the edges
+		* @param[in] featureVectors2 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1), corresponding to the second nodes of the edges
+		* @param[in] vParams Array of control parameters. Please refer to the concrete model implementation of the calculateEdgePotentials() function for more details
+		* @param[in] weight The weighting parameter
+		* @param[out] potentials %Edge potentials: Mat(size: nEdges x nStates^2; type: CV_32FC1). Every row holds the nStates x nStates potential matrix of one edge
+		*/
+		DllExport void			getEdgePotentials(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, float weight, Mat &potentials) const;
         /**
          * @brief Returns the data-independent edge potentials
          * @details This function returns matrix with diagonal elements equal to the argument \b val, all the other elements are 1's, what imitates the Potts model.
@@ -95,5 +106,25 @@ namespace DirectGraphicalModels
 		* @returns The edge potential matrix: Mat(size: nStates x nStates; type: CV_32FC1)
 		*/	
 		DllExport virtual Mat	calculateEdgePotentials(const Mat &featureVector1, const Mat &featureVector2, const vec_float_t &vParams) const = 0;
+		/**
+		* @brief Calculates the edge potentials, based on a block of feature vector pairs
+		* @details This function is called by the getEdgePotentials() function, which processes the blocks of edges. The default implementation calls
+		* calculateEdgePotentials() for every edge of the block. The derived classes override this function, when the potentials of many edges
+		* may be calculated at once more efficiently, \a e.g. with the vectorized matrix operations.
+		* @param[in] featureVectors1 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1), corresponding to the first nodes of the edges
+		* @param[in] featureVectors2 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1), corresponding to the second nodes of the edges
+		* @param[in] vParams Array of control parameters. Please refere to the concrete model implementation of the calculateEdgePotentials() function for more details
+		* @param[out] potentials %Edge potentials: Mat(size: nEdges x nStates^2; type: CV_32FC1). Every row holds the nStates x nStates potential matrix of one edge
+		*/
+		DllExport virtual void	calculateEdgePotentialsBatch(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, Mat &potentials) const;
+
+
+	private:
+		/**
+		* @brief Normalizes the edge potential
+		* @details Every row of the potential matrix is scaled to sum to 100
+		* @param[in,out] pPot %Edge potential: nStates x nStates values
+		*/
+		void					normalizePotential(float *pPot) const;
 	};
 }
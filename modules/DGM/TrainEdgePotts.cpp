@@ -9,4 +9,10 @@ namespace DirectGraphicalModels
 		else if (vParams.size() == m_nStates)	return getDefaultEdgePotentials(vParams);
 		else DGM_ASSERT_MSG(false, "Wrong number of parameters: %zu. It must be either %d or %u", vParams.size(), 1, m_nStates);
     }
+
+	void CTrainEdgePotts::calculateEdgePotentialsBatch(const Mat &, const Mat &, const vec_float_t &vParams, Mat &potentials) const
+	{
+		Mat pot = CTrainEdgePotts::calculateEdgePotentials(Mat(), Mat(), vParams);
+		repeat(pot.reshape(1, 1), potentials.rows, 1, potentials);
+	}
 }
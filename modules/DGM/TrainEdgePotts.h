@@ -49,5 +49,14 @@ namespace DirectGraphicalModels
 		* @return The edge potential matrix: Mat(size: nStates x nStates; type: CV_32FC1)
 		*/
 		DllExport virtual Mat	calculateEdgePotentials(const Mat &featureVector1, const Mat &featureVector2, const vec_float_t &vParams) const;
+		/**
+		* @brief Returns the data-independent edge potentials for a block of edges
+		* @details The Potts potential is calculated once and copied to every row of \b potentials
+		* @param featureVectors1 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1). It is not used in the Potts model
+		* @param featureVectors2 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1). It is not used in the Potts model
+		* @param vParams Array of control parameters \f$\vec{\theta}\f$ (Ref. calculateEdgePotentials())
+		* @param potentials %Edge potentials: Mat(size: nEdges x nStates^2; type: CV_32FC1)
+		*/
+		DllExport virtual void	calculateEdgePotentialsBatch(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, Mat &potentials) const;
 	};
 }
@@ -76,4 +76,36 @@ Mat	CTrainEdgePottsCS::calculateEdgePotentials(const Mat &featureVector1, const
 
 	return res;
 }
+
+void CTrainEdgePottsCS::calculateEdgePotentialsBatch(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, Mat &potentials) const
+{
+	DGM_ASSERT_MSG((vParams.size() == 2) || (vParams.size() == m_nStates + 1), "Wrong number of parameters: %zu. It must be either %d or %u", vParams.size(), 2, m_nStates + 1);
+
+	Mat potts = CTrainEdgePotts::calculateEdgePotentials(Mat(), Mat(), vec_float_t(vParams.begin(), vParams.end() - 1));
+	const float l = vParams.back();
+
+	// Squared contrasts of all the edges: d^2 = sum((f1 - f2)^2) / nFeatures
+	Mat dfv, contrast;
+	absdiff(featureVectors1, featureVectors2, dfv);
+	dfv.convertTo(dfv, CV_32FC1);
+	multiply(dfv, dfv, dfv);
+	reduce(dfv, contrast, 1, REDUCE_SUM, CV_32FC1);
+	contrast *= 1.0 / getNumFeatures();
+
+	// Penalties of all the edges
+	Mat penalty;
+	switch (m_penApproach) {
+		case eP_APP_PEN_CHAR:	sqrt(contrast + l * l, penalty);		divide(l, penalty, penalty);			break;
+		case eP_APP_PEN_PM:		divide(l * l, contrast + l * l, penalty);										break;
+		case eP_APP_PEN_EXP:	exp(-l * contrast, penalty);													break;
+	}
+	max(penalty, FLT_EPSILON, penalty);
+
+	repeat(potts.reshape(1, 1), potentials.rows, 1, potentials);
+	for (int i = 0; i < potentials.rows; i++) {
+		float *pPot = potentials.ptr<float>(i);
+		const float p = penalty.at<float>(i, 0);
+		for (byte s = 0; s < m_nStates; s++) pPot[s * (m_nStates + 1)] = MAX(1.0f, pPot[s * (m_nStates + 1)] * p);
+	} // i
+}
 }
\ No newline at end of file
@@ -66,6 +66,16 @@ namespace DirectGraphicalModels
 		* > If \b featureVector1 or \b featureVector2 is empty, the function returns the test-data-independent Potts potential: @ref CTrainEdgePotts::calculateEdgePotentials()
 		*/		
 		DllExport virtual Mat	calculateEdgePotentials(const Mat &featureVector1, const Mat &featureVector2, const vec_float_t &vParams) const;
+		/**
+		* @brief Returns the contrast-sensitive edge potentials for a block of edges
+		* @details The contrasts and the penalties of all the edges of the block are calculated at once with the vectorized matrix operations, 
+		* and the penalized diagonals are written to the rows of \b potentials. The result is equal to the one of calculateEdgePotentials() for every edge.
+		* @param featureVectors1 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1), corresponding to the first nodes of the edges
+		* @param featureVectors2 Block of multi-dimensinal points: Mat(size: nEdges x nFeatures; type: CV_8UC1), corresponding to the second nodes of the edges
+		* @param vParams Array of control parameters \f$\{\vec{\theta},\lambda\} \f$ (Ref. calculateEdgePotentials())
+		* @param potentials %Edge potentials: Mat(size: nEdges x nStates^2; type: CV_32FC1)
+		*/
+		DllExport virtual void	calculateEdgePotentialsBatch(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, Mat &potentials) const;
 
 
 	private:
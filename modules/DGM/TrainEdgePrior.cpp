@@ -52,6 +52,16 @@ Mat	CTrainEdgePrior::calculateEdgePotentials(const Mat &featureVector1, const Ma
 	return res;
 }
 
+void CTrainEdgePrior::calculateEdgePotentialsBatch(const Mat &featureVectors1, const Mat &featureVectors2, const vec_float_t &vParams, Mat &potentials) const
+{
+	CTrainEdgePottsCS::calculateEdgePotentialsBatch(featureVectors1, featureVectors2, vParams, potentials);
+	Mat prior = m_prior.reshape(1, 1);
+	for (int i = 0; i < potentials.rows; i++) {
+		Mat pot = potentials.row(i);
+		multiply(pot, prior, pot);
+	}
+}
+
 inline void CTrainEdgePrior::loadPriorMatrix(void)
 {
 	if (!m_prior.empty()) m_prior.release();
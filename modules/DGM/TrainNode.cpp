@@ -42,13 +42,34 @@ namespace DirectGraphicalModels
 	void CTrainNode::addFeatureVecs(const Mat &featureVectors, const Mat &gt)
 	{
 		DGM_ASSERT_MSG(featureVectors.channels() == getNumFeatures(), "Number of features in the <featureVectors> (%d) does not correspond to the specified (%d)", featureVectors.channels(), getNumFeatures());
-		DGM_VECTORWISE1<CTrainNode, &CTrainNode::addFeatureVec>(*this, featureVectors, gt);
+		DGM_ASSERT(featureVectors.size() == gt.size());
+		DGM_ASSERT(featureVectors.depth() == CV_8U);
+		DGM_ASSERT(gt.type() == CV_8UC1);
+
+		// The whole image is one block of samples, if possible
+		if (featureVectors.isContinuous() && gt.isContinuous())
+			addFeatureVecsBatch(featureVectors.reshape(1, static_cast<int>(featureVectors.total())), gt.reshape(1, static_cast<int>(gt.total())));
+		else
+			for (int y = 0; y < gt.rows; y++)
+				addFeatureVecsBatch(featureVectors.row(y).reshape(1, gt.cols), gt.row(y).reshape(1, gt.cols));
 	}
 
 	void CTrainNode::addFeatureVecs(const vec_mat_t &featureVectors, const Mat &gt)
 	{
 		DGM_ASSERT_MSG(featureVectors.size() == getNumFeatures(), "Number of features in the <featureVectors> (%zu) does not correspond to the specified (%d)", featureVectors.size(), getNumFeatures());
-		DGM_VECTORWISE1<CTrainNode, &CTrainNode::addFeatureVec>(*this, featureVectors, gt);
+		DGM_ASSERT(featureVectors[0].size() == gt.size());
+		DGM_ASSERT(featureVectors[0].depth() == CV_8U);
+		DGM_ASSERT(gt.type() == CV_8UC1);
+
+		// One row of the image is one block of samples: the features are gathered from the channels into the row buffer
+		Mat fv(gt.cols, getNumFeatures(), CV_8UC1);
+		for (int y = 0; y < gt.rows; y++) {
+			for (word f = 0; f < getNumFeatures(); f++) {
+				const byte *pFv = featureVectors[f].ptr<byte>(y);
+				for (int x = 0; x < gt.cols; x++) fv.at<byte>(x, f) = pFv[x];
+			} // f
+			addFeatureVecsBatch(fv, gt.row(y).reshape(1, gt.cols));
+		} // y
 	}
 
 	Mat	CTrainNode::getNodePotentials(const Mat& featureVectors, const Mat& weights, float Z) const
@@ -67,19 +88,12 @@ namespace DirectGraphicalModels
 #else
 		const Range range(0, res.rows);
 #endif
-		Mat pot;
-		Mat vec(getNumFeatures(), 1, CV_8UC1);
-
+		Mat mask(res.cols, m_nStates, CV_8UC1);
 		for (int y =  range.start; y < range.end; y++) {
-			const byte* pFv = featureVectors.ptr<byte>(y);
-			const float* pW = weights.empty() ? NULL : weights.ptr<float>(y);
-			float* pRes = res.ptr<float>(y);
-			for (int x = 0; x < res.cols; x++) {
-				float weight = pW ? pW[x] : 1.0f;
-				for (int f = 0; f < getNumFeatures(); f++) vec.at<byte>(f, 0) = pFv[getNumFeatures() * x + f];
-				pot = getNodePotentials(vec, weight, Z);
-				for (int s = 0; s < m_nStates; s++) pRes[m_nStates * x + s] = pot.at<float>(s, 0);
-			} // x
+			// One row of the image is one block of samples: the matrices below are the headers over the rows
+			const Mat fv	= featureVectors.row(y).reshape(1, res.cols);
+			Mat		  pot	= res.row(y).reshape(1, res.cols);
+			getNodePotentialsBatch(fv, weights.empty() ? NULL : weights.ptr<float>(y), Z, pot, mask);
 		} // y	
 #ifdef ENABLE_PDP
 		});
@@ -103,20 +117,15 @@ namespace DirectGraphicalModels
 #else
 		const Range range(0, res.rows);
 #endif
-		Mat pot;
-		Mat vec(getNumFeatures(), 1, CV_8UC1);
+		Mat fv(res.cols, getNumFeatures(), CV_8UC1);
+		Mat mask(res.cols, m_nStates, CV_8UC1);
 		for (int y = range.start; y < range.end; y++) {
-			const byte  **pFv = new const byte *[getNumFeatures()];
-			for (word f = 0; f < getNumFeatures(); f++) pFv[f] = featureVectors[f].ptr<byte>(y);
-			const float *pW = weights.empty() ? NULL : weights.ptr<float>(y);
-			float		*pRes = res.ptr<float>(y);
-			for (int x = 0; x < res.cols; x++) {
-				float weight = pW ? pW[x] : 1.0f;
-				for (int f = 0; f < getNumFeatures(); f++) vec.at<byte>(f, 0) = pFv[f][x];
-				pot = getNodePotentials(vec, weight, Z);
-				for (int s = 0; s < m_nStates; s++) pRes[m_nStates * x + s] = pot.at<float>(s, 0);
-			} // x
-			delete[] pFv;
+			for (word f = 0; f < getNumFeatures(); f++) {
+				const byte *pFv = featureVectors[f].ptr<byte>(y);
+				for (int x = 0; x < res.cols; x++) fv.at<byte>(x, f) = pFv[x];
+			} // f
+			Mat pot = res.row(y).reshape(1, res.cols);
+			getNodePotentialsBatch(fv, weights.empty() ? NULL : weights.ptr<float>(y), Z, pot, mask);
 		} // y	
 #ifdef ENABLE_PDP
 		});
@@ -136,19 +145,58 @@ namespace DirectGraphicalModels
 		Mat res(m_nStates, 1, CV_32FC1, Scalar(0));
 		const_cast<Mat &>(m_mask).setTo(1);
 		calculateNodePotentials(featureVector, res, const_cast<Mat &>(m_mask));
-		if (weight != 1.0f) pow(res, weight, res);
+		normalizePotential(res.ptr<float>(), m_mask.ptr<byte>(), weight, Z);
 
-		// Normalization
-		float Sum = static_cast<float>(sum(res).val[0]);
+		return res;
+	}
+
+	void CTrainNode::calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const
+	{
+		Mat pot(m_nStates, 1, CV_32FC1);
+		Mat msk(m_nStates, 1, CV_8UC1);
+		for (int i = 0; i < featureVectors.rows; i++) {
+			potentials.row(i).reshape(1, m_nStates).copyTo(pot);
+			mask.row(i).reshape(1, m_nStates).copyTo(msk);
+			calculateNodePotentials(featureVectors.row(i).reshape(1, getNumFeatures()), pot, msk);
+			// The derived classes may re-allocate the potential
+			pot.reshape(1, 1).copyTo(potentials.row(i));
+			msk.reshape(1, 1).copyTo(mask.row(i));
+		} // i
+	}
+
+	void CTrainNode::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+	{
+		Mat featureVector(getNumFeatures(), 1, CV_8UC1);
+		for (int i = 0; i < featureVectors.rows; i++) {
+			memcpy(featureVector.data, featureVectors.ptr<byte>(i), getNumFeatures());
+			addFeatureVec(featureVector, gt.at<byte>(i, 0));
+		} // i
+	}
+
+	// ------------------------- Private -------------------------
+	void CTrainNode::normalizePotential(float *pPot, const byte *pMask, float weight, float Z) const
+	{
+		if (weight != 1.0f) 
+			for (byte s = 0; s < m_nStates; s++) pPot[s] = powf(pPot[s], weight);
+
+		double sum = 0;
+		for (byte s = 0; s < m_nStates; s++) sum += pPot[s];
+		float Sum = static_cast<float>(sum);
 		if (Sum < FLT_EPSILON) {
-			res.setTo(FLT_EPSILON, m_mask);		// Case of too small potentials (make all the cases equaly small probable)
+			// Case of too small potentials (make all the cases equaly small probable)
+			for (byte s = 0; s < m_nStates; s++) if (pMask[s]) pPot[s] = FLT_EPSILON;
 		} else {
-			if (Z > FLT_EPSILON)
-				res *= 100.0 / Z;
-			else 
-				res *= 100.0 / Sum;
+			const double k = Z > FLT_EPSILON ? 100.0 / Z : 100.0 / Sum;
+			for (byte s = 0; s < m_nStates; s++) pPot[s] = static_cast<float>(pPot[s] * k);
 		}
+	}
 
-		return res;
+	void CTrainNode::getNodePotentialsBatch(const Mat &featureVectors, const float *pWeights, float Z, Mat &potentials, Mat &mask) const
+	{
+		potentials.setTo(0);
+		mask.setTo(1);
+		calculateNodePotentialsBatch(featureVectors, potentials, mask);
+		for (int i = 0; i < potentials.rows; i++)
+			normalizePotential(potentials.ptr<float>(i), mask.ptr<byte>(i), pWeights ? pWeights[i] : 1.0f, Z);
 	}
 }
@@ -133,8 +133,48 @@ namespace DirectGraphicalModels
 		* @param[in,out]	mask Relevant %Node potentials: Mat(size: nStates x 1; type: CV_8UC1). This parameter should be preinitialized and set to value 1 (all potentials are relevant).
 		*/		
 		DllExport virtual void calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const = 0;
+		/**
+		* @brief Calculates the node potentials, based on a block of feature vectors
+		* @details This function is called by the getNodePotentials() functions, which process the blocks of feature vectors, \a e.g. images.
+		* The default implementation calls calculateNodePotentials() for every feature vector of the block. The derived classes override 
+		* this function, when the potentials of many samples may be calculated at once more efficiently, \a e.g. with one call of the 
+		* classifier, or with the per-state data prepared only once for the whole block.
+		* @param[in]	featureVectors Block of multi-dimensinal points: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param[in,out]	potentials %Node potentials: Mat(size: nSamples x nStates; type: CV_32FC1). This parameter should be preinitialized and set to value 0.
+		* @param[in,out]	mask Relevant %Node potentials: Mat(size: nSamples x nStates; type: CV_8UC1). This parameter should be preinitialized and set to value 1 (all potentials are relevant).
+		*/
+		DllExport virtual void calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const;
+		/**
+		* @brief Adds a block of new feature vectors
+		* @details This function is called by the addFeatureVecs() functions, which process the blocks of feature vectors, \a e.g. images.
+		* The default implementation calls addFeatureVec() for every feature vector of the block. The derived classes, which accumulate the samples
+		* for training, override this function in order to add the whole block at once with CSamplesAccumulator::addSamples().
+		* @param featureVectors Block of multi-dimensinal points: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param gt Corresponding ground-truth states (classes): Mat(size: nSamples x 1; type: CV_8UC1)
+		*/
+		DllExport virtual void addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt);
 		
 
+	private:
+		/**
+		* @brief Applies the weight and normalizes the node potential
+		* @param[in,out] pPot %Node potential: \a nStates values
+		* @param pMask Relevant %Node potentials: \a nStates values
+		* @param weight The weighting parameter
+		* @param Z The value of partition function
+		*/
+		void	normalizePotential(float *pPot, const byte *pMask, float weight, float Z) const;
+		/**
+		* @brief Calculates and normalizes the node potentials for a block of feature vectors
+		* @param[in] featureVectors Block of multi-dimensinal points: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param[in] pWeights The weighting parameters of the samples; NULL if all the weights are 1
+		* @param Z The value of partition function
+		* @param[out] potentials %Node potentials: Mat(size: nSamples x nStates; type: CV_32FC1)
+		* @param mask Auxilary matrix: Mat(size: nSamples x nStates; type: CV_8UC1)
+		*/
+		void	getNodePotentialsBatch(const Mat &featureVectors, const float *pWeights, float Z, Mat &potentials, Mat &mask) const;
+
+
 	private:
 		Mat	m_mask;
 	};
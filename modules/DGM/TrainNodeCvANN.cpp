@@ -64,6 +64,11 @@ namespace DirectGraphicalModels
 		m_pSamplesAcc->addSample(featureVector, gt);
 	}
 
+	void CTrainNodeCvANN::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+	{
+		m_pSamplesAcc->addSamples(featureVectors, gt);
+	}
+
 	void	CTrainNodeCvANN::train(bool doClean)
 	{
 #ifdef DEBUG_PRINT_INFO
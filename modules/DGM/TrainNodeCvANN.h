@@ -54,7 +54,7 @@ namespace DirectGraphicalModels
 		* @param nFeatures Number of features
 		* @param maxSamples Maximum number of samples to be used in training
 		* > Default value \b 0 means using all the samples.<br>
-		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() function
+		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() or addFeatureVecs() functions
 		*/
 		DllExport CTrainNodeCvANN(byte nStates, word nFeatures, size_t maxSamples);
 		DllExport virtual ~CTrainNodeCvANN(void);
@@ -72,6 +72,7 @@ namespace DirectGraphicalModels
 		DllExport void	saveFile(FILE *pFile) const { }
 		DllExport void	loadFile(FILE *pFile) { }
 		DllExport void  calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const;
+		DllExport void  addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt);
 
 
 	private:
@@ -76,6 +76,11 @@ void CTrainNodeCvGMM::addFeatureVec(const Mat &featureVector, byte gt)
 	m_pSamplesAcc->addSample(featureVector, gt);
 }
 
+void CTrainNodeCvGMM::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+{
+	m_pSamplesAcc->addSamples(featureVectors, gt);
+}
+
 void CTrainNodeCvGMM::train(bool doClean)
 {
 #ifdef DEBUG_PRINT_INFO
@@ -52,7 +52,7 @@ namespace DirectGraphicalModels
 		* @param nFeatures Number of features
 		* @param maxSamples Maximum number of samples to be used in training
 		* > Default value \b 0 means using all the samples.<br>
-		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() function
+		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() or addFeatureVecs() functions
 		* @param nGausses The number of mixture components in the Gaussian Mixture Model per state (class)
 		*/
 		DllExport CTrainNodeCvGMM(byte nStates, word nFeatures, size_t maxSamples, byte nGausses = TRAIN_NODE_CV_GMM_PARAMS_DEFAULT.numGausses);
@@ -71,6 +71,7 @@ namespace DirectGraphicalModels
 		DllExport void	saveFile(FILE *pFile) const { } 
 		DllExport void	loadFile(FILE *pFile) { } 
 		DllExport void  calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const;
+		DllExport void  addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt);
 
 
 	private:
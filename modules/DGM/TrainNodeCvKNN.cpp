@@ -56,6 +56,11 @@ namespace DirectGraphicalModels
 	{
 		m_pSamplesAcc->addSample(featureVector, gt);
 	}
+
+	void CTrainNodeCvKNN::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+	{
+		m_pSamplesAcc->addSamples(featureVectors, gt);
+	}
 	
 	void	CTrainNodeCvKNN::train(bool doClean)
 	{
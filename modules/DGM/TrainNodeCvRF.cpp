@@ -1,5 +1,6 @@
 #include "TrainNodeCvRF.h"
 #include "SamplesAccumulator.h"
+#include "SampleStore.h"
 #include "macroses.h"
 
 namespace DirectGraphicalModels
@@ -62,6 +63,11 @@ void CTrainNodeCvRF::addFeatureVec(const Mat &featureVector, byte gt)
 	m_pSamplesAcc->addSample(featureVector, gt); 
 }
 
+void CTrainNodeCvRF::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+{
+	m_pSamplesAcc->addSamples(featureVectors, gt);
+}
+
 void CTrainNodeCvRF::train(bool doClean)
 {
 #ifdef DEBUG_PRINT_INFO
@@ -81,19 +87,20 @@ void CTrainNodeCvRF::train(bool doClean)
 	} // s
 	samples.convertTo(samples, CV_32FC1);
 
-	// Filling <var_type>
-	Mat var_type(getNumFeatures() + 1, 1, CV_8UC1, Scalar(ml::VAR_NUMERICAL));		// all inputs are numerical
-	var_type.at<byte>(getNumFeatures(), 0) = ml::VAR_CATEGORICAL;
+	trainForest(samples, classes);
+}
 
-	// Training
-	try {
-		m_pRF->train(ml::TrainData::create(samples, ml::ROW_SAMPLE, classes, noArray(), noArray(), noArray(), var_type));
-	} catch (std::exception &e) {
-		printf("EXCEPTION: %s\n", e.what());
-		printf("Try to reduce the maximal depth of the forest or switch to x64.\n");
-		getchar();
-		exit(-1);
-	}
+void CTrainNodeCvRF::train(const CSampleStore &store)
+{
+	DGM_ASSERT_MSG(store.getNumStates() == m_nStates, "The number of states in the store (%d) does not correspond to %d", store.getNumStates(), m_nStates);
+	DGM_ASSERT_MSG(store.getNumFeatures() == getNumFeatures(), "The number of features in the store (%d) does not correspond to %d", store.getNumFeatures(), getNumFeatures());
+
+	Mat samples, classes;
+	store.getSamples(samples, classes, m_pSamplesAcc->getMaxSamples());
+	samples.convertTo(samples, CV_32FC1);
+	classes.convertTo(classes, CV_32FC1);
+
+	trainForest(samples, classes);
 }
 
 Mat	CTrainNodeCvRF::getFeatureImportance(void) const
@@ -122,4 +129,33 @@ void CTrainNodeCvRF::calculateNodePotentials(const Mat &featureVector, Mat &pote
 	//if (sum) potential /= sum;
 }
 
+void CTrainNodeCvRF::calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const
+{
+	Mat fv, res;
+	featureVectors.convertTo(fv, CV_32FC1);
+	m_pRF->predict(fv, res);
+	for (int i = 0; i < fv.rows; i++) {
+		byte s = static_cast<byte>(res.at<float>(i, 0));
+		potentials.at<float>(i, s) = 1.0f;
+	}
+	potentials += 0.1f;
+}
+
+// ------------------------- Private -------------------------
+void CTrainNodeCvRF::trainForest(const Mat &samples, const Mat &classes)
+{
+	// Filling <var_type>
+	Mat var_type(getNumFeatures() + 1, 1, CV_8UC1, Scalar(ml::VAR_NUMERICAL));		// all inputs are numerical
+	var_type.at<byte>(getNumFeatures(), 0) = ml::VAR_CATEGORICAL;
+
+	// Training
+	try {
+		m_pRF->train(ml::TrainData::create(samples, ml::ROW_SAMPLE, classes, noArray(), noArray(), noArray(), var_type));
+	} catch (std::exception &e) {
+		printf("EXCEPTION: %s\n", e.what());
+		printf("Try to reduce the maximal depth of the forest or switch to x64.\n");
+		getchar();
+		exit(-1);
+	}
+}
 }
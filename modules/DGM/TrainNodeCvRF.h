@@ -8,6 +8,7 @@ namespace DirectGraphicalModels
 {
     class RTrees;
 	class CSamplesAccumulator;
+	class CSampleStore;
 
 	/// @brief OpenCV Random Forest parameters
 	typedef struct TrainNodeCvRFParams {
@@ -63,7 +64,7 @@ namespace DirectGraphicalModels
 		* @param nFeatures Number of features
 		* @param maxSamples Maximum number of samples to be used in training. 
 		* > Default value \b 0 means using all the samples.<br>
-		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() function
+		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() or addFeatureVecs() functions
 		*/
 		DllExport CTrainNodeCvRF(byte nStates, word nFeatures, size_t maxSamples);
 		DllExport ~CTrainNodeCvRF(void);
@@ -74,6 +75,13 @@ namespace DirectGraphicalModels
 	
 		DllExport void	addFeatureVec(const Mat &featureVector, byte gt);
 		DllExport void	train(bool doClean = false);
+		/**
+		* @brief Trains the random model on the samples from the on-disk store
+		* @details Up to \a maxSamples random samples of every state are copied from the memory-mapped \b store, bypassing the samples accumulator.
+		* The samples, added via addFeatureVec() or addFeatureVecs() functions, are not used.
+		* @param store The samples store
+		*/
+		DllExport void	train(const CSampleStore &store);
 
 		/**
 		* @brief Returns the feature importance vector
@@ -88,6 +96,8 @@ namespace DirectGraphicalModels
 		DllExport void	saveFile(FILE *pFile) const { }
 		DllExport void	loadFile(FILE *pFile) { }
 		DllExport void	calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const;
+		DllExport void	calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const;
+		DllExport void	addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt);
 
 
 	protected:
@@ -97,6 +107,7 @@ namespace DirectGraphicalModels
 
 	private:
 		void			init(TrainNodeCvRFParams params);	// This function is called by both constructors
+		void			trainForest(const Mat &samples, const Mat &classes);
 		
 
 	private:
@@ -1,5 +1,7 @@
 #include "TrainNodeCvSVM.h"
 #include "SamplesAccumulator.h"
+#include "SampleStore.h"
+#include "macroses.h"
 
 namespace DirectGraphicalModels
 {
@@ -56,6 +58,11 @@ namespace DirectGraphicalModels
 		m_pSamplesAcc->addSample(featureVector, gt);
 	}
 
+	void CTrainNodeCvSVM::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+	{
+		m_pSamplesAcc->addSamples(featureVectors, gt);
+	}
+
 	void	CTrainNodeCvSVM::train(bool doClean)
 	{
 #ifdef DEBUG_PRINT_INFO
@@ -77,6 +84,19 @@ namespace DirectGraphicalModels
 		m_pSVM->train(samples, ml::ROW_SAMPLE, classes);
 	}
 
+	void	CTrainNodeCvSVM::train(const CSampleStore &store)
+	{
+		DGM_ASSERT_MSG(store.getNumStates() == m_nStates, "The number of states in the store (%d) does not correspond to %d", store.getNumStates(), m_nStates);
+		DGM_ASSERT_MSG(store.getNumFeatures() == getNumFeatures(), "The number of features in the store (%d) does not correspond to %d", store.getNumFeatures(), getNumFeatures());
+
+		Mat samples, states;
+		store.getSamples(samples, states, m_pSamplesAcc->getMaxSamples());
+		samples.convertTo(samples, CV_32FC1);
+		states.convertTo(states, CV_32SC1);
+
+		m_pSVM->train(samples, ml::ROW_SAMPLE, states);
+	}
+
 	void CTrainNodeCvSVM::calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const
 	{
 		Mat fv;
@@ -86,4 +106,16 @@ namespace DirectGraphicalModels
 		potential.at<float>(s, 0) = 1.0f;
 		potential += 0.1f;
 	}
+
+	void CTrainNodeCvSVM::calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const
+	{
+		Mat fv, res;
+		featureVectors.convertTo(fv, CV_32FC1);
+		m_pSVM->predict(fv, res);
+		for (int i = 0; i < fv.rows; i++) {
+			byte s = static_cast<byte>(res.at<float>(i, 0));
+			potentials.at<float>(i, s) = 1.0f;
+		}
+		potentials += 0.1f;
+	}
 }
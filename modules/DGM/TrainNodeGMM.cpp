@@ -17,6 +17,7 @@ namespace DirectGraphicalModels
 		for (auto &gaussianMixture : m_vGaussianMixtures)
 			gaussianMixture.reserve(m_params.maxGausses);
 		if (m_params.minSamples < MIN_SAMPLES) m_params.minSamples = MIN_SAMPLES;
+		if (m_params.batchSize) m_pSamplesAcc = std::make_unique<CSamplesAccumulator>(m_nStates, 0);
 	}
 
 	// Constructor
@@ -35,6 +36,7 @@ namespace DirectGraphicalModels
 	{
 		m_vGaussianMixtures.clear();
 		m_minAlpha = 1;
+		if (m_pSamplesAcc) m_pSamplesAcc->reset();
 	}
 
 	namespace {
@@ -68,6 +70,11 @@ namespace DirectGraphicalModels
 		// Assertions
 		DGM_ASSERT_MSG(gt < m_nStates, "The groundtruth value %u is out of range [0; %u)", gt, m_nStates);
 
+		if (m_pSamplesAcc) {												// deferred training
+			m_pSamplesAcc->addSample(featureVector, gt);
+			return;
+		}
+
 		Mat point;
 		featureVector.convertTo(point, CV_64FC1);
 
@@ -112,6 +119,12 @@ namespace DirectGraphicalModels
 		}
 	}
 
+	void CTrainNodeGMM::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+	{
+		if (m_pSamplesAcc)	m_pSamplesAcc->addSamples(featureVectors, gt);		// deferred training
+		else				CTrainNode::addFeatureVecsBatch(featureVectors, gt);
+	}
+
 	namespace {
 		template<typename T>
 		void printMat(const std::string &name, const Mat &m) {
@@ -149,6 +162,23 @@ namespace DirectGraphicalModels
 
 	void CTrainNodeGMM::train(bool)
 	{
+		// approximate the accumulated samples
+		if (m_pSamplesAcc) {
+			m_vGaussianMixtures.resize(m_nStates);
+#ifdef ENABLE_PDP
+			parallel_for_(Range(0, m_nStates), [&](const Range &range) {
+#else
+			const Range range(0, m_nStates);
+#endif
+			for (int s = range.start; s < range.end; s++) {				// state
+				trainGaussianMixture(m_pSamplesAcc->getSamplesContainer(static_cast<byte>(s)), m_vGaussianMixtures[s]);
+				m_pSamplesAcc->release(static_cast<byte>(s));			// the samples are a part of the mixture now
+			} // s
+#ifdef ENABLE_PDP
+			});
+#endif
+		}
+
 		// merge gausses with too small number of samples 
 		for (GaussianMixture &gaussianMixture : m_vGaussianMixtures) {			// state
 			for (auto it = gaussianMixture.begin(); it != gaussianMixture.end(); it++) {
@@ -189,6 +219,211 @@ namespace DirectGraphicalModels
 		printStatus(m_vGaussianMixtures, m_minAlpha);
 	}
 
+	namespace {
+		// Statistics of the samples of a mini-batch, assigned to one Gauss function
+		struct Moments {
+			size_t				nPoints = 0;
+			std::vector<double>	vSum;						// sum of the points; the mean after calculateMoments(): k
+			std::vector<double>	vSigma;						// covariance matrix of the points: k x k
+		};
+
+		// Finds the nearest Gauss function of the frozen mixture for every sample of <X>
+		// The Mahalanobis distance is used for the Gauss functions with <vIsFull> flag, and the scaled Euclidian distance - for all others
+		void findNearestGausses(const Mat &X, const Mat &mu, const Mat &sigmaInv, const vec_byte_t &vIsFull, double eScale, std::vector<int> &vIdx, std::vector<double> &vDist)
+		{
+			const int k			= X.cols;
+			const int nGausses	= static_cast<int>(vIsFull.size());
+#ifdef ENABLE_PDP
+			parallel_for_(Range(0, X.rows), [&](const Range &range) {
+#else
+			const Range range(0, X.rows);
+#endif
+			std::vector<double> vDiff(k);
+			for (int i = range.start; i < range.end; i++) {
+				const double *pX = X.ptr<double>(i);
+				vIdx[i]  = -1;
+				vDist[i] = DBL_MAX;
+				for (int g = 0; g < nGausses; g++) {
+					const double *pMu = mu.ptr<double>(g);
+					for (int x = 0; x < k; x++) vDiff[x] = pX[x] - pMu[x];
+
+					double dist = 0;
+					if (vIsFull[g]) {										// Mahalanobis distance
+						const double *pSigmaInv = sigmaInv.ptr<double>(g);
+						for (int y = 0; y < k; y++) {
+							double p = 0;
+							for (int x = 0; x < k; x++) p += pSigmaInv[y * k + x] * vDiff[x];
+							dist += vDiff[y] * p;
+						} // y
+						dist = sqrt(MAX(0.0, dist));
+					}
+					else {													// (scaled) Euclidian distance
+						for (int x = 0; x < k; x++) dist += vDiff[x] * vDiff[x];
+						dist = eScale * sqrt(dist);
+					}
+					if (dist < vDist[i]) {
+						vDist[i] = dist;
+						vIdx[i]	 = g;
+					}
+				} // g
+			} // i
+#ifdef ENABLE_PDP
+			});
+#endif
+		}
+
+		// Calculates the means and the covariance matrices of the samples of <X>, assigned to every Gauss function with <vIdx>
+		// The sums of the samples in <vMoments> are expected to be filled
+		void calculateMoments(const Mat &X, const std::vector<int> &vIdx, std::vector<Moments> &vMoments)
+		{
+			const int k = X.cols;
+#ifdef ENABLE_PDP
+			parallel_for_(Range(0, static_cast<int>(vMoments.size())), [&](const Range &range) {
+#else
+			const Range range(0, static_cast<int>(vMoments.size()));
+#endif
+			std::vector<double> vDiff(k);
+			for (int g = range.start; g < range.end; g++) {
+				Moments &moments = vMoments[g];
+				moments.vSigma.assign(k * k, 0);
+				if (moments.nPoints == 0) continue;
+				for (double &sum : moments.vSum) sum /= moments.nPoints;		// sum -> mean
+				for (int i = 0; i < X.rows; i++) {
+					if (vIdx[i] != g) continue;
+					const double *pX = X.ptr<double>(i);
+					for (int x = 0; x < k; x++) vDiff[x] = pX[x] - moments.vSum[x];
+					for (int y = 0; y < k; y++)
+						for (int x = y; x < k; x++)
+							moments.vSigma[y * k + x] += vDiff[y] * vDiff[x];
+				} // i
+				for (int y = 0; y < k; y++)
+					for (int x = y; x < k; x++)
+						moments.vSigma[x * k + y] = moments.vSigma[y * k + x] /= moments.nPoints;
+			} // g
+#ifdef ENABLE_PDP
+			});
+#endif
+		}
+	}
+
+	// The samples are assigned to the Gauss functions with the same rules as in addFeatureVec(), but the distances of a whole mini-batch are calculated against 
+	// the mixture, frozen at the beginning of the mini-batch. Only the Gauss functions, created within the mini-batch, are tracked sequentially.
+	void CTrainNodeGMM::trainGaussianMixture(const Mat &samples, GaussianMixture &gaussianMixture) const
+	{
+		if (samples.empty()) return;
+
+		const int		k				= getNumFeatures();
+		const int		batchSize		= static_cast<int>(MIN(m_params.batchSize, static_cast<size_t>(samples.rows)));
+		const bool		isEuclidian		= m_params.dist_Mtreshold != 0;					// the same condition as in getDistance()
+		const double	eScale			= isEuclidian ? 1.0 : m_params.dist_Mtreshold / m_params.dist_Etreshold;
+		const double	dist_treshold	= (m_params.dist_Mtreshold < 0) ? m_params.dist_Etreshold : m_params.dist_Mtreshold;
+
+		DGM_ASSERT_MSG(samples.cols == k, "The number of features (%d) does not correspond to %d", samples.cols, k);
+
+		Mat						X;							// mini-batch: Mat(size: nSamples x k; type: CV_64FC1)
+		Mat						mu;							// means of the frozen mixture: Mat(size: nGausses x k; type: CV_64FC1)
+		Mat						sigmaInv;					// inverse covariance matrices of the frozen mixture: Mat(size: nGausses x k * k; type: CV_64FC1)
+		vec_byte_t				vIsFull;					// flags whether the Mahalanobis distance is used for the Gauss function
+		std::vector<int>		vIdx(batchSize);			// the nearest Gauss function for every sample
+		std::vector<double>		vDist(batchSize);			// the distance to the nearest Gauss function
+		std::vector<Moments>	vMoments;
+
+		for (int b = 0; b < samples.rows; b += batchSize) {
+			const int nSamples = MIN(batchSize, samples.rows - b);
+			const int nGausses = static_cast<int>(gaussianMixture.size());
+			samples.rowRange(b, b + nSamples).convertTo(X, CV_64FC1);
+
+			// Freezing the mixture
+			if (nGausses) {
+				mu.create(nGausses, k, CV_64FC1);
+				sigmaInv.create(nGausses, k * k, CV_64FC1);
+			}
+			vIsFull.assign(nGausses, 0);
+			for (int g = 0; g < nGausses; g++) {
+				const CKDGauss &gauss = gaussianMixture[g];
+				Mat(gauss.getMu().t()).copyTo(mu.row(g));
+				if (!isEuclidian && gauss.getNumPoints() >= m_params.minSamples) {
+					vIsFull[g] = 1;
+					Mat inv;
+					invert(gauss.getSigma(), inv, DECOMP_SVD);
+					inv.reshape(1, 1).copyTo(sigmaInv.row(g));
+				}
+			} // g
+
+			// Distances from the samples to the frozen mixture
+			findNearestGausses(X, mu, sigmaInv, vIsFull, eScale, vIdx, vDist);
+
+			// Assignment of the samples in their order: to the nearest Gauss function or to a new one
+			vMoments.resize(nGausses);
+			for (Moments &moments : vMoments) {
+				moments.nPoints = 0;
+				moments.vSum.assign(k, 0);
+			}
+			for (int i = 0; i < nSamples; i++) {
+				const double *pX = X.ptr<double>(i);
+				int		idx		= vIdx[i];
+				double	minDist = vDist[i];
+
+				// The Gauss functions, created within the mini-batch, are not full
+				for (int g = nGausses; g < static_cast<int>(vMoments.size()); g++) {
+					const Moments &moments = vMoments[g];
+					double dist = 0;
+					for (int x = 0; x < k; x++) {
+						const double diff = pX[x] - moments.vSum[x] / moments.nPoints;
+						dist += diff * diff;
+					}
+					dist = eScale * sqrt(dist);
+					if (dist < minDist) {
+						minDist = dist;
+						idx		= g;
+					}
+				} // g
+
+				if (idx < 0 || ((minDist > dist_treshold) && (vMoments.size() < m_params.maxGausses))) {	// NEW GAUSS
+					idx = static_cast<int>(vMoments.size());
+					vMoments.emplace_back();
+					vMoments.back().vSum.assign(k, 0);
+				}
+				vIdx[i] = idx;
+				Moments &moments = vMoments[idx];
+				moments.nPoints++;
+				for (int x = 0; x < k; x++) moments.vSum[x] += pX[x];
+			} // i
+
+			// Covariances of the assigned samples
+			calculateMoments(X, vIdx, vMoments);
+
+			// Updating the mixture: every Gauss function is merged with the Gaussian of its samples
+			for (int g = 0; g < static_cast<int>(vMoments.size()); g++) {
+				const Moments &moments = vMoments[g];
+				if (moments.nPoints == 0) continue;
+				CKDGauss gauss(k);
+				gauss.setMu(Mat(k, 1, CV_64FC1, const_cast<double *>(moments.vSum.data())));
+				gauss.setSigma(Mat(k, k, CV_64FC1, const_cast<double *>(moments.vSigma.data())));
+				gauss.setNumPoints(static_cast<long>(moments.nPoints));
+				if (g < nGausses)	gaussianMixture[g] += gauss;
+				else				gaussianMixture.push_back(gauss);		// NEW GAUSS
+			} // g
+
+			// Chech the updated Gauss functions if after update they became too close to another Gauss function
+			// The indices of the preceding Gauss functions are not affected by the erasing
+			if (m_params.div_KLtreshold > 0)
+				for (int g = static_cast<int>(vMoments.size()) - 1; g >= 0; g--) {
+					if (vMoments[g].nPoints == 0 || gaussianMixture[g].getNumPoints() < m_params.minSamples) continue;
+					std::vector<double> div = getDivergence(gaussianMixture[g], gaussianMixture, m_params.minSamples);
+					div[g] = DBL_MAX;												// divergence to itself
+
+					// Merge together if they are too close
+					auto it = std::min_element(div.begin(), div.end());
+					if ((it != div.end()) && (*it < m_params.div_KLtreshold)) {
+						size_t idx = std::distance(div.begin(), it);
+						gaussianMixture[idx] += gaussianMixture[g];
+						gaussianMixture.erase(gaussianMixture.begin() + g);
+					}
+				} // g
+		} // b
+	}
+
 	void CTrainNodeGMM::saveFile(FILE *pFile) const
 	{
 		// m_params
@@ -285,4 +520,29 @@ namespace DirectGraphicalModels
 			}
 		} // s
 	}
+
+	void CTrainNodeGMM::calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const
+	{
+		Mat fv, values;
+		featureVectors.convertTo(fv, CV_64FC1);
+
+		for (byte s = 0; s < m_nStates; s++) {						// state
+			const GaussianMixture &gaussianMixture = m_vGaussianMixtures[s];
+
+			if (gaussianMixture.empty())	mask.col(s).setTo(0);
+			else {
+				size_t nAllPoints = 0;									// number of points were used for approximating the density for current state
+				for (const CKDGauss &gauss : gaussianMixture)
+					nAllPoints += gauss.getNumPoints();
+
+				for (const CKDGauss &gauss : gaussianMixture) {
+					double		k = static_cast<double>(gauss.getNumPoints()) / nAllPoints;
+					long double	aK = gauss.getAlpha() / m_minAlpha;		// scaled Gaussian coefficient
+					gauss.getValues(fv, values);
+					for (int i = 0; i < fv.rows; i++)
+						potentials.ptr<float>(i)[s] += static_cast<float>(k * aK * values.at<double>(i, 0));
+				} // gausses
+			}
+		} // s
+	}
 }
@@ -5,6 +5,7 @@
 
 #include "TrainNode.h"
 #include "KDGauss.h"
+#include "SamplesAccumulator.h"
 
 namespace DirectGraphicalModels
 {
@@ -15,9 +16,10 @@ namespace DirectGraphicalModels
 		double	dist_Etreshold;				///< Minimum Euclidean distance between Gauss functions
 		double	dist_Mtreshold;				///< Minimum Mahalanobis distance between Gauss functions. If this parameter is negative, the Euclidean distance is used
 		double	div_KLtreshold;				///< Minimum Kullback-Leiber divergence between Gauss functions. If this parameter is negative, the merging of Gaussians in addFeatureVec() function will be disabled
+		size_t	batchSize;					///< Size of the mini-batches for the deferred training in train() function. If this parameter is 0, the samples are added to the Gauss functions sequentially in addFeatureVec() function
 
 		TrainNodeGMMParams() {}
-		TrainNodeGMMParams(word _maxGausses, size_t _minSamples, double _dist_Etreshold, double _dist_Mtreshold, double _div_KLtreshold) : maxGausses(_maxGausses), minSamples(_minSamples), dist_Etreshold(_dist_Etreshold), dist_Mtreshold(_dist_Mtreshold), div_KLtreshold(_div_KLtreshold) {}
+		TrainNodeGMMParams(word _maxGausses, size_t _minSamples, double _dist_Etreshold, double _dist_Mtreshold, double _div_KLtreshold, size_t _batchSize = 0) : maxGausses(_maxGausses), minSamples(_minSamples), dist_Etreshold(_dist_Etreshold), dist_Mtreshold(_dist_Mtreshold), div_KLtreshold(_div_KLtreshold), batchSize(_batchSize) {}
 	} TrainNodeGMMParams;
 
 	const TrainNodeGMMParams TRAIN_NODE_GMM_PARAMS_DEFAULT = TrainNodeGMMParams(
@@ -25,7 +27,8 @@ namespace DirectGraphicalModels
 		64,		// min_samples
 		64,		// dist_Etreshold
 		-16,	// dist_Mtreshold
-		-16		// div_KLtreshold
+		-16,	// div_KLtreshold
+		0		// batchSize
 	);
 
 	// ==================== Gaussian Mixture Model Train Class =====================
@@ -35,6 +38,12 @@ namespace DirectGraphicalModels
 	* @details This class implements the generative training mechanism, based on the idea of approximating the density of multi-dimensional random variables
 	* with an additive super-position of multivariate Gaussian distributions. The underlying algorithm is described in the paper
 	* <a href="http://www.project-10.de/Kosov/files/GCPR_2013.pdf" target="_blank">Sequential Gaussian Mixture Models for Two-Level Conditional Random Fields</a>
+	*
+	* If the parameter TrainNodeGMMParams::batchSize is set, the training is deferred: the samples are only accumulated in addFeatureVec() and
+	* the mixtures of all states are approximated in parallel in train(). The samples of every state are processed in mini-batches in the order of their addition:
+	* the distances from all the samples of a mini-batch to the Gauss functions are calculated in parallel against the mixture, frozen at the beginning of the mini-batch,
+	* and every Gauss function is updated once per mini-batch. The resulting mixtures are close to the ones of the sequential training, but the inverse
+	* covariance matrices are calculated once per mini-batch instead of once per sample.
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
 	class CTrainNodeGMM : public CTrainNode
@@ -59,6 +68,12 @@ namespace DirectGraphicalModels
 		DllExport void	reset(void);
 
 		DllExport void	addFeatureVec(const Mat &featureVector, byte gt);
+		/**
+		* @brief Trains the random model
+		* @details In the deferred training mode (Ref. TrainNodeGMMParams::batchSize) the accumulated samples are approximated with the mixtures
+		* and released.
+		* > This function supports PPL.
+		*/
 		DllExport void	train(bool doClean = false);
 
 
@@ -75,6 +90,24 @@ namespace DirectGraphicalModels
 		* @param[in,out]	mask Relevant %Node potentials: Mat(size: nStates x 1; type: CV_8UC1). This parameter should be preinitialized and set to value 1 (all potentials are relevant).
 		*/
 		DllExport void calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const;
+		/**
+		* @brief Calculates the node potentials, based on a block of feature vectors
+		* @details The block is converted to CV_64FC1 once, and every Gaussian function is evaluated for the whole block with CKDGauss::getValues()
+		* @param[in]	featureVectors Block of multi-dimensinal points: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param[in,out]	potentials %Node potentials: Mat(size: nSamples x nStates; type: CV_32FC1). This parameter should be preinitialized and set to value 0.
+		* @param[in,out]	mask Relevant %Node potentials: Mat(size: nSamples x nStates; type: CV_8UC1). This parameter should be preinitialized and set to value 1 (all potentials are relevant).
+		*/
+		DllExport void calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const;
+		DllExport void addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt);
+
+
+	private:
+		/**
+		* @brief Approximates the samples with the Gaussian mixture in mini-batches
+		* @param[in] samples The samples of one state: Mat(size: nSamples x nFeatures; type: CV_{XX}C1)
+		* @param[in,out] gaussianMixture The Gaussian mixture of the state
+		*/
+		void							trainGaussianMixture(const Mat &samples, GaussianMixture &gaussianMixture) const;
 
 
 	private:
@@ -86,6 +119,7 @@ namespace DirectGraphicalModels
 		TrainNodeGMMParams				m_params;
 		std::vector<GaussianMixture>	m_vGaussianMixtures;						// block of n-dimensional Gauss function	
 		long double						m_minAlpha = 1;								// auxilary coefficient for scaling gaussian coefficients
+		std::unique_ptr<CSamplesAccumulator> m_pSamplesAcc;							// samples container for the deferred training
 	};
 }
 
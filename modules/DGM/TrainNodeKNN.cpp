@@ -20,26 +20,27 @@ namespace DirectGraphicalModels
 	void CTrainNodeKNN::init(TrainNodeKNNParams params)
 	{
 		m_pSamplesAcc	= std::make_unique<CSamplesAccumulator>(m_nStates, params.maxSamples);
-		m_pTree			= std::make_unique<CKDTree>();
+		if (params.maxChecks)	m_pIndex = std::make_unique<CKDForest>(params.nTrees, params.maxChecks);
+		else					m_pIndex = std::make_unique<CKDTree>();
 		m_params		= params;
 	}
 
 	void CTrainNodeKNN::reset(void)
 	{
 		m_pSamplesAcc->reset();
-		m_pTree->reset();
+		m_pIndex->reset();
 	}
 
 	void CTrainNodeKNN::save(const std::string &path, const std::string &name, short idx) const
 	{
 		std::string fileName = generateFileName(path, name.empty() ? "TrainNodeKNN" : name, idx);
-		m_pTree->save(fileName);
+		m_pIndex->save(fileName);
 	}
 
 	void CTrainNodeKNN::load(const std::string &path, const std::string &name, short idx)
 	{
 		std::string fileName = generateFileName(path, name.empty() ? "TrainNodeKNN" : name, idx);
-		m_pTree->load(fileName);
+		m_pIndex->load(fileName);
 	}
 
 	void CTrainNodeKNN::addFeatureVec(const Mat &featureVector, byte gt)
@@ -47,6 +48,11 @@ namespace DirectGraphicalModels
 		m_pSamplesAcc->addSample(featureVector, gt);
 	}
 
+	void CTrainNodeKNN::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+	{
+		m_pSamplesAcc->addSamples(featureVectors, gt);
+	}
+
 	void CTrainNodeKNN::train(bool doClean)
 	{
 #ifdef DEBUG_PRINT_INFO
@@ -66,25 +72,49 @@ namespace DirectGraphicalModels
 		} // s
 
 		// Training, e.g. building the tree
-		m_pTree->build(samples, classes);
+		m_pIndex->build(samples, classes);
+	}
+
+	void CTrainNodeKNN::train(const CSampleStore &store)
+	{
+		DGM_ASSERT_MSG(store.getNumStates() == m_nStates, "The number of states in the store (%d) does not correspond to %d", store.getNumStates(), m_nStates);
+		DGM_ASSERT_MSG(store.getNumFeatures() == getNumFeatures(), "The number of features in the store (%d) does not correspond to %d", store.getNumFeatures(), getNumFeatures());
+
+		Mat samples, classes;
+		store.getSamples(samples, classes, m_pSamplesAcc->getMaxSamples());
+		m_pIndex->build(samples, classes);
 	}
 
 	void CTrainNodeKNN::calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const
 	{
-		auto nearestNeighbors = m_pTree->findNearestNeighbors(featureVector.t(), m_params.maxNeighbors);
-		//float minr = mathop::Euclidian<byte, float>(featureVector.t(), nearestNeighbors.front()->getKey());
+		vec_size_t nearestNeighbors = m_pIndex->findNearestNeighbors(featureVector.t(), m_params.maxNeighbors);
 
 		size_t n = nearestNeighbors.size();
-		for (auto node : nearestNeighbors) {
-			byte  s = node->getValue();				
-			
-			//float r = mathop::Euclidian<byte, float>(featureVector.t(), node->getKey());			
-			//r = 1 + r - minr;
-			//potential.at<float>(s, 0) += 0.1f / (r * r);
-			
-			potential.at<float>(s, 0) += 1.0f;
-		}
+		for (size_t idx : nearestNeighbors)
+			potential.at<float>(m_pIndex->getValue(idx), 0) += 1.0f;
 		if (n) potential /= static_cast<double>(n);
 		potential += m_params.bias;
 	}
+
+	void CTrainNodeKNN::calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const
+	{
+		if (m_pIndex->empty()) {
+			potentials += m_params.bias;
+			return;
+		}
+
+		Mat indices;
+		m_pIndex->findNearestNeighbors(featureVectors, m_params.maxNeighbors, indices);
+		for (int i = 0; i < featureVectors.rows; i++) {
+			const int *pIdx = indices.ptr<int>(i);
+			float	  *pPot = potentials.ptr<float>(i);
+			size_t n = 0;
+			for (; n < m_params.maxNeighbors && pIdx[n] >= 0; n++)
+				pPot[m_pIndex->getValue(pIdx[n])] += 1.0f;
+			for (byte s = 0; s < m_nStates; s++) {
+				if (n) pPot[s] = static_cast<float>(pPot[s] / static_cast<double>(n));
+				pPot[s] += m_params.bias;
+			} // s
+		} // i
+	}
 }
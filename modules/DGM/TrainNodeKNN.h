@@ -4,7 +4,9 @@
 
 #include "TrainNode.h"
 #include "KDTree.h"
+#include "KDForest.h"
 #include "SamplesAccumulator.h"
+#include "SampleStore.h"
 
 namespace DirectGraphicalModels
 {
@@ -13,15 +15,20 @@ namespace DirectGraphicalModels
 		float	bias;								///< Regularization CRF parameter: bias is added to all potential values
 		size_t	maxNeighbors;						///< Max number of neighbors to be used for calculating potentials
 		size_t 	maxSamples;							///< Maximum number of samples to be used in training. 0 means using all the samples
+		word	nTrees;								///< Number of randomized k-d trees for the approximate search (Ref. @ref CKDForest)
+		size_t	maxChecks;							///< Maximum number of samples to be checked for one feature vector in the approximate search. 0 means using the exact search with @ref CKDTree
 
 		TrainNodeKNNParams() {}
-		TrainNodeKNNParams(float _bias, size_t _maxNeighbors, size_t _maxSamples) : bias(_bias), maxNeighbors(_maxNeighbors), maxSamples(_maxSamples) {}
+		TrainNodeKNNParams(float _bias, size_t _maxNeighbors, size_t _maxSamples, word _nTrees = 4, size_t _maxChecks = 0) 
+			: bias(_bias), maxNeighbors(_maxNeighbors), maxSamples(_maxSamples), nTrees(_nTrees), maxChecks(_maxChecks) {}
 	} TrainNodeKNNParams;
 	
 	const TrainNodeKNNParams TRAIN_NODE_KNN_PARAMS_DEFAULT =	TrainNodeKNNParams(
 																0.1f,	// Regularization CRF parameter: bias is added to all potential values
 																100,	// Max number of neighbors to be used for calculating potentials
-																0		// Maximum number of samples to be used in training. 0 means using all the samples
+																0,		// Maximum number of samples to be used in training. 0 means using all the samples
+																4,		// Number of randomized k-d trees for the approximate search
+																0		// Maximum number of samples to be checked for one feature vector in the approximate search. 0 means using the exact search
 																);
 
 	// ====================== k-Nearest Neighbors Train Class =====================
@@ -31,6 +38,8 @@ namespace DirectGraphicalModels
 	* @details This class implements the <a href="https://en.wikipedia.org/wiki/K-nearest_neighbors_algorithm" target="blank"><i>k</i>-nearest neighbors classifier (<i>k</i>-NN)</a>,
 	* where the input consists of the k closest training samples in the feature space and the output depends on k-Nearest Neighbors. The implementation is based on 
 	* the <a href="https://en.wikipedia.org/wiki/K-d_tree" target="blank"><i>k</i>-d tree</a> data structure: @ref CKDTree.
+	* For large amounts of samples the approximate search with the randomized <i>k</i>-d forest (@ref CKDForest) may be used instead by setting
+	* TrainNodeKNNParams::maxChecks > 0. The index is saved and loaded with its search structure; it must be loaded with the same TrainNodeKNNParams::maxChecks setting (zero or non-zero).
 	* > This trainer is especially effective for low-dimentional feature spaces.
 	* @author Sergey G. Kosov, sergey.kosov@project-10.de
 	*/
@@ -50,7 +59,7 @@ namespace DirectGraphicalModels
 		* @param nFeatures Number of features
 		* @param maxSamples Maximum number of samples to be used in training
 		* > Default value \b 0 means using all the samples.<br>
-		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() function
+		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() or addFeatureVecs() functions
 		*/
 		DllExport CTrainNodeKNN(byte nStates, word nFeatures, size_t maxSamples);
 		DllExport virtual ~CTrainNodeKNN(void) = default;
@@ -61,16 +70,25 @@ namespace DirectGraphicalModels
 
 		DllExport void	addFeatureVec(const Mat &featureVector, byte gt);
 		DllExport void	train(bool doClean = false);
+		/**
+		* @brief Trains the random model on the samples from the on-disk store
+		* @details Up to \a maxSamples random samples of every state are copied from the memory-mapped \b store, bypassing the samples accumulator.
+		* The samples, added via addFeatureVec() or addFeatureVecs() functions, are not used.
+		* @param store The samples store
+		*/
+		DllExport void	train(const CSampleStore &store);
 
 
 	protected:
 		DllExport void	saveFile(FILE *pFile) const {}
 		DllExport void	loadFile(FILE *pFile) {}
 		DllExport void	calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const;
+		DllExport void	calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const;
+		DllExport void	addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt);
 
 
 	protected:
-		std::unique_ptr<CKDTree>				m_pTree;					///< k-D Tree
+		std::unique_ptr<IKNNIndex>				m_pIndex;					///< Nearest neighbors index: k-D tree or randomized k-D forest
 		std::unique_ptr<CSamplesAccumulator>	m_pSamplesAcc;				///< Samples Accumulator
 
 
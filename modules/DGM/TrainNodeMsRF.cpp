@@ -1,4 +1,5 @@
 #include "TrainNodeMsRF.h"
+#include "macroses.h"
 
 #ifdef USE_SHERWOOD
 
@@ -68,6 +69,11 @@ void CTrainNodeMsRF::addFeatureVec(const Mat &featureVector, byte gt)
 	m_pSamplesAcc->addSample(featureVector, gt);
 }
 
+void CTrainNodeMsRF::addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt)
+{
+	m_pSamplesAcc->addSamples(featureVectors, gt);
+}
+
 void CTrainNodeMsRF::train(bool doClean)
 {
 #ifdef DEBUG_PRINT_INFO
@@ -92,18 +98,38 @@ void CTrainNodeMsRF::train(bool doClean)
 		if (doClean) m_pSamplesAcc->release(s);					// releases memory
 	} // s
 
+	trainForest(*pData);
+	delete pData;
+}
+
+void CTrainNodeMsRF::train(const CSampleStore &store)
+{
+	DGM_ASSERT_MSG(store.getNumStates() == m_nStates, "The number of states in the store (%d) does not correspond to %d", store.getNumStates(), m_nStates);
+	DGM_ASSERT_MSG(store.getNumFeatures() == getNumFeatures(), "The number of features in the store (%d) does not correspond to %d", store.getNumFeatures(), getNumFeatures());
+
+	Mat samples, states;
+	store.getSamples(samples, states, m_pSamplesAcc->getMaxSamples());
+
+	// Filling <data>
+	sw::DataPointCollection data;
+	data.m_dimension = getNumFeatures();
+	data.m_vData.assign(samples.ptr<byte>(), samples.ptr<byte>() + samples.total());
+	data.m_vLabels.assign(states.ptr<byte>(), states.ptr<byte>() + states.total());
+
+	trainForest(data);
+}
 
-	// Training
+// ------------------------- Private -------------------------
+void CTrainNodeMsRF::trainForest(const sw::DataPointCollection &data)
+{
 	sw::Random random;
 	sw::ClassificationTrainingContext classificationContext(m_nStates, getNumFeatures());
 #ifdef ENABLE_PDP
 	// Use this function with cautions - it is not verifiied!
-	m_pRF = sw::ParallelForestTrainer<sw::LinearFeatureResponse, sw::HistogramAggregator>::TrainForest(random, *m_pParams, classificationContext, *pData);
+	m_pRF = sw::ParallelForestTrainer<sw::LinearFeatureResponse, sw::HistogramAggregator>::TrainForest(random, *m_pParams, classificationContext, data);
 #else
-	m_pRF = sw::ForestTrainer<sw::LinearFeatureResponse, sw::HistogramAggregator>::TrainForest(random, *m_pParams, classificationContext, *pData);
+	m_pRF = sw::ForestTrainer<sw::LinearFeatureResponse, sw::HistogramAggregator>::TrainForest(random, *m_pParams, classificationContext, data);
 #endif
-
-	delete pData;
 }	
 
 void CTrainNodeMsRF::calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const
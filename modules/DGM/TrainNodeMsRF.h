@@ -4,6 +4,7 @@
 
 #include "TrainNode.h"
 #include "SamplesAccumulator.h"
+#include "SampleStore.h"
 
 //#ifdef USE_SHERWOOD
 
@@ -65,7 +66,7 @@ namespace DirectGraphicalModels
 		* @param nFeatures Number of features
 		* @param maxSamples Maximum number of samples to be used in training.
 		* > Default value \b 0 means using all the samples.<br>
-		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() function		
+		* > If another value is specified, the class for training will use \b maxSamples random samples from the whole amount of samples, added via addFeatureVec() or addFeatureVecs() functions		
 		* @note This implementation of the random forest is not weighted
 		*/
 		DllExport CTrainNodeMsRF(byte nStates, word nFeatures, size_t maxSamples);
@@ -83,16 +84,25 @@ namespace DirectGraphicalModels
 
 		DllExport void	addFeatureVec(const Mat &featureVector, byte gt);
 		DllExport void	train(bool doClean = false);
+		/**
+		* @brief Trains the random model on the samples from the on-disk store
+		* @details Up to \a maxSamples random samples of every state are copied from the memory-mapped \b store, bypassing the samples accumulator.
+		* The samples, added via addFeatureVec() or addFeatureVecs() functions, are not used.
+		* @param store The samples store
+		*/
+		DllExport void	train(const CSampleStore &store);
 
 
 	protected:
 		DllExport void saveFile(FILE *pFile) const { }
 		DllExport void loadFile(FILE *pFile) { }
 		DllExport void calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const;
+		DllExport void addFeatureVecsBatch(const Mat &featureVectors, const Mat &gt);
 
 
 	private:
 		void		  init(TrainNodeMsRFParams params);													// This function is called by both constructors
+		void		  trainForest(const sw::DataPointCollection &data);
 
 
 	private:
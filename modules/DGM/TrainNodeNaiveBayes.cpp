@@ -26,6 +26,7 @@ namespace DirectGraphicalModels
 	{
 		CPriorNode::reset();							// resetting the prior histogram vector
 		if (!m_prior.empty()) m_prior.release();		// resetting the prior
+		m_vLogDensity.clear();							// resetting the lookup tables
 
 		for (auto& pdf : m_vPDF)
 			pdf->reset();
@@ -40,6 +41,7 @@ namespace DirectGraphicalModels
 		DGM_ASSERT_MSG(featureVector.type() == CV_8UC1, "The feature vector has incorrect type");
 		
 		addNodeGroundTruth(gt);
+		m_vLogDensity.clear();
 
 		for (word f = 0; f < getNumFeatures(); f++) {
 			byte feature = featureVector.at<byte>(f, 0);
@@ -56,6 +58,7 @@ namespace DirectGraphicalModels
 	void CTrainNodeBayes::train(bool)
 	{
 		m_prior = getPrior(FLT_MAX);
+		compile();
 	}
 
 	void CTrainNodeBayes::smooth(int nIt)
@@ -64,6 +67,29 @@ namespace DirectGraphicalModels
 			pdf->smooth(nIt);
 		for(auto &pdf: m_vPDF2D)
 			pdf->smooth(nIt);
+		if (!m_prior.empty()) compile();
+	}
+
+	void CTrainNodeBayes::compile(void)
+	{
+		DGM_ASSERT_MSG(!m_prior.empty(), "The prior is not estimated. Call train() first");
+		
+		m_vLogPrior.resize(m_nStates);
+		for (byte s = 0; s < m_nStates; s++)
+			m_vLogPrior[s] = logf(m_prior.at<float>(s, 0));
+
+		m_vEstimated.assign(m_nStates, 1);
+		m_vLogDensity.assign(getNumFeatures() * 256 * m_nStates, 0.0f);
+		for (word f = 0; f < getNumFeatures(); f++)			// feature
+			for (byte s = 0; s < m_nStates; s++) {				// state
+				const ptr_pdf_t &pdf = m_vPDF[f * m_nStates + s];
+				if (!pdf->isEstimated()) {
+					m_vEstimated[s] = 0;
+					continue;
+				}
+				for (int v = 0; v < 256; v++)
+					m_vLogDensity[(f * 256 + v) * m_nStates + s] = logf(static_cast<float>(pdf->getDensity(v)));
+			} // s
 	}
 
 	void CTrainNodeBayes::saveFile(FILE *pFile) const
@@ -85,10 +111,16 @@ namespace DirectGraphicalModels
 			pdf->loadFile(pFile);
 		for (auto &pdf: m_vPDF2D)
 			pdf->loadFile(pFile);
+		compile();
 	} 
 
 	void CTrainNodeBayes::calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const
 	{
+		if (!m_vLogDensity.empty()) {
+			calculateCompiledPotential(featureVector.ptr<byte>(), featureVector.step[0], potential.ptr<float>(), mask.ptr<byte>());
+			return;
+		}
+
 		m_prior.copyTo(potential);
 		for (byte s = 0; s < m_nStates; s++) {				// state
 			float	* pPot	= potential.ptr<float>(s);
@@ -104,4 +136,49 @@ namespace DirectGraphicalModels
 			} // f
 		} // s
 	}
+
+	void CTrainNodeBayes::calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const
+	{
+		if (!m_vLogDensity.empty()) {
+			for (int i = 0; i < featureVectors.rows; i++)
+				calculateCompiledPotential(featureVectors.ptr<byte>(i), 1, potentials.ptr<float>(i), mask.ptr<byte>(i));
+			return;
+		}
+
+		for (byte s = 0; s < m_nStates; s++) {				// state
+			bool isEstimated = true;
+			for (word f = 0; f < getNumFeatures(); f++)
+				if (!m_vPDF[f * m_nStates + s]->isEstimated()) isEstimated = false;
+			if (!isEstimated) {
+				potentials.col(s).setTo(0);
+				mask.col(s).setTo(0);
+				continue;
+			}
+
+			potentials.col(s).setTo(m_prior.at<float>(s, 0));
+			for (word f = 0; f < getNumFeatures(); f++) {		// feature
+				IPDF *pPDF = m_vPDF[f * m_nStates + s].get();
+				for (int i = 0; i < featureVectors.rows; i++) {
+					byte feature = featureVectors.ptr<byte>(i)[f];
+					potentials.ptr<float>(i)[s] *= static_cast<float>(pPDF->getDensity(feature));
+				} // i
+			} // f
+		} // s
+	}
+
+	// ------------------------- Private -------------------------
+	void CTrainNodeBayes::calculateCompiledPotential(const byte *pFv, size_t step, float *pPot, byte *pMask) const
+	{
+		std::copy(m_vLogPrior.begin(), m_vLogPrior.end(), pPot);
+		for (word f = 0; f < getNumFeatures(); f++) {			// feature
+			const float *pLogDensity = m_vLogDensity.data() + (f * 256 + pFv[f * step]) * m_nStates;
+			for (byte s = 0; s < m_nStates; s++) pPot[s] += pLogDensity[s];
+		} // f
+		for (byte s = 0; s < m_nStates; s++)					// state
+			if (m_vEstimated[s]) pPot[s] = MIN(expf(pPot[s]), FLT_MAX);
+			else {
+				pPot[s]  = 0;
+				pMask[s] = 0;
+			}
+	}
 }
@@ -51,6 +51,16 @@ namespace DirectGraphicalModels
 		* @param nIt Number of smooth iterations
 		*/
 		DllExport void			smooth(int nIt = 1);
+		/**
+		* @brief Compiles the PDFs into the lookup tables
+		* @details Since all the features have type CV_8UC1, every PDF is evaluated only in 256 points. This function bakes the logarithm of 
+		* the density of every (feature, state) PDF and the logarithm of the class prior into a dense table. After compilation, the node 
+		* potentials are calculated as a sum of the table entries, followed by one exponent per state, without any calls of the PDFs:
+		* \f[ nodePot_s = \exp\Big(\ln prior_s + \sum_{f\in\mathbb{F}} \ln p_{s,f}(\textbf{f}_f)\Big). \f]
+		* This function is called automatically by train(), smooth() and load(). It should be called explicitly only if the PDFs were modified 
+		* directly, \a e.g. via getPDF(). The tables are invalidated with addFeatureVec() and reset().
+		*/
+		DllExport void			compile(void);
 	
 	protected:
 		DllExport virtual void	saveFile(FILE *pFile) const; 
@@ -68,10 +78,32 @@ namespace DirectGraphicalModels
 		* @param[in,out]	mask Relevant %Node potentials: Mat(size: nStates x 1; type: CV_8UC1). This parameter should be preinitialized and set to value 1 (all potentials are relevant).
 		*/
 		DllExport void calculateNodePotentials(const Mat &featureVector, Mat &potential, Mat &mask) const;
+		/**
+		* @brief Calculates the node potentials, based on a block of feature vectors
+		* @details The densities of every (state, feature) PDF are evaluated for the whole block at once
+		* @param[in]	featureVectors Block of multi-dimensinal points: Mat(size: nSamples x nFeatures; type: CV_8UC1)
+		* @param[in,out]	potentials %Node potentials: Mat(size: nSamples x nStates; type: CV_32FC1). This parameter should be preinitialized and set to value 0.
+		* @param[in,out]	mask Relevant %Node potentials: Mat(size: nSamples x nStates; type: CV_8UC1). This parameter should be preinitialized and set to value 1 (all potentials are relevant).
+		*/
+		DllExport void calculateNodePotentialsBatch(const Mat &featureVectors, Mat &potentials, Mat &mask) const;
+
+
+	private:
+		/**
+		* @brief Calculates the node potential with the compiled lookup tables
+		* @param pFv Pointer to the first feature of the sample
+		* @param step The distance (in bytes) between two consecutive features of the sample
+		* @param[out] pPot %Node potential: \a nStates values
+		* @param[out] pMask Relevant %Node potentials: \a nStates values
+		*/
+		void			calculateCompiledPotential(const byte *pFv, size_t step, float *pPot, byte *pMask) const;
 
 
 	private:
 		std::vector<ptr_pdf_t>	m_vPDF;			///< The 1D PDF for node potentials	 [state][feature]
+		vec_float_t				m_vLogDensity;	///< The compiled logarithms of the 1D PDFs [feature][value][state]; empty if not compiled
+		vec_float_t				m_vLogPrior;	///< The compiled logarithm of the class prior [state]
+		vec_byte_t				m_vEstimated;	///< The compiled flags, indicating that all the PDFs of the state are estimated [state]
 		std::vector<ptr_pdf_t>	m_vPDF2D;		///< The 2D data histogram for node potentials and 2 features[state]
 		Mat						m_prior;		///< The class prior probability vector
 	};
@@ -0,0 +1,181 @@
+// Message passing kernels
+// Written in 2021 for Project X
+#pragma once
+
+#include "types.h"
+#include "opencv2/core/hal/intrin.hpp"
+
+namespace DirectGraphicalModels
+{
+	// ================================ Message Kernels Namespace ==============================
+	/**
+	* @brief Kernels for the message updates of the message passing algorithms
+	* @details The kernels multiply a square matrix \a Q of size \a nStates x \a nStates by a vector \a v, where the sum in the product may be
+	* replaced with the maximum, \a i.e. they compute \f$dst_x = \sum_y Q_{x,y}\cdot v_y\f$ (\a sum-product) or \f$dst_x = \max_y Q_{x,y}\cdot v_y\f$
+	* (\a max-product). The rows of \a Q are traversed contiguously, thus for the message update \f$\vec{dst} = (M\cdot M)^\top\times\vec{v}\f$
+	* the edge potential matrix \a M should be squared and transposed once in advance with prepare().
+	*
+	* For the message passing in the energy (negative log) domain, the \a min-sum kernel \f$dst_x = \min_y (E_{x,y} + v_y)\f$ is provided,
+	* where the energy matrix \a E is prepared from \a M with prepareEnergy().
+	*
+	* The kernels are specialized at compile time for 2, 4, 8, 16 and 32 states, and use the OpenCV universal intrinsics (SSE / AVX2 / NEON,
+	* depending on the target instruction set) when the number of states is a multiple of the SIMD vector width.
+	*/
+	namespace msgkernel {
+		/// @cond
+		namespace impl {
+			// Semirings of the kernels
+			enum class Op { SumProduct, MaxProduct, MinSum };
+
+			// Scalar kernel for N states (N = 0: the number of states is given at run-time)
+			template <Op OP, int N>
+			inline float matVecScalar(const float *Q, const float *v, float *dst, int nStates = N)
+			{
+				const int n = N ? N : nStates;
+				float res = OP == Op::MinSum ? FLT_MAX : 0;
+				for (int x = 0; x < n; x++) {
+					const float *q = Q + x * n;
+					float acc = OP == Op::MinSum ? q[0] + v[0] : q[0] * v[0];
+					for (int y = 1; y < n; y++) {
+						if (OP == Op::MinSum) { const float sum = q[y] + v[y]; if (acc > sum) acc = sum; }
+						else {
+							const float prod = q[y] * v[y];
+							if (OP == Op::MaxProduct) { if (acc < prod) acc = prod; }
+							else acc += prod;
+						}
+					}
+					dst[x] = acc;
+					if (OP == Op::MinSum) { if (res > acc) res = acc; }
+					else res += acc;
+				}
+				return res;
+			}
+
+#if CV_SIMD128
+			template <typename V> inline V load(const float *ptr);
+			template <> inline v_float32x4 load<v_float32x4>(const float *ptr) { return v_load(ptr); }
+#if CV_SIMD256
+			template <> inline v_float32x8 load<v_float32x8>(const float *ptr) { return v256_load(ptr); }
+#endif
+			// SIMD kernel for N states, where N is a multiple of the width of the vector type V
+			template <typename V, Op OP, int N>
+			inline float matVecSIMD(const float *Q, const float *v, float *dst)
+			{
+				constexpr int nLanes = V::nlanes;
+				static_assert(N % nLanes == 0, "The number of states must be a multiple of the SIMD vector width");
+
+				V vv[N / nLanes];
+				for (int i = 0; i < N / nLanes; i++) vv[i] = load<V>(v + i * nLanes);
+
+				float res = OP == Op::MinSum ? FLT_MAX : 0;
+				for (int x = 0; x < N; x++) {
+					const float *q = Q + x * N;
+					if constexpr (OP == Op::MinSum) {
+						V acc = load<V>(q) + vv[0];
+						for (int i = 1; i < N / nLanes; i++) acc = v_min(acc, load<V>(q + i * nLanes) + vv[i]);
+						dst[x] = v_reduce_min(acc);
+						if (res > dst[x]) res = dst[x];
+					}
+					else {
+						V acc = load<V>(q) * vv[0];
+						for (int i = 1; i < N / nLanes; i++) {
+							if (OP == Op::MaxProduct) acc = v_max(acc, load<V>(q + i * nLanes) * vv[i]);
+							else					  acc = v_fma(load<V>(q + i * nLanes), vv[i], acc);
+						}
+						dst[x] = OP == Op::MaxProduct ? v_reduce_max(acc) : v_reduce_sum(acc);
+						res += dst[x];
+					}
+				}
+				return res;
+			}
+#endif
+
+			// Selects the widest SIMD vector type suitable for N states
+			template <Op OP, int N>
+			inline float matVecN(const float *Q, const float *v, float *dst)
+			{
+#if CV_SIMD256
+				if constexpr (N % 8 == 0) return matVecSIMD<v_float32x8, OP, N>(Q, v, dst);
+#endif
+#if CV_SIMD128
+				if constexpr (N % 4 == 0) return matVecSIMD<v_float32x4, OP, N>(Q, v, dst);
+#endif
+				return matVecScalar<OP, N>(Q, v, dst);
+			}
+
+			template <Op OP>
+			inline float dispatch(const float *Q, byte nStates, const float *v, float *dst)
+			{
+				switch (nStates) {
+					case 2:  return matVecN<OP, 2>(Q, v, dst);
+					case 4:  return matVecN<OP, 4>(Q, v, dst);
+					case 8:  return matVecN<OP, 8>(Q, v, dst);
+					case 16: return matVecN<OP, 16>(Q, v, dst);
+					case 32: return matVecN<OP, 32>(Q, v, dst);
+					default: return matVecScalar<OP, 0>(Q, v, dst, nStates);
+				}
+			}
+		}
+		/// @endcond
+
+		/**
+		* @brief Prepares the edge potential matrix for the message kernels
+		* @details Computes \f$Q = (M\cdot M)^\top\f$, where the product is element-wise
+		* @param[in] M Edge potential matrix of size \b nStates x \b nStates (row-major)
+		* @param[in] nStates The number of states
+		* @param[out] Q Resulting matrix of size \b nStates x \b nStates (row-major)
+		*/
+		inline void prepare(const float *M, byte nStates, float *Q)
+		{
+			for (byte y = 0; y < nStates; y++)
+				for (byte x = 0; x < nStates; x++)
+					Q[x * nStates + y] = M[y * nStates + x] * M[y * nStates + x];
+		}
+
+		/**
+		* @brief Prepares the edge potential matrix for the min-sum kernel
+		* @details Computes the energy \f$E = -\log(M\cdot M)^\top\f$, where the product is element-wise. Zero potentials result in a large
+		* finite energy \f$-\log(FLT\_MIN)\f$
+		* @param[in] M Edge potential matrix of size \b nStates x \b nStates (row-major)
+		* @param[in] nStates The number of states
+		* @param[out] E Resulting matrix of size \b nStates x \b nStates (row-major)
+		*/
+		inline void prepareEnergy(const float *M, byte nStates, float *E)
+		{
+			for (byte y = 0; y < nStates; y++)
+				for (byte x = 0; x < nStates; x++)
+					E[x * nStates + y] = -logf(MAX(M[y * nStates + x] * M[y * nStates + x], FLT_MIN));
+		}
+
+		/**
+		* @brief Multiplies matrix by vector
+		* @details Computes \f$dst_x = \sum_y Q_{x,y}\cdot v_y\f$ if \b maxSum is false and \f$dst_x = \max_y Q_{x,y}\cdot v_y\f$ otherwise
+		* > This function is thread-safe
+		* @param[in] Q Square matrix of size \b nStates x \b nStates (row-major)
+		* @param[in] nStates The number of states
+		* @param[in] v Vector of length \b nStates
+		* @param[out] dst Resulting vector of length \b nStates
+		* @param[in] maxSum Flag indicating weather the \a max-product should be computed instead of the \a sum-product
+		* @return The sum of all elements in vector \b dst
+		*/
+		inline float matVec(const float *Q, byte nStates, const float *v, float *dst, bool maxSum = false)
+		{
+			return maxSum ? impl::dispatch<impl::Op::MaxProduct>(Q, nStates, v, dst) : impl::dispatch<impl::Op::SumProduct>(Q, nStates, v, dst);
+		}
+
+		/**
+		* @brief Min-sum product of matrix and vector
+		* @details Computes \f$dst_x = \min_y (E_{x,y} + v_y)\f$
+		* > This function is thread-safe
+		* @param[in] E Square matrix of size \b nStates x \b nStates (row-major)
+		* @param[in] nStates The number of states
+		* @param[in] v Vector of length \b nStates
+		* @param[out] dst Resulting vector of length \b nStates
+		* @return The minimal element of vector \b dst
+		*/
+		inline float minSum(const float *E, byte nStates, const float *v, float *dst)
+		{
+			return impl::dispatch<impl::Op::MinSum>(E, nStates, v, dst);
+		}
+	}
+}
@@ -59,6 +59,64 @@ TEST_F(CTestGraph, CG_pairwise_building)
 	testGraphBuilding(graph, nStates);
 }
 
+TEST_F(CTestGraph, CG_pairwise_csr_building)
+{
+	const byte nStates = static_cast<byte>(random::u(10, 255));
+	CGraphPairwiseCSR graph(nStates);
+	testGraphBuilding(graph, nStates);
+}
+
+void testGraphBulkPotentials(CGraph& graph)
+{
+	const byte nStates = graph.getNumStates();
+	const int  nNodes  = random::u<int>(100, 10000);
+	for (int n = 0; n < nNodes; n++) graph.addNode();
+
+	// Strided potentials: region of interest of a wider buffer
+	Mat buffer = random::U(Size(nStates + 3, nNodes), CV_32FC1, 0.0, 100.0);
+	Mat pots = buffer(Rect(1, 0, nStates, nNodes));
+	graph.setNodes(0, pots);
+
+	Mat test_pots(nNodes, nStates + 2, CV_32FC1, Scalar(-1.0f));
+	graph.getNodes(0, nNodes, test_pots.ptr<float>() + 1, test_pots.step1());
+	for (int n = 0; n < nNodes; n++) {
+		ASSERT_EQ(-1.0f, test_pots.at<float>(n, 0));
+		ASSERT_EQ(-1.0f, test_pots.at<float>(n, nStates + 1));
+		for (byte s = 0; s < nStates; s++)
+			ASSERT_EQ(pots.at<float>(n, s), test_pots.at<float>(n, s + 1));
+	}
+
+	// Decoding from the bulk potentials must choose the state with the maximal potential
+	Mat lossMatrix = CDecode::getDefaultLossMatrix(nStates);
+	vec_byte_t decoding = CDecode::decode(graph);
+	vec_byte_t decodingLoss = CDecode::decode(graph, lossMatrix);
+	ASSERT_EQ(nNodes, decoding.size());
+	for (int n = 0; n < nNodes; n++) {
+		Point extremumLoc;
+		minMaxLoc(pots.row(n), NULL, NULL, NULL, &extremumLoc);
+		ASSERT_EQ(extremumLoc.x, decoding[n]);
+		ASSERT_EQ(extremumLoc.x, decodingLoss[n]);
+	}
+}
+
+TEST_F(CTestGraph, CG_dense_bulk_potentials)
+{
+	CGraphDense graph(static_cast<byte>(random::u(2, 64)));
+	testGraphBulkPotentials(graph);
+}
+
+TEST_F(CTestGraph, CG_pairwise_bulk_potentials)
+{
+	CGraphPairwise graph(static_cast<byte>(random::u(2, 64)));
+	testGraphBulkPotentials(graph);
+}
+
+TEST_F(CTestGraph, CG_pairwise_csr_bulk_potentials)
+{
+	CGraphPairwiseCSR graph(static_cast<byte>(random::u(2, 64)));
+	testGraphBulkPotentials(graph);
+}
+
 
 // ======================================== IGraphPairwise Building ========================================
 void testGraphPairwiseBuilding(IGraphPairwise& graph, byte nStates)
@@ -143,6 +201,19 @@ void testGraphPairwiseBuilding(IGraphPairwise& graph, byte nStates)
 			ASSERT_EQ(sqrtf(pIn[x]), pOut[x]);
 	}
 
+	// Test shared edge potentials
+	size_t potId = graph.addEdgePotential(Mat::ones(nStates, nStates, CV_32FC1) * 3);
+	ASSERT_EQ(1, graph.getNumEdgePotentials());
+	graph.setEdgePotential(n - 3, n - 2, potId);
+	graph.setEdgePotential(n - 2, n - 1, potId);
+	graph.setEdge(n - 3, n - 2, pot_in);
+	graph.getEdge(n - 3, n - 2, pot_out);
+	ASSERT_EQ(pot_in.at<float>(0, 0), pot_out.at<float>(0, 0));
+	graph.getEdge(n - 2, n - 1, pot_out);
+	ASSERT_EQ(3, pot_out.at<float>(0, 0));
+	graph.getEdge(n - 4, n - 3, pot_out);
+	ASSERT_EQ(0, pot_out.at<float>(0, 0));
+
 	// graph.marginalize(const vec_size_t &nodes);
 	// graph.setEdge(size_t srcNode, size_t dstNode, const Mat &pot);
 }
@@ -154,12 +225,123 @@ TEST_F(CTestGraph, IGP_pairwise_building)
 	testGraphPairwiseBuilding(graph, nStates);
 }
 
+TEST_F(CTestGraph, IGP_pairwise_indexed_building)
+{
+	const byte nStates = static_cast<byte>(random::u(10, 255));
+	CGraphPairwise graph(nStates);
+	graph.enableEdgeIndex();
+	testGraphPairwiseBuilding(graph, nStates);
+}
+
+TEST_F(CTestGraph, IGP_pairwise_csr_building)
+{
+	const byte nStates = static_cast<byte>(random::u(10, 255));
+	CGraphPairwiseCSR graph(nStates);
+	testGraphPairwiseBuilding(graph, nStates);
+}
+
 TEST_F(CTestGraph, IGP_weiss_building)
 {
 	const byte nStates = static_cast<byte>(random::u(10, 255));
 	CGraphWeiss graph(nStates);
 	testGraphPairwiseBuilding(graph, nStates);
 }
+
+// ======================================== IGraphPairwise Bulk Edges ========================================
+void testGraphPairwiseBulkEdges(IGraphPairwise &graph)
+{
+	// Build a star graph with arcs
+	const size_t nNodes = random::u<size_t>(100, 1000);
+	for (size_t i = 0; i < nNodes; i++) graph.addNode();
+	vec_size_t srcNodes, dstNodes;
+	for (size_t i = 1; i < nNodes; i++) {
+		srcNodes.push_back(0);	dstNodes.push_back(i);
+		srcNodes.push_back(i);	dstNodes.push_back(0);
+	}
+	graph.addEdges(srcNodes, dstNodes, 1);
+	ASSERT_EQ(2 * (nNodes - 1), graph.getNumEdges());
+
+	vec_size_t vNodes;
+	graph.getChildNodes(0, vNodes);
+	ASSERT_EQ(nNodes - 1, vNodes.size());
+	for (size_t i = 1; i < nNodes; i++) {
+		ASSERT_TRUE(graph.isArcExists(0, i));
+		ASSERT_EQ(1, graph.getEdgeGroup(i, 0));
+		ASSERT_FALSE(graph.isEdgeExists(i, i % (nNodes - 1) + 1));
+	}
+
+	// The edges are indexed in the order of their addition
+	const byte nStates = graph.getNumStates();
+	Mat pots = random::U(Size(nStates * nStates, 2), CV_32FC1, 0.0, 100.0);
+	graph.setEdges(2, 2, pots.ptr<float>());
+	Mat pot;
+	graph.getEdge(0, 2, pot);
+	ASSERT_EQ(pots.at<float>(0, 0), pot.at<float>(0, 0));
+	graph.getEdge(2, 0, pot);
+	ASSERT_EQ(pots.at<float>(1, nStates * nStates - 1), pot.at<float>(nStates - 1, nStates - 1));
+
+	// The removed edge may be added again
+	const size_t n = random::u<size_t>(1, nNodes - 1);
+	graph.removeEdge(0, n);
+	ASSERT_FALSE(graph.isEdgeExists(0, n));
+	ASSERT_TRUE(graph.isEdgeExists(n, 0));
+	graph.addEdge(0, n);
+	ASSERT_TRUE(graph.isEdgeExists(0, n));
+	ASSERT_EQ(0, graph.getEdgeGroup(0, n));
+}
+
+TEST_F(CTestGraph, IGP_pairwise_bulk_edges)
+{
+	CGraphPairwise graph(static_cast<byte>(random::u(2, 64)));
+	testGraphPairwiseBulkEdges(graph);
+}
+
+TEST_F(CTestGraph, IGP_pairwise_indexed_bulk_edges)
+{
+	CGraphPairwise graph(static_cast<byte>(random::u(2, 64)));
+	graph.enableEdgeIndex();
+	testGraphPairwiseBulkEdges(graph);
+}
+
+TEST_F(CTestGraph, IGP_pairwise_indexed_edges)
+{
+	CGraphPairwise pairwiseGraph(static_cast<byte>(random::u(2, 64)));
+	pairwiseGraph.enableEdgeIndex();
+	IGraphPairwise &graph = pairwiseGraph;
+
+	// Single edges, making the index grow several times
+	const size_t nNodes = random::u<size_t>(100, 1000);
+	for (size_t i = 0; i < nNodes; i++) graph.addNode();
+	for (size_t i = 1; i < nNodes; i++) {
+		graph.addEdge(i - 1, i);
+		graph.addEdge(i, i - 1);
+	}
+	ASSERT_EQ(2 * (nNodes - 1), graph.getNumEdges());
+
+	// Removing and re-adding the edges
+	for (size_t i = 1; i < nNodes; i += 2) {
+		graph.removeEdge(i - 1, i);
+		ASSERT_FALSE(graph.isEdgeExists(i - 1, i));
+		ASSERT_TRUE(graph.isEdgeExists(i, i - 1));
+	}
+	for (size_t i = 1; i < nNodes; i += 2) {
+		graph.addEdge(i - 1, i);
+		ASSERT_TRUE(graph.isEdgeExists(i - 1, i));
+	}
+	for (size_t i = 1; i < nNodes; i++) {
+		ASSERT_TRUE(graph.isEdgeExists(i - 1, i));
+		ASSERT_TRUE(graph.isEdgeExists(i, i - 1));
+		vec_size_t vChilds;
+		graph.getChildNodes(i, vChilds);
+		ASSERT_EQ(i + 1 < nNodes ? 2 : 1, vChilds.size());
+	}
+}
+
+TEST_F(CTestGraph, IGP_pairwise_csr_bulk_edges)
+{
+	CGraphPairwiseCSR graph(static_cast<byte>(random::u(2, 64)));
+	testGraphPairwiseBulkEdges(graph);
+}
  
 
 // ======================================== Graph Extensions ========================================
@@ -202,6 +384,59 @@ TEST_F(CTestGraph, CG_dense_extension)
 	testGraphExtension(graphExt, graph);
 }
 
+TEST_F(CTestGraph, CG_dense_potts_lattice)
+{
+	const byte nStates	 = static_cast<byte>(random::u(2, 31));
+	const int  nNodes	 = random::u<int>(100, 10000);
+	const int  nFeatures = random::u<int>(2, 5);
+	Mat features = random::U(Size(nFeatures, nNodes), CV_32FC1, 0.0, 10.0);
+	Mat pots	 = random::U(Size(nStates, nNodes), CV_32FC1, 0.0, 1.0);
+
+	// The blocked lattice must match the reference implementation
+	CEdgeModelPotts modelRef(features, 1.0f, {}, true, false);
+	CEdgeModelPotts modelBlocked(features, 1.0f, {}, true, true);
+	Mat res, resBlocked;
+	modelRef.apply(pots, res);
+	modelBlocked.apply(pots, resBlocked);
+
+	ASSERT_EQ(res.size(), resBlocked.size());
+	for (int n = 0; n < nNodes; n++)
+		for (int s = 0; s < nStates; s++)
+			ASSERT_NEAR(res.at<float>(n, s), resBlocked.at<float>(n, s), 1e-4 * res.at<float>(n, s));
+}
+
+TEST_F(CTestGraph, CG_dense_potts_accumulate)
+{
+	const byte nStates	 = static_cast<byte>(random::u(2, 31));
+	const int  nNodes	 = random::u<int>(100, 10000);
+	const int  nFeatures = random::u<int>(2, 5);
+	const float weight1	 = random::U<float>(0.5f, 2.0f);
+	const float weight2	 = random::U<float>(0.5f, 2.0f);
+	Mat features = random::U(Size(nFeatures, nNodes), CV_32FC1, 0.0, 10.0);
+	Mat pots	 = random::U(Size(nStates, nNodes), CV_32FC1, 0.0, 1.0);
+
+	// Accumulation in the log domain must match the logarithm of apply()
+	CEdgeModelPotts model(features, weight1);
+	Mat res, acc(pots.size(), CV_32FC1, Scalar(0));
+	model.apply(pots, res);
+	log(res, res);
+	model.accumulate(pots, acc);
+	for (int n = 0; n < nNodes; n++)
+		for (int s = 0; s < nStates; s++)
+			ASSERT_NEAR(res.at<float>(n, s), acc.at<float>(n, s), 1e-4 * (1 + fabs(res.at<float>(n, s))));
+
+	// Merged model must match the sum of two separate models
+	CEdgeModelPotts model2(features, weight2);
+	model2.accumulate(pots, acc);
+	Mat accMerged(pots.size(), CV_32FC1, Scalar(0));
+	ASSERT_TRUE(model.merge(features, weight2));
+	ASSERT_FALSE(model.merge(features, weight2, false));
+	model.accumulate(pots, accMerged);
+	for (int n = 0; n < nNodes; n++)
+		for (int s = 0; s < nStates; s++)
+			ASSERT_NEAR(acc.at<float>(n, s), accMerged.at<float>(n, s), 1e-4 * (1 + fabs(acc.at<float>(n, s))));
+}
+
 TEST_F(CTestGraph, CG_pairwise_extension)
 {
 	const byte nStates = static_cast<byte>(random::u(10, 255));
@@ -260,4 +495,188 @@ TEST_F(CTestGraph, CG_pairwise_layered)
 	// fillEdges(const CTrainEdge &edgeTrainer, const CTrainLink* linkTrainer, const vec_mat_t &featureVectors, const vec_float_t &vParams, float edgeWeight = 1.0f, float linkWeight = 1.0f);
 	// defineEdgeGroup(float A, float B, float C, byte group);
 	// setEdges(std::optional<byte> group, const Mat &pot);
+}
+
+// ======================================== CGraphLayeredExt Edges ========================================
+void testGraphLayeredFillEdges(IGraphPairwise &graph)
+{
+	const byte nStates = graph.getNumStates();
+	const word nFeatures = static_cast<word>(random::u(1, 16));
+	const Size graphSize = Size(random::u<int>(2, 50), random::u<int>(2, 50));
+	const vec_float_t vParams = { 10.0f, 0.01f };
+	const float weight = 2.0f;
+
+	CGraphLayeredExt graphExt(graph, 1, GRAPH_EDGES_GRID | GRAPH_EDGES_DIAG);
+	graphExt.buildGraph(graphSize);
+
+	CTrainEdgePottsCS edgeTrainer(nStates, nFeatures);
+	Mat featureVectors = random::U(graphSize, CV_8UC(nFeatures), 0, 256);
+	vec_mat_t vFeatureVectors;
+	split(featureVectors, vFeatureVectors);
+
+	// The potentials of the arc should be equal to the ones set with setArc()
+	auto testArc = [&](int x1, int y1, int x2, int y2) {
+		Mat fv1(nFeatures, 1, CV_8UC1, featureVectors.ptr<byte>(y1) + x1 * nFeatures);
+		Mat fv2(nFeatures, 1, CV_8UC1, featureVectors.ptr<byte>(y2) + x2 * nFeatures);
+		Mat pot, test_pot;
+		sqrt(edgeTrainer.getEdgePotentials(fv1, fv2, vParams, weight), pot);
+		const size_t node1 = y1 * graphSize.width + x1;
+		const size_t node2 = y2 * graphSize.width + x2;
+		graph.getEdge(node1, node2, test_pot);
+		for (byte s1 = 0; s1 < nStates; s1++)
+			for (byte s2 = 0; s2 < nStates; s2++)
+				ASSERT_NEAR(pot.at<float>(s1, s2), test_pot.at<float>(s1, s2), 1e-4 * (1 + pot.at<float>(s1, s2)));
+		graph.getEdge(node2, node1, test_pot);
+		for (byte s1 = 0; s1 < nStates; s1++)
+			for (byte s2 = 0; s2 < nStates; s2++)
+				ASSERT_NEAR(pot.at<float>(s1, s2), test_pot.at<float>(s2, s1), 1e-4 * (1 + pot.at<float>(s1, s2)));
+	};
+	auto testEdges = [&]() {
+		for (int y = 0; y < graphSize.height; y++)
+			for (int x = 0; x < graphSize.width; x++) {
+				if (x > 0) testArc(x, y, x - 1, y);
+				if (y > 0) testArc(x, y, x, y - 1);
+				if (x > 0 && y > 0) testArc(x, y, x - 1, y - 1);
+				if (x < graphSize.width - 1 && y > 0) testArc(x, y, x + 1, y - 1);
+			}
+	};
+
+	graphExt.fillEdges(edgeTrainer, NULL, featureVectors, vParams, weight);
+	testEdges();
+
+	graph.setEdges({}, CTrainEdge::getDefaultEdgePotentials(1.0f, nStates));
+	graphExt.fillEdges(edgeTrainer, NULL, vFeatureVectors, vParams, weight);
+	testEdges();
+}
+
+TEST_F(CTestGraph, CG_pairwise_layered_fill_edges)
+{
+	CGraphPairwise graph(static_cast<byte>(random::u(2, 32)));
+	testGraphLayeredFillEdges(graph);
+}
+
+TEST_F(CTestGraph, CG_pairwise_csr_layered_fill_edges)
+{
+	CGraphPairwiseCSR graph(static_cast<byte>(random::u(2, 32)));
+	testGraphLayeredFillEdges(graph);
+}
+
+TEST_F(CTestGraph, CG_weiss_layered_fill_edges)
+{
+	const byte nStates = static_cast<byte>(random::u(2, 32));
+	CGraphWeiss weissGraph(nStates);
+	IGraphPairwise &graph = weissGraph;
+	testGraphLayeredFillEdges(graph);
+
+	// The default indexed setter enumerates the edges by their source nodes
+	const size_t nEdges = graph.getNumEdges();
+	const size_t size = static_cast<size_t>(nStates) * nStates;
+	const Mat pots = random::U(Size(static_cast<int>(size), static_cast<int>(nEdges)), CV_32FC1, 0.0, 1.0);
+	const size_t start_edge = random::u<size_t>(0, nEdges / 2);
+	graph.setEdges(start_edge, nEdges - start_edge, pots.ptr<float>(static_cast<int>(start_edge)));
+
+	vec_size_t vChilds;
+	Mat pot;
+	size_t e = 0;
+	for (size_t n = 0; n < graph.getNumNodes(); n++) {
+		graph.getChildNodes(n, vChilds);
+		for (size_t child : vChilds) {
+			graph.getEdge(n, child, pot);
+			if (e >= start_edge)
+				for (byte s1 = 0; s1 < nStates; s1++)
+					for (byte s2 = 0; s2 < nStates; s2++)
+						ASSERT_EQ(pots.at<float>(static_cast<int>(e), s1 * nStates + s2), pot.at<float>(s1, s2));
+			e++;
+		}
+	}
+	ASSERT_EQ(nEdges, e);
+}
+
+// ======================================== CGraphLayeredExt Building ========================================
+void testGraphLayeredBuilding(IGraphPairwise &graph, IGraphPairwise &refGraph)
+{
+	const word nLayers = static_cast<word>(random::u(1, 4));
+	const Size graphSize = Size(random::u<int>(1, 50), random::u<int>(1, 50));
+	const byte gType = GRAPH_EDGES_GRID | GRAPH_EDGES_DIAG | GRAPH_EDGES_LINK;
+
+	CGraphLayeredExt graphExt(graph, nLayers, gType);
+	graphExt.buildGraph(graphSize);
+
+	// The reference graph is built edge by edge
+	for (int y = 0; y < graphSize.height; y++)
+		for (int x = 0; x < graphSize.width; x++) {
+			size_t idx = refGraph.addNode();
+			for (word l = 1; l < nLayers; l++) refGraph.addNode();
+			if (nLayers >= 2) refGraph.addArc(idx, idx + 1, 1, Mat());
+			for (word l = 2; l < nLayers; l++) refGraph.addEdge(idx + l - 1, idx + l, 1, Mat());
+			for (word l = 0; l < nLayers; l++) {
+				if (x > 0) refGraph.addArc(idx + l, idx + l - nLayers);
+				if (y > 0) refGraph.addArc(idx + l, idx + l - nLayers * graphSize.width);
+				if (x > 0 && y > 0) refGraph.addArc(idx + l, idx + l - nLayers * (graphSize.width + 1));
+				if (x < graphSize.width - 1 && y > 0) refGraph.addArc(idx + l, idx + l - nLayers * (graphSize.width - 1));
+			}
+		}
+	
+	auto testStructure = [&]() {
+		ASSERT_EQ(refGraph.getNumNodes(), graph.getNumNodes());
+		ASSERT_EQ(refGraph.getNumEdges(), graph.getNumEdges());
+		vec_size_t vChilds, vRefChilds;
+		for (size_t n = 0; n < graph.getNumNodes(); n++) {
+			graph.getChildNodes(n, vChilds);
+			refGraph.getChildNodes(n, vRefChilds);
+			std::sort(vChilds.begin(), vChilds.end());
+			std::sort(vRefChilds.begin(), vRefChilds.end());
+			ASSERT_EQ(vRefChilds, vChilds);
+			for (size_t c : vChilds)
+				ASSERT_EQ(refGraph.getEdgeGroup(n, c), graph.getEdgeGroup(n, c));
+		}
+	};
+	testStructure();
+
+	// The graph of the same size is re-used with the reset potentials
+	graphExt.enableGraphReuse();
+	const size_t node = random::u<size_t>(0, graph.getNumNodes() - 1);
+	Mat pot = random::U(Size(1, graph.getNumStates()), CV_32FC1, 1.0, 100.0);
+	Mat test_pot;
+	graph.setNode(node, pot);
+	graph.setEdges(std::nullopt, random::U(Size(graph.getNumStates(), graph.getNumStates()), CV_32FC1, 2.0, 100.0));
+	graphExt.buildGraph(graphSize);
+	testStructure();
+	graph.getNode(node, test_pot);
+	for (byte s = 0; s < graph.getNumStates(); s++)
+		ASSERT_EQ(0.0f, test_pot.at<float>(s, 0));
+	vec_size_t vChilds;
+	graph.getChildNodes(node, vChilds);
+	for (size_t c : vChilds) {
+		graph.getEdge(node, c, test_pot);
+		for (byte s1 = 0; s1 < graph.getNumStates(); s1++)
+			for (byte s2 = 0; s2 < graph.getNumStates(); s2++)
+				ASSERT_EQ(1.0f, test_pot.at<float>(s1, s2));
+	}
+
+	// Without the reuse the graph is always rebuilt
+	graphExt.enableGraphReuse(false);
+	graphExt.buildGraph(graphSize);
+	testStructure();
+
+	// The changed groups are restored
+	graphExt.defineEdgeGroup(1.0f, 0.0f, -0.5f * graphSize.width, 2);
+	graphExt.buildGraph(graphSize);
+	testStructure();
+}
+
+TEST_F(CTestGraph, CG_pairwise_layered_building)
+{
+	const byte nStates = static_cast<byte>(random::u(2, 32));
+	CGraphPairwise graph(nStates);
+	CGraphPairwise refGraph(nStates);
+	testGraphLayeredBuilding(graph, refGraph);
+}
+
+TEST_F(CTestGraph, CG_pairwise_csr_layered_building)
+{
+	const byte nStates = static_cast<byte>(random::u(2, 32));
+	CGraphPairwiseCSR graph(nStates);
+	CGraphPairwise refGraph(nStates);
+	testGraphLayeredBuilding(graph, refGraph);
 }
\ No newline at end of file
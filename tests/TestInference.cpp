@@ -90,6 +90,296 @@ TEST_F(CTestInference, inference_LBP)
 	testInferer(inferer);
 }
 
+TEST_F(CTestInference, inference_LBP_csr)
+{
+	CGraphPairwiseCSR graph(m_nStates);
+	buildGraph(graph, m_nNodes);
+	fillGraph(graph);
+
+	CInferLBP inferer(graph);
+	testInferer(inferer);
+}
+
+TEST_F(CTestInference, inference_LBP_grid)
+{
+	CGraphPairwise graph(m_nStates);
+	CGraphPairwiseExt graphExt(graph);
+	graphExt.buildGraph(Size(m_nNodes, 1));
+	fillGraph(graph);
+
+	CInferLBPGrid inferer(graph, graphExt);
+	testInferer(inferer);
+
+	// Comparing with the generic LBP on a 2D grid with diagonal edges
+	const Size size(random::u(10, 50), random::u(10, 50));
+	const Mat pots = random::U(size, CV_32FC(m_nStates), 0.1, 1.0);
+	CGraphPairwise graph1(m_nStates), graph2(m_nStates);
+	CGraphPairwiseExt graphExt1(graph1, GRAPH_EDGES_GRID | GRAPH_EDGES_DIAG), graphExt2(graph2, GRAPH_EDGES_GRID | GRAPH_EDGES_DIAG);
+	for (CGraphPairwiseExt *pGraphExt : { &graphExt1, &graphExt2 }) {
+		pGraphExt->setGraph(pots);
+		pGraphExt->addDefaultEdgesModel(1.5f);
+	}
+
+	CInferLBP		inferer1(graph1);
+	CInferLBPGrid	inferer2(graph2, graphExt2);
+	inferer1.infer(10);
+	inferer2.infer(10);
+	for (byte s = 0; s < m_nStates; s++) {
+		vec_float_t pot1 = inferer1.getPotentials(s);
+		vec_float_t pot2 = inferer2.getPotentials(s);
+		ASSERT_EQ(pot1.size(), pot2.size());
+		for (size_t i = 0; i < pot1.size(); i++)
+			ASSERT_LT(fabs(pot1[i] - pot2[i]), 1e-4);
+	}
+}
+
+TEST_F(CTestInference, inference_pyramid)
+{
+	CGraphPairwise graph(m_nStates);
+	CGraphPairwiseExt graphExt(graph);
+	graphExt.buildGraph(Size(m_nNodes, 1));
+	fillGraph(graph);
+
+	CInferPyramid inferer(graph, graphExt, 1, [](IGraphPairwise &graph) { return std::make_unique<CInferLBP>(graph); });
+	testInferer(inferer);
+
+	// Warm start with the converged messages
+	const Size size(random::u(10, 50), random::u(10, 50));
+	const Mat pots = random::U(size, CV_32FC(m_nStates), 0.1, 1.0);
+	CGraphPairwise graph1(m_nStates), graph2(m_nStates);
+	CGraphPairwiseExt graphExt1(graph1, GRAPH_EDGES_GRID | GRAPH_EDGES_DIAG), graphExt2(graph2, GRAPH_EDGES_GRID | GRAPH_EDGES_DIAG);
+	for (CGraphPairwiseExt *pGraphExt : { &graphExt1, &graphExt2 }) {
+		pGraphExt->setGraph(pots);
+		pGraphExt->addDefaultEdgesModel(1.5f);
+	}
+
+	CInferLBP inferer1(graph1);
+	inferer1.setConvergenceTolerance(1e-6f);
+	inferer1.keepMessages();
+	inferer1.infer(1000);
+	ASSERT_EQ(graph1.getNumEdges() * m_nStates, inferer1.getMessages().size());
+	const unsigned int nItCold = inferer1.getNumIterations();
+
+	graphExt1.setGraph(pots);
+	inferer1.setInitialMessages(inferer1.getMessages());
+	inferer1.infer(1000);
+	ASSERT_LE(inferer1.getNumIterations(), 2);
+
+	// The coarse-to-fine inference converges to the same beliefs with fewer iterations on the original graph than the cold-started one
+	CInferPyramid inferer2(graph2, graphExt2, 1, [](IGraphPairwise &graph) { return std::make_unique<CInferLBP>(graph); });
+	inferer2.setConvergenceTolerance(1e-6f);
+	inferer2.infer(1000);
+	ASSERT_LT(inferer2.getNumIterations(), nItCold);
+	for (byte s = 0; s < m_nStates; s++) {
+		vec_float_t pot1 = inferer1.getPotentials(s);
+		vec_float_t pot2 = inferer2.getPotentials(s);
+		ASSERT_EQ(pot1.size(), pot2.size());
+		for (size_t i = 0; i < pot1.size(); i++)
+			ASSERT_LT(fabs(pot1[i] - pot2[i]), 1e-3);
+	}
+
+	// Coarse-to-fine TRW
+	CGraphPairwise graph3(m_nStates);
+	CGraphPairwiseExt graphExt3(graph3);
+	graphExt3.setGraph(pots);
+	graphExt3.addDefaultEdgesModel(1.5f);
+	CInferPyramid inferer3(graph3, graphExt3, 1, [](IGraphPairwise &graph) { return std::make_unique<CInferTRW>(graph); }, 4, 5);
+	vec_byte_t vDecoding = inferer3.decode(10);
+	ASSERT_EQ(static_cast<size_t>(size.area()), vDecoding.size());
+	for (byte state : vDecoding) ASSERT_LT(state, m_nStates);
+}
+
+TEST_F(CTestInference, inference_RBP)
+{
+	CGraphPairwise graph(m_nStates);
+	buildGraph(graph, m_nNodes);
+	fillGraph(graph);
+
+	CInferRBP inferer(graph, 1e-7f);
+	testInferer(inferer);
+	ASSERT_GT(inferer.getNumUpdates(), 0);
+	ASSERT_LE(inferer.getNumUpdates(), 100 * graph.getNumEdges());
+}
+
+TEST_F(CTestInference, inference_TRW)
+{
+	CGraphPairwise graph(m_nStates);
+	buildGraph(graph, m_nNodes);
+	fillGraph(graph);
+
+	// TRW-S finds the exact MAP configuration on a chain
+	CDecodeExact decoder(graph);
+	vec_byte_t vExact = decoder.decode();
+
+	CInferTRW inferer(graph);
+	vec_byte_t vTRW = inferer.decode(10);
+
+	ASSERT_EQ(vTRW, vExact);
+}
+
+TEST_F(CTestInference, inference_MinSum)
+{
+	CGraphPairwise graph(m_nStates);
+	buildGraph(graph, m_nNodes);
+	fillGraph(graph);
+
+	// Max-marginals of the probability domain
+	CInferViterbi viterbi(graph);
+	viterbi.infer(100);
+	vec_float_t vPotViterbi = viterbi.getPotentials(0);
+
+	auto test = [&](CInfer &inferer, float tolerance) {
+		inferer.infer(100);
+		vec_float_t pot = inferer.getPotentials(0);
+		ASSERT_EQ(pot.size(), vPotViterbi.size());
+		for (size_t i = 0; i < pot.size(); i++)
+			ASSERT_LT(fabs(pot[i] - vPotViterbi[i]), tolerance);
+	};
+
+	CInferMinSum minSum(graph);
+	test(minSum, 1e-4f);
+	
+	CInferMinSum minSumHalf(graph, true);
+	test(minSumHalf, 1e-2f);
+
+	// On a chain the TRW weights are 1, thus TRW-S results in the exact max-marginals
+	CInferMinSumTRW minSumTRW(graph);
+	test(minSumTRW, 1e-4f);
+
+	// Star graph with a high degree: the probability domain beliefs of the center would underflow
+	const size_t nLeaves = 1000;
+	buildGraph(graph, 1);
+	for (size_t i = 0; i < nLeaves; i++) graph.addArc(0, graph.addNode());
+	fillGraph(graph);
+	minSum.infer(10);
+	for (float pot : minSum.getPotentials(0)) ASSERT_FALSE(std::isnan(pot));
+}
+
+TEST_F(CTestInference, inference_GraphCut)
+{
+	CGraphPairwise graph(m_nStates);
+	buildGraph(graph, m_nNodes);
+	fillGraph(graph);
+
+	// The binary submodular energy is minimized exactly with one cut
+	CDecodeExact decoder(graph);
+	vec_byte_t vExact = decoder.decode();
+
+	CInferGraphCut expansion(graph);
+	ASSERT_EQ(expansion.decode(10), vExact);
+	fillGraph(graph);
+	CInferGraphCut swap(graph, true);
+	ASSERT_EQ(swap.decode(10), vExact);
+
+	// For the Potts model the energy found with the expansion moves is within the factor 2 of the minimal energy
+	const byte	nStates = 3;
+	const int	width	= 3;
+	const int	height	= 3;
+	CGraphPairwise potts(nStates);
+	vec_mat_t vNodePot(width * height);
+	Mat edgePot(nStates, nStates, CV_32FC1);
+	for (Mat &nodePot : vNodePot) {
+		nodePot = random::U(Size(1, nStates), CV_32FC1, 0.1, 1.0);
+		potts.addNode(nodePot);
+	}
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) {
+			edgePot.setTo(random::U<float>(0.1f, 0.9f));
+			for (byte s = 0; s < nStates; s++) edgePot.at<float>(s, s) = 1.0f;
+			if (x > 0) potts.addArc(y * width + x, y * width + x - 1, edgePot);
+			if (y > 0) potts.addArc(y * width + x, (y - 1) * width + x, edgePot);
+		}
+
+	CDecodeExact	pottsDecoder(potts);
+	CInferGraphCut	pottsExpansion(potts);
+	const double minEnergy = pottsExpansion.getEnergy(pottsDecoder.decode());
+	vec_byte_t vGraphCut = pottsExpansion.decode(10);
+	ASSERT_LE(pottsExpansion.getNumIterations(), 10);
+	for (size_t n = 0; n < vNodePot.size(); n++) potts.setNode(n, vNodePot[n]);	// decode() replaces the node potentials
+	const double energy = pottsExpansion.getEnergy(vGraphCut);
+	ASSERT_GE(energy, minEnergy - 1e-4);
+	ASSERT_LE(energy, 2 * minEnergy + 1e-4);
+}
+
+TEST_F(CTestInference, inference_convergence)
+{
+	CGraphPairwise graph(m_nStates);
+	buildGraph(graph, m_nNodes);
+	fillGraph(graph);
+
+	// On a chain the messages become exact after a number of iterations equal to the length of the chain
+	CInferLBP inferer(graph);
+	inferer.setConvergenceTolerance(1e-7f);
+	testInferer(inferer);
+	ASSERT_GT(inferer.getNumIterations(), 0);
+	ASSERT_LE(inferer.getNumIterations(), m_nNodes + 1);
+
+	inferer.setConvergenceTolerance(std::nullopt);
+	testInferer(inferer);
+	ASSERT_EQ(inferer.getNumIterations(), 100);
+}
+
+TEST_F(CTestInference, inference_exact_loopy)
+{
+	// Exhaustive search for the validation
+	class CDecodeExhaustive : public CDecodeExact {
+	public:
+		CDecodeExhaustive(IGraphPairwise &graph) : CDecodeExact(graph) {}
+		using CDecodeExact::calculatePotentials;
+		using CDecodeExact::setState;
+	};
+
+	const byte	nStates = 3;
+	const int	width	= 3;
+	const int	height	= 3;
+	CGraphPairwise graph(nStates);
+	for (int n = 0; n < width * height; n++) graph.addNode(random::U(Size(1, nStates), CV_32FC1, 0.1, 1.0));
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) {
+			if (x > 0) graph.addArc(y * width + x, y * width + x - 1, random::U(Size(nStates, nStates), CV_32FC1, 0.1, 1.0));
+			if (y > 0) graph.addArc(y * width + x, (y - 1) * width + x, random::U(Size(nStates, nStates), CV_32FC1, 0.1, 1.0));
+		}
+
+	CDecodeExhaustive exhaustive(graph);
+	vec_float_t P = exhaustive.calculatePotentials();
+	vec_byte_t	state(width * height);
+	exhaustive.setState(state, std::max_element(P.begin(), P.end()) - P.begin());
+	
+	CDecodeExact decoder(graph);
+	ASSERT_EQ(decoder.decode(), state);
+
+	// Marginals
+	Mat marginals(width * height, nStates, CV_32FC1, Scalar(0));
+	float Z = 0;
+	for (size_t c = 0; c < P.size(); c++) {
+		exhaustive.setState(state, c);
+		for (int n = 0; n < width * height; n++) marginals.at<float>(n, state[n]) += P[c];
+		Z += P[c];
+	}
+	
+	CInferExact inferer(graph);
+	inferer.infer();
+	for (byte s = 0; s < nStates; s++) {
+		vec_float_t pot = inferer.getPotentials(s);
+		for (int n = 0; n < width * height; n++)
+			ASSERT_NEAR(pot[n], marginals.at<float>(n, s) / Z, 1e-4);
+	}
+
+	// A chain, too long for the exhaustive search
+	CGraphPairwise chainGraph(m_nStates);
+	buildGraph(chainGraph, 200);
+	fillGraph(chainGraph);
+	CInferChain chain(chainGraph);
+	chain.infer();
+	vec_float_t vPotChain = chain.getPotentials(0);
+	fillGraph(chainGraph);
+	CInferExact chainExact(chainGraph);
+	chainExact.infer();
+	vec_float_t vPotExact = chainExact.getPotentials(0);
+	for (size_t n = 0; n < vPotChain.size(); n++)
+		ASSERT_NEAR(vPotExact[n], vPotChain[n], 1e-5);
+}
+
 TEST_F(CTestInference, inference_exact_weiss)
 {
 	CGraphWeiss graph(m_nStates);
@@ -99,3 +389,85 @@ TEST_F(CTestInference, inference_exact_weiss)
 	CInferExact inferer(graph);
 	testInferer(inferer);
 }
+
+TEST_F(CTestInference, inference_tiled)
+{
+	const byte	nStates		= 3;
+	const Size	imageSize(random::u(20, 60), random::u(20, 60));
+	const Mat	pots		= random::U(imageSize, CV_32FC(nStates), 0.1, 1.0);
+	float		smoothness	= 1.5f;
+	auto fillTile = [&](CGraphKit &graphKit, const Rect &roi) {
+		graphKit.getGraphExt().setGraph(pots(roi));
+		graphKit.getGraphExt().addDefaultEdgesModel(smoothness);
+	};
+
+	// The whole image graph
+	CGraphPairwiseKit graphKit(nStates);
+	fillTile(graphKit, Rect(Point(0, 0), imageSize));
+	vec_byte_t	vSolution	= graphKit.getInfer().decode(10);
+	vec_float_t	vConfidence	= graphKit.getInfer().getConfidence();
+
+	// With the halo, covering the whole image, every tile is decoded as the whole image
+	Mat solution, confidence;
+	CTiledInfer tiledInfer(GraphType::pairwise, nStates, Size(random::u(5, 15), random::u(5, 15)), MAX(imageSize.width, imageSize.height));
+	tiledInfer.infer(imageSize, fillTile, solution, confidence, 10);
+	ASSERT_EQ(imageSize, solution.size());
+	for (int y = 0; y < imageSize.height; y++)
+		for (int x = 0; x < imageSize.width; x++) {
+			ASSERT_EQ(vSolution[y * imageSize.width + x], solution.at<byte>(y, x));
+			ASSERT_NEAR(vConfidence[y * imageSize.width + x], confidence.at<float>(y, x), 1e-5);
+		}
+
+	// After nIt iterations of LBP the belief of a node depends only on the nodes within nIt + 1 edges from it. Thus the pixels, which are
+	// at least margin = nIt + 1 pixels away from the cut sides of their tile, are decoded as in the whole image, while the pixels closer
+	// to the seams may differ
+	auto testSeams = [&](CTiledInfer &tiledInfer, unsigned int nIt, size_t &nChecked) {
+		graphKit.getGraphExt().setGraph(pots);
+		graphKit.getGraphExt().addDefaultEdgesModel(smoothness);
+		vSolution = graphKit.getInfer().decode(nIt);
+		vConfidence = graphKit.getInfer().getConfidence();
+		tiledInfer.infer(imageSize, fillTile, solution, confidence, nIt);
+
+		std::vector<Rect> vCores, vTiles;
+		tiledInfer.getTiles(imageSize, vCores, vTiles);
+		const int margin = static_cast<int>(nIt) + 1;
+		nChecked = 0;
+		for (size_t t = 0; t < vCores.size(); t++) {
+			const Rect &core = vCores[t];
+			const Rect &tile = vTiles[t];
+			for (int y = core.y; y < core.y + core.height; y++)
+				for (int x = core.x; x < core.x + core.width; x++) {
+					ASSERT_LT(solution.at<byte>(y, x), nStates);
+					if (tile.x > 0 && x - tile.x < margin) continue;
+					if (tile.y > 0 && y - tile.y < margin) continue;
+					if (tile.x + tile.width < imageSize.width && tile.x + tile.width - 1 - x < margin) continue;
+					if (tile.y + tile.height < imageSize.height && tile.y + tile.height - 1 - y < margin) continue;
+					ASSERT_EQ(vSolution[y * imageSize.width + x], solution.at<byte>(y, x));
+					ASSERT_NEAR(vConfidence[y * imageSize.width + x], confidence.at<float>(y, x), 1e-5);
+					nChecked++;
+				} // x
+		} // t
+	};
+
+	// The halo, smaller than the image, but wider than the range of the iterations: every pixel is decoded as in the whole image
+	const unsigned int nIt = random::u(2, 4);
+	CTiledInfer tiledInferHalo(GraphType::pairwise, nStates, Size(random::u(5, 15), random::u(5, 15)), nIt + 1);
+	size_t nChecked;
+	testSeams(tiledInferHalo, nIt, nChecked);
+	ASSERT_EQ(static_cast<size_t>(imageSize.area()), nChecked);
+
+	// The narrow halo: only the pixels away from the seam between two halves of the image are decoded as in the whole image
+	CTiledInfer tiledInferSeam(GraphType::pairwise, nStates, Size((imageSize.width + 1) / 2, imageSize.height), 2);
+	testSeams(tiledInferSeam, 5, nChecked);
+	ASSERT_LT(0U, nChecked);
+
+	// Without smoothing the states are defined by the node potentials only
+	smoothness = 1.0f;
+	CTiledInfer tiledInfer0(GraphType::pairwise, nStates, Size(7, 5), 0);
+	tiledInfer0.infer(imageSize, fillTile, solution, confidence, 10);
+	for (int y = 0; y < imageSize.height; y++)
+		for (int x = 0; x < imageSize.width; x++) {
+			const float *pPot = pots.ptr<float>(y) + x * nStates;
+			ASSERT_EQ(std::max_element(pPot, pPot + nStates) - pPot, solution.at<byte>(y, x));
+		}
+}
@@ -1,7 +1,8 @@
 #include "TestKDTree.h"
 #include "DGM/random.h"
+#include "DGM/mathop.h"
 
-void CTestKDTree::fill_tree(CKDTree& tree) {
+void CTestKDTree::fill_tree(IKNNIndex& index) {
 
 	// Keys
 	if (!m_keys.empty()) m_keys.release();
@@ -16,7 +17,7 @@ void CTestKDTree::fill_tree(CKDTree& tree) {
 	// Values
 	m_values = Mat(nSamples, 1, CV_8UC1);
 
-	tree.build(lvalue_cast(m_keys.clone()), m_values);
+	index.build(lvalue_cast(m_keys.clone()), m_values);
 }
 
 Mat  CTestKDTree::find_nearestNeighbor_bruteForce(const Mat& key)
@@ -40,6 +41,59 @@ Mat  CTestKDTree::find_nearestNeighbor_bruteForce(const Mat& key)
 	return res;
 }
 
+std::vector<dword> CTestKDTree::find_sqDistances_bruteForce(const Mat& key)
+{
+	std::vector<dword> res(m_keys.rows);
+	const byte* pKey = key.ptr<byte>(0);
+	for (int s = 0; s < m_keys.rows; s++) {
+		res[s] = 0;
+		const byte* pKeys = m_keys.ptr<byte>(s);
+		for (int f = 0; f < nFeatures; f++) {
+			int diff = static_cast<int>(pKeys[f]) - static_cast<int>(pKey[f]);
+			res[s] += diff * diff;
+		}
+	}
+	std::sort(res.begin(), res.end());
+	return res;
+}
+
+Mat CTestKDTree::generate_clustered(const Mat &centers, int n)
+{
+	Mat res(n, nFeatures, CV_8UC1);
+	for (int i = 0; i < n; i++) {
+		int c = random::u(0, centers.rows - 1);
+		for (int f = 0; f < nFeatures; f++)
+			res.at<byte>(i, f) = saturate_cast<byte>(centers.at<byte>(c, f) + random::N<float>(0, 12));
+	}
+	return res;
+}
+
+// A found neighbor is a true one if it is not farther than the k-th exact neighbor
+double CTestKDTree::get_recall(const IKNNIndex &exact, const IKNNIndex &approx, const Mat &queries, size_t maxNeighbors)
+{
+	auto getSqDistance = [&](const IKNNIndex &index, int idx, int q) {
+		Mat key = index.getKey(idx);
+		dword res = 0;
+		for (int f = 0; f < nFeatures; f++) {
+			int diff = static_cast<int>(key.at<byte>(0, f)) - static_cast<int>(queries.at<byte>(q, f));
+			res += diff * diff;
+		}
+		return res;
+	};
+
+	Mat exactIndices, approxIndices;
+	exact.findNearestNeighbors(queries, maxNeighbors, exactIndices);
+	approx.findNearestNeighbors(queries, maxNeighbors, approxIndices);
+
+	size_t nHits = 0;
+	for (int q = 0; q < queries.rows; q++) {
+		dword maxDist = getSqDistance(exact, exactIndices.at<int>(q, static_cast<int>(maxNeighbors) - 1), q);
+		for (int j = 0; j < static_cast<int>(maxNeighbors); j++)
+			if (approxIndices.at<int>(q, j) >= 0 && getSqDistance(approx, approxIndices.at<int>(q, j), q) <= maxDist) nHits++;
+	}
+	return static_cast<double>(nHits) / (queries.rows * maxNeighbors);
+}
+
 TEST_F(CTestKDTree, findNearestNeighbor)
 {
 	CKDTree tree;
@@ -55,7 +109,7 @@ TEST_F(CTestKDTree, findNearestNeighbor)
 			key.at<byte>(0, f) = 5 * random::u(0, 51) + 1;
 
 		Mat bf_key = find_nearestNeighbor_bruteForce(key);	
-		Mat nn_key = tree.findNearestNeighbor(key)->getKey();
+		Mat nn_key = tree.getKey(tree.findNearestNeighbor(key));
 
 		// There might be multiple points with the same distance to the test key. So we compare the distances
 		float bf_dist = 0;
@@ -70,3 +124,178 @@ TEST_F(CTestKDTree, findNearestNeighbor)
 		ASSERT_FLOAT_EQ(bf_dist, nn_dist);
 	}
 }
+
+TEST_F(CTestKDTree, findNearestNeighbors_batch)
+{
+	const size_t maxNeighbors = 10;
+	CKDTree tree;
+
+	fill_tree(tree);
+
+	// Test Keys container
+	Mat keys(nTests, nFeatures, CV_8UC1);
+	for (int i = 0; i < nTests; i++)
+		for (int f = 0; f < nFeatures; f++)
+			keys.at<byte>(i, f) = 5 * random::u(0, 51) + 1;
+
+	Mat indices;
+	tree.findNearestNeighbors(keys, maxNeighbors, indices);
+	ASSERT_EQ(indices.rows, nTests);
+	ASSERT_EQ(indices.cols, static_cast<int>(maxNeighbors));
+
+	for (int i = 0; i < nTests; i++) {
+		// There might be multiple points with the same distance to the test key. So we compare the sorted distances
+		std::vector<dword> bf_dists = find_sqDistances_bruteForce(keys.row(i));
+		vec_size_t nn = tree.findNearestNeighbors(keys.row(i), maxNeighbors);
+		ASSERT_EQ(nn.size(), maxNeighbors);
+		for (size_t j = 0; j < maxNeighbors; j++) {
+			ASSERT_EQ(static_cast<size_t>(indices.at<int>(i, static_cast<int>(j))), nn[j]);
+			Mat nn_key = tree.getKey(nn[j]);
+			dword nn_dist = 0;
+			for (int f = 0; f < nFeatures; f++) {
+				int diff = static_cast<int>(nn_key.at<byte>(0, f)) - static_cast<int>(keys.at<byte>(i, f));
+				nn_dist += diff * diff;
+			}
+			ASSERT_EQ(bf_dists[j], nn_dist);
+		}
+	}
+}
+
+TEST_F(CTestKDTree, saveLoad)
+{
+	const std::string fileName = "TestKDTree.dat";
+	CKDTree tree;
+
+	fill_tree(tree);
+	tree.save(fileName);
+
+	CKDTree loaded;
+	loaded.load(fileName);
+	std::remove(fileName.c_str());
+
+	ASSERT_EQ(loaded.getNumPoints(), tree.getNumPoints());
+	ASSERT_EQ(loaded.getNumDimensions(), tree.getNumDimensions());
+	for (size_t i = 0; i < tree.getNumPoints(); i++) {
+		ASSERT_EQ(loaded.getValue(i), tree.getValue(i));
+		ASSERT_TRUE(mathop::isEqual<byte>(loaded.getKey(i), tree.getKey(i)));
+	}
+
+	Mat key(1, nFeatures, CV_8UC1);
+	for (int i = 0; i < nTests; i++) {
+		for (int f = 0; f < nFeatures; f++)
+			key.at<byte>(0, f) = 5 * random::u(0, 51) + 1;
+		ASSERT_EQ(loaded.findNearestNeighbor(key), tree.findNearestNeighbor(key));
+	}
+}
+
+TEST_F(CTestKDTree, KDForest_exact)
+{
+	const size_t maxNeighbors = 10;
+	CKDForest forest(4, 0);
+
+	fill_tree(forest);
+
+	// Test Keys container
+	Mat keys(nTests, nFeatures, CV_8UC1);
+	for (int i = 0; i < nTests; i++)
+		for (int f = 0; f < nFeatures; f++)
+			keys.at<byte>(i, f) = 5 * random::u(0, 51) + 1;
+
+	Mat indices;
+	forest.findNearestNeighbors(keys, maxNeighbors, indices);
+
+	for (int i = 0; i < nTests; i++) {
+		std::vector<dword> bf_dists = find_sqDistances_bruteForce(keys.row(i));
+		for (int j = 0; j < static_cast<int>(maxNeighbors); j++) {
+			ASSERT_GE(indices.at<int>(i, j), 0);
+			Mat nn_key = forest.getKey(indices.at<int>(i, j));
+			dword nn_dist = 0;
+			for (int f = 0; f < nFeatures; f++) {
+				int diff = static_cast<int>(nn_key.at<byte>(0, f)) - static_cast<int>(keys.at<byte>(i, f));
+				nn_dist += diff * diff;
+			}
+			ASSERT_EQ(bf_dists[j], nn_dist);
+		}
+	}
+}
+
+TEST_F(CTestKDTree, KDForest_saveLoad)
+{
+	const std::string fileName = "TestKDForest.dat";
+	const size_t maxNeighbors = 5;
+	CKDForest forest(4, 64);
+
+	fill_tree(forest);
+	forest.save(fileName);
+
+	CKDForest loaded(1, 64);
+	loaded.load(fileName);
+	std::remove(fileName.c_str());
+
+	ASSERT_EQ(loaded.getNumTrees(), forest.getNumTrees());
+	ASSERT_EQ(loaded.getNumPoints(), forest.getNumPoints());
+
+	Mat keys(nTests, nFeatures, CV_8UC1);
+	for (int i = 0; i < nTests; i++)
+		for (int f = 0; f < nFeatures; f++)
+			keys.at<byte>(i, f) = 5 * random::u(0, 51) + 1;
+
+	Mat indices, loadedIndices;
+	forest.findNearestNeighbors(keys, maxNeighbors, indices);
+	loaded.findNearestNeighbors(keys, maxNeighbors, loadedIndices);
+	for (int i = 0; i < nTests; i++)
+		for (int j = 0; j < static_cast<int>(maxNeighbors); j++)
+			ASSERT_EQ(loadedIndices.at<int>(i, j), indices.at<int>(i, j));
+}
+
+TEST_F(CTestKDTree, KDForest_recall)
+{
+	const size_t maxNeighbors = 10;
+	const Mat	 centers	  = random::U(Size(nFeatures, 20), CV_8UC1, 0, 255);
+	const Mat	 keys		  = generate_clustered(centers, nSamples);
+	const Mat	 values		  = Mat(nSamples, 1, CV_8UC1, Scalar(0));
+	const Mat	 queries	  = generate_clustered(centers, nTests);
+
+	CKDTree tree(keys, values);
+	CKDForest forest(keys, values, 4, 1024);
+	ASSERT_GE(get_recall(tree, forest, queries, maxNeighbors), 0.8);
+}
+
+// Compares the recall and the throughput of the approximate search with CKDForest against the exact search with CKDTree
+TEST_F(CTestKDTree, DISABLED_KDForest_benchmark)
+{
+	const int		nPoints		 = 200000;
+	const int		nQueries	 = 1000;
+	const size_t	maxNeighbors = 10;
+
+	// Clustered data
+	const Mat centers	= random::U(Size(nFeatures, 20), CV_8UC1, 0, 255);
+	const Mat keys		= generate_clustered(centers, nPoints);
+	const Mat values	= Mat(nPoints, 1, CV_8UC1, Scalar(0));
+	const Mat queries	= generate_clustered(centers, nQueries);
+
+	// Exact search
+	CKDTree tree(keys, values);
+	Mat exact;
+	int64 ticks = getTickCount();
+	tree.findNearestNeighbors(queries, maxNeighbors, exact);
+	double exactTime = static_cast<double>(getTickCount() - ticks) / getTickFrequency();
+	printf("CKDTree:                 %8.1f queries/s\n", nQueries / exactTime);
+
+	// Approximate search
+	CKDForest forest(keys, values, 4);
+	double prevRecall = 0;
+	for (size_t maxChecks : { 64, 256, 1024, 4096 }) {
+		forest.setMaxChecks(maxChecks);
+		Mat approx;
+		ticks = getTickCount();
+		forest.findNearestNeighbors(queries, maxNeighbors, approx);
+		double approxTime = static_cast<double>(getTickCount() - ticks) / getTickFrequency();
+
+		double recall = get_recall(tree, forest, queries, maxNeighbors);
+		printf("CKDForest (%4zu checks): %8.1f queries/s, speedup: %5.1f, recall: %.3f\n", maxChecks, nQueries / approxTime, exactTime / approxTime, recall);
+
+		EXPECT_GE(recall, prevRecall - 0.05);
+		prevRecall = recall;
+	}
+}
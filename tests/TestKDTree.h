@@ -13,16 +13,16 @@ public:
 
 
 protected:
-	void fill_tree(CKDTree& tree);
+	void fill_tree(IKNNIndex& index);
 	Mat  find_nearestNeighbor_bruteForce(const Mat& key);
+	std::vector<dword> find_sqDistances_bruteForce(const Mat& key);
+	Mat  generate_clustered(const Mat& centers, int n);
+	double get_recall(const IKNNIndex& exact, const IKNNIndex& approx, const Mat& queries, size_t maxNeighbors);
 
-
-private:
 	Mat m_keys		= Mat();
 	Mat m_values	= Mat();
 
-
-protected:	// Test configuration
+	// Test configuration
 	const int	nSamples	= 10000;
 	const int	nFeatures	= 16;
 	const int	nTests		= 100;
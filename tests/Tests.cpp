@@ -1,6 +1,7 @@
 #include "Tests.h"
 #include "DGM/parallel.h"
 #include "DGM/random.h"
+#include <filesystem>
 
 using namespace DirectGraphicalModels;
 
@@ -24,3 +25,182 @@ TEST_F(CTests, parallel_gemm)
 #endif
 }
 
+
+TEST_F(CTests, train_node_batch)
+{
+	const byte nStates	 = 3;
+	const word nFeatures = 3;
+	const Size size(random::u<int>(10, 30), random::u<int>(10, 30));
+	Mat features = random::U(size, CV_8UC(nFeatures), 0, 256);
+	Mat gt(size, CV_8UC1);
+	for (int y = 0; y < size.height; y++)
+		for (int x = 0; x < size.width; x++)
+			gt.at<byte>(y, x) = features.ptr<byte>(y)[x * nFeatures] / 86;
+
+	for (byte nodeRandomModel : { NodeRandomModel::Bayes, NodeRandomModel::GMM, NodeRandomModel::KNN, NodeRandomModel::CvRF, NodeRandomModel::CvSVM }) {
+		auto nodeTrainer = CTrainNode::create(nodeRandomModel, nStates, nFeatures);
+		nodeTrainer->addFeatureVecs(features, gt);
+		nodeTrainer->train();
+
+		// The potentials of the block must match the potentials of the single feature vectors
+		Mat pots = nodeTrainer->getNodePotentials(features);
+		Mat featureVector(nFeatures, 1, CV_8UC1);
+		for (int y = 0; y < size.height; y++)
+			for (int x = 0; x < size.width; x++) {
+				for (word f = 0; f < nFeatures; f++) featureVector.at<byte>(f, 0) = features.ptr<byte>(y)[x * nFeatures + f];
+				Mat pot = nodeTrainer->getNodePotentials(featureVector, 1.0f);
+				for (byte s = 0; s < nStates; s++)
+					ASSERT_NEAR(pot.at<float>(s, 0), pots.ptr<float>(y)[x * nStates + s], 1e-3);
+			} // x
+	}
+}
+
+TEST_F(CTests, train_node_bayes_compiled)
+{
+	const byte nStates	 = 4;
+	const word nFeatures = 3;
+	const int  nSamples	 = random::u<int>(5000, 20000);
+	CTrainNodeBayes nodeTrainer(nStates, nFeatures);
+
+	Mat featureVector(nFeatures, 1, CV_8UC1);
+	vec_size_t vCount(nStates, 0);
+	for (int i = 0; i < nSamples; i++) {
+		for (word f = 0; f < nFeatures; f++) featureVector.at<byte>(f, 0) = static_cast<byte>(random::u(0, 255));
+		byte gt = static_cast<byte>(random::u(0, nStates - 1));
+		vCount[gt]++;
+		nodeTrainer.addFeatureVec(featureVector, gt);
+	}
+	nodeTrainer.train();
+
+	// The compiled potentials must be proportional to prior * product of the densities
+	std::vector<double> vExpected(nStates);
+	for (int t = 0; t < 1000; t++) {
+		for (word f = 0; f < nFeatures; f++) featureVector.at<byte>(f, 0) = static_cast<byte>(random::u(0, 255));
+		double sum = 0;
+		for (byte s = 0; s < nStates; s++) {
+			vExpected[s] = static_cast<double>(vCount[s]);
+			for (word f = 0; f < nFeatures; f++) vExpected[s] *= nodeTrainer.getPDF(s, f)->getDensity(featureVector.at<byte>(f, 0));
+			sum += vExpected[s];
+		}
+		if (sum == 0) continue;
+
+		Mat pot = nodeTrainer.getNodePotentials(featureVector, 1.0f);
+		for (byte s = 0; s < nStates; s++)
+			ASSERT_NEAR(100 * vExpected[s] / sum, pot.at<float>(s, 0), 1e-2);
+	}
+}
+
+TEST_F(CTests, train_node_gmm_batch)
+{
+	const byte	 nStates	= 3;
+	const word	 nFeatures	= 3;
+	const int	 nSamples	= 30000;
+	const double centers[nStates][nFeatures] = { { 60, 60, 60 }, { 190, 60, 120 }, { 120, 190, 190 } };
+
+	auto generate = [&](Mat &featureVector) {
+		byte s = static_cast<byte>(random::u(0, nStates - 1));
+		for (word f = 0; f < nFeatures; f++)
+			featureVector.at<byte>(f, 0) = saturate_cast<byte>(centers[s][f] + random::N<double>(0, 25));
+		return s;
+	};
+
+	TrainNodeGMMParams params = TRAIN_NODE_GMM_PARAMS_DEFAULT;
+	CTrainNodeGMM sequentialTrainer(nStates, nFeatures, params);
+	params.batchSize = 1024;
+	CTrainNodeGMM batchTrainer(nStates, nFeatures, params);
+
+	Mat featureVector(nFeatures, 1, CV_8UC1);
+	for (int i = 0; i < nSamples; i++) {
+		byte gt = generate(featureVector);
+		sequentialTrainer.addFeatureVec(featureVector, gt);
+		batchTrainer.addFeatureVec(featureVector, gt);
+	}
+	sequentialTrainer.train();
+	batchTrainer.train();
+
+	// The mini-batch training must be as accurate as the sequential one
+	int nSequentialHits = 0;
+	int nBatchHits		= 0;
+	for (int i = 0; i < 5000; i++) {
+		byte gt = generate(featureVector);
+		Point extremumLoc;
+		minMaxLoc(sequentialTrainer.getNodePotentials(featureVector, 1.0f), NULL, NULL, NULL, &extremumLoc);
+		if (extremumLoc.y == gt) nSequentialHits++;
+		minMaxLoc(batchTrainer.getNodePotentials(featureVector, 1.0f), NULL, NULL, NULL, &extremumLoc);
+		if (extremumLoc.y == gt) nBatchHits++;
+	}
+	ASSERT_GT(nSequentialHits, 4500);
+	ASSERT_GE(nBatchHits, nSequentialHits - 100);
+}
+
+TEST_F(CTests, train_node_add_feature_vecs)
+{
+	const byte nStates	 = 3;
+	const word nFeatures = 3;
+	const Size size(random::u<int>(50, 100), random::u<int>(50, 100));
+	Mat features = random::U(size, CV_8UC(nFeatures), 0, 256);
+	Mat gt(size, CV_8UC1);
+	for (int y = 0; y < size.height; y++)
+		for (int x = 0; x < size.width; x++)
+			gt.at<byte>(y, x) = static_cast<byte>(random::u(0, nStates - 1));
+
+	// The samples, added as a block, must produce the same model as the samples, added one by one
+	CTrainNodeKNN blockTrainer(nStates, nFeatures);
+	CTrainNodeKNN sampleTrainer(nStates, nFeatures);
+	blockTrainer.addFeatureVecs(features, gt);
+	Mat featureVector(nFeatures, 1, CV_8UC1);
+	for (int y = 0; y < size.height; y++)
+		for (int x = 0; x < size.width; x++) {
+			for (word f = 0; f < nFeatures; f++) featureVector.at<byte>(f, 0) = features.ptr<byte>(y)[x * nFeatures + f];
+			sampleTrainer.addFeatureVec(featureVector, gt.at<byte>(y, x));
+		} // x
+	blockTrainer.train();
+	sampleTrainer.train();
+
+	Mat blockPots  = blockTrainer.getNodePotentials(features);
+	Mat samplePots = sampleTrainer.getNodePotentials(features);
+	ASSERT_EQ(0.0, norm(blockPots, samplePots, NORM_INF));
+}
+
+TEST_F(CTests, train_node_sample_store)
+{
+	const byte nStates	 = 3;
+	const word nFeatures = 3;
+	const Size size(random::u<int>(50, 100), random::u<int>(50, 100));
+	Mat features = random::U(size, CV_8UC(nFeatures), 0, 256);
+	Mat gt(size, CV_8UC1);
+	for (int y = 0; y < size.height; y++)
+		for (int x = 0; x < size.width; x++)
+			gt.at<byte>(y, x) = static_cast<byte>(random::u(0, nStates - 1));
+	const std::string fileName = (std::filesystem::temp_directory_path() / "dgm_sample_store.dat").string();
+	std::filesystem::remove(fileName);
+
+	// The ingestion is split into two sessions: the second one appends to the file
+	const int half = size.height / 2;
+	{
+		CSampleStore store(fileName, nStates, nFeatures);
+		store.addSamples(features.rowRange(0, half), gt.rowRange(0, half));
+	}
+	CSampleStore store(fileName, nStates, nFeatures);
+	store.addSamples(features.rowRange(half, size.height), gt.rowRange(half, size.height));
+	store.flush();
+	for (byte s = 0; s < nStates; s++)
+		ASSERT_EQ(static_cast<size_t>(countNonZero(gt == s)), store.getNumSamples(s));
+
+	// The model, trained from the store, must be the same as the model, trained from the samples accumulator
+	CTrainNodeKNN storeTrainer(nStates, nFeatures);
+	CTrainNodeKNN accTrainer(nStates, nFeatures);
+	storeTrainer.train(store);
+	accTrainer.addFeatureVecs(features, gt);
+	accTrainer.train();
+
+	Mat storePots = storeTrainer.getNodePotentials(features);
+	Mat accPots	  = accTrainer.getNodePotentials(features);
+	ASSERT_EQ(0.0, norm(storePots, accPots, NORM_INF));
+
+	// The random subset
+	Mat samples, states;
+	store.getSamples(samples, states, 10);
+	ASSERT_EQ(nStates * 10, samples.rows);
+	ASSERT_EQ(nFeatures, samples.cols);
+}